@@ -0,0 +1,89 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_atom.h"
+
+#include <QList>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+AdAtomTable *AdAtomTable::instance() {
+    static AdAtomTable table;
+
+    return &table;
+}
+
+AdAtomTable::AdAtomTable() {
+    static const QList<QString> well_known_list = {
+#define AD_WELL_KNOWN_ATOM_NAME(atom, name) name,
+        AD_WELL_KNOWN_ATOM_LIST(AD_WELL_KNOWN_ATOM_NAME)
+#undef AD_WELL_KNOWN_ATOM_NAME
+    };
+
+    // NOTE: atoms are assigned in order, so well-known
+    // atoms match their enum values
+    for (const QString &name : well_known_list) {
+        const AdAtom atom = name_list.size();
+        name_list.append(name);
+        atom_map.insert(name, atom);
+    }
+}
+
+AdAtom AdAtomTable::intern(const QString &name) {
+    {
+        QReadLocker locker(&lock);
+
+        const AdAtom existing = atom_map.value(name, AD_ATOM_NONE);
+        if (existing != AD_ATOM_NONE) {
+            return existing;
+        }
+    }
+
+    QWriteLocker locker(&lock);
+
+    // NOTE: check again because another thread could've
+    // interned this name while lock was released
+    const AdAtom existing = atom_map.value(name, AD_ATOM_NONE);
+    if (existing != AD_ATOM_NONE) {
+        return existing;
+    }
+
+    const AdAtom atom = name_list.size();
+    name_list.append(name);
+    atom_map.insert(name, atom);
+
+    return atom;
+}
+
+AdAtom AdAtomTable::find(const QString &name) {
+    QReadLocker locker(&lock);
+
+    return atom_map.value(name, AD_ATOM_NONE);
+}
+
+QString AdAtomTable::name(const AdAtom atom) {
+    QReadLocker locker(&lock);
+
+    if (atom >= 0 && atom < name_list.size()) {
+        return name_list[atom];
+    } else {
+        return QString();
+    }
+}
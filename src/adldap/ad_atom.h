@@ -0,0 +1,175 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_ATOM_H
+#define AD_ATOM_H
+
+/**
+ * Process-wide table of interned attribute names. Each
+ * name is mapped to a small integer id, called an atom,
+ * which stays the same for the lifetime of the process.
+ * Objects store atoms instead of attribute name strings,
+ * so that a name is stored once and not once per object.
+ * Comparing atoms is also much cheaper than comparing
+ * strings. Thread-safe.
+ *
+ * Attributes from ad_defines.h are interned when the table
+ * is created, so their atoms are known at compile time and
+ * can be used without looking up names. Other attributes,
+ * for example the ones loaded from schema, are interned at
+ * runtime.
+ */
+
+#include "ad_defines.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+typedef int AdAtom;
+
+#define AD_ATOM_NONE -1
+
+// NOTE: to add a well-known atom, add it's attribute to
+// this list
+#define AD_WELL_KNOWN_ATOM_LIST(X) \
+    X(ATOM_CN, ATTRIBUTE_CN) \
+    X(ATOM_USER_ACCOUNT_CONTROL, ATTRIBUTE_USER_ACCOUNT_CONTROL) \
+    X(ATOM_LOCKOUT_TIME, ATTRIBUTE_LOCKOUT_TIME) \
+    X(ATOM_ACCOUNT_EXPIRES, ATTRIBUTE_ACCOUNT_EXPIRES) \
+    X(ATOM_PWD_LAST_SET, ATTRIBUTE_PWD_LAST_SET) \
+    X(ATOM_NAME, ATTRIBUTE_NAME) \
+    X(ATOM_INITIALS, ATTRIBUTE_INITIALS) \
+    X(ATOM_SAMACCOUNT_NAME, ATTRIBUTE_SAMACCOUNT_NAME) \
+    X(ATOM_DISPLAY_NAME, ATTRIBUTE_DISPLAY_NAME) \
+    X(ATOM_DESCRIPTION, ATTRIBUTE_DESCRIPTION) \
+    X(ATOM_USER_PRINCIPAL_NAME, ATTRIBUTE_USER_PRINCIPAL_NAME) \
+    X(ATOM_MAIL, ATTRIBUTE_MAIL) \
+    X(ATOM_OFFICE, ATTRIBUTE_OFFICE) \
+    X(ATOM_TELEPHONE_NUMBER, ATTRIBUTE_TELEPHONE_NUMBER) \
+    X(ATOM_TELEPHONE_NUMBER_OTHER, ATTRIBUTE_TELEPHONE_NUMBER_OTHER) \
+    X(ATOM_WWW_HOMEPAGE, ATTRIBUTE_WWW_HOMEPAGE) \
+    X(ATOM_WWW_HOMEPAGE_OTHER, ATTRIBUTE_WWW_HOMEPAGE_OTHER) \
+    X(ATOM_COUNTRY_ABBREVIATION, ATTRIBUTE_COUNTRY_ABBREVIATION) \
+    X(ATOM_COUNTRY, ATTRIBUTE_COUNTRY) \
+    X(ATOM_COUNTRY_CODE, ATTRIBUTE_COUNTRY_CODE) \
+    X(ATOM_CITY, ATTRIBUTE_CITY) \
+    X(ATOM_PO_BOX, ATTRIBUTE_PO_BOX) \
+    X(ATOM_POSTAL_CODE, ATTRIBUTE_POSTAL_CODE) \
+    X(ATOM_STATE, ATTRIBUTE_STATE) \
+    X(ATOM_STREET, ATTRIBUTE_STREET) \
+    X(ATOM_DN, ATTRIBUTE_DN) \
+    X(ATOM_OBJECT_CLASS, ATTRIBUTE_OBJECT_CLASS) \
+    X(ATOM_WHEN_CREATED, ATTRIBUTE_WHEN_CREATED) \
+    X(ATOM_WHEN_CHANGED, ATTRIBUTE_WHEN_CHANGED) \
+    X(ATOM_USN_CHANGED, ATTRIBUTE_USN_CHANGED) \
+    X(ATOM_USN_CREATED, ATTRIBUTE_USN_CREATED) \
+    X(ATOM_HIGHEST_COMMITTED_USN, ATTRIBUTE_HIGHEST_COMMITTED_USN) \
+    X(ATOM_IS_DELETED, ATTRIBUTE_IS_DELETED) \
+    X(ATOM_OBJECT_CATEGORY, ATTRIBUTE_OBJECT_CATEGORY) \
+    X(ATOM_MEMBER, ATTRIBUTE_MEMBER) \
+    X(ATOM_MEMBER_OF, ATTRIBUTE_MEMBER_OF) \
+    X(ATOM_SHOW_IN_ADVANCED_VIEW_ONLY, ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY) \
+    X(ATOM_GROUP_TYPE, ATTRIBUTE_GROUP_TYPE) \
+    X(ATOM_FIRST_NAME, ATTRIBUTE_FIRST_NAME) \
+    X(ATOM_LAST_NAME, ATTRIBUTE_LAST_NAME) \
+    X(ATOM_DNS_HOST_NAME, ATTRIBUTE_DNS_HOST_NAME) \
+    X(ATOM_INFO, ATTRIBUTE_INFO) \
+    X(ATOM_PASSWORD, ATTRIBUTE_PASSWORD) \
+    X(ATOM_GPLINK, ATTRIBUTE_GPLINK) \
+    X(ATOM_GPOPTIONS, ATTRIBUTE_GPOPTIONS) \
+    X(ATOM_DEPARTMENT, ATTRIBUTE_DEPARTMENT) \
+    X(ATOM_COMPANY, ATTRIBUTE_COMPANY) \
+    X(ATOM_TITLE, ATTRIBUTE_TITLE) \
+    X(ATOM_LAST_LOGON, ATTRIBUTE_LAST_LOGON) \
+    X(ATOM_LAST_LOGON_TIMESTAMP, ATTRIBUTE_LAST_LOGON_TIMESTAMP) \
+    X(ATOM_BAD_PWD_TIME, ATTRIBUTE_BAD_PWD_TIME) \
+    X(ATOM_OBJECT_SID, ATTRIBUTE_OBJECT_SID) \
+    X(ATOM_SYSTEM_FLAGS, ATTRIBUTE_SYSTEM_FLAGS) \
+    X(ATOM_MAX_PWD_AGE, ATTRIBUTE_MAX_PWD_AGE) \
+    X(ATOM_MIN_PWD_AGE, ATTRIBUTE_MIN_PWD_AGE) \
+    X(ATOM_LOCKOUT_DURATION, ATTRIBUTE_LOCKOUT_DURATION) \
+    X(ATOM_IS_CRITICAL_SYSTEM_OBJECT, ATTRIBUTE_IS_CRITICAL_SYSTEM_OBJECT) \
+    X(ATOM_GPC_FILE_SYS_PATH, ATTRIBUTE_GPC_FILE_SYS_PATH) \
+    X(ATOM_GPC_FUNCTIONALITY_VERSION, ATTRIBUTE_GPC_FUNCTIONALITY_VERSION) \
+    X(ATOM_VERSION_NUMBER, ATTRIBUTE_VERSION_NUMBER) \
+    X(ATOM_FLAGS, ATTRIBUTE_FLAGS) \
+    X(ATOM_OBJECT_GUID, ATTRIBUTE_OBJECT_GUID) \
+    X(ATOM_PRIMARY_GROUP_ID, ATTRIBUTE_PRIMARY_GROUP_ID) \
+    X(ATOM_MANAGER, ATTRIBUTE_MANAGER) \
+    X(ATOM_MANAGED_BY, ATTRIBUTE_MANAGED_BY) \
+    X(ATOM_DIRECT_REPORTS, ATTRIBUTE_DIRECT_REPORTS) \
+    X(ATOM_PROFILE_PATH, ATTRIBUTE_PROFILE_PATH) \
+    X(ATOM_SCRIPT_PATH, ATTRIBUTE_SCRIPT_PATH) \
+    X(ATOM_HOME_DIRECTORY, ATTRIBUTE_HOME_DIRECTORY) \
+    X(ATOM_HOME_PHONE, ATTRIBUTE_HOME_PHONE) \
+    X(ATOM_OTHER_HOME_PHONE, ATTRIBUTE_OTHER_HOME_PHONE) \
+    X(ATOM_PAGER, ATTRIBUTE_PAGER) \
+    X(ATOM_OTHER_PAGER, ATTRIBUTE_OTHER_PAGER) \
+    X(ATOM_MOBILE, ATTRIBUTE_MOBILE) \
+    X(ATOM_OTHER_MOBILE, ATTRIBUTE_OTHER_MOBILE) \
+    X(ATOM_FAX_NUMBER, ATTRIBUTE_FAX_NUMBER) \
+    X(ATOM_OTHER_FAX_NUMBER, ATTRIBUTE_OTHER_FAX_NUMBER) \
+    X(ATOM_IP_PHONE, ATTRIBUTE_IP_PHONE) \
+    X(ATOM_OTHER_IP_PHONE, ATTRIBUTE_OTHER_IP_PHONE) \
+    X(ATOM_UPN_SUFFIXES, ATTRIBUTE_UPN_SUFFIXES) \
+    X(ATOM_SECURITY_DESCRIPTOR, ATTRIBUTE_SECURITY_DESCRIPTOR) \
+    X(ATOM_RIGHTS_GUID, ATTRIBUTE_RIGHTS_GUID) \
+    X(ATOM_LOCATION, ATTRIBUTE_LOCATION) \
+    X(ATOM_OS, ATTRIBUTE_OS) \
+    X(ATOM_OS_VERSION, ATTRIBUTE_OS_VERSION) \
+    X(ATOM_OS_SERVICE_PACK, ATTRIBUTE_OS_SERVICE_PACK) \
+    X(ATOM_LOGON_HOURS, ATTRIBUTE_LOGON_HOURS) \
+    X(ATOM_USER_WORKSTATIONS, ATTRIBUTE_USER_WORKSTATIONS)
+
+enum WellKnownAtom {
+#define AD_WELL_KNOWN_ATOM_ENUM(atom, name) atom,
+    AD_WELL_KNOWN_ATOM_LIST(AD_WELL_KNOWN_ATOM_ENUM)
+#undef AD_WELL_KNOWN_ATOM_ENUM
+
+    WellKnownAtom_COUNT,
+};
+
+class AdAtomTable {
+
+public:
+    static AdAtomTable *instance();
+
+    // Returns atom for given name, adding the name to the
+    // table if it's not there yet
+    AdAtom intern(const QString &name);
+
+    // Returns atom for given name or AD_ATOM_NONE if the
+    // name was never interned. Use this for lookups, so
+    // that looking up unknown names doesn't grow the table.
+    AdAtom find(const QString &name);
+
+    QString name(const AdAtom atom);
+
+private:
+    QReadWriteLock lock;
+    QHash<QString, AdAtom> atom_map;
+    QVector<QString> name_list;
+
+    AdAtomTable();
+};
+
+#endif /* AD_ATOM_H */
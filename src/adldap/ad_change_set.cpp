@@ -0,0 +1,89 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ad_change_set.h"
+
+void AdChangeSet::replace_values(const QString &attribute, const QList<QByteArray> &values) {
+    for (int i = change_list.size() - 1; i >= 0; i--) {
+        const AdChange &change = change_list[i];
+
+        if (change.type == AdChangeType_Replace && change.attribute == attribute) {
+            change_list.removeAt(i);
+        }
+    }
+
+    AdChange change;
+    change.type = AdChangeType_Replace;
+    change.attribute = attribute;
+    change.values = values;
+
+    change_list.append(change);
+}
+
+void AdChangeSet::replace_value(const QString &attribute, const QByteArray &value) {
+    const QList<QByteArray> values = [=]() -> QList<QByteArray> {
+        if (value.isEmpty()) {
+            return QList<QByteArray>();
+        } else {
+            return {value};
+        }
+    }();
+
+    replace_values(attribute, values);
+}
+
+void AdChangeSet::replace_string(const QString &attribute, const QString &value) {
+    const QByteArray value_bytes = value.toUtf8();
+
+    replace_value(attribute, value_bytes);
+}
+
+void AdChangeSet::replace_int(const QString &attribute, const int value) {
+    const QString value_string = QString::number(value);
+
+    replace_string(attribute, value_string);
+}
+
+void AdChangeSet::add_value(const QString &attribute, const QByteArray &value) {
+    AdChange change;
+    change.type = AdChangeType_Add;
+    change.attribute = attribute;
+    change.values = {value};
+
+    change_list.append(change);
+}
+
+void AdChangeSet::delete_value(const QString &attribute, const QByteArray &value) {
+    AdChange change;
+    change.type = AdChangeType_Delete;
+    change.attribute = attribute;
+    change.values = {value};
+
+    change_list.append(change);
+}
+
+bool AdChangeSet::is_empty() const {
+    return change_list.isEmpty();
+}
+
+QList<AdChange> AdChangeSet::changes() const {
+    return change_list;
+}
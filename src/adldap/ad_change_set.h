@@ -0,0 +1,71 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef AD_CHANGE_SET_H
+#define AD_CHANGE_SET_H
+
+/**
+ * Collection of modifications to attributes of one object.
+ * Pass it to AdInterface::object_modify() to apply all of
+ * the modifications in one request. The server applies
+ * such request atomically, so either all of modifications
+ * succeed or none of them do.
+ */
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+enum AdChangeType {
+    AdChangeType_Replace,
+    AdChangeType_Add,
+    AdChangeType_Delete,
+};
+
+class AdChange {
+
+public:
+    AdChangeType type;
+    QString attribute;
+    QList<QByteArray> values;
+};
+
+class AdChangeSet {
+
+public:
+    // NOTE: replacing the same attribute again overrides
+    // the previous replacement
+    void replace_values(const QString &attribute, const QList<QByteArray> &values);
+    void replace_value(const QString &attribute, const QByteArray &value);
+    void replace_string(const QString &attribute, const QString &value);
+    void replace_int(const QString &attribute, const int value);
+
+    void add_value(const QString &attribute, const QByteArray &value);
+    void delete_value(const QString &attribute, const QByteArray &value);
+
+    bool is_empty() const;
+    QList<AdChange> changes() const;
+
+private:
+    QList<AdChange> change_list;
+};
+
+#endif /* AD_CHANGE_SET_H */
@@ -21,15 +21,28 @@
 #include "ad_config.h"
 #include "ad_config_p.h"
 
+#include "ad_discovery.h"
 #include "ad_filter.h"
 #include "ad_interface.h"
 #include "ad_object.h"
 #include "ad_utils.h"
 
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
 #include <QLocale>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QVector>
 #include <algorithm>
+#include <functional>
 
 #define ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES "attributeDisplayNames"
 #define ATTRIBUTE_EXTRA_COLUMNS "extraColumns"
@@ -46,11 +59,13 @@
 #define ATTRIBUTE_SYSTEM_MUST_CONTAIN "systemMustContain"
 #define ATTRIBUTE_IS_SINGLE_VALUED "isSingleValued"
 #define ATTRIBUTE_SYSTEM_ONLY "systemOnly"
+#define ATTRIBUTE_IS_MEMBER_OF_PARTIAL_ATTRIBUTE_SET "isMemberOfPartialAttributeSet"
 #define ATTRIBUTE_RANGE_UPPER "rangeUpper"
 #define ATTRIBUTE_AUXILIARY_CLASS "auxiliaryClass"
 #define ATTRIBUTE_SYSTEM_FLAGS "systemFlags"
 #define ATTRIBUTE_LINK_ID "linkID"
 #define ATTRIBUTE_SYSTEM_AUXILIARY_CLASS "systemAuxiliaryClass"
+#define ATTRIBUTE_SCHEMA_INFO "schemaInfo"
 
 #define CLASS_ATTRIBUTE_SCHEMA "attributeSchema"
 #define CLASS_CLASS_SCHEMA "classSchema"
@@ -58,7 +73,26 @@
 
 #define FLAG_ATTR_IS_CONSTRUCTED 0x00000004
 
+// NOTE: increment version when changing cache format or
+// the way config is loaded from server, so that old caches
+// are discarded
+#define CACHE_MAGIC "ADMCCONF"
+#define CACHE_VERSION 3
+
+// Cache is discarded after this long, even if key matches
+#define CACHE_AGE_MAX_SECONDS (7 * 24 * 60 * 60)
+
+#define LOAD_PHASE_CACHE_CHECK "cache check"
+#define LOAD_PHASE_ATTRIBUTE_SCHEMAS "attribute schemas"
+#define LOAD_PHASE_CLASS_SCHEMAS "class schemas"
+#define LOAD_PHASE_DISPLAY_SPECIFIERS "display specifiers"
+#define LOAD_PHASE_UI_SETTINGS "columns and filter containers"
+#define LOAD_PHASE_EXTENDED_RIGHTS "extended rights"
+#define LOAD_PHASE_PROCESSING "processing"
+#define LOAD_PHASE_TOTAL "total"
+
 AdConfigPrivate::AdConfigPrivate() {
+    loaded_from_cache = false;
 }
 
 AdConfig::AdConfig() {
@@ -69,8 +103,57 @@ AdConfig::~AdConfig() {
     delete d;
 }
 
+// Same as AdInterface::search(), but returns false if not
+// all pages were received. Results are replaced, so that
+// a failed phase can be run again.
+bool config_search(AdInterface &ad, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results) {
+    results->clear();
+
+    AdCookie cookie;
+
+    while (true) {
+        const bool success = ad.search_paged(base, scope, filter, attributes, results, &cookie);
+
+        if (!success) {
+            return false;
+        }
+
+        if (!cookie.more_pages()) {
+            return true;
+        }
+    }
+}
+
+// Runs a load phase in a separate thread, on it's own
+// connection
+class LoadPhaseTask final : public QRunnable {
+
+public:
+    LoadPhaseTask(std::function<void(AdInterface &ad)> phase_arg, bool *connected_out_arg) {
+        phase = phase_arg;
+        connected_out = connected_out_arg;
+    }
+
+    void run() override {
+        AdInterface ad;
+
+        *connected_out = ad.is_connected();
+
+        if (ad.is_connected()) {
+            phase(ad);
+        }
+    }
+
+private:
+    std::function<void(AdInterface &ad)> phase;
+    bool *connected_out;
+};
+
 void AdConfig::load(AdInterface &ad, const QLocale &locale) {
-    d->domain = get_default_domain_from_krb5();
+    QElapsedTimer total_timer;
+    total_timer.start();
+
+    d->domain = AdDiscoveryCache::instance()->default_domain();
     d->domain_head = domain_to_domain_dn(d->domain);
 
     d->filter_containers.clear();
@@ -79,8 +162,10 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
     d->class_display_names.clear();
     d->find_attributes.clear();
     d->attribute_display_names.clear();
-    d->attribute_schemas.clear();
-    d->class_schemas.clear();
+    d->column_atoms.clear();
+    d->load_timings.clear();
+    d->load_phase_intervals.clear();
+    d->loaded_from_cache = false;
 
     const QString locale_dir = [this, locale]() {
         const QString locale_code = [locale]() {
@@ -95,115 +180,268 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
         return QString("CN=%1,CN=DisplaySpecifiers,%2").arg(locale_code, configuration_dn());
     }();
 
-    // Attribute schemas
-    {
-        const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_ATTRIBUTE_SCHEMA);
-
-        const QList<QString> attributes = {
-            ATTRIBUTE_LDAP_DISPLAY_NAME,
-            ATTRIBUTE_ATTRIBUTE_SYNTAX,
-            ATTRIBUTE_OM_SYNTAX,
-            ATTRIBUTE_IS_SINGLE_VALUED,
-            ATTRIBUTE_SYSTEM_ONLY,
-            ATTRIBUTE_RANGE_UPPER,
-            ATTRIBUTE_LINK_ID,
-            ATTRIBUTE_SYSTEM_FLAGS,
-        };
+    auto finish_load = [&]() {
+        d->load_timings[LOAD_PHASE_TOTAL] = total_timer.elapsed();
+    };
 
-        const QHash<QString, AdObject> results = ad.search(schema_dn(), SearchScope_Children, filter, attributes);
+    // Load from cache if server data didn't change since
+    // cache was saved, this skips all of the searches below
+    const QString cache_path = d->get_cache_path(locale);
+    const QByteArray cache_key = [&]() {
+        QElapsedTimer timer;
+        timer.start();
 
-        for (const AdObject &object : results.values()) {
-            const QString attribute = object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
-            d->attribute_schemas[attribute] = object;
-        }
+        const QByteArray out = d->get_cache_key(ad, locale, locale_dir);
+        d->load_timings[LOAD_PHASE_CACHE_CHECK] = timer.elapsed();
+
+        return out;
+    }();
+    if (!cache_key.isEmpty() && d->load_cache(cache_path, cache_key)) {
+        d->loaded_from_cache = true;
+
+        finish_load();
+
+        return;
     }
 
-    // Class schemas
-    {
-        const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CLASS_SCHEMA);
-
-        const QList<QString> attributes = {
-            ATTRIBUTE_LDAP_DISPLAY_NAME,
-            ATTRIBUTE_POSSIBLE_SUPERIORS,
-            ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS,
-            ATTRIBUTE_MAY_CONTAIN,
-            ATTRIBUTE_SYSTEM_MAY_CONTAIN,
-            ATTRIBUTE_MUST_CONTAIN,
-            ATTRIBUTE_SYSTEM_MUST_CONTAIN,
-            ATTRIBUTE_AUXILIARY_CLASS,
-            ATTRIBUTE_SYSTEM_AUXILIARY_CLASS,
+    // NOTE: searches below don't depend on each other, so
+    // they are sent in parallel, each on it's own
+    // connection. Phases only collect results, which are
+    // processed after all phases are done. Phases return
+    // false if any of their searches failed.
+    QHash<QString, AdObject> attribute_results;
+    QHash<QString, AdObject> class_results;
+    QHash<QString, AdObject> display_results;
+    QHash<QString, AdObject> ui_results;
+    QHash<QString, AdObject> category_results;
+    QHash<QString, AdObject> rights_results;
+
+    const QString default_display_dn = QString("CN=default-Display,%1").arg(locale_dir);
+    const QString ui_settings_dn = QString("CN=DS-UI-Default-Settings,%1").arg(locale_dir);
+
+    const QList<QString> phase_name_list = {
+        LOAD_PHASE_ATTRIBUTE_SCHEMAS,
+        LOAD_PHASE_CLASS_SCHEMAS,
+        LOAD_PHASE_DISPLAY_SPECIFIERS,
+        LOAD_PHASE_UI_SETTINGS,
+        LOAD_PHASE_EXTENDED_RIGHTS,
+    };
+
+    const QList<std::function<bool(AdInterface &)>> phase_list = {
+        // Attribute schemas
+        [&](AdInterface &phase_ad) {
+            const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_ATTRIBUTE_SCHEMA);
+
+            const QList<QString> attributes = {
+                ATTRIBUTE_LDAP_DISPLAY_NAME,
+                ATTRIBUTE_ATTRIBUTE_SYNTAX,
+                ATTRIBUTE_OM_SYNTAX,
+                ATTRIBUTE_IS_SINGLE_VALUED,
+                ATTRIBUTE_SYSTEM_ONLY,
+                ATTRIBUTE_IS_MEMBER_OF_PARTIAL_ATTRIBUTE_SET,
+                ATTRIBUTE_RANGE_UPPER,
+                ATTRIBUTE_LINK_ID,
+                ATTRIBUTE_SYSTEM_FLAGS,
+            };
+
+            return config_search(phase_ad, schema_dn(), SearchScope_Children, filter, attributes, &attribute_results);
+        },
+
+        // Class schemas
+        [&](AdInterface &phase_ad) {
+            const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CLASS_SCHEMA);
+
+            const QList<QString> attributes = {
+                ATTRIBUTE_LDAP_DISPLAY_NAME,
+                ATTRIBUTE_POSSIBLE_SUPERIORS,
+                ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS,
+                ATTRIBUTE_MAY_CONTAIN,
+                ATTRIBUTE_SYSTEM_MAY_CONTAIN,
+                ATTRIBUTE_MUST_CONTAIN,
+                ATTRIBUTE_SYSTEM_MUST_CONTAIN,
+                ATTRIBUTE_AUXILIARY_CLASS,
+                ATTRIBUTE_SYSTEM_AUXILIARY_CLASS,
+            };
+
+            return config_search(phase_ad, schema_dn(), SearchScope_Children, filter, attributes, &class_results);
+        },
+
+        // Class display specifiers
+        [&](AdInterface &phase_ad) {
+            const QList<QString> attributes = {
+                ATTRIBUTE_CLASS_DISPLAY_NAME,
+                ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES,
+            };
+
+            return config_search(phase_ad, locale_dir, SearchScope_Children, QString(), attributes, &display_results);
+        },
+
+        // Extra columns and filter containers
+        [&](AdInterface &phase_ad) {
+            category_results.clear();
+
+            // NOTE: both objects always exist, so if one of
+            // them is missing, the read failed
+            ui_results = phase_ad.search_objects({default_display_dn, ui_settings_dn}, {ATTRIBUTE_EXTRA_COLUMNS, ATTRIBUTE_FILTER_CONTAINERS});
+            if (!ui_results.contains(default_display_dn) || !ui_results.contains(ui_settings_dn)) {
+                return false;
+            }
+
+            // NOTE: ATTRIBUTE_FILTER_CONTAINERS contains
+            // object *categories* not classes, so need to
+            // get object class from category object. Get
+            // all of them in one search.
+            const QList<QString> categories = d->get_filter_categories(ui_results.value(ui_settings_dn));
+            if (categories.isEmpty()) {
+                return true;
+            }
+
+            const QList<QString> subfilter_list = [&]() {
+                QList<QString> out;
+
+                for (const QString &category : categories) {
+                    out.append(filter_CONDITION(Condition_Equals, ATTRIBUTE_CN, category));
+                }
+
+                return out;
+            }();
+
+            const QString filter = filter_OR(subfilter_list);
+
+            return config_search(phase_ad, schema_dn(), SearchScope_Children, filter, {ATTRIBUTE_CN, ATTRIBUTE_LDAP_DISPLAY_NAME}, &category_results);
+        },
+
+        // Extended rights
+        [&](AdInterface &phase_ad) {
+            const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CONTROL_ACCESS_RIGHT);
+
+            const QList<QString> attributes = {
+                ATTRIBUTE_CN,
+                ATTRIBUTE_RIGHTS_GUID,
+            };
+
+            return config_search(phase_ad, extended_rights_dn(), SearchScope_Children, filter, attributes, &rights_results);
+        },
+    };
+
+    // Wrap phases to measure how long each one took and
+    // when it ran. Each phase writes only to it's own
+    // variables, so there's no need for locking.
+    QVector<qint64> phase_time_list(phase_list.size(), 0);
+    QVector<QPair<qint64, qint64>> phase_interval_list(phase_list.size());
+    QVector<bool> phase_success_list(phase_list.size(), false);
+    qint64 *phase_times = phase_time_list.data();
+    QPair<qint64, qint64> *phase_intervals = phase_interval_list.data();
+    bool *phase_success = phase_success_list.data();
+    auto timed_phase = [&phase_list, &total_timer, phase_times, phase_intervals, phase_success](const int i) {
+        return [&phase_list, &total_timer, phase_times, phase_intervals, phase_success, i](AdInterface &phase_ad) {
+            const qint64 start = total_timer.nsecsElapsed();
+
+            phase_success[i] = phase_list[i](phase_ad);
+
+            const qint64 end = total_timer.nsecsElapsed();
+
+            phase_times[i] = (end - start) / 1000000;
+            phase_intervals[i] = QPair<qint64, qint64>(start, end);
         };
+    };
 
-        const QHash<QString, AdObject> results = ad.search(schema_dn(), SearchScope_Children, filter, attributes);
+    // NOTE: first phase runs on the given connection in
+    // this thread, instead of waiting idly
+    QVector<bool> connected_list(phase_list.size(), false);
+    bool *connected = connected_list.data();
+    {
+        QThreadPool phase_pool;
+        phase_pool.setMaxThreadCount(phase_list.size());
 
-        for (const AdObject &object : results.values()) {
-            const QString object_class = object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
-            d->class_schemas[object_class] = object;
+        for (int i = 1; i < phase_list.size(); i++) {
+            phase_pool.start(new LoadPhaseTask(timed_phase(i), &connected[i]));
         }
+
+        timed_phase(0)(ad);
+        connected[0] = true;
+
+        phase_pool.waitForDone();
     }
 
-    // Class display specifiers
-    // NOTE: can't just store objects for these because the values require a decent amount of preprocessing which is best done once here, not everytime value is requested
-    {
-        const QString filter = QString();
+    // Phases that couldn't connect or failed run again on
+    // the given connection, one after another. First phase
+    // already ran on that connection, so it's not retried.
+    for (int i = 0; i < phase_list.size(); i++) {
+        if (!connected_list[i]) {
+            qDebug() << "Failed to connect for config load phase" << phase_name_list[i] << ", running it on main connection";
+        } else if (!phase_success_list[i] && i != 0) {
+            qDebug() << "Config load phase" << phase_name_list[i] << "failed, running it again on main connection";
+        } else {
+            continue;
+        }
 
-        const QList<QString> search_attributes = {
-            ATTRIBUTE_CLASS_DISPLAY_NAME,
-            ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES,
-        };
+        timed_phase(i)(ad);
+    }
 
-        const QHash<QString, AdObject> results = ad.search(locale_dir, SearchScope_Children, filter, search_attributes);
+    const bool all_phases_success = !phase_success_list.contains(false);
 
-        for (const AdObject &object : results) {
-            const QString dn = object.get_dn();
+    for (int i = 0; i < phase_list.size(); i++) {
+        d->load_timings[phase_name_list[i]] = phase_time_list[i];
+        d->load_phase_intervals[phase_name_list[i]] = phase_interval_list[i];
+    }
 
-            // Display specifier DN is "CN=object-class-Display,CN=..."
-            // Get "object-class" from that
-            const QString object_class = [dn]() {
-                const QString rdn = dn.split(",")[0];
-                QString out = rdn;
-                out.remove("CN=", Qt::CaseInsensitive);
-                out.remove("-Display");
+    QElapsedTimer process_timer;
+    process_timer.start();
 
-                return out;
-            }();
+    d->compile_attribute_schemas(attribute_results.values());
+    d->compile_class_schemas(class_results.values());
+
+    // Class display specifiers
+    // NOTE: can't just store objects for these because the values require a decent amount of preprocessing which is best done once here, not everytime value is requested
+    for (const AdObject &object : display_results) {
+        const QString dn = object.get_dn();
+
+        // Display specifier DN is "CN=object-class-Display,CN=..."
+        // Get "object-class" from that
+        const QString object_class = [dn]() {
+            const QString rdn = dn.split(",")[0];
+            QString out = rdn;
+            out.remove("CN=", Qt::CaseInsensitive);
+            out.remove("-Display");
+
+            return out;
+        }();
+
+        if (object.contains(ATTRIBUTE_CLASS_DISPLAY_NAME)) {
+            d->class_display_names[object_class] = object.get_string(ATTRIBUTE_CLASS_DISPLAY_NAME);
+        }
 
-            if (object.contains(ATTRIBUTE_CLASS_DISPLAY_NAME)) {
-                d->class_display_names[object_class] = object.get_string(ATTRIBUTE_CLASS_DISPLAY_NAME);
+        if (object.contains(ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES)) {
+            const QList<QString> display_names = object.get_strings(ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES);
+
+            for (const auto &display_name_pair : display_names) {
+                const QList<QString> split = display_name_pair.split(",");
+                const QString attribute_name = split[0];
+                const QString display_name = split[1];
+
+                d->attribute_display_names[object_class][attribute_name] = display_name;
             }
 
-            if (object.contains(ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES)) {
-                const QList<QString> display_names = object.get_strings(ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES);
+            d->find_attributes[object_class] = [object_class, display_names]() {
+                QList<QString> out;
 
                 for (const auto &display_name_pair : display_names) {
                     const QList<QString> split = display_name_pair.split(",");
-                    const QString attribute_name = split[0];
-                    const QString display_name = split[1];
+                    const QString attribute = split[0];
 
-                    d->attribute_display_names[object_class][attribute_name] = display_name;
+                    out.append(attribute);
                 }
 
-                d->find_attributes[object_class] = [object_class, display_names]() {
-                    QList<QString> out;
-
-                    for (const auto &display_name_pair : display_names) {
-                        const QList<QString> split = display_name_pair.split(",");
-                        const QString attribute = split[0];
-
-                        out.append(attribute);
-                    }
-
-                    return out;
-                }();
-            }
+                return out;
+            }();
         }
     }
 
     // Columns
     {
         const QList<QString> columns_values = [&] {
-            const QString dn = QString("CN=default-Display,%1").arg(locale_dir);
-            const AdObject object = ad.search_object(dn, {ATTRIBUTE_EXTRA_COLUMNS});
+            const AdObject object = ui_results.value(default_display_dn);
 
             // NOTE: order as stored in attribute is reversed. Order is not sorted alphabetically so can't just sort.
             QList<QString> extra_columns = object.get_strings(ATTRIBUTE_EXTRA_COLUMNS);
@@ -239,31 +477,32 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
         add_custom(ATTRIBUTE_DESCRIPTION, QCoreApplication::translate("AdConfig", "Description"));
         add_custom(ATTRIBUTE_OBJECT_CLASS, QCoreApplication::translate("AdConfig", "Class"));
         add_custom(ATTRIBUTE_NAME, QCoreApplication::translate("AdConfig", "Name"));
+
+        for (const QString &attribute : d->columns) {
+            const AdAtom atom = AdAtomTable::instance()->intern(attribute);
+            d->column_atoms.append(atom);
+        }
     }
 
     d->filter_containers = [&] {
         QList<QString> out;
 
-        const QString ui_settings_dn = QString("CN=DS-UI-Default-Settings,%1").arg(locale_dir);
-        const AdObject object = ad.search_object(ui_settings_dn, {ATTRIBUTE_FILTER_CONTAINERS});
+        // NOTE: categories are matched to results by cn
+        // to keep the order in which they are listed
+        const QHash<QString, QString> category_to_class = [&]() {
+            QHash<QString, QString> category_map;
 
-        // TODO: dns-Zone category is mispelled in
-        // ATTRIBUTE_FILTER_CONTAINERS, no idea why, might
-        // just be on this domain version
-        const QList<QString> categories = [object]() {
-            QList<QString> categories_out = object.get_strings(ATTRIBUTE_FILTER_CONTAINERS);
-            categories_out.replaceInStrings("dns-Zone", "Dns-Zone");
+            for (const AdObject &object : category_results) {
+                const QString cn = object.get_string(ATTRIBUTE_CN).toLower();
+                category_map[cn] = object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
+            }
 
-            return categories_out;
+            return category_map;
         }();
 
-        // NOTE: ATTRIBUTE_FILTER_CONTAINERS contains object
-        // *categories* not classes, so need to get object
-        // class from category object
+        const QList<QString> categories = d->get_filter_categories(ui_results.value(ui_settings_dn));
         for (const auto &object_category : categories) {
-            const QString category_dn = QString("CN=%1,%2").arg(object_category, schema_dn());
-            const AdObject category_object = ad.search_object(category_dn, {ATTRIBUTE_LDAP_DISPLAY_NAME});
-            const QString object_class = category_object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
+            const QString object_class = category_to_class.value(object_category.toLower());
 
             out.append(object_class);
         }
@@ -280,18 +519,7 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
     d->right_to_guid_map = [&]() {
         QHash<QString, QString> out;
 
-        const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CONTROL_ACCESS_RIGHT);
-
-        const QList<QString> attributes = {
-            ATTRIBUTE_CN,
-            ATTRIBUTE_RIGHTS_GUID,
-        };
-
-        const QString search_base = extended_rights_dn();
-
-        const QHash<QString, AdObject> search_results = ad.search(search_base, SearchScope_Children, filter, attributes);
-
-        for (const AdObject &object : search_results.values()) {
+        for (const AdObject &object : rights_results) {
             const QString cn = object.get_string(ATTRIBUTE_CN);
             const QString guid = object.get_string(ATTRIBUTE_RIGHTS_GUID);
 
@@ -300,6 +528,29 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
 
         return out;
     }();
+
+    d->load_timings[LOAD_PHASE_PROCESSING] = process_timer.elapsed();
+
+    // NOTE: don't save incomplete config, if some searches
+    // failed
+    const bool loaded_schema = (!d->attribute_list.isEmpty() && !d->class_list.isEmpty());
+    if (!cache_key.isEmpty() && all_phases_success && loaded_schema) {
+        d->save_cache(cache_path, cache_key);
+    }
+
+    finish_load();
+}
+
+QHash<QString, qint64> AdConfig::get_load_timings() const {
+    return d->load_timings;
+}
+
+QHash<QString, QPair<qint64, qint64>> AdConfig::get_load_phase_intervals() const {
+    return d->load_phase_intervals;
+}
+
+bool AdConfig::loaded_from_cache() const {
+    return d->loaded_from_cache;
 }
 
 QString AdConfig::domain() const {
@@ -327,8 +578,8 @@ QString AdConfig::extended_rights_dn() const {
 }
 
 QString AdConfig::get_attribute_display_name(const Attribute &attribute, const ObjectClass &objectClass) const {
-    if (d->attribute_display_names.contains(objectClass) && d->attribute_display_names[objectClass].contains(attribute)) {
-        const QString display_name = d->attribute_display_names[objectClass][attribute];
+    if (d->attribute_display_names.contains(objectClass) && d->attribute_display_names.value(objectClass).contains(attribute)) {
+        const QString display_name = d->attribute_display_names.value(objectClass).value(attribute);
 
         return display_name;
     }
@@ -363,6 +614,10 @@ QList<QString> AdConfig::get_columns() const {
     return d->columns;
 }
 
+QList<AdAtom> AdConfig::get_column_atoms() const {
+    return d->column_atoms;
+}
+
 QString AdConfig::get_column_display_name(const Attribute &attribute) const {
     return d->column_display_names.value(attribute, attribute);
 }
@@ -380,59 +635,51 @@ QList<QString> AdConfig::get_filter_containers() const {
 }
 
 QList<QString> AdConfig::get_possible_superiors(const QList<ObjectClass> &object_classes) const {
-    QList<QString> out;
+    QBitArray bits(d->class_list.size());
 
-    for (const QString &object_class : object_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        out += schema.get_strings(ATTRIBUTE_POSSIBLE_SUPERIORS);
-        out += schema.get_strings(ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS);
+    for (const SchemaClass *schema_class : d->get_classes(object_classes)) {
+        bits |= schema_class->possible_superiors;
     }
 
-    out.removeDuplicates();
+    QList<QString> out;
+
+    for (int i = 0; i < bits.size(); i++) {
+        if (bits.testBit(i)) {
+            out.append(d->class_list[i]);
+        }
+    }
 
     return out;
 }
 
 QList<QString> AdConfig::get_optional_attributes(const QList<QString> &object_classes) const {
-    const QList<QString> all_classes = d->add_auxiliary_classes(object_classes);
-
-    QList<QString> attributes;
+    QBitArray bits(d->attribute_list.size());
 
-    for (const auto &object_class : all_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        attributes += schema.get_strings(ATTRIBUTE_MAY_CONTAIN);
-        attributes += schema.get_strings(ATTRIBUTE_SYSTEM_MAY_CONTAIN);
+    for (const SchemaClass *schema_class : d->get_classes(object_classes)) {
+        bits |= schema_class->may_contain;
     }
 
-    attributes.removeDuplicates();
-
-    return attributes;
+    return d->attributes_from_bits(bits);
 }
 
 QList<QString> AdConfig::get_mandatory_attributes(const QList<QString> &object_classes) const {
-    const QList<QString> all_classes = d->add_auxiliary_classes(object_classes);
-
-    QList<QString> attributes;
+    QBitArray bits(d->attribute_list.size());
 
-    for (const auto &object_class : all_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        attributes += schema.get_strings(ATTRIBUTE_MUST_CONTAIN);
-        attributes += schema.get_strings(ATTRIBUTE_SYSTEM_MUST_CONTAIN);
+    for (const SchemaClass *schema_class : d->get_classes(object_classes)) {
+        bits |= schema_class->must_contain;
     }
 
-    attributes.removeDuplicates();
-
-    return attributes;
+    return d->attributes_from_bits(bits);
 }
 
 QList<QString> AdConfig::get_find_attributes(const QString &object_class) const {
     return d->find_attributes.value(object_class, QList<QString>());
 }
 
-AttributeType AdConfig::get_attribute_type(const QString &attribute) const {
+AttributeType attribute_type_from_schema(const AdObject &schema) {
     // NOTE: replica of: https://docs.microsoft.com/en-us/openspecs/windows_protocols/ms-adts/7cda533e-d7a4-4aec-a517-91d02ff4a1aa
     // syntax -> om syntax list -> type
-    static QHash<QString, QHash<QString, AttributeType>> type_map = {
+    static const QHash<QString, QHash<QString, AttributeType>> type_map = {
         {"2.5.5.8", {{"1", AttributeType_Boolean}}},
         {"2.5.5.9",
             {
@@ -464,40 +711,43 @@ AttributeType AdConfig::get_attribute_type(const QString &attribute) const {
         {"2.5.5.1", {{"127", AttributeType_DSDN}}},
     };
 
-    const AdObject schema = d->attribute_schemas[attribute];
-
     const QString attribute_syntax = schema.get_string(ATTRIBUTE_ATTRIBUTE_SYNTAX);
     const QString om_syntax = schema.get_string(ATTRIBUTE_OM_SYNTAX);
 
-    if (type_map.contains(attribute_syntax) && type_map[attribute_syntax].contains(om_syntax)) {
-        return type_map[attribute_syntax][om_syntax];
+    if (type_map.contains(attribute_syntax) && type_map.value(attribute_syntax).contains(om_syntax)) {
+        return type_map.value(attribute_syntax).value(om_syntax);
     } else {
         return AttributeType_StringCase;
     }
 }
 
+AttributeType AdConfig::get_attribute_type(const QString &attribute) const {
+    return get_attribute_type(AdAtomTable::instance()->find(attribute));
+}
+
+AttributeType AdConfig::get_attribute_type(const AdAtom attribute) const {
+    return d->get_attribute(attribute).type;
+}
+
 LargeIntegerSubtype AdConfig::get_attribute_large_integer_subtype(const QString &attribute) const {
-    // Manually remap large integer types to subtypes
-    static const QList<QString> datetimes = {
-        ATTRIBUTE_ACCOUNT_EXPIRES,
-        ATTRIBUTE_LAST_LOGON,
-        ATTRIBUTE_LAST_LOGON_TIMESTAMP,
-        ATTRIBUTE_PWD_LAST_SET,
-        ATTRIBUTE_LOCKOUT_TIME,
-        ATTRIBUTE_BAD_PWD_TIME,
-    };
-    static const QList<QString> timespans = {
-        ATTRIBUTE_MAX_PWD_AGE,
-        ATTRIBUTE_MIN_PWD_AGE,
-        ATTRIBUTE_LOCKOUT_DURATION,
-    };
+    return get_attribute_large_integer_subtype(AdAtomTable::instance()->find(attribute));
+}
 
-    if (datetimes.contains(attribute)) {
-        return LargeIntegerSubtype_Datetime;
-    } else if (timespans.contains(attribute)) {
-        return LargeIntegerSubtype_Timespan;
-    } else {
-        return LargeIntegerSubtype_Integer;
+LargeIntegerSubtype AdConfig::get_attribute_large_integer_subtype(const AdAtom attribute) const {
+    // Manually remap large integer types to subtypes
+    switch (attribute) {
+        case ATOM_ACCOUNT_EXPIRES:
+        case ATOM_LAST_LOGON:
+        case ATOM_LAST_LOGON_TIMESTAMP:
+        case ATOM_PWD_LAST_SET:
+        case ATOM_LOCKOUT_TIME:
+        case ATOM_BAD_PWD_TIME: return LargeIntegerSubtype_Datetime;
+
+        case ATOM_MAX_PWD_AGE:
+        case ATOM_MIN_PWD_AGE:
+        case ATOM_LOCKOUT_DURATION: return LargeIntegerSubtype_Timespan;
+
+        default: return LargeIntegerSubtype_Integer;
     }
 }
 
@@ -514,31 +764,29 @@ bool AdConfig::get_attribute_is_number(const QString &attribute) const {
 }
 
 bool AdConfig::get_attribute_is_single_valued(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_bool(ATTRIBUTE_IS_SINGLE_VALUED);
+    return d->get_attribute_flag(attribute, SchemaAttributeFlag_SingleValued);
 }
 
 bool AdConfig::get_attribute_is_system_only(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_bool(ATTRIBUTE_SYSTEM_ONLY);
+    return d->get_attribute_flag(attribute, SchemaAttributeFlag_SystemOnly);
+}
+
+bool AdConfig::get_attribute_is_in_gc(const QString &attribute) const {
+    return d->get_attribute_flag(attribute, SchemaAttributeFlag_InGc);
 }
 
 int AdConfig::get_attribute_range_upper(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_int(ATTRIBUTE_RANGE_UPPER);
+    const AdAtom atom = AdAtomTable::instance()->find(attribute);
+
+    return d->get_attribute(atom).range_upper;
 }
 
 bool AdConfig::get_attribute_is_backlink(const QString &attribute) const {
-    if (d->attribute_schemas[attribute].contains(ATTRIBUTE_LINK_ID)) {
-        const int link_id = d->attribute_schemas[attribute].get_int(ATTRIBUTE_LINK_ID);
-        const bool link_id_is_odd = (link_id % 2 != 0);
-
-        return link_id_is_odd;
-    } else {
-        return false;
-    }
+    return d->get_attribute_flag(attribute, SchemaAttributeFlag_Backlink);
 }
 
 bool AdConfig::get_attribute_is_constructed(const QString &attribute) const {
-    const int system_flags = d->attribute_schemas[attribute].get_int(ATTRIBUTE_SYSTEM_FLAGS);
-    return bit_is_set(system_flags, FLAG_ATTR_IS_CONSTRUCTED);
+    return d->get_attribute_flag(attribute, SchemaAttributeFlag_Constructed);
 }
 
 QString AdConfig::get_right_guid(const QString &right_cn) const {
@@ -558,18 +806,465 @@ QList<QString> AdConfig::get_noncontainer_classes() {
     return out;
 }
 
-QList<QString> AdConfigPrivate::add_auxiliary_classes(const QList<QString> &object_classes) const {
-    QList<QString> out;
+SchemaAttribute::SchemaAttribute() {
+    // NOTE: attributes that are not in schema default to
+    // string type
+    type = AttributeType_StringCase;
+    flags = 0;
+    range_upper = 0;
+}
+
+void AdConfigPrivate::compile_attribute_schemas(const QList<AdObject> &schema_list) {
+    attribute_list.clear();
+
+    for (const AdObject &schema : schema_list) {
+        const QString attribute = schema.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
+        const AdAtom atom = AdAtomTable::instance()->intern(attribute);
+
+        // NOTE: atoms in between may belong to attributes
+        // that are not in schema, those get default entries
+        if (atom >= attribute_list.size()) {
+            attribute_list.resize(atom + 1);
+        }
+
+        SchemaAttribute &out = attribute_list[atom];
+        out.type = attribute_type_from_schema(schema);
+        out.range_upper = schema.get_int(ATTRIBUTE_RANGE_UPPER);
+        out.flags = 0;
+
+        if (schema.get_bool(ATTRIBUTE_IS_SINGLE_VALUED)) {
+            out.flags |= SchemaAttributeFlag_SingleValued;
+        }
+
+        if (schema.get_bool(ATTRIBUTE_SYSTEM_ONLY)) {
+            out.flags |= SchemaAttributeFlag_SystemOnly;
+        }
+
+        if (schema.get_bool(ATTRIBUTE_IS_MEMBER_OF_PARTIAL_ATTRIBUTE_SET)) {
+            out.flags |= SchemaAttributeFlag_InGc;
+        }
+
+        // NOTE: backlinks have odd link id's
+        if (schema.contains(ATTRIBUTE_LINK_ID) && schema.get_int(ATTRIBUTE_LINK_ID) % 2 != 0) {
+            out.flags |= SchemaAttributeFlag_Backlink;
+        }
+
+        if (bit_is_set(schema.get_int(ATTRIBUTE_SYSTEM_FLAGS), FLAG_ATTR_IS_CONSTRUCTED)) {
+            out.flags |= SchemaAttributeFlag_Constructed;
+        }
+    }
+}
 
-    out += object_classes;
+// NOTE: must be called after compile_attribute_schemas()
+void AdConfigPrivate::compile_class_schemas(const QList<AdObject> &schema_list) {
+    class_list.clear();
+    class_index_map.clear();
+    class_table.clear();
 
-    for (const auto &object_class : object_classes) {
-        const AdObject schema = class_schemas[object_class];
-        out += schema.get_strings(ATTRIBUTE_AUXILIARY_CLASS);
-        out += schema.get_strings(ATTRIBUTE_SYSTEM_AUXILIARY_CLASS);
+    for (const AdObject &schema : schema_list) {
+        const QString object_class = schema.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
+
+        class_index_map[object_class] = class_list.size();
+        class_list.append(object_class);
     }
 
-    out.removeDuplicates();
+    auto get_attribute_bits = [&](const AdObject &schema, const QString &attribute_a, const QString &attribute_b) {
+        const QList<QString> value_list = schema.get_strings(attribute_a) + schema.get_strings(attribute_b);
+
+        QList<AdAtom> atom_list;
+        for (const QString &value : value_list) {
+            const AdAtom atom = AdAtomTable::instance()->intern(value);
+            atom_list.append(atom);
+
+            if (atom >= attribute_list.size()) {
+                attribute_list.resize(atom + 1);
+            }
+        }
+
+        // NOTE: bits are resized to final size after all
+        // classes are compiled
+        QBitArray out(attribute_list.size());
+        for (const AdAtom atom : atom_list) {
+            out.setBit(atom);
+        }
+
+        return out;
+    };
+
+    auto get_class_bits = [&](const AdObject &schema, const QString &attribute_a, const QString &attribute_b) {
+        const QList<QString> value_list = schema.get_strings(attribute_a) + schema.get_strings(attribute_b);
+
+        QBitArray out(class_list.size());
+        for (const QString &value : value_list) {
+            if (class_index_map.contains(value)) {
+                out.setBit(class_index_map[value]);
+            }
+        }
+
+        return out;
+    };
+
+    // Direct sets, as they are in schema
+    for (const AdObject &schema : schema_list) {
+        SchemaClass schema_class;
+        schema_class.may_contain = get_attribute_bits(schema, ATTRIBUTE_MAY_CONTAIN, ATTRIBUTE_SYSTEM_MAY_CONTAIN);
+        schema_class.must_contain = get_attribute_bits(schema, ATTRIBUTE_MUST_CONTAIN, ATTRIBUTE_SYSTEM_MUST_CONTAIN);
+        schema_class.possible_superiors = get_class_bits(schema, ATTRIBUTE_POSSIBLE_SUPERIORS, ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS);
+        schema_class.auxiliary_classes = get_class_bits(schema, ATTRIBUTE_AUXILIARY_CLASS, ATTRIBUTE_SYSTEM_AUXILIARY_CLASS);
+
+        class_table.append(schema_class);
+    }
+
+    for (SchemaClass &schema_class : class_table) {
+        schema_class.may_contain.resize(attribute_list.size());
+        schema_class.must_contain.resize(attribute_list.size());
+    }
+
+    // Close auxiliary sets over auxiliary classes of
+    // auxiliary classes
+    const QVector<SchemaClass> direct_table = class_table;
+    for (int i = 0; i < class_table.size(); i++) {
+        QBitArray &closure = class_table[i].auxiliary_classes;
+
+        QList<int> stack;
+        for (int j = 0; j < closure.size(); j++) {
+            if (closure.testBit(j)) {
+                stack.append(j);
+            }
+        }
+
+        while (!stack.isEmpty()) {
+            const int aux_i = stack.takeLast();
+            const QBitArray &aux_direct = direct_table[aux_i].auxiliary_classes;
+
+            for (int j = 0; j < aux_direct.size(); j++) {
+                if (aux_direct.testBit(j) && !closure.testBit(j)) {
+                    closure.setBit(j);
+                    stack.append(j);
+                }
+            }
+        }
+
+        // Add attributes of all auxiliary classes
+        for (int j = 0; j < closure.size(); j++) {
+            if (closure.testBit(j)) {
+                class_table[i].may_contain |= direct_table[j].may_contain;
+                class_table[i].must_contain |= direct_table[j].must_contain;
+            }
+        }
+    }
+}
+
+const SchemaAttribute &AdConfigPrivate::get_attribute(const AdAtom atom) const {
+    static const SchemaAttribute default_attribute;
+
+    if (atom >= 0 && atom < attribute_list.size()) {
+        return attribute_list[atom];
+    } else {
+        return default_attribute;
+    }
+}
+
+bool AdConfigPrivate::get_attribute_flag(const QString &attribute, const SchemaAttributeFlag flag) const {
+    const AdAtom atom = AdAtomTable::instance()->find(attribute);
+    const int flags = get_attribute(atom).flags;
+
+    return ((flags & flag) != 0);
+}
+
+QList<const SchemaClass *> AdConfigPrivate::get_classes(const QList<ObjectClass> &object_classes) const {
+    QList<const SchemaClass *> out;
+
+    for (const ObjectClass &object_class : object_classes) {
+        if (class_index_map.contains(object_class)) {
+            const int index = class_index_map[object_class];
+            out.append(&class_table[index]);
+        }
+    }
+
+    return out;
+}
+
+QList<Attribute> AdConfigPrivate::attributes_from_bits(const QBitArray &bits) const {
+    QList<Attribute> out;
+
+    for (int atom = 0; atom < bits.size(); atom++) {
+        if (bits.testBit(atom)) {
+            out.append(AdAtomTable::instance()->name(atom));
+        }
+    }
+
+    return out;
+}
+
+// NOTE: each locale has it's own file, so that switching
+// locale back and forth doesn't discard the cache
+QString AdConfigPrivate::get_cache_path(const QLocale &locale) const {
+    const QString cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    return QString("%1/adconfig/%2-%3.cache").arg(cache_dir, domain.toLower(), locale.name());
+}
+
+// Cache key is made from values which change when cached
+// data changes on the server. schemaInfo changes whenever
+// schema is modified. Display specifiers and extended
+// rights are child objects, so their containers don't
+// change when they are modified. For those, key contains
+// the highest uSNChanged and the number of children.
+// uSNChanged is local to each DC, so key also contains the
+// DC and cache is discarded when connecting to another DC.
+// Locale is included because several locales share one
+// display specifier dir.
+QByteArray AdConfigPrivate::get_cache_key(AdInterface &ad, const QLocale &locale, const QString &locale_dir) const {
+    const QString dc = ad.connected_dc();
+    if (dc.isEmpty()) {
+        return QByteArray();
+    }
+
+    const QString schema_dn = QString("CN=Schema,CN=Configuration,%1").arg(domain_head);
+    const QString extended_rights_dn = QString("CN=Extended-Rights,CN=Configuration,%1").arg(domain_head);
+
+    const AdObject schema_object = ad.search_object(schema_dn, {ATTRIBUTE_SCHEMA_INFO});
+    const QByteArray schema_info = schema_object.get_value(ATTRIBUTE_SCHEMA_INFO);
+    if (schema_info.isEmpty()) {
+        return QByteArray();
+    }
+
+    QByteArray out;
+    out.append(locale.name().toUtf8());
+    out.append('\n');
+    out.append(locale_dir.toUtf8());
+    out.append('\n');
+    out.append(dc.toLower().toUtf8());
+    out.append('\n');
+    out.append(schema_info.toHex());
+
+    // NOTE: locale dir contains class display specifiers,
+    // including "default-Display", and
+    // "DS-UI-Default-Settings"
+    const QList<QString> parent_list = {
+        locale_dir,
+        extended_rights_dn,
+    };
+
+    for (const QString &parent : parent_list) {
+        const QHash<QString, AdObject> children = ad.search(parent, SearchScope_Children, QString(), {ATTRIBUTE_USN_CHANGED});
+        if (children.isEmpty()) {
+            return QByteArray();
+        }
+
+        qint64 usn_max = 0;
+        for (const AdObject &child : children) {
+            const qint64 usn = child.get_string(ATTRIBUTE_USN_CHANGED).toLongLong();
+            usn_max = qMax(usn_max, usn);
+        }
+
+        out.append('\n');
+        out.append(QByteArray::number(usn_max));
+        out.append('\n');
+        out.append(QByteArray::number(children.size()));
+    }
+
+    return out;
+}
+
+bool AdConfigPrivate::load_cache(const QString &path, const QByteArray &key) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // NOTE: map file instead of reading it into a buffer
+    const qint64 size = file.size();
+    uchar *mapped = file.map(0, size);
+    if (mapped == nullptr) {
+        return false;
+    }
+
+    const QByteArray data = QByteArray::fromRawData((const char *) mapped, size);
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    QByteArray magic;
+    qint32 version;
+    QByteArray cached_key;
+    qint64 saved_time;
+    stream >> magic >> version >> cached_key >> saved_time;
+
+    // NOTE: key can't detect every change, for example
+    // changes of objects that were deleted and replaced,
+    // so cache is also reloaded after some time
+    const qint64 age = QDateTime::currentSecsSinceEpoch() - saved_time;
+    const bool too_old = (age < 0 || age > CACHE_AGE_MAX_SECONDS);
+
+    const bool header_ok = (stream.status() == QDataStream::Ok && magic == CACHE_MAGIC && version == CACHE_VERSION && cached_key == key && !too_old);
+    if (!header_ok) {
+        file.unmap(mapped);
+
+        return false;
+    }
+
+    // NOTE: read into local variables, so that config is
+    // not left half-loaded if cache is corrupted
+    QList<ObjectClass> cached_filter_containers;
+    QList<Attribute> cached_columns;
+    QHash<Attribute, QString> cached_column_display_names;
+    QHash<ObjectClass, QString> cached_class_display_names;
+    QHash<ObjectClass, QList<Attribute>> cached_find_attributes;
+    QHash<ObjectClass, QHash<Attribute, QString>> cached_attribute_display_names;
+    QHash<QString, QString> cached_right_to_guid_map;
+    QList<QString> attribute_name_list;
+    QList<ObjectClass> cached_class_list;
+
+    stream >> cached_filter_containers >> cached_columns >> cached_column_display_names >> cached_class_display_names >> cached_find_attributes >> cached_attribute_display_names >> cached_right_to_guid_map;
+    stream >> attribute_name_list;
+
+    QVector<SchemaAttribute> cached_attribute_list;
+    for (int i = 0; i < attribute_name_list.size() && stream.status() == QDataStream::Ok; i++) {
+        qint32 type;
+        qint32 flags;
+        qint32 range_upper;
+        stream >> type >> flags >> range_upper;
+
+        SchemaAttribute attribute;
+        attribute.type = (AttributeType) type;
+        attribute.flags = flags;
+        attribute.range_upper = range_upper;
+
+        cached_attribute_list.append(attribute);
+    }
+
+    stream >> cached_class_list;
+
+    QVector<SchemaClass> cached_class_table;
+    for (int i = 0; i < cached_class_list.size() && stream.status() == QDataStream::Ok; i++) {
+        SchemaClass schema_class;
+        stream >> schema_class.may_contain >> schema_class.must_contain >> schema_class.possible_superiors >> schema_class.auxiliary_classes;
+
+        cached_class_table.append(schema_class);
+    }
+
+    const bool read_ok = (stream.status() == QDataStream::Ok);
+
+    file.unmap(mapped);
+
+    if (!read_ok) {
+        qDebug() << "Config cache is corrupted:" << path;
+
+        return false;
+    }
+
+    // Atoms are only valid within one process, so cached
+    // attributes are indexed by position in name list.
+    // Intern names and move attributes to their atoms.
+    QVector<AdAtom> atom_list;
+    attribute_list.clear();
+    for (int i = 0; i < attribute_name_list.size(); i++) {
+        const AdAtom atom = AdAtomTable::instance()->intern(attribute_name_list[i]);
+        atom_list.append(atom);
+
+        if (atom >= attribute_list.size()) {
+            attribute_list.resize(atom + 1);
+        }
+
+        attribute_list[atom] = cached_attribute_list[i];
+    }
+
+    auto remap_bits = [&](const QBitArray &bits) {
+        QBitArray out(attribute_list.size());
+
+        for (int i = 0; i < bits.size() && i < atom_list.size(); i++) {
+            if (bits.testBit(i)) {
+                out.setBit(atom_list[i]);
+            }
+        }
+
+        return out;
+    };
+
+    for (SchemaClass &schema_class : cached_class_table) {
+        schema_class.may_contain = remap_bits(schema_class.may_contain);
+        schema_class.must_contain = remap_bits(schema_class.must_contain);
+    }
+
+    filter_containers = cached_filter_containers;
+    columns = cached_columns;
+    column_display_names = cached_column_display_names;
+    class_display_names = cached_class_display_names;
+    find_attributes = cached_find_attributes;
+    attribute_display_names = cached_attribute_display_names;
+    right_to_guid_map = cached_right_to_guid_map;
+
+    class_list = cached_class_list;
+    class_table = cached_class_table;
+    class_index_map.clear();
+    for (int i = 0; i < class_list.size(); i++) {
+        class_index_map[class_list[i]] = i;
+    }
+
+    column_atoms.clear();
+    for (const QString &attribute : columns) {
+        column_atoms.append(AdAtomTable::instance()->intern(attribute));
+    }
+
+    return true;
+}
+
+void AdConfigPrivate::save_cache(const QString &path, const QByteArray &key) const {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // NOTE: save file replaces old cache only after all of
+    // new cache is written
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open config cache for writing:" << path;
+
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << QByteArray(CACHE_MAGIC) << (qint32) CACHE_VERSION << key << (qint64) QDateTime::currentSecsSinceEpoch();
+    stream << filter_containers << columns << column_display_names << class_display_names << find_attributes << attribute_display_names << right_to_guid_map;
+
+    // Attributes are saved by name, see load_cache()
+    const QList<QString> attribute_name_list = [&]() {
+        QList<QString> out;
+
+        for (int atom = 0; atom < attribute_list.size(); atom++) {
+            out.append(AdAtomTable::instance()->name(atom));
+        }
+
+        return out;
+    }();
+
+    stream << attribute_name_list;
+
+    for (const SchemaAttribute &attribute : attribute_list) {
+        stream << (qint32) attribute.type << (qint32) attribute.flags << (qint32) attribute.range_upper;
+    }
+
+    stream << class_list;
+
+    for (const SchemaClass &schema_class : class_table) {
+        stream << schema_class.may_contain << schema_class.must_contain << schema_class.possible_superiors << schema_class.auxiliary_classes;
+    }
+
+    if (!file.commit()) {
+        qDebug() << "Failed to save config cache:" << path;
+    }
+}
+
+// NOTE: categories are names of classSchema objects, not
+// class names
+QList<QString> AdConfigPrivate::get_filter_categories(const AdObject &ui_settings) const {
+    QList<QString> out = ui_settings.get_strings(ATTRIBUTE_FILTER_CONTAINERS);
+
+    // TODO: dns-Zone category is mispelled in
+    // ATTRIBUTE_FILTER_CONTAINERS, no idea why, might
+    // just be on this domain version
+    out.replaceInStrings("dns-Zone", "Dns-Zone");
 
     return out;
 }
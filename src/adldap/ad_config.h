@@ -27,6 +27,7 @@
  * loaded once to avoid unnecessary server requests.
  */
 
+#include "ad_atom.h"
 #include "ad_defines.h"
 
 class AdConfigPrivate;
@@ -47,8 +48,25 @@ public:
     AdConfig();
     ~AdConfig();
 
+    // NOTE: independent searches are done in parallel, on
+    // separate connections, so load takes about as long as
+    // the slowest search
     void load(AdInterface &ad, const QLocale &locale);
 
+    // Durations of load phases in milliseconds, by phase
+    // name. Phases run in parallel, so "total" is less
+    // than the sum of all phases.
+    QHash<QString, qint64> get_load_timings() const;
+
+    // Start and end of load phases in nanoseconds since
+    // start of load, by phase name. Empty if config was
+    // loaded from cache.
+    QHash<QString, QPair<qint64, qint64>> get_load_phase_intervals() const;
+
+    // True if last load() was done from persistent cache,
+    // without loading config from server
+    bool loaded_from_cache() const;
+
     QString domain() const;
     QString domain_head() const;
     QString configuration_dn() const;
@@ -61,6 +79,8 @@ public:
     QString get_class_display_name(const ObjectClass &objectClass) const;
 
     QList<Attribute> get_columns() const;
+    // Same as get_columns(), but returns atoms
+    QList<AdAtom> get_column_atoms() const;
     QString get_column_display_name(const Attribute &attribute) const;
     int get_column_index(const QString &attribute) const;
 
@@ -73,10 +93,15 @@ public:
     QList<Attribute> get_find_attributes(const ObjectClass &object_class) const;
 
     AttributeType get_attribute_type(const Attribute &attribute) const;
+    AttributeType get_attribute_type(const AdAtom attribute) const;
     LargeIntegerSubtype get_attribute_large_integer_subtype(const Attribute &attribute) const;
+    LargeIntegerSubtype get_attribute_large_integer_subtype(const AdAtom attribute) const;
     bool get_attribute_is_number(const Attribute &attribute) const;
     bool get_attribute_is_single_valued(const Attribute &attribute) const;
     bool get_attribute_is_system_only(const Attribute &attribute) const;
+    // Returns true if attribute is replicated to Global
+    // Catalog
+    bool get_attribute_is_in_gc(const Attribute &attribute) const;
     int get_attribute_range_upper(const Attribute &attribute) const;
     bool get_attribute_is_backlink(const Attribute &attribute) const;
     bool get_attribute_is_constructed(const Attribute &attribute) const;
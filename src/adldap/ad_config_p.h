@@ -21,17 +21,56 @@
 #ifndef AD_CONFIG_P_H
 #define AD_CONFIG_P_H
 
+#include "ad_atom.h"
 #include "ad_object.h"
 
+#include <QBitArray>
 #include <QByteArray>
 #include <QHash>
 #include <QList>
 #include <QString>
+#include <QVector>
 
 // NOTE: name strings to reduce confusion
 typedef QString ObjectClass;
 typedef QString Attribute;
 
+class AdInterface;
+class QLocale;
+
+enum SchemaAttributeFlag {
+    SchemaAttributeFlag_SingleValued = 0x01,
+    SchemaAttributeFlag_SystemOnly = 0x02,
+    SchemaAttributeFlag_InGc = 0x04,
+    SchemaAttributeFlag_Backlink = 0x08,
+    SchemaAttributeFlag_Constructed = 0x10,
+};
+
+// Schema data of an attribute, parsed from attributeSchema
+// object once at load
+class SchemaAttribute final {
+public:
+    SchemaAttribute();
+
+    AttributeType type;
+    int flags;
+    int range_upper;
+};
+
+// Schema data of a class. Attribute sets are indexed by
+// atom and class sets are indexed by position in class
+// list. Attribute sets include attributes of all auxiliary
+// classes, including auxiliary classes of auxiliary
+// classes, so that a class can be checked without
+// visiting other classes.
+class SchemaClass final {
+public:
+    QBitArray may_contain;
+    QBitArray must_contain;
+    QBitArray possible_superiors;
+    QBitArray auxiliary_classes;
+};
+
 class AdConfigPrivate {
 
 public:
@@ -43,18 +82,46 @@ public:
     QList<ObjectClass> filter_containers;
 
     QList<Attribute> columns;
+    QList<AdAtom> column_atoms;
     QHash<Attribute, QString> column_display_names;
 
     QHash<ObjectClass, QString> class_display_names;
     QHash<ObjectClass, QList<Attribute>> find_attributes;
     QHash<ObjectClass, QHash<Attribute, QString>> attribute_display_names;
 
-    QHash<Attribute, AdObject> attribute_schemas;
-    QHash<ObjectClass, AdObject> class_schemas;
+    // Indexed by atom. Contains default entries for atoms
+    // that are not schema attributes.
+    QVector<SchemaAttribute> attribute_list;
+
+    QList<ObjectClass> class_list;
+    QHash<ObjectClass, int> class_index_map;
+    QVector<SchemaClass> class_table;
+
+    void compile_attribute_schemas(const QList<AdObject> &schema_list);
+    void compile_class_schemas(const QList<AdObject> &schema_list);
 
-    QList<ObjectClass> add_auxiliary_classes(const QList<QString> &object_classes) const;
+    // Persistent cache of loaded config, one file per
+    // domain and locale. Cache is valid as long as key
+    // matches.
+    QString get_cache_path(const QLocale &locale) const;
+    QByteArray get_cache_key(AdInterface &ad, const QLocale &locale, const QString &locale_dir) const;
+    bool load_cache(const QString &path, const QByteArray &key);
+    void save_cache(const QString &path, const QByteArray &key) const;
+
+    QHash<QString, qint64> load_timings;
+    QHash<QString, QPair<qint64, qint64>> load_phase_intervals;
+    bool loaded_from_cache;
+
+    QList<QString> get_filter_categories(const AdObject &ui_settings) const;
+
+    const SchemaAttribute &get_attribute(const AdAtom atom) const;
+    bool get_attribute_flag(const QString &attribute, const SchemaAttributeFlag flag) const;
+    QList<const SchemaClass *> get_classes(const QList<ObjectClass> &object_classes) const;
+    QList<Attribute> attributes_from_bits(const QBitArray &bits) const;
 
     QHash<QString, QString> right_to_guid_map;
 };
 
+AttributeType attribute_type_from_schema(const AdObject &schema);
+
 #endif /* AD_CONFIG_P_H */
@@ -0,0 +1,234 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_connection_pool.h"
+
+#include <ldap.h>
+#include <sys/time.h>
+
+#include <QMutexLocker>
+
+#define POOL_MAX_IDLE_DEFAULT 8
+#define POOL_IDLE_TIMEOUT_DEFAULT_SECONDS 300
+#define POOL_CHECK_INTERVAL_DEFAULT_SECONDS 10
+#define ALIVE_CHECK_TIMEOUT_SECONDS 5
+
+AdConnectionPool *AdConnectionPool::instance() {
+    static AdConnectionPool pool;
+
+    return &pool;
+}
+
+AdConnectionPool::AdConnectionPool() {
+    m_generation = 0;
+    m_hit_count = 0;
+    max_idle = POOL_MAX_IDLE_DEFAULT;
+    idle_timeout_ms = POOL_IDLE_TIMEOUT_DEFAULT_SECONDS * 1000;
+    check_interval_ms = POOL_CHECK_INTERVAL_DEFAULT_SECONDS * 1000;
+}
+
+AdConnectionPool::~AdConnectionPool() {
+    for (const IdleConnection &connection : idle_list) {
+        ad_connection_unbind(connection.ld);
+    }
+}
+
+LDAP *AdConnectionPool::acquire(const QString &dc) {
+    while (true) {
+        IdleConnection connection;
+        bool found = false;
+        QList<LDAP *> expired_list;
+
+        {
+            QMutexLocker locker(&mutex);
+
+            expired_list = take_expired();
+
+            // NOTE: take most recently used connection,
+            // it is the least likely to have been dropped
+            // by the server
+            for (int i = idle_list.size() - 1; i >= 0; i--) {
+                if (idle_list[i].dc == dc) {
+                    connection = idle_list.takeAt(i);
+                    found = true;
+
+                    break;
+                }
+            }
+        }
+
+        for (LDAP *expired_ld : expired_list) {
+            ad_connection_unbind(expired_ld);
+        }
+
+        if (!found) {
+            return NULL;
+        }
+
+        // NOTE: skip health check for connections that
+        // were used very recently, this is the common case
+        // when the UI creates many short-lived
+        // AdInterface's in a row
+        const bool need_check = (connection.idle_timer.elapsed() > check_interval_ms);
+        if (!need_check || ad_connection_is_alive(connection.ld)) {
+            QMutexLocker locker(&mutex);
+            m_hit_count++;
+
+            return connection.ld;
+        }
+
+        // Connection is dead, drop it and try next one
+        ad_connection_unbind(connection.ld);
+    }
+}
+
+void AdConnectionPool::release(LDAP *ld, const QString &dc, const int generation_arg, const bool is_healthy) {
+    if (ld == NULL) {
+        return;
+    }
+
+    QList<LDAP *> unbind_list;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        const bool is_stale = (generation_arg != m_generation);
+
+        if (is_healthy && !is_stale) {
+            IdleConnection connection;
+            connection.ld = ld;
+            connection.dc = dc;
+            connection.generation = generation_arg;
+            connection.idle_timer.start();
+
+            idle_list.append(connection);
+        } else {
+            unbind_list.append(ld);
+        }
+
+        unbind_list += take_expired();
+
+        // Drop least recently used connections if over
+        // limit
+        while (idle_list.size() > max_idle) {
+            const IdleConnection oldest = idle_list.takeFirst();
+            unbind_list.append(oldest.ld);
+        }
+    }
+
+    for (LDAP *unbind_ld : unbind_list) {
+        ad_connection_unbind(unbind_ld);
+    }
+}
+
+void AdConnectionPool::clear() {
+    QList<IdleConnection> cleared_list;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        m_generation++;
+        cleared_list = idle_list;
+        idle_list.clear();
+    }
+
+    for (const IdleConnection &connection : cleared_list) {
+        ad_connection_unbind(connection.ld);
+    }
+}
+
+int AdConnectionPool::generation() {
+    QMutexLocker locker(&mutex);
+
+    return m_generation;
+}
+
+int AdConnectionPool::hit_count() {
+    QMutexLocker locker(&mutex);
+
+    return m_hit_count;
+}
+
+void AdConnectionPool::set_max_idle(const int max_idle_arg) {
+    QMutexLocker locker(&mutex);
+
+    max_idle = max_idle_arg;
+}
+
+void AdConnectionPool::set_idle_timeout(const int seconds) {
+    QMutexLocker locker(&mutex);
+
+    idle_timeout_ms = seconds * 1000;
+}
+
+void AdConnectionPool::set_check_interval(const int seconds) {
+    QMutexLocker locker(&mutex);
+
+    check_interval_ms = seconds * 1000;
+}
+
+QList<LDAP *> AdConnectionPool::take_expired() {
+    QList<LDAP *> out;
+
+    for (int i = idle_list.size() - 1; i >= 0; i--) {
+        const IdleConnection &connection = idle_list[i];
+
+        const bool timed_out = (connection.idle_timer.elapsed() > idle_timeout_ms);
+        const bool is_stale = (connection.generation != m_generation);
+
+        if (timed_out || is_stale) {
+            out.append(connection.ld);
+            idle_list.removeAt(i);
+        }
+    }
+
+    return out;
+}
+
+bool ad_connection_is_alive(LDAP *ld) {
+    if (ld == NULL) {
+        return false;
+    }
+
+    int socket_fd = -1;
+    const int get_desc_result = ldap_get_option(ld, LDAP_OPT_DESC, &socket_fd);
+    if (get_desc_result != LDAP_OPT_SUCCESS || socket_fd < 0) {
+        return false;
+    }
+
+    // NOTE: rootDSE read with "1.1" attribute returns no
+    // attributes, so this is as cheap as a request can get
+    char *attributes[] = {(char *) LDAP_NO_ATTRS, NULL};
+    struct timeval timeout;
+    timeout.tv_sec = ALIVE_CHECK_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    LDAPMessage *res = NULL;
+
+    const int result = ldap_search_ext_s(ld, "", LDAP_SCOPE_BASE, "(objectClass=*)", attributes, 0, NULL, NULL, &timeout, 1, &res);
+    ldap_msgfree(res);
+
+    return (result == LDAP_SUCCESS);
+}
+
+void ad_connection_unbind(LDAP *ld) {
+    if (ld != NULL) {
+        ldap_unbind_ext(ld, NULL, NULL);
+    }
+}
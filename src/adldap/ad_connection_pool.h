@@ -0,0 +1,109 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_CONNECTION_POOL_H
+#define AD_CONNECTION_POOL_H
+
+/**
+ * Process-wide pool of bound LDAP connections. Creating a
+ * connection requires a DNS lookup, a TCP connect and a
+ * full GSSAPI bind, which is the most expensive part of
+ * constructing an AdInterface. Instead of unbinding in
+ * dtor, AdInterface returns it's connection to this pool
+ * and the next AdInterface leases it back. Connections are
+ * checked for health before being reused, reaped after
+ * staying idle for too long and the number of idle
+ * connections is limited. Pool is thread-safe, but a
+ * leased connection must only be used by one AdInterface
+ * at a time.
+ */
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+typedef struct ldap LDAP;
+
+class AdConnectionPool {
+
+public:
+    static AdConnectionPool *instance();
+
+    ~AdConnectionPool();
+
+    // Returns an idle connection to given dc. Returns NULL
+    // if there are no usable idle connections to that dc,
+    // in which case caller should create a new connection.
+    LDAP *acquire(const QString &dc);
+
+    // Returns a leased connection back to the pool.
+    // Connection is unbound instead if it is broken, if
+    // it was created before the last clear() or if the
+    // pool is full. Pass generation() value obtained
+    // before connection was created or acquired.
+    void release(LDAP *ld, const QString &dc, const int generation, const bool is_healthy);
+
+    // Unbinds all idle connections. Connections that are
+    // currently leased will be unbound when they are
+    // released. Call this when connection options change.
+    void clear();
+
+    int generation();
+
+    // Number of acquire() calls that returned a pooled
+    // connection
+    int hit_count();
+
+    void set_max_idle(const int max_idle);
+    void set_idle_timeout(const int seconds);
+    void set_check_interval(const int seconds);
+
+private:
+    struct IdleConnection {
+        LDAP *ld;
+        QString dc;
+        int generation;
+        QElapsedTimer idle_timer;
+    };
+
+    QMutex mutex;
+    QList<IdleConnection> idle_list;
+    int m_generation;
+    int m_hit_count;
+    int max_idle;
+    int idle_timeout_ms;
+    int check_interval_ms;
+
+    AdConnectionPool();
+
+    // NOTE: must be called with mutex locked. Removes
+    // expired connections from idle list and returns them
+    // so that they can be unbound outside of the lock.
+    QList<LDAP *> take_expired();
+};
+
+// Performs a cheap rootDSE read to check that connection
+// is still usable.
+bool ad_connection_is_alive(LDAP *ld);
+
+void ad_connection_unbind(LDAP *ld);
+
+#endif /* AD_CONNECTION_POOL_H */
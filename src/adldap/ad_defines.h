@@ -120,6 +120,9 @@ enum SystemFlagsBit {
 #define ATTRIBUTE_WHEN_CHANGED "whenChanged"
 #define ATTRIBUTE_USN_CHANGED "uSNChanged"
 #define ATTRIBUTE_USN_CREATED "uSNCreated"
+#define ATTRIBUTE_HIGHEST_COMMITTED_USN "highestCommittedUSN"
+#define ATTRIBUTE_IS_DELETED "isDeleted"
+#define ATTRIBUTE_LAST_KNOWN_PARENT "lastKnownParent"
 #define ATTRIBUTE_OBJECT_CATEGORY "objectCategory"
 #define ATTRIBUTE_MEMBER "member"
 #define ATTRIBUTE_MEMBER_OF "memberOf"
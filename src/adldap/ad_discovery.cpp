@@ -0,0 +1,706 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_discovery.h"
+
+#include "ad_utils.h"
+
+#include <arpa/nameser.h>
+#include <cstring>
+#include <netinet/in.h>
+#include <resolv.h>
+
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <ldap.h>
+
+#include <algorithm>
+
+// NOTE: TTL's are clamped so that a misconfigured DNS
+// server can't make us query on every connection or keep
+// a list forever
+#define SRV_TTL_MIN_SECONDS 30
+#define SRV_TTL_MAX_SECONDS 3600
+// Failed lookups are cached for a short time
+#define SRV_NEGATIVE_TTL_SECONDS 30
+// Records are refreshed in background after this portion
+// of TTL has passed, so that they never actually expire
+#define SRV_REFRESH_AHEAD_PERCENT 75
+#define DEFAULT_DOMAIN_TTL_SECONDS 60
+#define RANKING_REFRESH_INTERVAL_SECONDS 600
+// Max number of DC's probed at the same time
+#define PROBE_MAX_CANDIDATES 16
+#define PROBE_TIMEOUT_SECONDS 2
+// NOTE: ranking doesn't wait for DC's that take longer
+// than this, since they are not going to be near anyway
+#define PROBE_DEADLINE_MS 1500
+// NtVer = NETLOGON_NT_VERSION_5 | NETLOGON_NT_VERSION_5EX,
+// which selects the NETLOGON_SAM_LOGON_RESPONSE_EX format
+#define LDAP_PING_FILTER "(&(DnsDomain=%1)(NtVer=\\06\\00\\00\\00))"
+#define LOGON_SAM_LOGON_RESPONSE_EX 23
+#define LOGON_SAM_USER_UNKNOWN_EX 25
+
+class SrvRefreshTask final : public QRunnable {
+
+public:
+    SrvRefreshTask(const QString &dname_arg) {
+        dname = dname_arg;
+    }
+
+    void run() override {
+        AdDiscoveryCache::instance()->refresh(dname);
+    }
+
+private:
+    QString dname;
+};
+
+class RankRefreshTask final : public QRunnable {
+
+public:
+    RankRefreshTask(const QString &domain_arg) {
+        domain = domain_arg;
+    }
+
+    void run() override {
+        AdDiscoveryCache::instance()->rank(domain);
+    }
+
+private:
+    QString domain;
+};
+
+// Results of probes are shared between ranking and probe
+// tasks, because ranking may stop waiting for slow probes
+// before they finish
+struct ProbeState {
+    QMutex mutex;
+    QList<AdDcProbeResult> result_list;
+    QSemaphore finished;
+};
+
+class DcProbeTask final : public QRunnable {
+
+public:
+    DcProbeTask(QSharedPointer<ProbeState> state_arg, const AdSrvRecord &record_arg, const QString &domain_arg) {
+        state = state_arg;
+        record = record_arg;
+        domain = domain_arg;
+    }
+
+    void run() override {
+        const AdDcProbeResult result = probe_dc(record.host, record.port, domain);
+
+        {
+            QMutexLocker locker(&state->mutex);
+            state->result_list.append(result);
+        }
+
+        state->finished.release();
+    }
+
+private:
+    QSharedPointer<ProbeState> state;
+    AdSrvRecord record;
+    QString domain;
+};
+
+AdDiscoveryCache *AdDiscoveryCache::instance() {
+    static AdDiscoveryCache cache;
+
+    return &cache;
+}
+
+AdDiscoveryCache::AdDiscoveryCache() {
+}
+
+QList<AdSrvRecord> AdDiscoveryCache::get_records(const QString &domain, const QString &site) {
+    return get_service_records("_ldap", domain, site);
+}
+
+QList<AdSrvRecord> AdDiscoveryCache::get_gc_records(const QString &forest, const QString &site) {
+    return get_service_records("_gc", forest, site);
+}
+
+QString AdDiscoveryCache::forest_of(const QString &domain) {
+    // NOTE: GC records are only registered in the zone of
+    // forest root domain. Child domains are below the root
+    // in DNS, so walk up until records are found.
+    QList<QString> label_list = domain.split(".");
+
+    while (label_list.size() >= 2) {
+        const QString candidate = label_list.join(".");
+        const QString gc_dname = QString("_gc._tcp.%1").arg(candidate);
+
+        if (!get_records_for_dname(gc_dname).isEmpty()) {
+            return candidate;
+        }
+
+        label_list.removeFirst();
+    }
+
+    return QString();
+}
+
+QList<AdSrvRecord> AdDiscoveryCache::get_service_records(const QString &service, const QString &domain, const QString &site) {
+    QList<AdSrvRecord> out;
+
+    if (!site.isEmpty()) {
+        const QString site_dname = QString("%1._tcp.%2._sites.%3").arg(service, site, domain);
+        out.append(get_records_for_dname(site_dname));
+    }
+
+    const QString default_dname = QString("%1._tcp.%2").arg(service, domain);
+    const QList<AdSrvRecord> default_records = get_records_for_dname(default_dname);
+
+    // NOTE: site DC's are also listed in default records,
+    // skip duplicates
+    for (const AdSrvRecord &record : default_records) {
+        const bool is_duplicate = std::any_of(out.begin(), out.end(),
+            [&](const AdSrvRecord &other) {
+                return (other.host == record.host);
+            });
+
+        if (!is_duplicate) {
+            out.append(record);
+        }
+    }
+
+    return out;
+}
+
+QString AdDiscoveryCache::select_host(const QString &domain, const QString &site) {
+    // NOTE: prefer site DC's, only fall back to all
+    // DC's if site has none
+    if (!site.isEmpty()) {
+        const QString site_dname = QString("_ldap._tcp.%1._sites.%2").arg(site, domain);
+        const QString site_host = srv_select_host(get_records_for_dname(site_dname));
+
+        if (!site_host.isEmpty()) {
+            return site_host;
+        }
+    }
+
+    const QString default_dname = QString("_ldap._tcp.%1").arg(domain);
+    const QString host = srv_select_host(get_records_for_dname(default_dname));
+
+    return host;
+}
+
+QList<QString> AdDiscoveryCache::ranked_hosts(const QString &domain) {
+    {
+        QMutexLocker locker(&mutex);
+
+        if (ranking_map.contains(domain)) {
+            Ranking &ranking = ranking_map[domain];
+
+            // NOTE: if no DC's responded last time, retry
+            // sooner
+            const qint64 refresh_interval_ms = [&]() -> qint64 {
+                if (ranking.host_list.isEmpty()) {
+                    return SRV_NEGATIVE_TTL_SECONDS * 1000;
+                } else {
+                    return RANKING_REFRESH_INTERVAL_SECONDS * 1000;
+                }
+            }();
+            const bool need_refresh = (ranking.age_timer.elapsed() > refresh_interval_ms);
+            if (need_refresh && !ranking.refresh_in_progress) {
+                ranking.refresh_in_progress = true;
+                QThreadPool::globalInstance()->start(new RankRefreshTask(domain));
+            }
+
+            return ranking.host_list;
+        }
+    }
+
+    // First ranking for this domain, have to wait for it
+    rank(domain);
+
+    QMutexLocker locker(&mutex);
+
+    return ranking_map.value(domain).host_list;
+}
+
+QString AdDiscoveryCache::client_site(const QString &domain) {
+    QMutexLocker locker(&mutex);
+
+    return ranking_map.value(domain).client_site;
+}
+
+QString AdDiscoveryCache::default_domain() {
+    {
+        QMutexLocker locker(&mutex);
+
+        const bool is_fresh = (!m_default_domain.isEmpty() && default_domain_timer.isValid() && default_domain_timer.elapsed() < DEFAULT_DOMAIN_TTL_SECONDS * 1000);
+        if (is_fresh) {
+            return m_default_domain;
+        }
+    }
+
+    const QString domain = get_default_domain_from_krb5();
+
+    QMutexLocker locker(&mutex);
+
+    // NOTE: don't cache failures, user might be about to
+    // obtain a ticket
+    if (!domain.isEmpty()) {
+        m_default_domain = domain;
+        default_domain_timer.start();
+    }
+
+    return domain;
+}
+
+void AdDiscoveryCache::clear() {
+    QMutexLocker locker(&mutex);
+
+    entry_map.clear();
+    ranking_map.clear();
+    m_default_domain.clear();
+    default_domain_timer.invalidate();
+}
+
+void AdDiscoveryCache::refresh(const QString &dname) {
+    const QList<AdSrvRecord> records = query_srv_records(dname);
+
+    const int ttl_ms = [&]() {
+        if (records.isEmpty()) {
+            return SRV_NEGATIVE_TTL_SECONDS * 1000;
+        }
+
+        int min_ttl = SRV_TTL_MAX_SECONDS;
+        for (const AdSrvRecord &record : records) {
+            min_ttl = std::min(min_ttl, record.ttl);
+        }
+        min_ttl = std::max(min_ttl, SRV_TTL_MIN_SECONDS);
+
+        return min_ttl * 1000;
+    }();
+
+    QMutexLocker locker(&mutex);
+
+    CacheEntry &entry = entry_map[dname];
+    entry.refresh_in_progress = false;
+
+    // NOTE: if refresh failed but there are previous
+    // records, keep them. It's more likely that DNS is
+    // temporarily unreachable than that all DC's are gone.
+    const bool keep_previous = (records.isEmpty() && !entry.records.isEmpty());
+    if (keep_previous) {
+        entry.ttl_ms = SRV_NEGATIVE_TTL_SECONDS * 1000;
+    } else {
+        entry.records = records;
+        entry.ttl_ms = ttl_ms;
+    }
+
+    entry.age_timer.start();
+}
+
+void AdDiscoveryCache::rank(const QString &domain) {
+    // NOTE: if site is known from previous ranking,
+    // include site DC's which might not be listed in
+    // default records
+    const QString prev_site = client_site(domain);
+
+    QList<AdSrvRecord> candidate_list = get_records(domain, prev_site);
+    while (candidate_list.size() > PROBE_MAX_CANDIDATES) {
+        candidate_list.removeLast();
+    }
+
+    // Probe all candidates in parallel
+    // NOTE: use separate pool so that probes are not
+    // limited by global pool's thread count
+    static QThreadPool probe_pool;
+    probe_pool.setMaxThreadCount(PROBE_MAX_CANDIDATES);
+
+    QSharedPointer<ProbeState> state = QSharedPointer<ProbeState>::create();
+    for (const AdSrvRecord &record : candidate_list) {
+        probe_pool.start(new DcProbeTask(state, record, domain));
+    }
+
+    state->finished.tryAcquire(candidate_list.size(), PROBE_DEADLINE_MS);
+
+    const QList<AdDcProbeResult> result_list = [&]() {
+        QMutexLocker locker(&state->mutex);
+
+        QList<AdDcProbeResult> out;
+        for (const AdDcProbeResult &result : state->result_list) {
+            if (result.responded) {
+                out.append(result);
+            }
+        }
+
+        return out;
+    }();
+
+    // NOTE: all DC's should report the same client site,
+    // but take the most common answer just in case
+    const QString site = [&]() {
+        QHash<QString, int> count_map;
+        for (const AdDcProbeResult &result : result_list) {
+            if (!result.client_site.isEmpty()) {
+                count_map[result.client_site]++;
+            }
+        }
+
+        QString out;
+        int max_count = 0;
+        for (const QString &this_site : count_map.keys()) {
+            if (count_map[this_site] > max_count) {
+                out = this_site;
+                max_count = count_map[this_site];
+            }
+        }
+
+        return out;
+    }();
+
+    QList<AdDcProbeResult> sorted_list = result_list;
+    std::stable_sort(sorted_list.begin(), sorted_list.end(),
+        [&](const AdDcProbeResult &a, const AdDcProbeResult &b) {
+            const bool a_in_site = (!site.isEmpty() && a.dc_site == site);
+            const bool b_in_site = (!site.isEmpty() && b.dc_site == site);
+
+            if (a_in_site != b_in_site) {
+                return a_in_site;
+            } else {
+                return (a.rtt_ms < b.rtt_ms);
+            }
+        });
+
+    QList<QString> host_list;
+    for (const AdDcProbeResult &result : sorted_list) {
+        host_list.append(result.host);
+    }
+
+    QMutexLocker locker(&mutex);
+
+    Ranking &ranking = ranking_map[domain];
+    ranking.refresh_in_progress = false;
+
+    // NOTE: if no DC's responded, keep previous ranking
+    // since this is most likely a temporary network issue
+    if (!host_list.isEmpty() || ranking.host_list.isEmpty()) {
+        ranking.host_list = host_list;
+    }
+
+    if (!site.isEmpty()) {
+        ranking.client_site = site;
+    }
+
+    ranking.age_timer.start();
+}
+
+QList<AdSrvRecord> AdDiscoveryCache::get_records_for_dname(const QString &dname) {
+    {
+        QMutexLocker locker(&mutex);
+
+        if (entry_map.contains(dname)) {
+            CacheEntry &entry = entry_map[dname];
+
+            const qint64 age = entry.age_timer.elapsed();
+            const qint64 refresh_age = (qint64) entry.ttl_ms * SRV_REFRESH_AHEAD_PERCENT / 100;
+            const bool need_refresh = (age > refresh_age);
+            const bool is_expired_failure = (entry.records.isEmpty() && age > entry.ttl_ms);
+
+            // NOTE: expired failures are re-queried below
+            // synchronously, since there's nothing to
+            // return
+            if (!is_expired_failure) {
+                if (need_refresh && !entry.refresh_in_progress) {
+                    entry.refresh_in_progress = true;
+                    QThreadPool::globalInstance()->start(new SrvRefreshTask(dname));
+                }
+
+                return entry.records;
+            }
+        }
+    }
+
+    // First lookup for this name, have to wait for it
+    refresh(dname);
+
+    QMutexLocker locker(&mutex);
+
+    return entry_map.value(dname).records;
+}
+
+// NOTE: this is rewritten from
+// https://github.com/paleg/libadclient/blob/master/adclient.cpp
+// which itself is copied from
+// https://www.ccnx.org/releases/latest/doc/ccode/html/ccndc-srv_8c_source.html
+QList<AdSrvRecord> query_srv_records(const QString &dname) {
+    union dns_msg {
+        HEADER header;
+        unsigned char buf[NS_MAXMSG];
+    } msg;
+
+    const QList<AdSrvRecord> error_out = QList<AdSrvRecord>();
+
+    // NOTE: use private resolver state so that lookups can
+    // be done from background threads
+    struct __res_state res_state;
+    memset(&res_state, 0, sizeof(res_state));
+    if (res_ninit(&res_state) != 0) {
+        return error_out;
+    }
+
+    const QByteArray dname_bytes = dname.toUtf8();
+    const int msg_len = res_nsearch(&res_state, dname_bytes.constData(), ns_c_in, ns_t_srv, msg.buf, sizeof(msg.buf));
+    res_nclose(&res_state);
+
+    const bool message_error = (msg_len < 0 || msg_len < (int) sizeof(HEADER));
+    if (message_error) {
+        return error_out;
+    }
+
+    const int packet_count = ntohs(msg.header.qdcount);
+    const int answer_count = ntohs(msg.header.ancount);
+
+    unsigned char *curr = msg.buf + sizeof(msg.header);
+    const unsigned char *eom = msg.buf + msg_len;
+
+    // Skip over packet records
+    for (int i = packet_count; i > 0 && curr < eom; i--) {
+        const int packet_len = dn_skipname(curr, eom);
+
+        const bool packet_error = (packet_len < 0);
+        if (packet_error) {
+            return error_out;
+        }
+
+        curr = curr + packet_len + QFIXEDSZ;
+    }
+
+    QList<AdSrvRecord> out;
+
+    // Process answers by collecting records into list
+    for (int i = 0; i < answer_count; i++) {
+        // Get server
+        char server[NS_MAXDNAME];
+        const int server_len = dn_expand(msg.buf, eom, curr, server, sizeof(server));
+
+        const bool server_error = (server_len < 0);
+        if (server_error) {
+            return error_out;
+        }
+
+        curr = curr + server_len;
+
+        int record_type;
+        int record_class;
+        int ttl;
+        int record_len;
+        GETSHORT(record_type, curr);
+        GETSHORT(record_class, curr);
+        GETLONG(ttl, curr);
+        GETSHORT(record_len, curr);
+        (void) record_class;
+
+        unsigned char *record_end = curr + record_len;
+        if (record_end > eom) {
+            return error_out;
+        }
+
+        // Skip non-server records
+        if (record_type != ns_t_srv) {
+            curr = record_end;
+
+            continue;
+        }
+
+        int priority;
+        int weight;
+        int port;
+        GETSHORT(priority, curr);
+        GETSHORT(weight, curr);
+        GETSHORT(port, curr);
+
+        // Get host
+        char host[NS_MAXDNAME];
+        const int host_len = dn_expand(msg.buf, eom, curr, host, sizeof(host));
+        const bool host_error = (host_len < 0);
+        if (host_error) {
+            return error_out;
+        }
+
+        AdSrvRecord record;
+        record.host = QString(host);
+        record.port = port;
+        record.priority = priority;
+        record.weight = weight;
+        record.ttl = ttl;
+
+        out.append(record);
+
+        curr = record_end;
+    }
+
+    std::stable_sort(out.begin(), out.end(),
+        [](const AdSrvRecord &a, const AdSrvRecord &b) {
+            if (a.priority != b.priority) {
+                return (a.priority < b.priority);
+            } else {
+                return (a.weight > b.weight);
+            }
+        });
+
+    return out;
+}
+
+AdDcProbeResult probe_dc(const QString &host, const int port, const QString &domain) {
+    AdDcProbeResult out;
+    out.host = host;
+    out.responded = false;
+    out.rtt_ms = -1;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QByteArray uri = QString("ldap://%1:%2").arg(host).arg(port).toUtf8();
+
+    LDAP *ld = NULL;
+    const int init_result = ldap_initialize(&ld, uri.constData());
+    if (init_result != LDAP_SUCCESS) {
+        return out;
+    }
+
+    const int version = LDAP_VERSION3;
+    ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+    ldap_set_option(ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
+
+    struct timeval timeout;
+    timeout.tv_sec = PROBE_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    ldap_set_option(ld, LDAP_OPT_NETWORK_TIMEOUT, &timeout);
+
+    // NOTE: LDAP ping is allowed without binding
+    const QByteArray filter = QString(LDAP_PING_FILTER).arg(domain).toUtf8();
+    char *attributes[] = {(char *) "Netlogon", NULL};
+    LDAPMessage *res = NULL;
+
+    const int result = ldap_search_ext_s(ld, "", LDAP_SCOPE_BASE, filter.constData(), attributes, 0, NULL, NULL, &timeout, 1, &res);
+
+    if (result == LDAP_SUCCESS) {
+        out.responded = true;
+        out.rtt_ms = timer.elapsed();
+
+        LDAPMessage *entry = ldap_first_entry(ld, res);
+        if (entry != NULL) {
+            struct berval **values = ldap_get_values_len(ld, entry, "Netlogon");
+
+            if (values != NULL && values[0] != NULL) {
+                const QByteArray data(values[0]->bv_val, values[0]->bv_len);
+                parse_netlogon_response(data, &out.dc_site, &out.client_site);
+            }
+
+            ldap_value_free_len(values);
+        }
+    }
+
+    ldap_msgfree(res);
+    ldap_unbind_ext(ld, NULL, NULL);
+
+    return out;
+}
+
+// NOTE: see MS-ADTS 6.3.1.9 for format description.
+// Strings in the response are compressed the same way as
+// names in DNS messages, so dn_expand() can decode them.
+bool parse_netlogon_response(const QByteArray &data, QString *dc_site, QString *client_site) {
+    // Opcode(2) + Sbz(2) + Flags(4) + DomainGuid(16)
+    const int header_size = 24;
+    if (data.size() < header_size) {
+        return false;
+    }
+
+    const unsigned char *msg = (const unsigned char *) data.constData();
+    const unsigned char *eom = msg + data.size();
+
+    const int opcode = msg[0] | (msg[1] << 8);
+    if (opcode != LOGON_SAM_LOGON_RESPONSE_EX && opcode != LOGON_SAM_USER_UNKNOWN_EX) {
+        return false;
+    }
+
+    // Strings in order: DnsForestName, DnsDomainName,
+    // DnsHostName, NetbiosDomainName, NetbiosComputerName,
+    // UserName, DcSiteName, ClientSiteName
+    const int string_count = 8;
+    QList<QString> string_list;
+
+    const unsigned char *curr = msg + header_size;
+    for (int i = 0; i < string_count; i++) {
+        char buffer[NS_MAXDNAME];
+        const int len = dn_expand(msg, eom, curr, buffer, sizeof(buffer));
+        if (len < 0) {
+            return false;
+        }
+
+        string_list.append(QString(buffer));
+        curr += len;
+    }
+
+    *dc_site = string_list[6];
+    *client_site = string_list[7];
+
+    return true;
+}
+
+QString srv_select_host(const QList<AdSrvRecord> &records) {
+    if (records.isEmpty()) {
+        return QString();
+    }
+
+    int min_priority = records[0].priority;
+    for (const AdSrvRecord &record : records) {
+        min_priority = std::min(min_priority, record.priority);
+    }
+
+    QList<AdSrvRecord> candidate_list;
+    int total_weight = 0;
+    for (const AdSrvRecord &record : records) {
+        if (record.priority == min_priority) {
+            candidate_list.append(record);
+            total_weight += record.weight;
+        }
+    }
+
+    // NOTE: if all weights are 0, pick uniformly
+    if (total_weight == 0) {
+        const int index = QRandomGenerator::global()->bounded(candidate_list.size());
+
+        return candidate_list[index].host;
+    }
+
+    int pick = QRandomGenerator::global()->bounded(total_weight);
+    for (const AdSrvRecord &record : candidate_list) {
+        if (pick < record.weight) {
+            return record.host;
+        }
+
+        pick -= record.weight;
+    }
+
+    return candidate_list.last().host;
+}
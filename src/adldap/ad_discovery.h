@@ -0,0 +1,156 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_DISCOVERY_H
+#define AD_DISCOVERY_H
+
+/**
+ * Process-wide cache for domain controller discovery.
+ * Finding DC's requires a DNS SRV lookup and getting the
+ * default domain requires reading krb5 credentials cache,
+ * both of which are too slow to repeat for every
+ * connection. SRV answers are cached according to their
+ * DNS TTL and are refreshed in the background before they
+ * expire, so after the first lookup, connections never
+ * wait for DNS. If a refresh fails, previous answers are
+ * kept. Cache is thread-safe.
+ *
+ * Cache also ranks DC's by probing them in parallel with
+ * an "LDAP ping" (a rootDSE read of the Netlogon
+ * attribute). Response time measures how close a DC is and
+ * the response also contains the client's site, which is
+ * used to prefer DC's in the same site.
+ */
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+struct AdDcProbeResult {
+    QString host;
+    bool responded;
+    qint64 rtt_ms;
+    QString dc_site;
+    QString client_site;
+};
+
+struct AdSrvRecord {
+    QString host;
+    int port;
+    int priority;
+    int weight;
+    int ttl;
+};
+
+class AdDiscoveryCache {
+
+public:
+    static AdDiscoveryCache *instance();
+
+    // Returns SRV records of domain controllers. If site
+    // is not empty, records for that site come first.
+    QList<AdSrvRecord> get_records(const QString &domain, const QString &site);
+
+    // Same as get_records(), but for Global Catalog
+    // servers of a forest
+    QList<AdSrvRecord> get_gc_records(const QString &forest, const QString &site);
+
+    // Returns name of forest root domain of given domain,
+    // which is where GC records are. Empty if no GC's were
+    // found.
+    QString forest_of(const QString &domain);
+
+    // Selects a host out of records for domain and site
+    // according to SRV priority and weight rules. Returns
+    // empty string if there are no hosts.
+    QString select_host(const QString &domain, const QString &site);
+
+    // Returns responsive DC's of domain, DC's in client's
+    // site first, then ordered by response time. The
+    // first call blocks while DC's are probed, after that
+    // ranking is refreshed periodically in the background.
+    // Returns empty list if no DC's responded.
+    QList<QString> ranked_hosts(const QString &domain);
+
+    // Returns client's site, as reported by DC's during
+    // ranking. Empty if ranking hasn't been done yet or
+    // site is unknown.
+    QString client_site(const QString &domain);
+
+    // Cached version of get_default_domain_from_krb5()
+    QString default_domain();
+
+    void clear();
+
+    // Refreshes records for given SRV name. This is a
+    // blocking call, it's used by background refresh.
+    void refresh(const QString &dname);
+
+    // Probes DC's and updates ranking. This is a blocking
+    // call, it's used by background refresh.
+    void rank(const QString &domain);
+
+private:
+    struct CacheEntry {
+        QList<AdSrvRecord> records;
+        QElapsedTimer age_timer;
+        int ttl_ms;
+        bool refresh_in_progress;
+    };
+
+    struct Ranking {
+        QList<QString> host_list;
+        QString client_site;
+        QElapsedTimer age_timer;
+        bool refresh_in_progress;
+    };
+
+    QMutex mutex;
+    QHash<QString, CacheEntry> entry_map;
+    QHash<QString, Ranking> ranking_map;
+    QString m_default_domain;
+    QElapsedTimer default_domain_timer;
+
+    AdDiscoveryCache();
+
+    QList<AdSrvRecord> get_records_for_dname(const QString &dname);
+    QList<AdSrvRecord> get_service_records(const QString &service, const QString &domain, const QString &site);
+};
+
+// Performs a DNS SRV query. Records are sorted by
+// priority, then by weight in descending order.
+QList<AdSrvRecord> query_srv_records(const QString &dname);
+
+// Performs an "LDAP ping" of a DC, measuring it's
+// response time and getting site information
+AdDcProbeResult probe_dc(const QString &host, const int port, const QString &domain);
+
+// Parses NETLOGON_SAM_LOGON_RESPONSE_EX structure returned
+// by LDAP ping. Returns false if data is malformed.
+bool parse_netlogon_response(const QByteArray &data, QString *dc_site, QString *client_site);
+
+// Selects a host according to RFC 2782: out of records
+// with lowest priority, a host is picked randomly with
+// probability proportional to it's weight
+QString srv_select_host(const QList<AdSrvRecord> &records);
+
+#endif /* AD_DISCOVERY_H */
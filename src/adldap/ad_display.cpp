@@ -44,10 +44,20 @@ QString octet_display_value(const QByteArray &bytes);
 QString guid_to_display_value(const QByteArray &bytes);
 
 QString attribute_display_value(const QString &attribute, const QByteArray &value, const AdConfig *adconfig) {
+    return attribute_display_value(AdAtomTable::instance()->find(attribute), value, adconfig);
+}
+
+QString attribute_display_value(const AdAtom attribute, const QByteArray &value, const AdConfig *adconfig) {
     if (adconfig == nullptr) {
         return value;
     }
 
+    // NOTE: name is only needed for datetimes, so look it
+    // up only in that case
+    auto attribute_name = [attribute]() {
+        return AdAtomTable::instance()->name(attribute);
+    };
+
     const AttributeType type = adconfig->get_attribute_type(attribute);
 
     switch (type) {
@@ -55,16 +65,16 @@ QString attribute_display_value(const QString &attribute, const QByteArray &valu
             const LargeIntegerSubtype subtype = adconfig->get_attribute_large_integer_subtype(attribute);
 
             switch (subtype) {
-                case LargeIntegerSubtype_Datetime: return large_integer_datetime_display_value(attribute, value, adconfig);
+                case LargeIntegerSubtype_Datetime: return large_integer_datetime_display_value(attribute_name(), value, adconfig);
                 case LargeIntegerSubtype_Timespan: return timespan_display_value(value);
                 case LargeIntegerSubtype_Integer: return QString(value);
             }
         }
-        case AttributeType_UTCTime: return datetime_display_value(attribute, value, adconfig);
-        case AttributeType_GeneralizedTime: return datetime_display_value(attribute, value, adconfig);
+        case AttributeType_UTCTime: return datetime_display_value(attribute_name(), value, adconfig);
+        case AttributeType_GeneralizedTime: return datetime_display_value(attribute_name(), value, adconfig);
         case AttributeType_Sid: return object_sid_display_value(value);
         case AttributeType_Octet: {
-            if (attribute == ATTRIBUTE_OBJECT_GUID) {
+            if (attribute == ATOM_OBJECT_GUID) {
                 return guid_to_display_value(value);
             } else {
                 return octet_display_value(value);
@@ -26,6 +26,8 @@
  * is given, then raw attribute values are returned.
  */
 
+#include "ad_atom.h"
+
 class AdConfig;
 class QString;
 class QByteArray;
@@ -33,6 +35,7 @@ template <typename T>
 class QList;
 
 QString attribute_display_value(const QString &attribute, const QByteArray &value, const AdConfig *adconfig);
+QString attribute_display_value(const AdAtom attribute, const QByteArray &value, const AdConfig *adconfig);
 QString attribute_display_values(const QString &attribute, const QList<QByteArray> &values, const AdConfig *adconfig);
 QString object_sid_display_value(const QByteArray &sid_bytes);
 
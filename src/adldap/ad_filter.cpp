@@ -23,6 +23,7 @@
 #include "ad_defines.h"
 
 #include <QCoreApplication>
+#include <QRegularExpression>
 
 const QList<QString> filter_classes = {
     CLASS_USER,
@@ -118,3 +119,26 @@ QList<QString> process_subfilters(const QList<QString> &in) {
 
     return out;
 }
+
+QList<QString> filter_get_attributes(const QString &filter) {
+    // NOTE: attribute is whatever comes between an opening
+    // parenthesis and an operator. Parentheses inside
+    // values are always escaped, so they can't be
+    // confused with this. Extensible matches, like
+    // "(attribute:1.2.3:=value)", are covered too.
+    static const QRegularExpression attribute_regex("\\(([A-Za-z][A-Za-z0-9-]*)[^()=]*=");
+
+    QList<QString> out;
+
+    QRegularExpressionMatchIterator it = attribute_regex.globalMatch(filter);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        const QString attribute = match.captured(1);
+
+        if (!out.contains(attribute)) {
+            out.append(attribute);
+        }
+    }
+
+    return out;
+}
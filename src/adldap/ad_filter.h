@@ -52,4 +52,7 @@ QString add_advanced_view_filter(const QString &filter);
 
 QString condition_to_display_string(const Condition condition);
 
+// Returns names of attributes that are used in filter
+QList<QString> filter_get_attributes(const QString &filter);
+
 #endif /* AD_FILTER_H */
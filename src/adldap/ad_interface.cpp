@@ -21,9 +21,15 @@
 #include "ad_interface.h"
 #include "ad_interface_p.h"
 
+#include "ad_change_set.h"
 #include "ad_config.h"
+#include "ad_connection_pool.h"
+#include "ad_discovery.h"
+#include "ad_read_router.h"
 #include "ad_display.h"
+#include "ad_atom.h"
 #include "ad_object.h"
+#include "ad_object_p.h"
 #include "ad_security.h"
 #include "ad_utils.h"
 #include "gplink.h"
@@ -42,7 +48,6 @@
 #include <lber.h>
 #include <ldap.h>
 #include <libsmbclient.h>
-#include <resolv.h>
 #include <sasl/sasl.h>
 #include <uuid/uuid.h>
 #include <dirent.h>
@@ -50,21 +55,57 @@
 #include <sys/types.h>
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QSharedPointer>
 #include <QTextCodec>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <algorithm>
 
 // NOTE: LDAP library char* inputs are non-const in the API
 // but are const for practical purposes so we use forced
 // casts (const char *) -> (char *)
 
-#ifdef __GNUC__
-#define UNUSED(x) x __attribute__((unused))
-#else
-#define UNUSED(x) x
-#endif
-
 #define MAX_DN_LENGTH 1024
 #define MAX_PASSWORD_LENGTH 255
 
+// Max number of operations that are in flight at the same
+// time in a pipeline
+#define PIPELINE_WINDOW_SIZE 64
+
+#define CONNECT_TIMEOUT_SECONDS 5
+// Searches pass this time limit to the server. Client
+// waits a bit longer, so that server can return partial
+// results before client gives up.
+#define OPERATION_TIMEOUT_DEFAULT_SECONDS 120
+#define OPERATION_TIMEOUT_GRACE_SECONDS 5
+// Results are waited for in intervals of this length, so
+// that operations can be cancelled
+#define RESULT_POLL_INTERVAL_MS 100
+// When connecting, up to this many DC's are tried. Each
+// next DC is tried if previous ones haven't connected
+// after a delay.
+#define CONNECT_RACE_MAX_CANDIDATES 3
+#define CONNECT_RACE_STAGGER_MS 300
+
+// Streaming search starts with a small page so that first
+// results arrive quickly, then grows page size
+#define STREAM_FIRST_PAGE_SIZE 50
+// NOTE: 1000 is the default MaxPageSize of AD
+#define STREAM_MAX_PAGE_SIZE 1000
+#define STREAM_MAX_PAGE_BYTES (4 * 1024 * 1024)
+#define STREAM_MAX_GROWTH_FACTOR 4
+// Page should take this many times longer to transfer than
+// the round-trip
+#define STREAM_LATENCY_FACTOR 10
+
 typedef struct sasl_defaults_gssapi {
     char *mech;
     char *realm;
@@ -78,23 +119,108 @@ enum AceMaskFormat {
     AceMaskFormat_Decimal,
 };
 
-QList<QString> query_server_for_hosts(const char *dname);
 int sasl_interact_gssapi(LDAP *ld, unsigned flags, void *indefaults, void *in);
 QString get_gpt_sd_string(const AdObject &gpc_object, const AceMaskFormat format);
+QString account_option_success_context(const AccountOption option, const bool set, const QString &name);
+QString account_option_error_context(const AccountOption option, const bool set, const QString &name);
+struct berval *sd_control_value(const bool get_sacl);
+int search_scope_to_ldap(const SearchScope scope);
+QString connection_pool_key(const QString &dc, const AdRouting routing);
+char **attributes_to_array(const QList<QString> &attributes);
+void attributes_array_free(char **attributes_array);
+int stream_next_page_size(const int page_size, const int entry_count, const qint64 page_bytes, const qint64 first_entry_ms, const qint64 page_ms);
+bool parse_range_attribute(const QString &attribute_full, QString *attribute_out, int *end_out);
+LDAPControl *read_entry_control_create(const char *oid, const QList<QString> &attributes);
+LDAPControl **read_entry_controls_create(const QList<QString> &pre_read_attributes, const QList<QString> &post_read_attributes);
+AdObject read_entry_control_get(LDAPControl **controls, const char *oid);
+
+// State shared between connect_race() and connect attempts
+struct ConnectRaceState {
+    QMutex mutex;
+    QWaitCondition condition;
+    LDAP *winner_ld;
+    QString winner_dc;
+    int finished_count;
+    bool race_over;
+    QList<QString> failed_list;
+    QList<QString> error_list;
+};
+
+class ConnectAttemptTask final : public QRunnable {
+
+public:
+    ConnectAttemptTask(QSharedPointer<ConnectRaceState> state_arg, const QString &dc_arg, const QString &pool_key_arg, QSharedPointer<const AdInterfaceSettings> settings_arg, const int generation_arg) {
+        state = state_arg;
+        dc = dc_arg;
+        pool_key = pool_key_arg;
+        settings = settings_arg;
+        generation = generation_arg;
+    }
+
+    void run() override {
+        LDAP *new_ld = NULL;
+        QString error;
+        const bool success = AdInterfacePrivate::create_connection(dc, *settings, &new_ld, &error);
+
+        bool lost_race = false;
+
+        {
+            QMutexLocker locker(&state->mutex);
+
+            state->finished_count++;
+
+            if (success) {
+                if (state->winner_ld == NULL && !state->race_over) {
+                    state->winner_ld = new_ld;
+                    state->winner_dc = dc;
+                } else {
+                    lost_race = true;
+                }
+            } else {
+                state->failed_list.append(dc);
+                state->error_list.append(error);
+            }
+
+            state->condition.wakeAll();
+        }
+
+        // NOTE: don't waste a connection that bound
+        // successfully but too late, it can be reused
+        if (lost_race) {
+            AdConnectionPool::instance()->release(new_ld, pool_key, generation, true);
+        }
+    }
+
+private:
+    QSharedPointer<ConnectRaceState> state;
+    QString dc;
+    QString pool_key;
+    QSharedPointer<const AdInterfaceSettings> settings;
+    int generation;
+};
 
-AdConfig *AdInterfacePrivate::adconfig = nullptr;
-bool AdInterfacePrivate::s_log_searches = false;
-QString AdInterfacePrivate::s_dc = QString();
-void *AdInterfacePrivate::s_sasl_nocanon = LDAP_OPT_ON;
-int AdInterfacePrivate::s_port = 0;
-CertStrategy AdInterfacePrivate::s_cert_strat = CertStrategy_Never;
+QMutex AdInterfacePrivate::settings_mutex;
+QSharedPointer<const AdInterfaceSettings> AdInterfacePrivate::s_settings = QSharedPointer<const AdInterfaceSettings>(new AdInterfaceSettings());
+QMutex AdInterfacePrivate::smbc_mutex;
 SMBCCTX *AdInterfacePrivate::smbc = NULL;
 
+AdInterfaceSettings::AdInterfaceSettings() {
+    adconfig = nullptr;
+    log_searches = false;
+    dc = QString();
+    dc_pinned = false;
+    sasl_nocanon = LDAP_OPT_ON;
+    port = 0;
+    cert_strategy = CertStrategy_Never;
+    timeout = OPERATION_TIMEOUT_DEFAULT_SECONDS;
+}
+
 void get_auth_data_fn(const char *pServer, const char *pShare, char *pWorkgroup, int maxLenWorkgroup, char *pUsername, int maxLenUsername, char *pPassword, int maxLenPassword) {
 }
 
-AdInterface::AdInterface() {
+AdInterface::AdInterface(const AdRouting routing) {
     d = new AdInterfacePrivate(this);
+    d->routing = routing;
 
     // TODO: this is very bug-prone, error returns should
     // set this to false or return false
@@ -104,7 +230,7 @@ AdInterface::AdInterface() {
 
     const QString connect_error_context = tr("Failed to connect.");
 
-    d->domain = get_default_domain_from_krb5();
+    d->domain = AdDiscoveryCache::instance()->default_domain();
     if (d->domain.isEmpty()) {
         d->error_message(connect_error_context, tr("Failed to get a domain."));
         return;
@@ -112,134 +238,178 @@ AdInterface::AdInterface() {
 
     d->domain_head = domain_to_domain_dn(d->domain);
 
+    AdConnectionPool *pool = AdConnectionPool::instance();
+
+    // NOTE: save generation before leasing or creating a
+    // connection, so that if connection options change
+    // while this connection is in use, it is not returned
+    // to the pool
+    d->pool_generation = pool->generation();
+
+    if (routing == AdRouting_GlobalCatalog) {
+        const bool gc_connected = d->connect_gc();
+
+        if (!gc_connected) {
+            return;
+        }
+    }
+
     //
-    // Connect via LDAP
+    // Lease connection from pool
     //
 
-    d->dc = [&]() {
-        const QList<QString> dc_list = get_domain_hosts(d->domain, QString());
-        if (dc_list.isEmpty()) {
-            d->error_message_plain(tr("Failed to find domain controllers. Make sure your computer is in the domain and that domain controllers are operational."));
+    // NOTE: if a DC has already been selected, then there
+    // may be an idle connection to it in the pool. In that
+    // case there's no need to lookup DC's or bind.
+    // NOTE: unless DC was set explicitly, select it from
+    // DC ranking every time, so that when ranking is
+    // refreshed, new connections move to the new nearest
+    // DC. Ranking is cached, so this doesn't wait for
+    // probes except for the very first connection.
+    const bool dc_pinned = d->settings->dc_pinned;
+    const QString default_dc = [&]() {
+        if (!dc_pinned) {
+            const QList<QString> ranked_list = AdDiscoveryCache::instance()->ranked_hosts(d->domain);
+
+            if (!ranked_list.isEmpty()) {
+                return ranked_list[0];
+            }
+        }
+
+        return d->settings->dc;
+    }();
+
+    // NOTE: balanced reads go to the site DC with the
+    // least connections in use. Until primary DC has been
+    // selected, there's nothing to balance against.
+    AdReadRouter *router = AdReadRouter::instance();
+    const bool route_read = (routing == AdRouting_ReadBalanced && !default_dc.isEmpty() && !router->write_is_recent());
 
-            return QString();
+    if (route_read) {
+        AdDiscoveryCache *discovery = AdDiscoveryCache::instance();
+
+        QList<QString> read_dc_list = discovery->ranked_hosts(d->domain);
+        if (read_dc_list.isEmpty()) {
+            const QString site = discovery->client_site(d->domain);
+            read_dc_list = get_domain_hosts(d->domain, site);
         }
 
-        if (!AdInterfacePrivate::s_dc.isEmpty()) {
-            if (dc_list.contains(AdInterfacePrivate::s_dc)) {
-                return AdInterfacePrivate::s_dc;
-            } else {
-                d->error_message_plain(tr("Failed to load DC defined in settings. Switching to default DC"));
+        d->routed_dc = router->select(read_dc_list);
+    }
 
-                return dc_list[0];
-            }
+    const QString preferred_dc = [&]() {
+        if (!d->routed_dc.isEmpty()) {
+            return d->routed_dc;
         } else {
-            return dc_list[0];
+            return default_dc;
         }
     }();
 
-    if (AdInterfacePrivate::s_dc.isEmpty()) {
-        AdInterfacePrivate::s_dc = d->dc;
+    if (d->ld == NULL && !preferred_dc.isEmpty()) {
+        d->ld = pool->acquire(connection_pool_key(preferred_dc, routing));
+
+        if (d->ld != NULL) {
+            d->dc = preferred_dc;
+        }
     }
 
-    const QString uri = [&]() {
-        QString out;
+    //
+    // Connect via LDAP
+    //
 
-        if (!d->dc.isEmpty()) {
-            out = "ldap://" + d->dc;
+    QList<QString> failed_list;
 
-            if (AdInterfacePrivate::s_port > 0) {
-                out = out + ":" + AdInterfacePrivate::s_port;
-            }
-        }
+    if (d->ld == NULL) {
+        d->dc = [&]() {
+            // NOTE: DC list comes from discovery cache, so
+            // this doesn't wait for DNS except for the very
+            // first connection
+            const QString site = AdDiscoveryCache::instance()->client_site(d->domain);
+            const QList<QString> dc_list = get_domain_hosts(d->domain, site);
+            if (dc_list.isEmpty()) {
+                d->error_message_plain(tr("Failed to find domain controllers. Make sure your computer is in the domain and that domain controllers are operational."));
 
-        return out;
-    }();
+                return QString();
+            }
 
-    if (uri.isEmpty()) {
-        return;
-    }
+            if (!d->routed_dc.isEmpty()) {
+                return d->routed_dc;
+            }
 
-    int result;
+            if (!default_dc.isEmpty()) {
+                if (dc_list.contains(default_dc)) {
+                    return default_dc;
+                } else if (dc_pinned) {
+                    d->error_message_plain(tr("Failed to load DC defined in settings. Switching to default DC"));
+                }
+            }
 
-    // NOTE: this doesn't leak memory. False positive.
-    result = ldap_initialize(&d->ld, cstr(uri));
-    if (result != LDAP_SUCCESS) {
-        ldap_memfree(d->ld);
-        d->error_message(tr("Failed to initialize LDAP library."), strerror(errno));
+            // None of the DC's responded to probes, fall
+            // back to SRV priorities and weights
+            return AdDiscoveryCache::instance()->select_host(d->domain, site);
+        }();
 
-        return;
-    }
+        if (d->dc.isEmpty()) {
+            return;
+        }
 
-    auto option_error = [&](const QString &option) {
-        d->error_message(connect_error_context, QString(tr("Failed to set ldap option %1.")).arg(option));
-    };
+        // NOTE: other DC's are raced against the selected
+        // one, so that if it's down or slow, connection
+        // goes to the next best DC instead of waiting for
+        // a timeout. Selected DC gets a head start, so in
+        // normal conditions it wins.
+        const QList<QString> candidate_list = [&]() {
+            AdDiscoveryCache *discovery = AdDiscoveryCache::instance();
 
-    // Set version
-    const int version = LDAP_VERSION3;
-    result = ldap_set_option(d->ld, LDAP_OPT_PROTOCOL_VERSION, &version);
-    if (result != LDAP_OPT_SUCCESS) {
-        option_error("LDAP_OPT_PROTOCOL_VERSION");
-        return;
-    }
+            QList<QString> out = discovery->ranked_hosts(d->domain);
 
-    // Disable referrals
-    result = ldap_set_option(d->ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
-    if (result != LDAP_OPT_SUCCESS) {
-        option_error("LDAP_OPT_REFERRALS");
-        return;
-    }
+            if (out.isEmpty()) {
+                const QString site = discovery->client_site(d->domain);
+                out = get_domain_hosts(d->domain, site);
+            }
 
-    // Set maxssf
-    const char *sasl_secprops = "maxssf=56";
-    result = ldap_set_option(d->ld, LDAP_OPT_X_SASL_SECPROPS, sasl_secprops);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_SASL_SECPROPS");
-        return;
-    }
+            out.removeAll(d->dc);
+            out.prepend(d->dc);
 
-    result = ldap_set_option(d->ld, LDAP_OPT_X_SASL_NOCANON, AdInterfacePrivate::s_sasl_nocanon);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_SASL_NOCANON");
-        return;
-    }
+            return out;
+        }();
 
-    const void *cert_strategy = [&]() {
-        switch (AdInterfacePrivate::s_cert_strat) {
-            case CertStrategy_Never: return (void *) LDAP_OPT_X_TLS_NEVER;
-            case CertStrategy_Hard: return (void *) LDAP_OPT_X_TLS_HARD;
-            case CertStrategy_Demand: return (void *) LDAP_OPT_X_TLS_DEMAND;
-            case CertStrategy_Allow: return (void *) LDAP_OPT_X_TLS_ALLOW;
-            case CertStrategy_Try: return (void *) LDAP_OPT_X_TLS_TRY;
+        const bool connect_success = d->connect_race(candidate_list, &failed_list);
+        if (!connect_success) {
+            return;
         }
-
-        return (void *) LDAP_OPT_X_TLS_NEVER;
-    }();
-    
-    ldap_set_option(d->ld, LDAP_OPT_X_TLS_REQUIRE_CERT, cert_strategy);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_TLS_REQUIRE_CERT");
-        return;
     }
 
-    // Setup sasl_defaults_gssapi
-    struct sasl_defaults_gssapi defaults;
-    defaults.mech = (char *) "GSSAPI";
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_REALM, &defaults.realm);
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_AUTHCID, &defaults.authcid);
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_AUTHZID, &defaults.authzid);
-    defaults.passwd = NULL;
+    // NOTE: only switch a pinned DC if it failed, not if it
+    // was merely slower. Balanced reads and GC connections
+    // don't affect default DC.
+    const QString connected_dc = d->dc;
+    if (!route_read && routing != AdRouting_GlobalCatalog) {
+        AdInterfacePrivate::change_settings(
+            [&](AdInterfaceSettings *settings) {
+                const bool default_dc_failed = failed_list.contains(settings->dc);
+
+                if (!settings->dc_pinned || settings->dc.isEmpty() || default_dc_failed) {
+                    settings->dc = connected_dc;
+                    settings->dc_pinned = false;
+                }
+            });
+    }
 
-    // Perform bind operation
-    unsigned sasl_flags = LDAP_SASL_QUIET;
-    result = ldap_sasl_interactive_bind_s(d->ld, NULL, defaults.mech, NULL, NULL, sasl_flags, sasl_interact_gssapi, &defaults);
-    ldap_memfree(defaults.realm);
-    ldap_memfree(defaults.authcid);
-    ldap_memfree(defaults.authzid);
-    if (result != LDAP_SUCCESS) {
-        d->error_message_plain(tr("Failed to connect to server. Check your connection and make sure you have initialized your credentials using kinit."));
-        d->error_message_plain(d->default_error());
+    // NOTE: count all domain connections, not just balanced
+    // ones, so that reads avoid DC's that are busy with
+    // other work. Connection may have ended up on a
+    // different DC than the one that was selected for it.
+    // GC connections are to a different port and reads are
+    // never routed to them, so they are not counted.
+    const bool is_domain_connection = (routing != AdRouting_GlobalCatalog);
+    if (is_domain_connection && d->routed_dc != d->dc) {
+        if (!d->routed_dc.isEmpty()) {
+            router->remove(d->routed_dc);
+        }
 
-        return;
+        router->add(d->dc);
+        d->routed_dc = d->dc;
     }
 
     d->client_user = [&]() {
@@ -262,18 +432,26 @@ AdInterface::AdInterface() {
     
     // NOTE: initialize only once, because otherwise
     // wouldn't be able to have multiple active
-    // AdInterface's instances at the same time
-    if (AdInterfacePrivate::smbc == NULL) {
-        smbc_init(get_auth_data_fn, 0);
-        AdInterfacePrivate::smbc = smbc_new_context();
-        smbc_setOptionUseKerberos(AdInterfacePrivate::smbc, true);
-        smbc_setOptionFallbackAfterKerberos(AdInterfacePrivate::smbc, true);
-        if (!smbc_init_context(AdInterfacePrivate::smbc)) {
-            d->error_message(connect_error_context, tr("Failed to initialize SMB context."));
-
-            return;
+    // AdInterface's instances at the same time. Lock
+    // because AdInterface's may be created by multiple
+    // threads at the same time.
+    {
+        QMutexLocker locker(&AdInterfacePrivate::smbc_mutex);
+
+        if (AdInterfacePrivate::smbc == NULL) {
+            smbc_init(get_auth_data_fn, 0);
+            SMBCCTX *new_smbc = smbc_new_context();
+            smbc_setOptionUseKerberos(new_smbc, true);
+            smbc_setOptionFallbackAfterKerberos(new_smbc, true);
+            if (!smbc_init_context(new_smbc)) {
+                smbc_free_context(new_smbc, 0);
+                d->error_message(connect_error_context, tr("Failed to initialize SMB context."));
+
+                return;
+            }
+            smbc_set_context(new_smbc);
+            AdInterfacePrivate::smbc = new_smbc;
         }
-        smbc_set_context(AdInterfacePrivate::smbc);
     }
 
     d->is_connected = true;
@@ -281,1505 +459,4387 @@ AdInterface::AdInterface() {
 
 AdInterface::~AdInterface() {
     if (d->is_connected) {
-        ldap_unbind_ext(d->ld, NULL, NULL);
+        // NOTE: instead of unbinding, return connection to
+        // the pool so that it can be reused by next
+        // AdInterface
+        const bool is_healthy = [&]() {
+            const int ldap_result = d->get_ldap_result();
+            const bool connection_lost = (ldap_result == LDAP_SERVER_DOWN || ldap_result == LDAP_CONNECT_ERROR || ldap_result == LDAP_TIMEOUT);
+
+            return !connection_lost;
+        }();
+
+        // NOTE: connection with running notifications
+        // would send their results to next user, so it
+        // can't be reused
+        const bool can_reuse = (is_healthy && d->notification_ids.isEmpty());
+
+        AdConnectionPool::instance()->release(d->ld, connection_pool_key(d->dc, d->routing), d->pool_generation, can_reuse);
     } else {
         ldap_memfree(d->ld);
     }
 
+    if (!d->routed_dc.isEmpty()) {
+        AdReadRouter::instance()->remove(d->routed_dc);
+    }
+
     delete d;
 }
 
 void AdInterface::set_config(AdConfig *config_arg) {
-    AdInterfacePrivate::adconfig = config_arg;
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->adconfig = config_arg;
+        });
 }
 
 void AdInterface::set_log_searches(const bool enabled) {
-    AdInterfacePrivate::s_log_searches = enabled;
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->log_searches = enabled;
+        });
 }
 
 void AdInterface::set_dc(const QString &dc) {
-    AdInterfacePrivate::s_dc = dc;
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->dc = dc;
+            settings->dc_pinned = !dc.isEmpty();
+        });
+
+    AdConnectionPool::instance()->clear();
 }
 
 void AdInterface::set_sasl_nocanon(const bool is_on) {
-    AdInterfacePrivate::s_sasl_nocanon = [&]() {
-        if (is_on) {
-            return LDAP_OPT_ON;
-        } else {
-            return LDAP_OPT_OFF;
-        }
-    }();
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->sasl_nocanon = [&]() {
+                if (is_on) {
+                    return LDAP_OPT_ON;
+                } else {
+                    return LDAP_OPT_OFF;
+                }
+            }();
+        });
+
+    AdConnectionPool::instance()->clear();
 }
 
 void AdInterface::set_port(const int port) {
-    AdInterfacePrivate::s_port = port;
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->port = port;
+        });
+
+    AdConnectionPool::instance()->clear();
 }
 
 void AdInterface::set_cert_strategy(const CertStrategy strategy) {
-    AdInterfacePrivate::s_cert_strat = strategy;
-}
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->cert_strategy = strategy;
+        });
 
-QString AdInterface::get_dc() {
-    return AdInterfacePrivate::s_dc;
+    AdConnectionPool::instance()->clear();
 }
 
-AdInterfacePrivate::AdInterfacePrivate(AdInterface *q_arg) {
-    q = q_arg;
+void AdInterface::set_timeout(const int seconds) {
+    AdInterfacePrivate::change_settings(
+        [&](AdInterfaceSettings *settings) {
+            settings->timeout = seconds;
+        });
+
+    AdConnectionPool::instance()->clear();
 }
 
-bool AdInterface::is_connected() const {
-    return d->is_connected;
+QString AdInterface::get_dc() {
+    return AdInterfacePrivate::current_settings()->dc;
 }
 
-QList<AdMessage> AdInterface::messages() const {
-    return d->messages;
+int AdInterface::get_timeout() {
+    return AdInterfacePrivate::current_settings()->timeout;
 }
 
-bool AdInterface::any_error_messages() const {
-    for (const auto &message : d->messages) {
-        if (message.type() == AdMessageType_Error) {
-            return true;
-        }
-    }
+AdInterfacePrivate::AdInterfacePrivate(AdInterface *q_arg) {
+    q = q_arg;
+    range_limit = 0;
+    operation_depth = 0;
+    defer_ranges = false;
 
-    return false;
+    settings = current_settings();
+    adconfig = settings->adconfig;
 }
 
-void AdInterface::clear_messages() {
-    d->messages.clear();
-}
+QSharedPointer<const AdInterfaceSettings> AdInterfacePrivate::current_settings() {
+    QMutexLocker locker(&settings_mutex);
 
-AdConfig *AdInterface::adconfig() const {
-    return d->adconfig;
+    return s_settings;
 }
 
-QString AdInterface::client_user() const {
-    return d->client_user;
+void AdInterfacePrivate::change_settings(std::function<void(AdInterfaceSettings *)> change) {
+    QMutexLocker locker(&settings_mutex);
+
+    AdInterfaceSettings *new_settings = new AdInterfaceSettings(*s_settings);
+    change(new_settings);
+
+    s_settings = QSharedPointer<const AdInterfaceSettings>(new_settings);
 }
 
-// Helper f-n for search()
-// NOTE: cookie is starts as NULL. Then after each while
-// loop, it is set to the value returned by
-// ldap_search_ext_s(). At the end cookie is set back to
-// NULL.
-bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl) {
+// Creates a new connection and binds it. On success, "ld"
+// is set to the new connection.
+bool AdInterfacePrivate::create_connection(const QString &dc, const AdInterfaceSettings &settings, LDAP **ld_out, QString *error_out) {
     int result;
-    LDAPMessage *res = NULL;
-    LDAPControl *page_control = NULL;
-    LDAPControl **returned_controls = NULL;
-    struct berval *prev_cookie = cookie->cookie;
-    struct berval *new_cookie = NULL;
-    BerElement *sd_control_value_be = NULL;
-    berval *sd_control_value_bv = NULL;
+    LDAP *new_ld = NULL;
 
-    auto cleanup = [&]() {
-        ldap_msgfree(res);
-        ldap_control_free(page_control);
-        ldap_controls_free(returned_controls);
-        ber_bvfree(prev_cookie);
-        ber_bvfree(new_cookie);
-        ber_free(sd_control_value_be, 1);
-        ber_bvfree(sd_control_value_bv);
-    };
+    const QString uri = [&]() {
+        QString out = "ldap://" + dc;
 
-    // NOTE: this control is needed so that ldap returns
-    // security descriptor attribute when we ask for all
-    // attributes. Otherwise it won't includ the descriptor
-    // in attributes. This might break something when the
-    // app is used by a client with not enough rights to get
-    // some/all parts of the descriptor. Investigate.
-    LDAPControl sd_control;
-    const char *sd_control_oid = LDAP_SERVER_SD_FLAGS_OID;
-    sd_control.ldctl_oid = (char *) sd_control_oid;
-    // NOTE: sacl part of the sd can only be obtained by
-    // administrators, so for normal operations we omit it.
-    // For some operations sacl is required so there's an
-    // option to get it.
-    const int sd_control_value_int = [&]() {
-        if (get_sacl) {
-            return (OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | SACL_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION);
-        } else {
-            return (OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION);
+        if (settings.port > 0) {
+            out = out + ":" + QString::number(settings.port);
         }
+
+        return out;
     }();
-    sd_control_value_be = ber_alloc_t(LBER_USE_DER);
-    ber_printf(sd_control_value_be, "{i}", sd_control_value_int);
-    ber_flatten(sd_control_value_be, &sd_control_value_bv);
-    sd_control.ldctl_value.bv_len = sd_control_value_bv->bv_len;
-    sd_control.ldctl_value.bv_val = sd_control_value_bv->bv_val;
-    sd_control.ldctl_iscritical = (char) 1;
+    const QByteArray uri_bytes = uri.toUtf8();
 
-    // Create page control
-    const ber_int_t page_size = 1000;
-    const int is_critical = 1;
-    result = ldap_create_page_control(ld, page_size, prev_cookie, is_critical, &page_control);
+    // NOTE: this doesn't leak memory. False positive.
+    result = ldap_initialize(&new_ld, uri_bytes.constData());
     if (result != LDAP_SUCCESS) {
-        qDebug() << "Failed to create page control: " << ldap_err2string(result);
+        ldap_memfree(new_ld);
+        *error_out = QString(tr("Failed to initialize LDAP library. Error: \"%1\"")).arg(strerror(errno));
 
-        cleanup();
         return false;
     }
-    LDAPControl *server_controls[3] = {page_control, &sd_control, NULL};
 
-    // Perform search
-    const int attrsonly = 0;
-    result = ldap_search_ext_s(ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &res);
-
-    if ((result != LDAP_SUCCESS) && (result != LDAP_PARTIAL_RESULTS)) {
-        // NOTE: it's not really an error for an object to
-        // not exist. For example, sometimes it's needed to
-        // check whether an object exists. Not sure how to
-        // distinguish this error type from others
-        if (result != LDAP_NO_SUCH_OBJECT) {
-            qDebug() << "Error in paged ldap_search_ext_s: " << ldap_err2string(result);
-        }
+    auto option_error = [&](const QString &option) {
+        ldap_unbind_ext(new_ld, NULL, NULL);
+        *error_out = QString(tr("Failed to set ldap option %1.")).arg(option);
+    };
 
-        cleanup();
+    // Set version
+    const int version = LDAP_VERSION3;
+    result = ldap_set_option(new_ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_PROTOCOL_VERSION");
         return false;
     }
 
-    // Collect results for this search
-    for (LDAPMessage *entry = ldap_first_entry(ld, res); entry != NULL; entry = ldap_next_entry(ld, entry)) {
-        char *dn_cstr = ldap_get_dn(ld, entry);
-        const QString dn(dn_cstr);
-        ldap_memfree(dn_cstr);
+    // Disable referrals
+    result = ldap_set_option(new_ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_REFERRALS");
+        return false;
+    }
 
-        QHash<QString, QList<QByteArray>> object_attributes;
+    // NOTE: limit TCP connect time, otherwise a DC that is
+    // down blocks until OS connect timeout which can be
+    // very long
+    struct timeval network_timeout;
+    network_timeout.tv_sec = CONNECT_TIMEOUT_SECONDS;
+    network_timeout.tv_usec = 0;
+    result = ldap_set_option(new_ld, LDAP_OPT_NETWORK_TIMEOUT, &network_timeout);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_NETWORK_TIMEOUT");
+        return false;
+    }
 
-        BerElement *berptr;
-        for (char *attr = ldap_first_attribute(ld, entry, &berptr); attr != NULL; attr = ldap_next_attribute(ld, entry, berptr)) {
-            struct berval **values_ldap = ldap_get_values_len(ld, entry, attr);
+    // NOTE: limit time of synchronous operations, so that
+    // a DC that stopped responding doesn't block them
+    // forever
+    struct timeval operation_timeout;
+    operation_timeout.tv_sec = settings.timeout + OPERATION_TIMEOUT_GRACE_SECONDS;
+    operation_timeout.tv_usec = 0;
+    result = ldap_set_option(new_ld, LDAP_OPT_TIMEOUT, &operation_timeout);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_TIMEOUT");
+        return false;
+    }
 
-            const QList<QByteArray> values_bytes = [=]() {
-                QList<QByteArray> out;
+    // Set maxssf
+    const char *sasl_secprops = "maxssf=56";
+    result = ldap_set_option(new_ld, LDAP_OPT_X_SASL_SECPROPS, sasl_secprops);
+    if (result != LDAP_SUCCESS) {
+        option_error("LDAP_OPT_X_SASL_SECPROPS");
+        return false;
+    }
 
-                if (values_ldap != NULL) {
-                    const int values_count = ldap_count_values_len(values_ldap);
-                    for (int i = 0; i < values_count; i++) {
-                        struct berval value_berval = *values_ldap[i];
-                        const QByteArray value_bytes(value_berval.bv_val, value_berval.bv_len);
+    result = ldap_set_option(new_ld, LDAP_OPT_X_SASL_NOCANON, settings.sasl_nocanon);
+    if (result != LDAP_SUCCESS) {
+        option_error("LDAP_OPT_X_SASL_NOCANON");
+        return false;
+    }
 
-                        out.append(value_bytes);
-                    }
-                }
-
-                return out;
-            }();
-
-            const QString attribute(attr);
-
-            object_attributes[attribute] = values_bytes;
-
-            ldap_value_free_len(values_ldap);
-            ldap_memfree(attr);
+    const void *cert_strategy = [&]() {
+        switch (settings.cert_strategy) {
+            case CertStrategy_Never: return (void *) LDAP_OPT_X_TLS_NEVER;
+            case CertStrategy_Hard: return (void *) LDAP_OPT_X_TLS_HARD;
+            case CertStrategy_Demand: return (void *) LDAP_OPT_X_TLS_DEMAND;
+            case CertStrategy_Allow: return (void *) LDAP_OPT_X_TLS_ALLOW;
+            case CertStrategy_Try: return (void *) LDAP_OPT_X_TLS_TRY;
         }
-        ber_free(berptr, 0);
 
-        AdObject object;
-        object.load(dn, object_attributes);
-
-        results->insert(dn, object);
-    }
-
-    // Parse the results to retrieve returned controls
-    int errcodep;
-    result = ldap_parse_result(ld, res, &errcodep, NULL, NULL, NULL, &returned_controls, false);
+        return (void *) LDAP_OPT_X_TLS_NEVER;
+    }();
+    
+    ldap_set_option(new_ld, LDAP_OPT_X_TLS_REQUIRE_CERT, cert_strategy);
     if (result != LDAP_SUCCESS) {
-        qDebug() << "Failed to parse result: " << ldap_err2string(result);
-
-        cleanup();
+        option_error("LDAP_OPT_X_TLS_REQUIRE_CERT");
         return false;
     }
 
-    // Get page response control
-    LDAPControl *pageresponse_control = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, returned_controls, NULL);
-    if (pageresponse_control == NULL) {
-        qDebug() << "Failed to find PAGEDRESULTS control";
-
-        cleanup();
-        return false;
-    }
+    // Setup sasl_defaults_gssapi
+    struct sasl_defaults_gssapi defaults;
+    defaults.mech = (char *) "GSSAPI";
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_REALM, &defaults.realm);
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_AUTHCID, &defaults.authcid);
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_AUTHZID, &defaults.authzid);
+    defaults.passwd = NULL;
 
-    // Parse page response control to determine whether
-    // there are more pages
-    ber_int_t total_count;
-    new_cookie = (struct berval *) malloc(sizeof(struct berval));
-    result = ldap_parse_pageresponse_control(ld, pageresponse_control, &total_count, new_cookie);
+    // Perform bind operation
+    unsigned sasl_flags = LDAP_SASL_QUIET;
+    result = ldap_sasl_interactive_bind_s(new_ld, NULL, defaults.mech, NULL, NULL, sasl_flags, sasl_interact_gssapi, &defaults);
+    ldap_memfree(defaults.realm);
+    ldap_memfree(defaults.authcid);
+    ldap_memfree(defaults.authzid);
     if (result != LDAP_SUCCESS) {
-        qDebug() << "Failed to parse pageresponse control: " << ldap_err2string(result);
+        ldap_unbind_ext(new_ld, NULL, NULL);
+        *error_out = error_string(result);
 
-        cleanup();
         return false;
     }
 
-    // Switch to new cookie if there are more pages
-    // NOTE: there are more pages if the cookie isn't
-    // empty
-    const bool more_pages = (new_cookie->bv_len > 0);
-    if (more_pages) {
-        cookie->cookie = ber_bvdup(new_cookie);
-    } else {
-        cookie->cookie = NULL;
-    }
+    *ld_out = new_ld;
 
-    cleanup();
     return true;
 }
 
-QHash<QString, AdObject> AdInterface::search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
-    AdCookie cookie;
-    QHash<QString, AdObject> results;
+bool AdInterfacePrivate::connect_race(const QList<QString> &dc_list, QList<QString> *failed_list) {
+    QSharedPointer<ConnectRaceState> state = QSharedPointer<ConnectRaceState>::create();
+    state->winner_ld = NULL;
+    state->finished_count = 0;
+    state->race_over = false;
+
+    const int candidate_count = std::min(dc_list.size(), CONNECT_RACE_MAX_CANDIDATES);
+
+    // NOTE: use separate pool so that connect attempts
+    // are not limited by global pool's thread count
+    static QThreadPool connect_pool;
+    connect_pool.setMaxThreadCount(CONNECT_RACE_MAX_CANDIDATES * 2);
+
+    {
+        QMutexLocker locker(&state->mutex);
+
+        for (int i = 0; i < candidate_count; i++) {
+            const QString pool_key = connection_pool_key(dc_list[i], routing);
+            connect_pool.start(new ConnectAttemptTask(state, dc_list[i], pool_key, settings, pool_generation));
+
+            // Give this attempt a head start before
+            // starting the next one. Skip waiting if all
+            // started attempts have already failed.
+            const bool is_last = (i == candidate_count - 1);
+            if (!is_last) {
+                QElapsedTimer stagger_timer;
+                stagger_timer.start();
+
+                while (state->winner_ld == NULL && state->finished_count < i + 1) {
+                    const qint64 remaining = CONNECT_RACE_STAGGER_MS - stagger_timer.elapsed();
+                    if (remaining <= 0) {
+                        break;
+                    }
 
-    if (AdInterfacePrivate::s_log_searches) {
-        const QString attributes_string = "{" + attributes.join(",") + "}";
+                    state->condition.wait(&state->mutex, remaining);
+                }
+            }
 
-        const QString scope_string = [&scope]() -> QString {
-            switch (scope) {
-                case SearchScope_Object: return "object";
-                case SearchScope_Children: return "children";
-                case SearchScope_Descendants: return "descendants";
-                case SearchScope_All: return "all";
-                default: break;
+            if (state->winner_ld != NULL) {
+                break;
             }
-            return QString();
-        }();
+        }
 
-        d->success_message(QString(tr("Search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tscope = \"%3\"\n\tbase = \"%4\"")).arg(filter, attributes_string, scope_string, base));
-    }
+        // Wait for a winner or for all attempts to fail.
+        // Attempts are bounded by network timeout so this
+        // doesn't wait forever.
+        while (state->winner_ld == NULL && state->finished_count < candidate_count) {
+            state->condition.wait(&state->mutex);
+        }
 
-    while (true) {
-        const bool success = search_paged(base, scope, filter, attributes, &results, &cookie);
+        // NOTE: attempts that finish after this point
+        // return their connections to the pool
+        state->race_over = true;
 
-        if (!success) {
-            break;
-        }
+        *failed_list = state->failed_list;
 
-        if (!cookie.more_pages()) {
-            break;
+        if (state->winner_ld == NULL) {
+            if (!state->error_list.isEmpty()) {
+                error_message_plain(tr("Failed to connect to server. Check your connection and make sure you have initialized your credentials using kinit."));
+                error_message_plain(state->error_list.last());
+            }
+
+            return false;
         }
+
+        ld = state->winner_ld;
+        dc = state->winner_dc;
     }
 
-    return results;
+    return true;
 }
 
-bool AdInterface::search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie) {
-    const char *base_cstr = cstr(base);
+bool AdInterfacePrivate::connect_gc() {
+    const QString connect_error_context = tr("Failed to connect to Global Catalog.");
 
-    const int scope_int = [&]() {
-        switch (scope) {
-            case SearchScope_Object: return LDAP_SCOPE_BASE;
-            case SearchScope_Children: return LDAP_SCOPE_ONELEVEL;
-            case SearchScope_All: return LDAP_SCOPE_SUBTREE;
-            case SearchScope_Descendants: return LDAP_SCOPE_CHILDREN;
-        }
-        return 0;
-    }();
+    AdDiscoveryCache *discovery = AdDiscoveryCache::instance();
 
-    const char *filter_cstr = [&]() {
-        if (filter.isEmpty()) {
-            // NOTE: need to pass NULL instead of empty
-            // string to denote "no filter"
-            return (const char *) NULL;
-        } else {
-            return cstr(filter);
-        }
-    }();
+    const QString forest = discovery->forest_of(domain);
+    if (forest.isEmpty()) {
+        error_message(connect_error_context, tr("Failed to find Global Catalog servers."));
 
-    // Convert attributes list to NULL-terminated array
-    char **attributes_array = [&]() {
-        char **out;
-        if (attributes.isEmpty()) {
-            // Pass NULL so LDAP gets all attributes
-            out = NULL;
-        } else {
-            out = (char **) malloc((attributes.size() + 1) * sizeof(char *));
+        return false;
+    }
 
-            if (out != NULL) {
-                for (int i = 0; i < attributes.size(); i++) {
-                    const QString attribute = attributes[i];
-                    out[i] = strdup(cstr(attribute));
-                }
-                out[attributes.size()] = NULL;
+    domain_head = domain_to_domain_dn(forest);
+
+    // NOTE: GC port comes from SRV records and is made
+    // part of the host, so port from settings must not be
+    // added on top of it.
+    AdInterfaceSettings gc_settings = *settings;
+    gc_settings.port = 0;
+    settings = QSharedPointer<const AdInterfaceSettings>(new AdInterfaceSettings(gc_settings));
+
+    const QList<QString> candidate_list = [&]() {
+        const QString site = discovery->client_site(domain);
+        const QList<AdSrvRecord> record_list = discovery->get_gc_records(forest, site);
+
+        QList<QString> out;
+
+        for (const AdSrvRecord &record : record_list) {
+            const QString candidate = QString("%1:%2").arg(record.host).arg(record.port);
+
+            if (!out.contains(candidate)) {
+                out.append(candidate);
             }
         }
 
         return out;
     }();
 
-    const bool search_success = d->search_paged_internal(base_cstr, scope_int, filter_cstr, attributes_array, results, cookie);
-    if (!search_success) {
-        results->clear();
+    if (candidate_list.isEmpty()) {
+        error_message(connect_error_context, tr("Failed to find Global Catalog servers."));
 
         return false;
     }
 
-    if (attributes_array != NULL) {
-        for (int i = 0; attributes_array[i] != NULL; i++) {
-            free(attributes_array[i]);
+    for (const QString &candidate : candidate_list) {
+        ld = AdConnectionPool::instance()->acquire(connection_pool_key(candidate, routing));
+
+        if (ld != NULL) {
+            dc = candidate;
+
+            return true;
         }
-        free(attributes_array);
     }
 
-    return true;
-}
+    QList<QString> failed_list;
+    const bool connect_success = connect_race(candidate_list, &failed_list);
 
-AdObject AdInterface::search_object(const QString &dn, const QList<QString> &attributes) {
-    const QString base = dn;
-    const SearchScope scope = SearchScope_Object;
-    const QString filter = QString();
-    const QHash<QString, AdObject> results = search(base, scope, filter, attributes);
+    return connect_success;
+}
 
-    if (results.contains(dn)) {
-        return results[dn];
-    } else {
-        return AdObject();
+bool AdInterfacePrivate::gc_can_answer(const QString &filter, const QList<QString> &attributes) const {
+    if (adconfig == nullptr || attributes.isEmpty()) {
+        return false;
     }
-}
 
-bool AdInterface::attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg) {
-    const AdObject object = search_object(dn, {attribute});
-    const QList<QByteArray> old_values = object.get_values(attribute);
-    const QString name = dn_get_name(dn);
-    const QString values_display = attribute_display_values(attribute, values, d->adconfig);
-    const QString old_values_display = attribute_display_values(attribute, old_values, d->adconfig);
+    const QList<QString> needed_list = attributes + filter_get_attributes(filter);
 
-    // Do nothing if both new and old values are empty
-    if (old_values.isEmpty() && values.isEmpty()) {
-        return true;
+    for (const QString &attribute : needed_list) {
+        if (!adconfig->get_attribute_is_in_gc(attribute)) {
+            return false;
+        }
     }
 
-    // NOTE: store bvalues in array instead of dynamically allocating ptrs
-    struct berval bvalues_storage[values.size()];
-    struct berval *bvalues[values.size() + 1];
-    bvalues[values.size()] = NULL;
-    for (int i = 0; i < values.size(); i++) {
-        const QByteArray value = values[i];
-        struct berval *bvalue = &(bvalues_storage[i]);
-
-        bvalue->bv_val = (char *) value.constData();
-        bvalue->bv_len = (size_t) value.size();
+    return true;
+}
 
-        bvalues[i] = bvalue;
+bool AdInterfacePrivate::failover() {
+    // NOTE: GC connections don't fail over, because other
+    // DC's may not be GC's. Search falls back to domain
+    // instead.
+    if (!is_connected || routing == AdRouting_GlobalCatalog) {
+        return false;
     }
 
-    LDAPMod attr;
-    attr.mod_op = (LDAP_MOD_REPLACE | LDAP_MOD_BVALUES);
-    attr.mod_type = (char *) cstr(attribute);
-    attr.mod_bvalues = bvalues;
+    const QString failed_dc = dc;
+    LDAP *failed_ld = ld;
 
-    LDAPMod *attrs[] = {&attr, NULL};
+    const QList<QString> candidate_list = [&]() {
+        AdDiscoveryCache *discovery = AdDiscoveryCache::instance();
 
-    const int result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
+        QList<QString> out = discovery->ranked_hosts(domain);
 
-    if (result == LDAP_SUCCESS) {
-        d->success_message(QString(tr("Attribute %1 of object %2 was changed from \"%3\" to \"%4\".")).arg(attribute, name, old_values_display, values_display), do_msg);
+        if (out.isEmpty()) {
+            const QString site = discovery->client_site(domain);
+            out = get_domain_hosts(domain, site);
+        }
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to change attribute %1 of object %2 from \"%3\" to \"%4\".")).arg(attribute, name, old_values_display, values_display);
+        out.removeAll(failed_dc);
 
-        d->error_message(context, d->default_error(), do_msg);
+        return out;
+    }();
 
+    // NOTE: if failover fails, keep the broken connection
+    // so that ops fail normally with a connection error
+    QList<QString> failed_list;
+    const bool connect_success = connect_race(candidate_list, &failed_list);
+    if (!connect_success) {
         return false;
     }
-}
 
-bool AdInterface::attribute_replace_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
-    const QList<QByteArray> values = [=]() -> QList<QByteArray> {
-        if (value.isEmpty()) {
-            return QList<QByteArray>();
-        } else {
-            return {value};
-        }
-    }();
+    ldap_unbind_ext(failed_ld, NULL, NULL);
 
-    return attribute_replace_values(dn, attribute, values, do_msg);
+    // NOTE: move this connection's count in router from
+    // failed DC to the new one, otherwise reads keep
+    // avoiding new DC and failed DC is never released
+    AdReadRouter *router = AdReadRouter::instance();
+    if (!routed_dc.isEmpty()) {
+        router->remove(routed_dc);
+    }
+    router->add(dc);
+    routed_dc = dc;
+
+    // NOTE: switch default DC so that next connections
+    // don't try the dead one
+    const QString new_dc = dc;
+    change_settings(
+        [&](AdInterfaceSettings *new_settings) {
+            if (new_settings->dc == failed_dc) {
+                new_settings->dc = new_dc;
+                new_settings->dc_pinned = false;
+            }
+        });
+
+    success_message(QString(tr("Lost connection to %1, switched to %2.")).arg(failed_dc, dc));
+
+    return true;
 }
 
-bool AdInterface::attribute_add_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
-    char *data_copy = (char *) malloc(value.size());
-    if (data_copy == NULL) {
+bool AdInterfacePrivate::switch_dc(const QString &target_dc) {
+    if (!is_connected || routing == AdRouting_GlobalCatalog) {
         return false;
     }
-    memcpy(data_copy, value.constData(), value.size());
 
-    struct berval ber_data;
-    ber_data.bv_val = data_copy;
-    ber_data.bv_len = value.size();
+    if (dc == target_dc) {
+        return true;
+    }
 
-    struct berval *values[] = {&ber_data, NULL};
+    // NOTE: connection with running notifications can't be
+    // returned to the pool
+    if (!notification_ids.isEmpty()) {
+        return false;
+    }
 
-    LDAPMod attr;
-    attr.mod_op = LDAP_MOD_ADD | LDAP_MOD_BVALUES;
-    attr.mod_type = (char *) cstr(attribute);
-    attr.mod_bvalues = values;
+    AdConnectionPool *pool = AdConnectionPool::instance();
 
-    LDAPMod *attrs[] = {&attr, NULL};
+    const int new_generation = pool->generation();
 
-    const int result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
-    free(data_copy);
+    LDAP *new_ld = pool->acquire(connection_pool_key(target_dc, routing));
 
-    const QString name = dn_get_name(dn);
-    const QString new_display_value = attribute_display_value(attribute, value, d->adconfig);
+    if (new_ld == NULL) {
+        QString error;
+        const bool create_success = create_connection(target_dc, *settings, &new_ld, &error);
 
-    if (result == LDAP_SUCCESS) {
-        const QString context = QString(tr("Value \"%1\" was added for attribute %2 of object %3.")).arg(new_display_value, attribute, name);
+        if (!create_success) {
+            qDebug() << "Failed to switch to" << target_dc << ":" << error;
 
-        d->success_message(context, do_msg);
+            return false;
+        }
+    }
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to add value \"%1\" for attribute %2 of object %3.")).arg(new_display_value, attribute, name);
+    const bool is_healthy = [&]() {
+        const int ldap_result = get_ldap_result();
+        const bool connection_lost = (ldap_result == LDAP_SERVER_DOWN || ldap_result == LDAP_CONNECT_ERROR || ldap_result == LDAP_TIMEOUT);
 
-        d->error_message(context, d->default_error(), do_msg);
+        return !connection_lost;
+    }();
 
-        return false;
-    }
-}
+    pool->release(ld, connection_pool_key(dc, routing), pool_generation, is_healthy);
 
-bool AdInterface::attribute_delete_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
-    const QString name = dn_get_name(dn);
-    const QString value_display = attribute_display_value(attribute, value, d->adconfig);
+    ld = new_ld;
+    dc = target_dc;
+    pool_generation = new_generation;
 
-    char *data_copy = (char *) malloc(value.size());
-    if (data_copy == NULL) {
-        return false;
+    AdReadRouter *router = AdReadRouter::instance();
+    if (!routed_dc.isEmpty()) {
+        router->remove(routed_dc);
     }
-    memcpy(data_copy, value.constData(), value.size());
-
-    struct berval ber_data;
-    ber_data.bv_val = data_copy;
-    ber_data.bv_len = value.size();
+    router->add(dc);
+    routed_dc = dc;
 
-    LDAPMod attr;
-    struct berval *values[] = {&ber_data, NULL};
-    attr.mod_op = LDAP_MOD_DELETE | LDAP_MOD_BVALUES;
-    attr.mod_type = (char *) cstr(attribute);
-    attr.mod_bvalues = values;
+    return true;
+}
 
-    LDAPMod *attrs[] = {&attr, NULL};
+int AdInterfacePrivate::with_failover(std::function<int()> op) {
+    const int result = op();
 
-    const int result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
-    free(data_copy);
+    const bool connection_lost = (result == LDAP_SERVER_DOWN || result == LDAP_CONNECT_ERROR);
+    if (!connection_lost) {
+        return result;
+    }
 
-    if (result == LDAP_SUCCESS) {
-        const QString context = QString(tr("Value \"%1\" for attribute %2 of object %3 was deleted.")).arg(value_display, attribute, name);
+    const bool failover_success = failover();
+    if (!failover_success) {
+        return result;
+    }
 
-        d->success_message(context, do_msg);
+    return op();
+}
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to delete value \"%1\" for attribute %2 of object %3.")).arg(value_display, attribute, name);
+int AdInterfacePrivate::send_write(std::function<int()> send_op) {
+    const int msgid = send_op();
 
-        d->error_message(context, d->default_error(), do_msg);
+    if (msgid != -1) {
+        return msgid;
+    }
 
-        return false;
+    // NOTE: write that failed to send never reached the
+    // server, so it's safe to send it again
+    const int result = get_ldap_result();
+    const bool connection_lost = (result == LDAP_SERVER_DOWN || result == LDAP_CONNECT_ERROR);
+    if (!connection_lost) {
+        return -1;
     }
-}
 
-bool AdInterface::attribute_replace_string(const QString &dn, const QString &attribute, const QString &value, const DoStatusMsg do_msg) {
-    const QByteArray value_bytes = value.toUtf8();
+    const bool failover_success = failover();
+    if (!failover_success) {
+        return -1;
+    }
 
-    return attribute_replace_value(dn, attribute, value_bytes, do_msg);
+    return send_op();
 }
 
-bool AdInterface::attribute_replace_int(const QString &dn, const QString &attribute, const int value, const DoStatusMsg do_msg) {
-    const QString value_string = QString::number(value);
-    const bool result = attribute_replace_string(dn, attribute, value_string, do_msg);
+int AdInterfacePrivate::receive_result(const int msgid, const int all, LDAPMessage **res) {
+    QElapsedTimer timer;
+    timer.start();
 
-    return result;
-}
+    const qint64 timeout_ms = (settings->timeout + OPERATION_TIMEOUT_GRACE_SECONDS) * 1000;
 
-bool AdInterface::attribute_replace_datetime(const QString &dn, const QString &attribute, const QDateTime &datetime) {
-    const QString datetime_string = datetime_qdatetime_to_string(attribute, datetime, d->adconfig);
-    const bool result = attribute_replace_string(dn, attribute, datetime_string);
+    while (true) {
+        const bool cancelled = (cancel_requested.loadAcquire() != 0);
+        const bool timed_out = (timer.elapsed() > timeout_ms);
 
-    return result;
+        if (cancelled || timed_out) {
+            if (msgid != LDAP_RES_ANY) {
+                ldap_abandon_ext(ld, msgid, NULL, NULL);
+            }
+
+            int result_code = [&]() {
+                if (cancelled) {
+                    return LDAP_USER_CANCELLED;
+                } else {
+                    return LDAP_TIMEOUT;
+                }
+            }();
+            ldap_set_option(ld, LDAP_OPT_RESULT_CODE, &result_code);
+
+            return 0;
+        }
+
+        struct timeval poll_interval;
+        poll_interval.tv_sec = 0;
+        poll_interval.tv_usec = RESULT_POLL_INTERVAL_MS * 1000;
+
+        const int res_type = ldap_result(ld, msgid, all, &poll_interval, res);
+        if (res_type != 0) {
+            return res_type;
+        }
+    }
 }
 
-bool AdInterface::object_add(const QString &dn, const QString &object_class) {
-    const char *classes[2] = {cstr(object_class), NULL};
+int AdInterfacePrivate::search_async(const char *base, const int scope, const char *filter, char **attributes, LDAPControl **server_controls, LDAPMessage **res) {
+    struct timeval time_limit;
+    time_limit.tv_sec = settings->timeout;
+    time_limit.tv_usec = 0;
 
-    LDAPMod attr;
-    attr.mod_op = LDAP_MOD_ADD;
-    attr.mod_type = (char *) "objectClass";
-    attr.mod_values = (char **) classes;
+    const int attrsonly = 0;
+    int msgid;
+    const int send_result = ldap_search_ext(ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, &time_limit, LDAP_NO_LIMIT, &msgid);
+    if (send_result != LDAP_SUCCESS) {
+        return send_result;
+    }
 
-    LDAPMod *attrs[] = {&attr, NULL};
+    const int res_type = receive_result(msgid, LDAP_MSG_ALL, res);
+    if (res_type == -1 || res_type == 0) {
+        return get_ldap_result();
+    }
 
-    const int result = ldap_add_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
+    const int free_res = 0;
 
-    if (result == LDAP_SUCCESS) {
-        d->success_message(QString(tr("Object %1 was created.")).arg(dn));
+    return ldap_result2error(ld, *res, free_res);
+}
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to create object %1.")).arg(dn);
+void AdInterface::set_range_limit(const int max_values) {
+    d->range_limit = max_values;
+}
 
-        const QString error = [this, dn]() {
-            const bool wrong_ou_parent = [&]() {
-                const int ldap_result = d->get_ldap_result();
-                
-                const bool is_ou = dn.startsWith("OU=");
-                const QString parent = dn_get_parent(dn);
-                const bool bad_parent = parent.startsWith("CN=");
+void AdInterface::cancel() {
+    d->cancel_requested.storeRelease(1);
+}
 
-                const bool out = (ldap_result == LDAP_NAMING_VIOLATION && is_ou && bad_parent);
+AdOperationGuard::AdOperationGuard(AdInterfacePrivate *d_arg) {
+    d = d_arg;
+    d->operation_depth++;
+}
 
-                return out;
-            }();
+AdOperationGuard::~AdOperationGuard() {
+    d->operation_depth--;
 
-            if (wrong_ou_parent) {
-                return tr("Can't create OU under this object type.");
-            } else {
-                return d->default_error();
-            }
-        }();
+    if (d->operation_depth == 0) {
+        d->cancel_requested.storeRelease(0);
+    }
+}
 
-        d->error_message(context, error);
+bool AdInterface::is_connected() const {
+    return d->is_connected;
+}
 
-        return false;
+QList<AdMessage> AdInterface::messages() const {
+    return d->messages;
+}
+
+bool AdInterface::any_error_messages() const {
+    for (const auto &message : d->messages) {
+        if (message.type() == AdMessageType_Error) {
+            return true;
+        }
     }
+
+    return false;
 }
 
-bool AdInterface::object_delete(const QString &dn, const DoStatusMsg do_msg) {
+void AdInterface::clear_messages() {
+    d->messages.clear();
+}
+
+AdConfig *AdInterface::adconfig() const {
+    return d->adconfig;
+}
+
+QString AdInterface::client_user() const {
+    return d->client_user;
+}
+
+QString AdInterface::connected_dc() const {
+    return d->dc;
+}
+
+// Helper f-n for search()
+// NOTE: cookie is starts as NULL. Then after each while
+// loop, it is set to the value returned by
+// the server. At the end cookie is set back to
+// NULL.
+bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl, const bool show_deleted) {
     int result;
-    LDAPControl *tree_delete_control = NULL;
+    LDAPMessage *res = NULL;
+    LDAPControl *page_control = NULL;
+    LDAPControl **returned_controls = NULL;
+    // NOTE: take ownership of previous cookie so that it's
+    // not freed twice if search fails
+    struct berval *prev_cookie = cookie->cookie;
+    cookie->cookie = NULL;
+    struct berval *new_cookie = NULL;
+    berval *sd_control_value_bv = NULL;
 
-    auto cleanup = [tree_delete_control]() {
-        ldap_control_free(tree_delete_control);
+    auto cleanup = [&]() {
+        ldap_msgfree(res);
+        ldap_control_free(page_control);
+        ldap_controls_free(returned_controls);
+        ber_bvfree(prev_cookie);
+        ber_bvfree(new_cookie);
+        ber_bvfree(sd_control_value_bv);
     };
 
-    const QString name = dn_get_name(dn);
-
-    const QString error_context = QString(tr("Failed to delete object %1.")).arg(name);
+    // NOTE: this control is needed so that ldap returns
+    // security descriptor attribute when we ask for all
+    // attributes. Otherwise it won't includ the descriptor
+    // in attributes. This might break something when the
+    // app is used by a client with not enough rights to get
+    // some/all parts of the descriptor. Investigate.
+    LDAPControl sd_control;
+    const char *sd_control_oid = LDAP_SERVER_SD_FLAGS_OID;
+    sd_control.ldctl_oid = (char *) sd_control_oid;
+    sd_control_value_bv = sd_control_value(get_sacl);
+    if (sd_control_value_bv == NULL) {
+        qDebug() << "Failed to create SD flags control";
 
-    // Use a tree delete control to enable recursive delete
-    tree_delete_control = (LDAPControl *) malloc(sizeof(LDAPControl));
-    if (tree_delete_control == NULL) {
-        d->error_message(error_context, tr("LDAP Operation error - Failed to allocate tree delete control."));
         cleanup();
-
         return false;
     }
+    sd_control.ldctl_value.bv_len = sd_control_value_bv->bv_len;
+    sd_control.ldctl_value.bv_val = sd_control_value_bv->bv_val;
+    sd_control.ldctl_iscritical = (char) 1;
 
-    result = ldap_control_create(LDAP_CONTROL_X_TREE_DELETE, 1, NULL, 0, &tree_delete_control);
+    // Create page control
+    const ber_int_t page_size = cookie->page_size;
+    auto create_page_control = [&]() {
+        ldap_control_free(page_control);
+        page_control = NULL;
+
+        const int is_critical = 1;
+
+        return ldap_create_page_control(ld, page_size, prev_cookie, is_critical, &page_control);
+    };
+    result = create_page_control();
     if (result != LDAP_SUCCESS) {
-        d->error_message(error_context, tr("LDAP Operation error - Failed to create tree delete control."));
-        cleanup();
+        qDebug() << "Failed to create page control: " << ldap_err2string(result);
 
+        cleanup();
         return false;
     }
+    LDAPControl show_deleted_control;
+    const char *show_deleted_control_oid = LDAP_SERVER_SHOW_DELETED_OID;
+    show_deleted_control.ldctl_oid = (char *) show_deleted_control_oid;
+    show_deleted_control.ldctl_value.bv_len = 0;
+    show_deleted_control.ldctl_value.bv_val = NULL;
+    show_deleted_control.ldctl_iscritical = (char) 1;
+
+    LDAPControl *server_controls[4] = {page_control, &sd_control, NULL, NULL};
+    if (show_deleted) {
+        server_controls[2] = &show_deleted_control;
+    }
 
-    LDAPControl *server_controls[2] = {tree_delete_control, NULL};
+    // Perform search
+    QElapsedTimer page_timer;
+    page_timer.start();
 
-    result = ldap_delete_ext_s(d->ld, cstr(dn), server_controls, NULL);
+    auto search_op = [&]() {
+        ldap_msgfree(res);
+        res = NULL;
 
-    cleanup();
+        server_controls[0] = page_control;
 
-    if (result == LDAP_SUCCESS) {
-        d->success_message(QString(tr("Object %1 was deleted.")).arg(name), do_msg);
+        page_timer.restart();
 
-        return true;
-    } else {
-        d->error_message(error_context, d->default_error(), do_msg);
+        return search_async(base, scope, filter, attributes, server_controls, &res);
+    };
 
-        return false;
+    const bool is_first_page = (prev_cookie == NULL);
+    if (is_first_page) {
+        result = with_failover(search_op);
+    } else {
+        result = search_op();
+
+        // NOTE: cookies for next pages are only valid on
+        // the DC that issued them, so if connection was
+        // lost in the middle of the search, start over
+        // from the first page on another DC. Results of
+        // previous pages are dropped, so that caller
+        // doesn't get a mix of results from different
+        // DC's.
+        const bool connection_lost = (result == LDAP_SERVER_DOWN || result == LDAP_CONNECT_ERROR);
+        if (connection_lost && failover()) {
+            results->clear();
+
+            ber_bvfree(prev_cookie);
+            prev_cookie = NULL;
+
+            result = create_page_control();
+            if (result == LDAP_SUCCESS) {
+                result = search_op();
+            }
+        }
     }
-}
 
-bool AdInterface::object_move(const QString &dn, const QString &new_container) {
-    const QString rdn = dn.split(',')[0];
-    const QString new_dn = rdn + "," + new_container;
-    const QString object_name = dn_get_name(dn);
-    const QString container_name = dn_get_name(new_container);
+    const bool time_limit_exceeded = (result == LDAP_TIMELIMIT_EXCEEDED);
 
-    const int result = ldap_rename_s(d->ld, cstr(dn), cstr(rdn), cstr(new_container), 1, NULL, NULL);
+    if ((result != LDAP_SUCCESS) && (result != LDAP_PARTIAL_RESULTS) && !time_limit_exceeded) {
+        // NOTE: it's not really an error for an object to
+        // not exist. For example, sometimes it's needed to
+        // check whether an object exists. Not sure how to
+        // distinguish this error type from others
+        if (result != LDAP_NO_SUCH_OBJECT) {
+            qDebug() << "Error in paged search: " << ldap_err2string(result);
+        }
 
-    if (result == LDAP_SUCCESS) {
-        d->success_message(QString(tr("Object %1 was moved to %2.")).arg(object_name, container_name));
+        cleanup();
+        return false;
+    }
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to move object %1 to %2.")).arg(object_name, container_name);
+    const qint64 page_ms = page_timer.elapsed();
 
-        d->error_message(context, d->default_error());
+    // Collect results for this search. Objects of one page
+    // share an arena.
+    AdObjectBuilder builder;
+    int entry_count = 0;
+    qint64 page_bytes = 0;
+    for (LDAPMessage *entry = ldap_first_entry(ld, res); entry != NULL; entry = ldap_next_entry(ld, entry)) {
+        int entry_size = 0;
+        const AdObject object = load_entry(entry, &entry_size, &builder);
 
-        return false;
+        results->insert(object.get_dn(), object);
+
+        entry_count++;
+        page_bytes += entry_size;
     }
-}
 
-bool AdInterface::object_rename(const QString &dn, const QString &new_name) {
-    const QString new_dn = dn_rename(dn, new_name);
-    const QString new_rdn = new_dn.split(",")[0];
-    const QString old_name = dn_get_name(dn);
+    // NOTE: whole page is received at once, so time to
+    // first entry is unknown. Count whole page time as
+    // latency, then page size only shrinks if entries are
+    // big, using the same limits as streaming search.
+    cookie->page_size = stream_next_page_size(page_size, entry_count, page_bytes, page_ms, page_ms);
 
-    const int result = ldap_rename_s(d->ld, cstr(dn), cstr(new_rdn), NULL, 1, NULL, NULL);
+    // NOTE: server returns objects it found before time
+    // limit ran out, return them as the last page
+    if (time_limit_exceeded) {
+        error_message_plain(tr("Search took too long and was stopped, results are incomplete."));
 
-    if (result == LDAP_SUCCESS) {
-        d->success_message(QString(tr("Object %1 was renamed to %2.")).arg(old_name, new_name));
+        cookie->cookie = NULL;
 
+        cleanup();
         return true;
-    } else {
-        const QString context = QString(tr("Failed to rename object %1 to %2.")).arg(old_name, new_name);
+    }
 
-        d->error_message(context, d->default_error());
+    // Parse the results to retrieve returned controls
+    int errcodep;
+    result = ldap_parse_result(ld, res, &errcodep, NULL, NULL, NULL, &returned_controls, false);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to parse result: " << ldap_err2string(result);
 
+        cleanup();
         return false;
     }
-}
 
-bool AdInterface::group_add_member(const QString &group_dn, const QString &user_dn) {
-    const QByteArray user_dn_bytes = user_dn.toUtf8();
-    const bool success = attribute_add_value(group_dn, ATTRIBUTE_MEMBER, user_dn_bytes, DoStatusMsg_No);
+    // Get page response control
+    LDAPControl *pageresponse_control = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, returned_controls, NULL);
+    if (pageresponse_control == NULL) {
+        qDebug() << "Failed to find PAGEDRESULTS control";
 
-    const QString user_name = dn_get_name(user_dn);
-    const QString group_name = dn_get_name(group_dn);
+        cleanup();
+        return false;
+    }
 
-    if (success) {
-        d->success_message(QString(tr("Object %1 was added to group %2.")).arg(user_name, group_name));
+    // Parse page response control to determine whether
+    // there are more pages
+    ber_int_t total_count;
+    new_cookie = (struct berval *) malloc(sizeof(struct berval));
+    result = ldap_parse_pageresponse_control(ld, pageresponse_control, &total_count, new_cookie);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to parse pageresponse control: " << ldap_err2string(result);
 
-        return true;
+        cleanup();
+        return false;
+    }
+
+    // Switch to new cookie if there are more pages
+    // NOTE: there are more pages if the cookie isn't
+    // empty
+    const bool more_pages = (new_cookie->bv_len > 0);
+    if (more_pages) {
+        cookie->cookie = ber_bvdup(new_cookie);
     } else {
-        const QString context = QString(tr("Failed to add object %1 to group %2.")).arg(user_name, group_name);
+        cookie->cookie = NULL;
+    }
 
-        d->error_message(context, d->default_error());
+    cleanup();
+    return true;
+}
+
+bool AdInterfacePrivate::search_stream_internal(const char *base, const int scope, const char *filter, char **attributes, std::function<bool(const AdObject &object)> callback, const bool get_sacl) {
+    struct berval *sd_value = sd_control_value(get_sacl);
+    if (sd_value == NULL) {
+        qDebug() << "Failed to create SD flags control";
 
         return false;
     }
-}
 
-bool AdInterface::group_remove_member(const QString &group_dn, const QString &user_dn) {
-    const QByteArray user_dn_bytes = user_dn.toUtf8();
-    const bool success = attribute_delete_value(group_dn, ATTRIBUTE_MEMBER, user_dn_bytes, DoStatusMsg_No);
+    // NOTE: see search_paged_internal() for why this
+    // control is needed
+    LDAPControl sd_control;
+    const char *sd_control_oid = LDAP_SERVER_SD_FLAGS_OID;
+    sd_control.ldctl_oid = (char *) sd_control_oid;
+    sd_control.ldctl_value.bv_len = sd_value->bv_len;
+    sd_control.ldctl_value.bv_val = sd_value->bv_val;
+    sd_control.ldctl_iscritical = (char) 1;
 
-    const QString user_name = dn_get_name(user_dn);
-    const QString group_name = dn_get_name(group_dn);
+    struct berval *cookie = NULL;
+    int page_size = STREAM_FIRST_PAGE_SIZE;
+    bool success = true;
+    bool stopped = false;
+    bool is_first_page = true;
 
-    if (success) {
-        d->success_message(QString(tr("Object %1 was removed from group %2.")).arg(user_name, group_name));
+    // NOTE: page is still being received while entries
+    // are loaded, so ranged attributes are completed
+    // after each page
+    defer_ranges = true;
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to remove object %1 from group %2.")).arg(user_name, group_name);
+    while (true) {
+        LDAPControl *page_control = NULL;
+        const int is_critical = 1;
+        int result = ldap_create_page_control(ld, page_size, cookie, is_critical, &page_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create page control: " << ldap_err2string(result);
 
-        d->error_message(context, d->default_error());
+            success = false;
+            break;
+        }
+        LDAPControl *server_controls[3] = {page_control, &sd_control, NULL};
 
-        return false;
-    }
-}
+        QElapsedTimer page_timer;
+        page_timer.start();
 
-bool AdInterface::group_set_scope(const QString &dn, GroupScope scope, const DoStatusMsg do_msg) {
-    // NOTE: it is not possible to change scope from
-    // global<->domainlocal directly, so have to switch to
-    // universal first.
-    const bool need_to_switch_to_universal = [=]() {
-        const AdObject object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
-        const GroupScope current_scope = object.get_group_scope();
-
-        return (current_scope == GroupScope_Global && scope == GroupScope_DomainLocal) || (current_scope == GroupScope_DomainLocal && scope == GroupScope_Global);
-    }();
+        int msgid;
+        auto send_op = [&]() {
+            const int attrsonly = 0;
 
-    if (need_to_switch_to_universal) {
-        group_set_scope(dn, GroupScope_Universal, DoStatusMsg_No);
-    }
+            struct timeval time_limit;
+            time_limit.tv_sec = settings->timeout;
+            time_limit.tv_usec = 0;
 
-    const AdObject object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
-    int group_type = object.get_int(ATTRIBUTE_GROUP_TYPE);
+            return ldap_search_ext(ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, &time_limit, LDAP_NO_LIMIT, &msgid);
+        };
 
-    // Unset all scope bits, because scope bits are exclusive
-    for (int i = 0; i < GroupScope_COUNT; i++) {
-        const GroupScope this_scope = (GroupScope) i;
-        const int this_scope_bit = group_scope_bit(this_scope);
+        // NOTE: can only fail over on first page, because
+        // cookies are only valid on the DC that issued them
+        if (is_first_page) {
+            result = with_failover(send_op);
+        } else {
+            result = send_op();
+        }
 
-        group_type = bit_set(group_type, this_scope_bit, false);
-    }
+        ldap_control_free(page_control);
 
-    // Set given scope bit
-    const int scope_bit = group_scope_bit(scope);
-    group_type = bit_set(group_type, scope_bit, true);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Error in ldap_search_ext: " << ldap_err2string(result);
 
-    const QString name = dn_get_name(dn);
-    const QString scope_string = group_scope_string(scope);
+            success = false;
+            break;
+        }
 
-    const bool result = attribute_replace_int(dn, ATTRIBUTE_GROUP_TYPE, group_type);
-    if (result) {
-        d->success_message(QString(tr("Group scope for %1 was changed to \"%2\".")).arg(name, scope_string), do_msg);
+        // Receive entries of this page one by one
+        AdObjectBuilder builder;
+        QList<AdObject> deferred_list;
+        int entry_count = 0;
+        qint64 page_bytes = 0;
+        qint64 first_entry_ms = -1;
+        struct berval *new_cookie = NULL;
+        bool page_done = false;
+
+        while (!page_done) {
+            LDAPMessage *res = NULL;
+            const int res_type = receive_result(msgid, LDAP_MSG_ONE, &res);
+
+            switch (res_type) {
+                case LDAP_RES_SEARCH_ENTRY: {
+                    if (first_entry_ms == -1) {
+                        first_entry_ms = page_timer.elapsed();
+                    }
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to change group scope for %1 to \"%2\".")).arg(name, scope_string);
+                    int entry_size = 0;
+                    const AdObject object = load_entry(res, &entry_size, &builder);
 
-        d->error_message(context, d->default_error(), do_msg);
+                    entry_count++;
+                    page_bytes += entry_size;
 
-        return false;
-    }
-}
+                    // NOTE: objects with deferred ranges
+                    // are passed to callback once the page
+                    // is done
+                    if (deferred_range_map.contains(object.get_dn())) {
+                        deferred_list.append(object);
 
-bool AdInterface::group_set_type(const QString &dn, GroupType type) {
-    const AdObject object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
-    const int group_type = object.get_int(ATTRIBUTE_GROUP_TYPE);
+                        break;
+                    }
 
-    const bool set_security_bit = type == GroupType_Security;
+                    const bool keep_going = callback(object);
+                    if (!keep_going) {
+                        ldap_abandon_ext(ld, msgid, NULL, NULL);
 
-    const int update_group_type = bit_set(group_type, GROUP_TYPE_BIT_SECURITY, set_security_bit);
-    const QString update_group_type_string = QString::number(update_group_type);
+                        stopped = true;
+                        page_done = true;
+                    }
 
-    const QString name = dn_get_name(dn);
-    const QString type_string = group_type_string(type);
+                    break;
+                }
+                case LDAP_RES_SEARCH_REFERENCE: {
+                    break;
+                }
+                case LDAP_RES_SEARCH_RESULT: {
+                    page_done = true;
+
+                    int errcode = LDAP_OTHER;
+                    LDAPControl **returned_controls = NULL;
+                    const int parse_result = ldap_parse_result(ld, res, &errcode, NULL, NULL, NULL, &returned_controls, 0);
+
+                    if (parse_result == LDAP_SUCCESS && errcode == LDAP_TIMELIMIT_EXCEEDED) {
+                        // NOTE: objects found before time
+                        // limit ran out were already
+                        // passed to callback, so stop
+                        // here without failing
+                        error_message_plain(tr("Search took too long and was stopped, results are incomplete."));
+
+                        stopped = true;
+                    } else if (parse_result != LDAP_SUCCESS || (errcode != LDAP_SUCCESS && errcode != LDAP_PARTIAL_RESULTS)) {
+                        // NOTE: see search_paged_internal()
+                        // about LDAP_NO_SUCH_OBJECT
+                        if (errcode != LDAP_NO_SUCH_OBJECT) {
+                            qDebug() << "Error in streaming search: " << ldap_err2string(errcode);
+                        }
+
+                        // Save result code so that
+                        // default_error() can report it
+                        ldap_set_option(ld, LDAP_OPT_RESULT_CODE, &errcode);
+
+                        success = false;
+                    } else {
+                        LDAPControl *pageresponse_control = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, returned_controls, NULL);
+
+                        if (pageresponse_control != NULL) {
+                            ber_int_t total_count;
+                            struct berval parsed_cookie;
+                            parsed_cookie.bv_len = 0;
+                            parsed_cookie.bv_val = NULL;
+
+                            result = ldap_parse_pageresponse_control(ld, pageresponse_control, &total_count, &parsed_cookie);
+                            if (result == LDAP_SUCCESS) {
+                                // NOTE: there are more pages if
+                                // the cookie isn't empty
+                                if (parsed_cookie.bv_len > 0) {
+                                    new_cookie = ber_bvdup(&parsed_cookie);
+                                }
+                            } else {
+                                qDebug() << "Failed to parse pageresponse control: " << ldap_err2string(result);
+
+                                success = false;
+                            }
+
+                            ber_memfree(parsed_cookie.bv_val);
+                        } else {
+                            qDebug() << "Failed to find PAGEDRESULTS control";
+
+                            success = false;
+                        }
+                    }
 
-    const bool result = attribute_replace_string(dn, ATTRIBUTE_GROUP_TYPE, update_group_type_string);
-    if (result) {
-        d->success_message(QString(tr("Group type for %1 was changed to \"%2\".")).arg(name, type_string));
+                    ldap_controls_free(returned_controls);
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to change group type for %1 to \"%2\".")).arg(name, type_string);
-        d->error_message(context, d->default_error());
+                    break;
+                }
+                case 0: {
+                    // NOTE: search was abandoned because it
+                    // was cancelled or timed out.
+                    // Cancelling is the same as stopping
+                    // from callback.
+                    page_done = true;
+
+                    if (get_ldap_result() == LDAP_USER_CANCELLED) {
+                        stopped = true;
+                    } else {
+                        qDebug() << "Streaming search timed out";
 
-        return false;
-    }
-}
+                        success = false;
+                    }
 
-bool AdInterface::user_set_primary_group(const QString &group_dn, const QString &user_dn) {
-    const AdObject group_object = search_object(group_dn, {ATTRIBUTE_OBJECT_SID, ATTRIBUTE_MEMBER});
+                    break;
+                }
+                default: {
+                    qDebug() << "Error in streaming search ldap_result";
 
-    // NOTE: need to add user to group before it can become primary
-    const QList<QString> group_members = group_object.get_strings(ATTRIBUTE_MEMBER);
-    const bool user_is_in_group = group_members.contains(user_dn);
-    if (!user_is_in_group) {
-        group_add_member(group_dn, user_dn);
-    }
+                    page_done = true;
+                    success = false;
 
-    const QByteArray group_sid = group_object.get_value(ATTRIBUTE_OBJECT_SID);
-    const QString group_rid = extract_rid_from_sid(group_sid, d->adconfig);
+                    break;
+                }
+            }
 
-    const bool success = attribute_replace_string(user_dn, ATTRIBUTE_PRIMARY_GROUP_ID, group_rid, DoStatusMsg_No);
+            ldap_msgfree(res);
+        }
 
-    const QString user_name = dn_get_name(user_dn);
-    const QString group_name = dn_get_name(group_dn);
+        // Nothing is in flight on this connection anymore,
+        // so remaining values of ranged attributes can be
+        // loaded now
+        for (const AdObject &object : deferred_list) {
+            if (stopped) {
+                break;
+            }
 
-    if (success) {
-        d->success_message(QString(tr("Primary group for object %1 was changed to %2.")).arg(user_name, group_name));
+            const AdObject complete_object = complete_ranges(object);
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to change primary group for user %1 to %2.")).arg(user_name, group_name);
+            const bool keep_going = callback(complete_object);
+            if (!keep_going) {
+                stopped = true;
+            }
+        }
+        deferred_range_map.clear();
 
-        d->error_message(context, d->default_error());
+        ber_bvfree(cookie);
+        cookie = new_cookie;
 
-        return false;
-    }
-}
+        if (!success || stopped || cookie == NULL) {
+            break;
+        }
 
-bool AdInterface::user_set_pass(const QString &dn, const QString &password, const DoStatusMsg do_msg) {
-    // NOTE: AD requires that the password:
-    // 1. is surrounded by quotes
-    // 2. is encoded as UTF16-LE
-    // 3. has no Byte Order Mark
-    const QString quoted_password = QString("\"%1\"").arg(password);
-    const auto codec = QTextCodec::codecForName("UTF-16LE");
-    QByteArray password_bytes = codec->fromUnicode(quoted_password);
-    // Remove BOM
-    // NOTE: gotta be a way to tell codec not to add BOM
-    // but couldn't find it, only QTextStream has
-    // setGenerateBOM()
-    if (password_bytes[0] != '\"') {
-        password_bytes.remove(0, 2);
+        is_first_page = false;
+
+        page_size = stream_next_page_size(page_size, entry_count, page_bytes, first_entry_ms, page_timer.elapsed());
     }
 
-    const bool success = attribute_replace_value(dn, ATTRIBUTE_PASSWORD, password_bytes, DoStatusMsg_No);
+    ber_bvfree(cookie);
+    ber_bvfree(sd_value);
 
-    const QString name = dn_get_name(dn);
+    defer_ranges = false;
 
-    if (success) {
-        d->success_message(QString(tr("Password for object %1 was changed.")).arg(name), do_msg);
+    return success;
+}
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to change password for object %1.")).arg(name);
+bool AdInterfacePrivate::search_all_pages(const QString &base, const int scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, const bool show_deleted) {
+    const QByteArray base_bytes = base.toUtf8();
+    const QByteArray filter_bytes = filter.toUtf8();
+    const char *filter_cstr = [&]() {
+        if (filter.isEmpty()) {
+            return (const char *) NULL;
+        } else {
+            return filter_bytes.constData();
+        }
+    }();
 
-        const QString error = [this]() {
-            const int ldap_result = d->get_ldap_result();
-            if (ldap_result == LDAP_CONSTRAINT_VIOLATION) {
-                return tr("Password doesn't match rules.");
-            } else {
-                return d->default_error();
-            }
-        }();
+    char **attributes_array = attributes_to_array(attributes);
 
-        d->error_message(context, error, do_msg);
+    AdCookie cookie;
+    bool success = true;
 
-        return false;
-    }
-}
+    while (true) {
+        success = search_paged_internal(base_bytes.constData(), scope, filter_cstr, attributes_array, results, &cookie, false, show_deleted);
 
-// TODO:
-// "User cannot change password" - CAN'T just set PASSWD_CANT_CHANGE. See: https://docs.microsoft.com/en-us/windows/win32/adsi/modifying-user-cannot-change-password-ldap-provider?redirectedfrom=MSDN
-// "This account supports 128bit encryption" (and for 256bit)
-// "Use Kerberos DES encryption types for this account"
-bool AdInterface::user_set_account_option(const QString &dn, AccountOption option, bool set) {
-    if (dn.isEmpty()) {
-        return false;
+        if (!success || !cookie.more_pages()) {
+            break;
+        }
     }
 
-    bool success = false;
-
-    switch (option) {
-        case AccountOption_CantChangePassword: {
-            const AdObject object = search_object(dn, {ATTRIBUTE_SECURITY_DESCRIPTOR});
-            const auto old_security_state = object.get_security_state(d->adconfig);
+    attributes_array_free(attributes_array);
 
-            const QByteArray self_trustee = sid_string_to_bytes(SID_NT_SELF);
+    return success;
+}
 
-            const PermissionState new_permission_state = [&]() {
-                if (set) {
-                    return PermissionState_Denied;
-                } else {
-                    return PermissionState_Allowed;
-                }
-            }();
+bool AdInterfacePrivate::get_highest_usn(qint64 *usn_out) {
+    char *attributes[] = {(char *) ATTRIBUTE_HIGHEST_COMMITTED_USN, NULL};
+    LDAPMessage *res = NULL;
 
-            const auto new_security_state = ad_security_modify(old_security_state, self_trustee, AcePermission_ChangePassword, new_permission_state);
+    auto search_op = [&]() {
+        ldap_msgfree(res);
+        res = NULL;
 
-            success = attribute_replace_security_descriptor(this, dn, new_security_state);
+        return search_async("", LDAP_SCOPE_BASE, "(objectClass=*)", attributes, NULL, &res);
+    };
 
-            break;
-        }
-        case AccountOption_PasswordExpired: {
-            QString pwdLastSet_value;
-            if (set) {
-                pwdLastSet_value = AD_PWD_LAST_SET_EXPIRED;
-            } else {
-                pwdLastSet_value = AD_PWD_LAST_SET_RESET;
-            }
+    const int result = with_failover(search_op);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to read highest committed USN: " << ldap_err2string(result);
 
-            success = attribute_replace_string(dn, ATTRIBUTE_PWD_LAST_SET, pwdLastSet_value, DoStatusMsg_No);
+        ldap_msgfree(res);
 
-            break;
-        }
-        default: {
-            const int uac = [this, dn]() {
-                const AdObject object = search_object(dn, {ATTRIBUTE_USER_ACCOUNT_CONTROL});
-                return object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL);
-            }();
+        return false;
+    }
 
-            const int bit = account_option_bit(option);
-            const int updated_uac = bit_set(uac, bit, set);
+    LDAPMessage *entry = ldap_first_entry(ld, res);
+    if (entry == NULL) {
+        ldap_msgfree(res);
 
-            success = attribute_replace_int(dn, ATTRIBUTE_USER_ACCOUNT_CONTROL, updated_uac, DoStatusMsg_No);
-        }
+        return false;
     }
 
-    const QString name = dn_get_name(dn);
+    const AdObject root_dse = load_entry(entry);
+    ldap_msgfree(res);
 
-    if (success) {
-        const QString success_context = [option, set, name]() {
-            switch (option) {
-                case AccountOption_Disabled: {
-                    if (set) {
-                        return QString(tr("Object %1 has been disabled.")).arg(name);
-                    } else {
-                        return QString(tr("Object %1 has been enabled.")).arg(name);
-                    }
-                }
-                default: {
-                    const QString description = account_option_string(option);
+    const QString usn_string = root_dse.get_string(ATTRIBUTE_HIGHEST_COMMITTED_USN);
 
-                    if (set) {
-                        return QString(tr("Account option \"%1\" was turned ON for object %2.")).arg(description, name);
-                    } else {
-                        return QString(tr("Account option \"%1\" was turned OFF for object %2.")).arg(description, name);
-                    }
-                }
-            }
-        }();
+    bool ok;
+    *usn_out = usn_string.toLongLong(&ok);
 
-        d->success_message(success_context);
+    return ok;
+}
 
-        return true;
-    } else {
-        const QString context = [option, set, name]() {
-            switch (option) {
-                case AccountOption_Disabled: {
-                    if (set) {
-                        return QString(tr("Failed to disable object %1.")).arg(name);
-                    } else {
-                        return QString(tr("Failed to enable object %1.")).arg(name);
-                    }
-                }
-                default: {
-                    const QString description = account_option_string(option);
+bool AdInterfacePrivate::search_vlv_internal(const char *base, const int scope, const char *filter, char **attributes, const char *sort_attribute, const bool sort_descending, const int offset, const int count, QList<AdObject> *results, AdVlvContext *context) {
+    int result;
+    LDAPMessage *res = NULL;
+    LDAPSortKey **sort_keys = NULL;
+    LDAPControl *sort_control = NULL;
+    LDAPControl *vlv_control = NULL;
+    LDAPControl **returned_controls = NULL;
+    struct berval *new_context_id = NULL;
 
-                    if (set) {
-                        return QString(tr("Failed to turn ON account option \"%1\" for object %2.")).arg(description, name);
-                    } else {
-                        return QString(tr("Failed to turn OFF account option \"%1\" for object %2.")).arg(description, name);
-                    }
-                }
-            }
-        }();
+    auto cleanup = [&]() {
+        ldap_msgfree(res);
+        ldap_free_sort_keylist(sort_keys);
+        ldap_control_free(sort_control);
+        ldap_control_free(vlv_control);
+        ldap_controls_free(returned_controls);
+        ber_bvfree(new_context_id);
+    };
 
-        d->error_message(context, d->default_error());
+    // Create sort control
+    // NOTE: "-" prefix in key string reverses sort order
+    QByteArray sort_key_string = sort_attribute;
+    if (sort_descending) {
+        sort_key_string.prepend('-');
+    }
+    result = ldap_create_sort_keylist(&sort_keys, sort_key_string.data());
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to create sort key list: " << ldap_err2string(result);
 
+        cleanup();
         return false;
     }
-}
 
-bool AdInterface::user_unlock(const QString &dn) {
-    const bool result = attribute_replace_string(dn, ATTRIBUTE_LOCKOUT_TIME, LOCKOUT_UNLOCKED_VALUE);
-
-    const QString name = dn_get_name(dn);
+    // NOTE: VLV control requires sort control, so both are
+    // critical. Server must fail the search instead of
+    // returning everything unsorted.
+    const int is_critical = 1;
+    result = ldap_create_sort_control(ld, sort_keys, is_critical, &sort_control);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to create sort control: " << ldap_err2string(result);
 
-    if (result) {
-        d->success_message(QString(tr("User \"%1\" was unlocked.")).arg(name));
+        cleanup();
+        return false;
+    }
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to unlock user %1.")).arg(name);
+    auto create_vlv_control = [&](struct berval *context_id) {
+        ldap_control_free(vlv_control);
+        vlv_control = NULL;
+
+        // NOTE: target is selected by offset. Offset is
+        // 1-based. Content count of 0 tells the server that
+        // offset is absolute and shouldn't be scaled by
+        // client's estimate of content count.
+        LDAPVLVInfo vlv_info;
+        vlv_info.ldvlv_version = 1;
+        vlv_info.ldvlv_before_count = 0;
+        vlv_info.ldvlv_after_count = count - 1;
+        vlv_info.ldvlv_offset = offset + 1;
+        vlv_info.ldvlv_count = 0;
+        vlv_info.ldvlv_attrvalue = NULL;
+        vlv_info.ldvlv_context = context_id;
+        vlv_info.ldvlv_extradata = NULL;
+
+        return ldap_create_vlv_control(ld, &vlv_info, &vlv_control);
+    };
 
-        d->error_message(context, d->default_error());
+    result = create_vlv_control(context->context_id);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to create VLV control: " << ldap_err2string(result);
 
-        return result;
+        cleanup();
+        return false;
     }
-}
 
-bool AdInterface::computer_reset_account(const QString &dn) {
-    const QString name = dn_get_name(dn);
-    const QString reset_password = QString("%1$").arg(name);
+    // Perform search
+    auto search_op = [&]() {
+        ldap_msgfree(res);
+        res = NULL;
 
-    const bool success = user_set_pass(dn, reset_password, DoStatusMsg_No);
+        LDAPControl *server_controls[3] = {sort_control, vlv_control, NULL};
 
-    if (success) {
-        d->success_message(QString(tr("Computer \"%1\" was reset.")).arg(name));
+        return search_async(base, scope, filter, attributes, server_controls, &res);
+    };
 
-        return true;
-    } else {
-        const QString context = QString(tr("Failed to reset computer %1.")).arg(name);
+    result = with_failover(search_op);
+
+    // NOTE: context id is only valid on the connection
+    // that received it, but connections are shared between
+    // AdInterface's through the pool. If server rejects
+    // the context, retry without it. Cancelled or timed
+    // out searches are not retried.
+    const bool can_retry = (result != LDAP_SUCCESS && result != LDAP_USER_CANCELLED && result != LDAP_TIMEOUT);
+    if (can_retry && context->context_id != NULL) {
+        ber_bvfree(context->context_id);
+        context->context_id = NULL;
+
+        result = create_vlv_control(NULL);
+        if (result == LDAP_SUCCESS) {
+            result = search_op();
+        }
+    }
 
-        d->error_message(context, d->default_error());
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Error in VLV search: " << ldap_err2string(result);
 
+        cleanup();
         return false;
     }
-}
-
-bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
-    auto error_message = [&](const QString &error) {
-        d->error_message(tr("Failed to create GPO."), error);
-    };
 
-    if (!d->logged_in_as_admin()) {
-        error_message(tr("Insufficient rights."));
+    // Parse the results to retrieve returned controls
+    int errcodep;
+    result = ldap_parse_result(ld, res, &errcodep, NULL, NULL, NULL, &returned_controls, false);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to parse result: " << ldap_err2string(result);
 
+        cleanup();
         return false;
     }
 
-    //
-    // Generate UUID used for directory and object names
-    //
-    // TODO: make sure endianess works fine on processors
-    // with weird endianess.
-    const QString uuid = []() {
-        uuid_t uuid_struct;
-        uuid_generate_random(uuid_struct);
+    LDAPControl *vlv_response_control = ldap_control_find(LDAP_CONTROL_VLVRESPONSE, returned_controls, NULL);
+    if (vlv_response_control == NULL) {
+        qDebug() << "Failed to find VLVRESPONSE control";
 
-        char uuid_cstr[UUID_STR_LEN];
-        uuid_unparse_upper(uuid_struct, uuid_cstr);
+        cleanup();
+        return false;
+    }
 
-        const QString out = "{" + QString(uuid_cstr) + "}";
+    ber_int_t target_position;
+    ber_int_t content_count;
+    ber_int_t vlv_result;
+    result = ldap_parse_vlvresponse_control(ld, vlv_response_control, &target_position, &content_count, &new_context_id, &vlv_result);
+    if (result != LDAP_SUCCESS || vlv_result != LDAP_SUCCESS) {
+        qDebug() << "Failed to get VLV response: " << ldap_err2string(result) << ldap_err2string(vlv_result);
 
-        return out;
-    }();
+        cleanup();
+        return false;
+    }
 
-    // Ex: "\\domain.alt\sysvol\domain.alt\Policies\{FF7E0880-F3AD-4540-8F1D-4472CB4A7044}"
-    const QString filesys_path = QString("\\\\%1\\sysvol\\%2\\Policies\\%3").arg(d->domain.toLower(), d->domain.toLower(), uuid);
-    const QString gpt_path = filesys_path_to_smb_path(filesys_path);
-    const QString gpc_dn = QString("CN=%1,CN=Policies,CN=System,%2").arg(uuid, d->domain_head);
+    context->m_total_count = content_count;
 
-    // After each error case we need to clean up whatever we
-    // have created successfully so far. Don't just use
-    // gpo_delete() because we want to delete partially in
-    // some error cases and that shouldn't print any error
-    // messages.
-    auto cleanup = [&]() {
-        const AdObject gpc_object = search_object(gpc_dn);
-        const bool gpc_exists = !gpc_object.is_empty();
-        if (gpc_exists) {
-            object_delete(gpc_dn);
+    ber_bvfree(context->context_id);
+    context->context_id = new_context_id;
+    new_context_id = NULL;
+
+    // NOTE: if offset is past the end of result set, which
+    // can happen if objects were deleted since last
+    // request, server moves target to the last object.
+    // Objects returned in that case are not at requested
+    // offset, so don't return them.
+    const bool target_is_offset = (target_position == offset + 1);
+    if (target_is_offset) {
+        AdObjectBuilder builder;
+        for (LDAPMessage *entry = ldap_first_entry(ld, res); entry != NULL; entry = ldap_next_entry(ld, entry)) {
+            const AdObject object = load_entry(entry, nullptr, &builder);
+
+            results->append(object);
         }
+    }
 
-        struct stat filestat;
-        const int stat_result = smbc_stat(cstr(gpt_path), &filestat);
-        const bool gpt_exists = (stat_result == 0);
-        if (gpt_exists) {
-            d->delete_gpt(gpt_path);
+    cleanup();
+    return true;
+}
+
+QHash<QString, AdObject> AdInterface::search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
+    const AdOperationGuard operation_guard(d);
+
+    AdCookie cookie;
+    QHash<QString, AdObject> results;
+
+    if (d->settings->log_searches) {
+        const QString attributes_string = "{" + attributes.join(",") + "}";
+
+        const QString scope_string = [&scope]() -> QString {
+            switch (scope) {
+                case SearchScope_Object: return "object";
+                case SearchScope_Children: return "children";
+                case SearchScope_Descendants: return "descendants";
+                case SearchScope_All: return "all";
+                default: break;
+            }
+            return QString();
+        }();
+
+        d->success_message(QString(tr("Search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tscope = \"%3\"\n\tbase = \"%4\"")).arg(filter, attributes_string, scope_string, base));
+    }
+
+    while (true) {
+        const bool success = search_paged(base, scope, filter, attributes, &results, &cookie);
+
+        if (!success) {
+            break;
         }
-    };
 
-    //
-    // Create GPT
-    //
+        if (!cookie.more_pages()) {
+            break;
+        }
+    }
 
-    // Create root dir
-    // "smb://domain.alt/sysvol/domain.alt/Policies/{FF7E0880-F3AD-4540-8F1D-4472CB4A7044}"
-    const int result_mkdir_gpt = smbc_mkdir(cstr(gpt_path), 0755);
-    if (result_mkdir_gpt != 0) {
-        error_message(tr("Failed to create GPT root dir."));
+    return results;
+}
 
-        cleanup();
+QHash<QString, AdObject> AdInterface::search_forest(const QString &filter, const QList<QString> &attributes) {
+    const AdOperationGuard operation_guard(d);
 
-        return false;
+    const bool use_gc = d->gc_can_answer(filter, attributes);
+
+    if (use_gc) {
+        AdInterface gc(AdRouting_GlobalCatalog);
+
+        if (gc.is_connected()) {
+            QHash<QString, AdObject> results;
+            AdCookie cookie;
+            bool success = true;
+
+            while (success) {
+                // NOTE: empty base searches all naming
+                // contexts held by GC, which includes other
+                // domain trees of the forest, not just the
+                // tree under forest root
+                success = gc.search_paged(QString(), SearchScope_All, filter, attributes, &results, &cookie);
+
+                if (!cookie.more_pages()) {
+                    break;
+                }
+            }
+
+            if (success) {
+                return results;
+            }
+        }
     }
 
-    const QString gpt_machine_path = gpt_path + "/Machine";
-    const int result_mkdir_machine = smbc_mkdir(cstr(gpt_machine_path), 0755);
-    if (result_mkdir_machine != 0) {
-        error_message(tr("Failed to create GPT machine dir."));
+    return search(d->domain_head, SearchScope_All, filter, attributes);
+}
 
-        cleanup();
+bool AdInterface::search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie) {
+    const AdOperationGuard operation_guard(d);
+
+    const QByteArray base_bytes = base.toUtf8();
+    const QByteArray filter_bytes = filter.toUtf8();
+
+    const int scope_int = search_scope_to_ldap(scope);
+
+    const char *filter_cstr = [&]() {
+        if (filter.isEmpty()) {
+            // NOTE: need to pass NULL instead of empty
+            // string to denote "no filter"
+            return (const char *) NULL;
+        } else {
+            return filter_bytes.constData();
+        }
+    }();
+
+    // Convert attributes list to NULL-terminated array
+    char **attributes_array = attributes_to_array(attributes);
+
+    const bool search_success = d->search_paged_internal(base_bytes.constData(), scope_int, filter_cstr, attributes_array, results, cookie);
+
+    attributes_array_free(attributes_array);
+
+    if (!search_success) {
+        results->clear();
 
         return false;
     }
 
-    const QString gpt_user_path = gpt_path + "/User";
-    const int result_mkdir_user = smbc_mkdir(cstr(gpt_user_path), 0755);
-    if (result_mkdir_user != 0) {
-        error_message(tr("Failed to create GPT user dir."));
+    return true;
+}
 
-        cleanup();
+bool AdInterface::search_stream(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, std::function<bool(const AdObject &object)> callback) {
+    const AdOperationGuard operation_guard(d);
 
-        return false;
+    if (d->settings->log_searches) {
+        const QString attributes_string = "{" + attributes.join(",") + "}";
+
+        d->success_message(QString(tr("Streaming search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tbase = \"%3\"")).arg(filter, attributes_string, base));
     }
 
-    const QString gpt_ini_path = gpt_path + "/GPT.INI";
-    const int ini_file = smbc_open(cstr(gpt_ini_path), O_WRONLY | O_CREAT, 0644);
-    if (ini_file < 0) {
-        error_message(tr("Failed to open GPT ini file."));
+    const QByteArray base_bytes = base.toUtf8();
+    const QByteArray filter_bytes = filter.toUtf8();
+    const char *filter_cstr = [&]() {
+        if (filter.isEmpty()) {
+            return (const char *) NULL;
+        } else {
+            return filter_bytes.constData();
+        }
+    }();
 
-        cleanup();
+    const int scope_int = search_scope_to_ldap(scope);
+    char **attributes_array = attributes_to_array(attributes);
+
+    const bool search_success = d->search_stream_internal(base_bytes.constData(), scope_int, filter_cstr, attributes_array, callback);
+
+    attributes_array_free(attributes_array);
 
+    return search_success;
+}
+
+bool AdInterface::search_vlv(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const bool sort_descending, const int offset, const int count, QList<AdObject> *results, AdVlvContext *context) {
+    const AdOperationGuard operation_guard(d);
+
+    if (count <= 0 || offset < 0) {
         return false;
     }
 
-    const char *ini_contents = "[General]\r\nVersion=0\r\n";
-    const int bytes_written = smbc_write(ini_file, ini_contents, strlen(ini_contents));
-    smbc_close(ini_file);
-    if (bytes_written < 0) {
-        error_message(tr("Failed to write GPT ini file."));
+    if (d->settings->log_searches) {
+        const QString attributes_string = "{" + attributes.join(",") + "}";
 
-        cleanup();
+        d->success_message(QString(tr("VLV search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tbase = \"%3\"\n\tsort = \"%4\"\n\twindow = %5-%6")).arg(filter, attributes_string, base, sort_attribute, QString::number(offset), QString::number(offset + count - 1)));
+    }
+
+    const QByteArray base_bytes = base.toUtf8();
+    const QByteArray filter_bytes = filter.toUtf8();
+    const QByteArray sort_attribute_bytes = sort_attribute.toUtf8();
+    const char *filter_cstr = [&]() {
+        if (filter.isEmpty()) {
+            return (const char *) NULL;
+        } else {
+            return filter_bytes.constData();
+        }
+    }();
+
+    const int scope_int = search_scope_to_ldap(scope);
+    char **attributes_array = attributes_to_array(attributes);
+
+    const bool search_success = d->search_vlv_internal(base_bytes.constData(), scope_int, filter_cstr, attributes_array, sort_attribute_bytes.constData(), sort_descending, offset, count, results, context);
+
+    attributes_array_free(attributes_array);
+
+    if (!search_success) {
+        results->clear();
 
         return false;
     }
 
-    //
-    // Create AD object for gpo
-    //
-    const bool result_add = object_add(gpc_dn, CLASS_GP_CONTAINER);
-    if (!result_add) {
-        error_message(tr("Failed to create GPC object."));
+    return true;
+}
 
-        cleanup();
+bool AdInterface::search_count(const QString &base, const SearchScope scope, const QString &filter, int *count_out) {
+    const AdOperationGuard operation_guard(d);
+
+    // NOTE: "1.1" requests no attributes. Sorting by name
+    // is cheap because it's indexed.
+    const QList<QString> attributes = {LDAP_NO_ATTRS};
+
+    AdVlvContext context;
+    QList<AdObject> results;
+    const bool success = search_vlv(base, scope, filter, attributes, ATTRIBUTE_NAME, false, 0, 1, &results, &context);
+
+    if (success) {
+        *count_out = context.total_count();
+    } else {
+        *count_out = 0;
+    }
+
+    return success;
+}
+
+bool AdInterface::sync_begin(AdSyncState *state) {
+    const AdOperationGuard operation_guard(d);
+
+    qint64 usn;
+    const bool success = d->get_highest_usn(&usn);
+    if (!success) {
+        *state = AdSyncState();
 
         return false;
     }
 
-    const QHash<QString, QString> attribute_value_map = {
-        {ATTRIBUTE_DISPLAY_NAME, display_name},
-        {ATTRIBUTE_GPC_FILE_SYS_PATH, filesys_path},
-        // TODO: samba defaults to 1, ADUC defaults to 0. Figure out what's this supposed to be.
-        {ATTRIBUTE_FLAGS, "1"},
-        {ATTRIBUTE_VERSION_NUMBER, "0"},
-        {ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE"},
-        {ATTRIBUTE_GPC_FUNCTIONALITY_VERSION, "2"},
-    };
+    state->dc = d->dc;
+    state->usn = usn;
 
-    for (const QString &attribute : attribute_value_map.keys()) {
-        const QString value = attribute_value_map[attribute];
+    return true;
+}
+
+bool AdInterface::sync_changes(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, AdSyncState *state, QList<AdObject> *changed, QList<QByteArray> *removed_guids) {
+    const AdOperationGuard operation_guard(d);
+
+    if (!state->is_valid()) {
+        return false;
+    }
 
-        const bool replace_success = attribute_replace_string(gpc_dn, attribute, value);
+    // NOTE: USN's of different DC's are unrelated, so sync
+    // has to go to the DC where the state was saved. If
+    // that DC can't be reached, caller falls back to a
+    // full reload.
+    const bool switched_to_state_dc = d->switch_dc(state->dc);
+    if (!switched_to_state_dc) {
+        return false;
+    }
+
+    // NOTE: get new position before searching for changes,
+    // so that changes made during the search are not
+    // skipped. Such changes may be returned again by next
+    // sync, which is harmless.
+    qint64 new_usn;
+    const bool got_usn = d->get_highest_usn(&new_usn);
+    if (!got_usn) {
+        return false;
+    }
 
-        if (!replace_success) {
-            error_message(QString(tr("Failed to set GPC attribute %1.")).arg(attribute));
+    const QString usn_filter = QString("(%1>=%2)").arg(ATTRIBUTE_USN_CHANGED, QString::number(state->usn + 1));
 
-            cleanup();
+    // Objects that were created, modified or moved into
+    // the search
+    const QList<QString> changed_attributes = [&]() {
+        QList<QString> out = attributes;
 
-            return false;
+        // NOTE: empty list means all attributes, so guid
+        // is already included
+        if (!out.isEmpty() && !out.contains(ATTRIBUTE_OBJECT_GUID)) {
+            out.append(ATTRIBUTE_OBJECT_GUID);
         }
+
+        return out;
+    }();
+    const QString changed_filter = filter_AND({filter, usn_filter});
+    QHash<QString, AdObject> changed_map;
+    const bool changed_success = d->search_all_pages(base, search_scope_to_ldap(scope), changed_filter, changed_attributes, &changed_map, false);
+    if (!changed_success) {
+        return false;
     }
 
-    // User object
-    const QString user_dn = "CN=User," + gpc_dn;
-    const bool result_add_user = object_add(user_dn, CLASS_CONTAINER);
-    attribute_replace_string(gpc_dn, ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE");
-    if (!result_add_user) {
-        error_message(tr("Failed to create user folder object for GPO."));
+    // NOTE: objects that stopped matching the filter are
+    // still in the search scope, so search it again
+    // without the filter. Every changed object that isn't
+    // in the search anymore is removed. Only guid's are
+    // loaded, so this is cheap.
+    QHash<QString, AdObject> all_changed_map;
+    const bool all_changed_success = d->search_all_pages(base, search_scope_to_ldap(scope), usn_filter, {ATTRIBUTE_OBJECT_GUID}, &all_changed_map, false);
+    if (!all_changed_success) {
+        return false;
+    }
 
-        cleanup();
+    // NOTE: deleted objects are moved to "Deleted Objects"
+    // container and keep their last parent, so for
+    // children scope only tombstones of this parent are
+    // loaded. Objects that were moved out of the search by
+    // other clients leave no trace in the search scope, so
+    // they are not returned and stay until next full
+    // reload.
+    const QString deleted_filter = [&]() {
+        const QString is_deleted = filter_CONDITION(Condition_Equals, ATTRIBUTE_IS_DELETED, LDAP_BOOL_TRUE);
+
+        if (scope == SearchScope_Children) {
+            QString base_escaped = base;
+            base_escaped.replace("\\", "\\5c");
+            base_escaped.replace("*", "\\2a");
+            base_escaped.replace("(", "\\28");
+            base_escaped.replace(")", "\\29");
+
+            const QString is_child = filter_CONDITION(Condition_Equals, ATTRIBUTE_LAST_KNOWN_PARENT, base_escaped);
+
+            return filter_AND({usn_filter, is_deleted, is_child});
+        } else {
+            return filter_AND({usn_filter, is_deleted});
+        }
+    }();
+    const QString deleted_objects_dn = QString("CN=Deleted Objects,%1").arg(d->domain_head);
+    QHash<QString, AdObject> deleted_map;
+    const bool deleted_success = d->search_all_pages(deleted_objects_dn, LDAP_SCOPE_ONELEVEL, deleted_filter, {ATTRIBUTE_OBJECT_GUID}, &deleted_map, true);
+    if (!deleted_success) {
+        return false;
+    }
 
+    for (const QString &dn : deleted_map.keys()) {
+        all_changed_map.insert(dn, deleted_map[dn]);
+    }
+
+    // NOTE: if connection failed over to another DC during
+    // sync, results are from different DC's and can't be
+    // trusted
+    if (d->dc != state->dc) {
         return false;
     }
 
-    // Machine object
-    const QString machine_dn = "CN=Machine," + gpc_dn;
-    const bool result_add_machine = object_add(machine_dn, CLASS_CONTAINER);
-    attribute_replace_string(gpc_dn, ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE");
-    if (!result_add_machine) {
-        error_message(tr("Failed to create machine folder object for GPO."));
+    QSet<QByteArray> changed_guid_set;
+    for (const AdObject &object : changed_map.values()) {
+        const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+        changed_guid_set.insert(guid);
 
-        cleanup();
+        changed->append(object);
+    }
 
-        return false;
+    for (const AdObject &object : all_changed_map.values()) {
+        const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+
+        if (!changed_guid_set.contains(guid)) {
+            removed_guids->append(guid);
+        }
     }
 
-    const bool sync_perms_success = gpo_sync_perms(gpc_dn);
+    state->usn = new_usn;
 
-    if (!sync_perms_success) {
-        // NOTE: don't fail if failed to sync perms, user
-        // can retry it later
+    return true;
+}
+
+int AdInterface::notification_start(const QString &dn, const SearchScope scope, const QList<QString> &attributes) {
+    const AdOperationGuard operation_guard(d);
+
+    const QList<QString> attributes_with_extra = [&]() {
+        QList<QString> out = attributes;
+
+        // NOTE: guid is needed to identify deleted objects
+        // because their dn's change when they are deleted
+        if (!out.isEmpty()) {
+            out.append(ATTRIBUTE_OBJECT_GUID);
+            out.append(ATTRIBUTE_IS_DELETED);
+        }
+
+        return out;
+    }();
+    char **attributes_array = attributes_to_array(attributes_with_extra);
+
+    LDAPControl notification_control;
+    const char *notification_control_oid = LDAP_SERVER_NOTIFICATION_OID;
+    notification_control.ldctl_oid = (char *) notification_control_oid;
+    notification_control.ldctl_value.bv_len = 0;
+    notification_control.ldctl_value.bv_val = NULL;
+    notification_control.ldctl_iscritical = (char) 1;
+
+    // NOTE: show deleted control makes server send
+    // notifications for deleted objects
+    LDAPControl show_deleted_control;
+    const char *show_deleted_control_oid = LDAP_SERVER_SHOW_DELETED_OID;
+    show_deleted_control.ldctl_oid = (char *) show_deleted_control_oid;
+    show_deleted_control.ldctl_value.bv_len = 0;
+    show_deleted_control.ldctl_value.bv_val = NULL;
+    show_deleted_control.ldctl_iscritical = (char) 1;
+
+    LDAPControl *server_controls[3] = {&notification_control, &show_deleted_control, NULL};
+
+    // NOTE: server only accepts this filter for
+    // notifications
+    const char *filter = "(objectClass=*)";
+    const QByteArray dn_bytes = dn.toUtf8();
+    const int scope_int = search_scope_to_ldap(scope);
+    const int attrsonly = 0;
+    int msgid;
+    const int result = ldap_search_ext(d->ld, dn_bytes.constData(), scope_int, filter, attributes_array, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &msgid);
+
+    attributes_array_free(attributes_array);
+
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to start notification for" << dn << ":" << ldap_err2string(result);
+
+        return -1;
     }
 
-    dn_out = gpc_dn;
+    d->notification_ids.insert(msgid);
+
+    return msgid;
+}
+
+void AdInterface::notification_stop(const int id) {
+    const AdOperationGuard operation_guard(d);
+
+    if (!d->notification_ids.contains(id)) {
+        return;
+    }
+
+    ldap_abandon_ext(d->ld, id, NULL, NULL);
+    d->notification_ids.remove(id);
+}
+
+bool AdInterface::notification_wait(const int timeout_ms, QList<AdObject> *changed, QList<int> *ended_ids) {
+    const AdOperationGuard operation_guard(d);
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    while (true) {
+        LDAPMessage *res = NULL;
+        const int result = ldap_result(d->ld, LDAP_RES_ANY, LDAP_MSG_ONE, &timeout, &res);
+
+        if (result == -1) {
+            ldap_msgfree(res);
+
+            return false;
+        } else if (result == 0) {
+            // Timed out, no more messages
+            return true;
+        }
+
+        const int msgid = ldap_msgid(res);
+
+        if (result == LDAP_RES_SEARCH_ENTRY) {
+            LDAPMessage *entry = ldap_first_entry(d->ld, res);
+
+            if (entry != NULL) {
+                const AdObject object = d->load_entry(entry);
+                changed->append(object);
+            }
+        } else if (result == LDAP_RES_SEARCH_RESULT) {
+            // NOTE: notification searches only end when
+            // server ends them, for example because of an
+            // error or a limit
+            d->notification_ids.remove(msgid);
+            ended_ids->append(msgid);
+        }
+
+        ldap_msgfree(res);
+
+        // NOTE: after the first message, only collect
+        // messages which have already arrived
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 0;
+    }
+}
+
+AdObject AdInterface::search_object(const QString &dn, const QList<QString> &attributes) {
+    const AdOperationGuard operation_guard(d);
+
+    // NOTE: base scope read returns at most one object, so
+    // it doesn't need the paging that search() does
+    const QHash<QString, AdObject> results = search_objects({dn}, attributes);
+
+    return results.value(dn);
+}
+
+QHash<QString, AdObject> AdInterface::search_objects(const QList<QString> &dn_list, const QList<QString> &attributes) {
+    const AdOperationGuard operation_guard(d);
+
+    QHash<QString, AdObject> out;
+
+    if (dn_list.isEmpty()) {
+        return out;
+    }
+
+    if (d->settings->log_searches) {
+        const QString attributes_string = "{" + attributes.join(",") + "}";
+
+        d->success_message(QString(tr("Search objects:\n\tattributes = %1\n\tcount = %2")).arg(attributes_string, QString::number(dn_list.size())));
+    }
+
+    // NOTE: see search_paged_internal() for why this
+    // control is needed. Paged results control is not
+    // used because base scope reads return at most one
+    // entry.
+    struct berval *sd_value = sd_control_value(false);
+    if (sd_value == NULL) {
+        qDebug() << "Failed to create SD flags control";
+
+        return out;
+    }
+
+    LDAPControl sd_control;
+    const char *sd_control_oid = LDAP_SERVER_SD_FLAGS_OID;
+    sd_control.ldctl_oid = (char *) sd_control_oid;
+    sd_control.ldctl_value.bv_len = sd_value->bv_len;
+    sd_control.ldctl_value.bv_val = sd_value->bv_val;
+    sd_control.ldctl_iscritical = (char) 1;
+    LDAPControl *server_controls[2] = {&sd_control, NULL};
+
+    char **attributes_array = attributes_to_array(attributes);
+
+    // NOTE: all objects share one arena
+    AdObjectBuilder builder;
+
+    // NOTE: other reads are in flight while entries are
+    // loaded, so ranged attributes are completed after the
+    // pipeline is done
+    d->defer_ranges = true;
+
+    d->run_pipelined(PipelineType_Read, dn_list.size(),
+        [&](const int i) {
+            return d->send_search_object(dn_list[i], attributes_array, server_controls);
+        },
+        [&](const int i, LDAPMessage *res) {
+            LDAPMessage *entry = ldap_first_entry(d->ld, res);
+
+            // NOTE: use requested dn as key instead of dn
+            // returned by server, so that callers can look
+            // up objects by the dn's they passed in
+            if (entry != NULL) {
+                const AdObject object = d->load_entry(entry, nullptr, &builder);
+                out[dn_list[i]] = object;
+            }
+        });
+
+    d->defer_ranges = false;
+
+    if (!d->deferred_range_map.isEmpty()) {
+        for (const QString &dn : out.keys()) {
+            out[dn] = d->complete_ranges(out[dn]);
+        }
+
+        d->deferred_range_map.clear();
+    }
+
+    attributes_array_free(attributes_array);
+    ber_bvfree(sd_value);
+
+    return out;
+}
+
+bool AdInterface::attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    return d->attribute_replace_values(dn, attribute, values, nullptr, do_msg);
+}
+
+bool AdInterface::attribute_replace_values(const AdObject &object, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QList<QByteArray> old_values = object.get_values(attribute);
+
+    return d->attribute_replace_values(object.get_dn(), attribute, values, &old_values, do_msg);
+}
+
+bool AdInterfacePrivate::attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const QList<QByteArray> *known_old_values, const DoStatusMsg do_msg) {
+    // Do nothing if both new and old values are empty
+    if (known_old_values != nullptr && known_old_values->isEmpty() && values.isEmpty()) {
+        return true;
+    }
+
+    // NOTE: store bvalues in array instead of dynamically allocating ptrs
+    struct berval bvalues_storage[values.size()];
+    struct berval *bvalues[values.size() + 1];
+    bvalues[values.size()] = NULL;
+    for (int i = 0; i < values.size(); i++) {
+        const QByteArray &value = values[i];
+        struct berval *bvalue = &(bvalues_storage[i]);
+
+        bvalue->bv_val = (char *) value.constData();
+        bvalue->bv_len = (size_t) value.size();
+
+        bvalues[i] = bvalue;
+    }
+
+    const QByteArray attribute_bytes = attribute.toUtf8();
+
+    LDAPMod attr;
+    attr.mod_op = (LDAP_MOD_REPLACE | LDAP_MOD_BVALUES);
+    attr.mod_type = (char *) attribute_bytes.constData();
+    attr.mod_bvalues = bvalues;
+
+    LDAPMod *attrs[] = {&attr, NULL};
+
+    // NOTE: if old values are not known, get them
+    // through pre-read instead of reading the object
+    // before modifying it
+    const QList<QString> pre_read_attributes = [&]() -> QList<QString> {
+        if (known_old_values == nullptr) {
+            return {attribute};
+        } else {
+            return QList<QString>();
+        }
+    }();
+
+    AdObject pre_read_object;
+
+    const int result = modify(dn, attrs, pre_read_attributes, &pre_read_object);
+
+    const bool old_values_known = (known_old_values != nullptr || !pre_read_object.get_dn().isEmpty());
+    const QList<QByteArray> old_values = [&]() {
+        if (known_old_values != nullptr) {
+            return *known_old_values;
+        } else {
+            return pre_read_object.get_values(attribute);
+        }
+    }();
+
+    const QString name = dn_get_name(dn);
+    const QString values_display = attribute_display_values(attribute, values, adconfig);
+    const QString old_values_display = attribute_display_values(attribute, old_values, adconfig);
+
+    if (result == LDAP_SUCCESS) {
+        if (old_values_known) {
+            success_message(QString(AdInterface::tr("Attribute %1 of object %2 was changed from \"%3\" to \"%4\".")).arg(attribute, name, old_values_display, values_display), do_msg);
+        } else {
+            success_message(QString(AdInterface::tr("Attribute %1 of object %2 was changed to \"%3\".")).arg(attribute, name, values_display), do_msg);
+        }
+
+        return true;
+    } else {
+        const QString context = [&]() {
+            if (old_values_known) {
+                return QString(AdInterface::tr("Failed to change attribute %1 of object %2 from \"%3\" to \"%4\".")).arg(attribute, name, old_values_display, values_display);
+            } else {
+                return QString(AdInterface::tr("Failed to change attribute %1 of object %2 to \"%3\".")).arg(attribute, name, values_display);
+            }
+        }();
+
+        error_message(context, default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::attribute_replace_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QList<QByteArray> values = [=]() -> QList<QByteArray> {
+        if (value.isEmpty()) {
+            return QList<QByteArray>();
+        } else {
+            return {value};
+        }
+    }();
+
+    return attribute_replace_values(dn, attribute, values, do_msg);
+}
+
+bool AdInterface::attribute_add_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    char *data_copy = (char *) malloc(value.size());
+    if (data_copy == NULL) {
+        return false;
+    }
+    memcpy(data_copy, value.constData(), value.size());
+
+    struct berval ber_data;
+    ber_data.bv_val = data_copy;
+    ber_data.bv_len = value.size();
+
+    struct berval *values[] = {&ber_data, NULL};
+
+    const QByteArray attribute_bytes = attribute.toUtf8();
+
+    LDAPMod attr;
+    attr.mod_op = LDAP_MOD_ADD | LDAP_MOD_BVALUES;
+    attr.mod_type = (char *) attribute_bytes.constData();
+    attr.mod_bvalues = values;
+
+    LDAPMod *attrs[] = {&attr, NULL};
+
+    const int result = d->modify(dn, attrs);
+    free(data_copy);
+
+    const QString name = dn_get_name(dn);
+    const QString new_display_value = attribute_display_value(attribute, value, d->adconfig);
+
+    if (result == LDAP_SUCCESS) {
+        const QString context = QString(tr("Value \"%1\" was added for attribute %2 of object %3.")).arg(new_display_value, attribute, name);
+
+        d->success_message(context, do_msg);
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to add value \"%1\" for attribute %2 of object %3.")).arg(new_display_value, attribute, name);
+
+        d->error_message(context, d->default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::attribute_delete_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString name = dn_get_name(dn);
+    const QString value_display = attribute_display_value(attribute, value, d->adconfig);
+
+    char *data_copy = (char *) malloc(value.size());
+    if (data_copy == NULL) {
+        return false;
+    }
+    memcpy(data_copy, value.constData(), value.size());
+
+    struct berval ber_data;
+    ber_data.bv_val = data_copy;
+    ber_data.bv_len = value.size();
+
+    const QByteArray attribute_bytes = attribute.toUtf8();
+
+    LDAPMod attr;
+    struct berval *values[] = {&ber_data, NULL};
+    attr.mod_op = LDAP_MOD_DELETE | LDAP_MOD_BVALUES;
+    attr.mod_type = (char *) attribute_bytes.constData();
+    attr.mod_bvalues = values;
+
+    LDAPMod *attrs[] = {&attr, NULL};
+
+    const int result = d->modify(dn, attrs);
+    free(data_copy);
+
+    if (result == LDAP_SUCCESS) {
+        const QString context = QString(tr("Value \"%1\" for attribute %2 of object %3 was deleted.")).arg(value_display, attribute, name);
+
+        d->success_message(context, do_msg);
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to delete value \"%1\" for attribute %2 of object %3.")).arg(value_display, attribute, name);
+
+        d->error_message(context, d->default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::attribute_replace_string(const QString &dn, const QString &attribute, const QString &value, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QByteArray value_bytes = value.toUtf8();
+
+    return attribute_replace_value(dn, attribute, value_bytes, do_msg);
+}
+
+bool AdInterface::attribute_replace_int(const QString &dn, const QString &attribute, const int value, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString value_string = QString::number(value);
+    const bool result = attribute_replace_string(dn, attribute, value_string, do_msg);
+
+    return result;
+}
+
+bool AdInterface::attribute_replace_datetime(const QString &dn, const QString &attribute, const QDateTime &datetime) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString datetime_string = datetime_qdatetime_to_string(attribute, datetime, d->adconfig);
+    const bool result = attribute_replace_string(dn, attribute, datetime_string);
+
+    return result;
+}
+
+bool AdInterface::object_modify(const QString &dn, const AdChangeSet &changes, const DoStatusMsg do_msg, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    return d->object_modify(dn, changes, nullptr, do_msg, post_read_attributes, post_read_out);
+}
+
+bool AdInterface::object_modify(const AdObject &object, const AdChangeSet &changes, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    return d->object_modify(object.get_dn(), changes, &object, do_msg);
+}
+
+bool AdInterfacePrivate::object_modify(const QString &dn, const AdChangeSet &changes, const AdObject *known_object, const DoStatusMsg do_msg, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    if (changes.is_empty()) {
+        return true;
+    }
+
+    const QString name = dn_get_name(dn);
+
+    // NOTE: skip replacements where both new and old
+    // values are empty, same as
+    // attribute_replace_values() does. This is only
+    // possible if old values are known.
+    const QList<AdChange> change_list = [&]() {
+        QList<AdChange> out;
+
+        for (const AdChange &change : changes.changes()) {
+            const bool is_empty_replace = (known_object != nullptr && change.type == AdChangeType_Replace && change.values.isEmpty() && known_object->get_values(change.attribute).isEmpty());
+
+            if (!is_empty_replace) {
+                out.append(change);
+            }
+        }
+
+        return out;
+    }();
+
+    if (change_list.isEmpty()) {
+        return true;
+    }
+
+    // NOTE: allocate all storage up front, so that
+    // pointers into it stay valid
+    const int values_count = [&]() {
+        int out = 0;
+
+        for (const AdChange &change : change_list) {
+            out += change.values.size();
+        }
+
+        return out;
+    }();
+
+    QList<QByteArray> attribute_bytes_list;
+    QVector<struct berval> bvalues_storage(values_count);
+    QVector<struct berval *> bvalues_ptr_storage(values_count + change_list.size());
+    QVector<LDAPMod> mods_storage(change_list.size());
+    QVector<LDAPMod *> mods(change_list.size() + 1);
+
+    int bvalue_i = 0;
+    int bvalue_ptr_i = 0;
+
+    for (int i = 0; i < change_list.size(); i++) {
+        const AdChange &change = change_list[i];
+
+        attribute_bytes_list.append(change.attribute.toUtf8());
+
+        struct berval **bvalues = &bvalues_ptr_storage[bvalue_ptr_i];
+
+        for (const QByteArray &value : change.values) {
+            struct berval *bvalue = &bvalues_storage[bvalue_i];
+            bvalue->bv_val = (char *) value.constData();
+            bvalue->bv_len = (size_t) value.size();
+
+            bvalues_ptr_storage[bvalue_ptr_i] = bvalue;
+
+            bvalue_i++;
+            bvalue_ptr_i++;
+        }
+
+        bvalues_ptr_storage[bvalue_ptr_i] = NULL;
+        bvalue_ptr_i++;
+
+        const int mod_op = [&]() {
+            switch (change.type) {
+                case AdChangeType_Replace: return LDAP_MOD_REPLACE;
+                case AdChangeType_Add: return LDAP_MOD_ADD;
+                case AdChangeType_Delete: return LDAP_MOD_DELETE;
+            }
+            return LDAP_MOD_REPLACE;
+        }();
+
+        LDAPMod *mod = &mods_storage[i];
+        mod->mod_op = (mod_op | LDAP_MOD_BVALUES);
+        mod->mod_type = (char *) attribute_bytes_list.last().constData();
+        mod->mod_bvalues = bvalues;
+
+        mods[i] = mod;
+    }
+    mods[change_list.size()] = NULL;
+
+    // Old values of replaced attributes are needed for
+    // status messages. If they are not known, get them
+    // through pre-read in the same request.
+    const QList<QString> pre_read_attributes = [&]() {
+        QList<QString> out;
+
+        if (known_object != nullptr) {
+            return out;
+        }
+
+        for (const AdChange &change : change_list) {
+            if (change.type == AdChangeType_Replace && !out.contains(change.attribute)) {
+                out.append(change.attribute);
+            }
+        }
+
+        return out;
+    }();
+
+    AdObject pre_read_object;
+
+    const int result = modify(dn, mods.data(), pre_read_attributes, &pre_read_object, post_read_attributes, post_read_out);
+
+    const AdObject &old_object = (known_object != nullptr) ? *known_object : pre_read_object;
+    const bool old_values_known = (known_object != nullptr || !pre_read_object.get_dn().isEmpty());
+
+    if (result == LDAP_SUCCESS) {
+        for (const AdChange &change : change_list) {
+            switch (change.type) {
+                case AdChangeType_Replace: {
+                    const QList<QByteArray> old_values = old_object.get_values(change.attribute);
+                    const QString values_display = attribute_display_values(change.attribute, change.values, adconfig);
+                    const QString old_values_display = attribute_display_values(change.attribute, old_values, adconfig);
+
+                    if (old_values_known) {
+                        success_message(QString(AdInterface::tr("Attribute %1 of object %2 was changed from \"%3\" to \"%4\".")).arg(change.attribute, name, old_values_display, values_display), do_msg);
+                    } else {
+                        success_message(QString(AdInterface::tr("Attribute %1 of object %2 was changed to \"%3\".")).arg(change.attribute, name, values_display), do_msg);
+                    }
+
+                    break;
+                }
+                case AdChangeType_Add: {
+                    for (const QByteArray &value : change.values) {
+                        const QString value_display = attribute_display_value(change.attribute, value, adconfig);
+
+                        success_message(QString(AdInterface::tr("Value \"%1\" was added for attribute %2 of object %3.")).arg(value_display, change.attribute, name), do_msg);
+                    }
+
+                    break;
+                }
+                case AdChangeType_Delete: {
+                    for (const QByteArray &value : change.values) {
+                        const QString value_display = attribute_display_value(change.attribute, value, adconfig);
+
+                        success_message(QString(AdInterface::tr("Value \"%1\" for attribute %2 of object %3 was deleted.")).arg(value_display, change.attribute, name), do_msg);
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return true;
+    } else {
+        const QString attributes_string = [&]() {
+            QList<QString> attribute_list;
+
+            for (const AdChange &change : change_list) {
+                if (!attribute_list.contains(change.attribute)) {
+                    attribute_list.append(change.attribute);
+                }
+            }
+
+            return attribute_list.join(", ");
+        }();
+
+        const QString context = QString(AdInterface::tr("Failed to change attributes %1 of object %2.")).arg(attributes_string, name);
+
+        error_message(context, default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::object_add(const QString &dn, const QString &object_class, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    const QByteArray object_class_bytes = object_class.toUtf8();
+    const char *classes[2] = {object_class_bytes.constData(), NULL};
+
+    LDAPMod attr;
+    attr.mod_op = LDAP_MOD_ADD;
+    attr.mod_type = (char *) "objectClass";
+    attr.mod_values = (char **) classes;
+
+    LDAPMod *attrs[] = {&attr, NULL};
+
+    const int result = d->add(dn, attrs, post_read_attributes, post_read_out);
+
+    if (result == LDAP_SUCCESS) {
+        d->success_message(QString(tr("Object %1 was created.")).arg(dn));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to create object %1.")).arg(dn);
+
+        const QString error = [this, dn]() {
+            const bool wrong_ou_parent = [&]() {
+                const int ldap_result = d->get_ldap_result();
+                
+                const bool is_ou = dn.startsWith("OU=");
+                const QString parent = dn_get_parent(dn);
+                const bool bad_parent = parent.startsWith("CN=");
+
+                const bool out = (ldap_result == LDAP_NAMING_VIOLATION && is_ou && bad_parent);
+
+                return out;
+            }();
+
+            if (wrong_ou_parent) {
+                return tr("Can't create OU under this object type.");
+            } else {
+                return d->default_error();
+            }
+        }();
+
+        d->error_message(context, error);
+
+        return false;
+    }
+}
+
+bool AdInterface::object_delete(const QString &dn, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    int result;
+    LDAPControl *tree_delete_control = NULL;
+
+    auto cleanup = [tree_delete_control]() {
+        ldap_control_free(tree_delete_control);
+    };
+
+    const QString name = dn_get_name(dn);
+
+    const QString error_context = QString(tr("Failed to delete object %1.")).arg(name);
+
+    // Use a tree delete control to enable recursive delete
+    tree_delete_control = (LDAPControl *) malloc(sizeof(LDAPControl));
+    if (tree_delete_control == NULL) {
+        d->error_message(error_context, tr("LDAP Operation error - Failed to allocate tree delete control."));
+        cleanup();
+
+        return false;
+    }
+
+    result = ldap_control_create(LDAP_CONTROL_X_TREE_DELETE, 1, NULL, 0, &tree_delete_control);
+    if (result != LDAP_SUCCESS) {
+        d->error_message(error_context, tr("LDAP Operation error - Failed to create tree delete control."));
+        cleanup();
+
+        return false;
+    }
+
+    LDAPControl *server_controls[2] = {tree_delete_control, NULL};
+
+    result = d->delete_entry(dn, server_controls);
+
+    cleanup();
+
+    if (result == LDAP_SUCCESS) {
+        d->success_message(QString(tr("Object %1 was deleted.")).arg(name), do_msg);
+
+        return true;
+    } else {
+        d->error_message(error_context, d->default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::object_move(const QString &dn, const QString &new_container, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString rdn = dn.split(',')[0];
+    const QString new_dn = rdn + "," + new_container;
+    const QString object_name = dn_get_name(dn);
+    const QString container_name = dn_get_name(new_container);
+
+    const int result = d->rename(dn, rdn, new_container, post_read_attributes, post_read_out);
+
+    if (result == LDAP_SUCCESS) {
+        d->success_message(QString(tr("Object %1 was moved to %2.")).arg(object_name, container_name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to move object %1 to %2.")).arg(object_name, container_name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::object_rename(const QString &dn, const QString &new_name, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString new_dn = dn_rename(dn, new_name);
+    const QString new_rdn = new_dn.split(",")[0];
+    const QString old_name = dn_get_name(dn);
+
+    const int result = d->rename(dn, new_rdn, QString(), post_read_attributes, post_read_out);
+
+    if (result == LDAP_SUCCESS) {
+        d->success_message(QString(tr("Object %1 was renamed to %2.")).arg(old_name, new_name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to rename object %1 to %2.")).arg(old_name, new_name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::group_add_member(const QString &group_dn, const QString &user_dn) {
+    const AdOperationGuard operation_guard(d);
+
+    const QByteArray user_dn_bytes = user_dn.toUtf8();
+    const bool success = attribute_add_value(group_dn, ATTRIBUTE_MEMBER, user_dn_bytes, DoStatusMsg_No);
+
+    const QString user_name = dn_get_name(user_dn);
+    const QString group_name = dn_get_name(group_dn);
+
+    if (success) {
+        d->success_message(QString(tr("Object %1 was added to group %2.")).arg(user_name, group_name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to add object %1 to group %2.")).arg(user_name, group_name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::group_remove_member(const QString &group_dn, const QString &user_dn) {
+    const AdOperationGuard operation_guard(d);
+
+    const QByteArray user_dn_bytes = user_dn.toUtf8();
+    const bool success = attribute_delete_value(group_dn, ATTRIBUTE_MEMBER, user_dn_bytes, DoStatusMsg_No);
+
+    const QString user_name = dn_get_name(user_dn);
+    const QString group_name = dn_get_name(group_dn);
+
+    if (success) {
+        d->success_message(QString(tr("Object %1 was removed from group %2.")).arg(user_name, group_name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to remove object %1 from group %2.")).arg(user_name, group_name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::group_set_scope(const QString &dn, GroupScope scope, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const AdObject object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
+
+    return group_set_scope(object, scope, do_msg);
+}
+
+bool AdInterface::group_set_scope(const AdObject &object, GroupScope scope, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString dn = object.get_dn();
+    const QString name = dn_get_name(dn);
+    const QString scope_string = group_scope_string(scope);
+
+    const auto group_type_with_scope = [](const int group_type_arg, const GroupScope new_scope) {
+        int out = group_type_arg;
+
+        // Unset all scope bits, because scope bits are exclusive
+        for (int i = 0; i < GroupScope_COUNT; i++) {
+            const GroupScope this_scope = (GroupScope) i;
+            const int this_scope_bit = group_scope_bit(this_scope);
+
+            out = bit_set(out, this_scope_bit, false);
+        }
+
+        // Set given scope bit
+        const int scope_bit = group_scope_bit(new_scope);
+        out = bit_set(out, scope_bit, true);
+
+        return out;
+    };
+
+    // NOTE: group type of given object may be stale, so
+    // instead of replacing it, swap the known value for the
+    // updated one, same as in user_set_account_option()
+    const auto set_scope = [&](const AdObject &group_object) {
+        // NOTE: it is not possible to change scope from
+        // global<->domainlocal directly, so have to switch
+        // to universal first.
+        const GroupScope current_scope = group_object.get_group_scope();
+        const bool need_to_switch_to_universal = (current_scope == GroupScope_Global && scope == GroupScope_DomainLocal) || (current_scope == GroupScope_DomainLocal && scope == GroupScope_Global);
+
+        QByteArray old_value = group_object.get_value(ATTRIBUTE_GROUP_TYPE);
+        int group_type = group_object.get_int(ATTRIBUTE_GROUP_TYPE);
+
+        if (need_to_switch_to_universal) {
+            const int universal_group_type = group_type_with_scope(group_type, GroupScope_Universal);
+            const QByteArray universal_bytes = QString::number(universal_group_type).toUtf8();
+
+            const int switch_result = d->swap_value(dn, ATTRIBUTE_GROUP_TYPE, old_value, universal_bytes);
+            if (switch_result != LDAP_SUCCESS) {
+                return switch_result;
+            }
+
+            group_type = universal_group_type;
+            old_value = universal_bytes;
+        }
+
+        const int updated_group_type = group_type_with_scope(group_type, scope);
+        const QByteArray updated_bytes = QString::number(updated_group_type).toUtf8();
+
+        return d->swap_value(dn, ATTRIBUTE_GROUP_TYPE, old_value, updated_bytes);
+    };
+
+    int swap_result = [&]() {
+        if (object.contains(ATTRIBUTE_GROUP_TYPE)) {
+            return set_scope(object);
+        } else {
+            return LDAP_NO_SUCH_ATTRIBUTE;
+        }
+    }();
+
+    // If group type changed since object was loaded, read
+    // current value and try again
+    if (swap_result == LDAP_NO_SUCH_ATTRIBUTE) {
+        const AdObject current_object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
+        swap_result = set_scope(current_object);
+    }
+
+    const bool result = (swap_result == LDAP_SUCCESS);
+    if (result) {
+        d->success_message(QString(tr("Group scope for %1 was changed to \"%2\".")).arg(name, scope_string), do_msg);
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to change group scope for %1 to \"%2\".")).arg(name, scope_string);
+
+        d->error_message(context, d->default_error(), do_msg);
+
+        return false;
+    }
+}
+
+bool AdInterface::group_set_type(const QString &dn, GroupType type) {
+    const AdOperationGuard operation_guard(d);
+
+    const AdObject object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
+
+    return group_set_type(object, type);
+}
+
+bool AdInterface::group_set_type(const AdObject &object, GroupType type) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString dn = object.get_dn();
+
+    const bool set_security_bit = type == GroupType_Security;
+
+    const QString name = dn_get_name(dn);
+    const QString type_string = group_type_string(type);
+
+    // NOTE: group type of given object may be stale, so
+    // instead of replacing it, swap the known value for the
+    // updated one, same as in user_set_account_option()
+    const auto set_type = [&](const AdObject &group_object) {
+        const QByteArray old_value = group_object.get_value(ATTRIBUTE_GROUP_TYPE);
+        const int update_group_type = bit_set(group_object.get_int(ATTRIBUTE_GROUP_TYPE), GROUP_TYPE_BIT_SECURITY, set_security_bit);
+        const QByteArray update_group_type_bytes = QString::number(update_group_type).toUtf8();
+
+        return d->swap_value(dn, ATTRIBUTE_GROUP_TYPE, old_value, update_group_type_bytes);
+    };
+
+    int swap_result = [&]() {
+        if (object.contains(ATTRIBUTE_GROUP_TYPE)) {
+            return set_type(object);
+        } else {
+            return LDAP_NO_SUCH_ATTRIBUTE;
+        }
+    }();
+
+    // If group type changed since object was loaded, read
+    // current value and try again
+    if (swap_result == LDAP_NO_SUCH_ATTRIBUTE) {
+        const AdObject current_object = search_object(dn, {ATTRIBUTE_GROUP_TYPE});
+        swap_result = set_type(current_object);
+    }
+
+    const bool result = (swap_result == LDAP_SUCCESS);
+    if (result) {
+        d->success_message(QString(tr("Group type for %1 was changed to \"%2\".")).arg(name, type_string));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to change group type for %1 to \"%2\".")).arg(name, type_string);
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::user_set_primary_group(const QString &group_dn, const QString &user_dn) {
+    const AdOperationGuard operation_guard(d);
+
+    const AdObject group_object = search_object(group_dn, {ATTRIBUTE_OBJECT_SID, ATTRIBUTE_MEMBER});
+
+    // NOTE: need to add user to group before it can become primary
+    const QList<QString> group_members = group_object.get_strings(ATTRIBUTE_MEMBER);
+    const bool user_is_in_group = group_members.contains(user_dn);
+    if (!user_is_in_group) {
+        group_add_member(group_dn, user_dn);
+    }
+
+    const QByteArray group_sid = group_object.get_value(ATTRIBUTE_OBJECT_SID);
+    const QString group_rid = extract_rid_from_sid(group_sid, d->adconfig);
+
+    const bool success = attribute_replace_string(user_dn, ATTRIBUTE_PRIMARY_GROUP_ID, group_rid, DoStatusMsg_No);
+
+    const QString user_name = dn_get_name(user_dn);
+    const QString group_name = dn_get_name(group_dn);
+
+    if (success) {
+        d->success_message(QString(tr("Primary group for object %1 was changed to %2.")).arg(user_name, group_name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to change primary group for user %1 to %2.")).arg(user_name, group_name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::user_set_pass(const QString &dn, const QString &password, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    // NOTE: AD requires that the password:
+    // 1. is surrounded by quotes
+    // 2. is encoded as UTF16-LE
+    // 3. has no Byte Order Mark
+    const QString quoted_password = QString("\"%1\"").arg(password);
+    const auto codec = QTextCodec::codecForName("UTF-16LE");
+    QByteArray password_bytes = codec->fromUnicode(quoted_password);
+    // Remove BOM
+    // NOTE: gotta be a way to tell codec not to add BOM
+    // but couldn't find it, only QTextStream has
+    // setGenerateBOM()
+    if (password_bytes[0] != '\"') {
+        password_bytes.remove(0, 2);
+    }
+
+    const bool success = attribute_replace_value(dn, ATTRIBUTE_PASSWORD, password_bytes, DoStatusMsg_No);
+
+    const QString name = dn_get_name(dn);
+
+    if (success) {
+        d->success_message(QString(tr("Password for object %1 was changed.")).arg(name), do_msg);
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to change password for object %1.")).arg(name);
+
+        const QString error = [this]() {
+            const int ldap_result = d->get_ldap_result();
+            if (ldap_result == LDAP_CONSTRAINT_VIOLATION) {
+                return tr("Password doesn't match rules.");
+            } else {
+                return d->default_error();
+            }
+        }();
+
+        d->error_message(context, error, do_msg);
+
+        return false;
+    }
+}
+
+// TODO:
+// "User cannot change password" - CAN'T just set PASSWD_CANT_CHANGE. See: https://docs.microsoft.com/en-us/windows/win32/adsi/modifying-user-cannot-change-password-ldap-provider?redirectedfrom=MSDN
+// "This account supports 128bit encryption" (and for 256bit)
+// "Use Kerberos DES encryption types for this account"
+bool AdInterface::user_set_account_option(const QString &dn, AccountOption option, bool set) {
+    const AdOperationGuard operation_guard(d);
+
+    if (dn.isEmpty()) {
+        return false;
+    }
+
+    // NOTE: object without attributes, they are read
+    // only if the option needs them
+    AdObject object;
+    object.load(dn, QHash<QString, QList<QByteArray>>());
+
+    return user_set_account_option(object, option, set);
+}
+
+bool AdInterface::user_set_account_option(const AdObject &object, AccountOption option, bool set) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString dn = object.get_dn();
+
+    if (dn.isEmpty()) {
+        return false;
+    }
+
+    bool success = false;
+
+    switch (option) {
+        case AccountOption_CantChangePassword: {
+            const AdObject sd_object = [&]() {
+                if (object.contains(ATTRIBUTE_SECURITY_DESCRIPTOR)) {
+                    return object;
+                } else {
+                    return search_object(dn, {ATTRIBUTE_SECURITY_DESCRIPTOR});
+                }
+            }();
+            const auto old_security_state = sd_object.get_security_state(d->adconfig);
+
+            const QByteArray self_trustee = sid_string_to_bytes(SID_NT_SELF);
+
+            const PermissionState new_permission_state = [&]() {
+                if (set) {
+                    return PermissionState_Denied;
+                } else {
+                    return PermissionState_Allowed;
+                }
+            }();
+
+            const auto new_security_state = ad_security_modify(old_security_state, self_trustee, AcePermission_ChangePassword, new_permission_state);
+
+            success = attribute_replace_security_descriptor(this, dn, new_security_state);
+
+            break;
+        }
+        case AccountOption_PasswordExpired: {
+            QString pwdLastSet_value;
+            if (set) {
+                pwdLastSet_value = AD_PWD_LAST_SET_EXPIRED;
+            } else {
+                pwdLastSet_value = AD_PWD_LAST_SET_RESET;
+            }
+
+            success = attribute_replace_string(dn, ATTRIBUTE_PWD_LAST_SET, pwdLastSet_value, DoStatusMsg_No);
+
+            break;
+        }
+        default: {
+            const int bit = account_option_bit(option);
+
+            // NOTE: UAC value of given object may be stale,
+            // so instead of replacing it, swap the known
+            // value for the updated one. If UAC was changed
+            // since object was loaded, the swap fails
+            // without modifying anything and then the
+            // current value is read.
+            const int swap_result = [&]() {
+                if (!object.contains(ATTRIBUTE_USER_ACCOUNT_CONTROL)) {
+                    return LDAP_NO_SUCH_ATTRIBUTE;
+                }
+
+                const QByteArray old_uac = object.get_value(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+                const int updated_uac = bit_set(object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL), bit, set);
+                const QByteArray updated_uac_bytes = QString::number(updated_uac).toUtf8();
+
+                return d->swap_value(dn, ATTRIBUTE_USER_ACCOUNT_CONTROL, old_uac, updated_uac_bytes);
+            }();
+
+            if (swap_result == LDAP_NO_SUCH_ATTRIBUTE) {
+                const AdObject current_object = search_object(dn, {ATTRIBUTE_USER_ACCOUNT_CONTROL});
+                const QList<QByteArray> old_values = current_object.get_values(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+                const int updated_uac = bit_set(current_object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL), bit, set);
+                const QByteArray updated_uac_bytes = QString::number(updated_uac).toUtf8();
+
+                success = d->attribute_replace_values(dn, ATTRIBUTE_USER_ACCOUNT_CONTROL, {updated_uac_bytes}, &old_values, DoStatusMsg_No);
+            } else {
+                success = (swap_result == LDAP_SUCCESS);
+            }
+        }
+    }
+
+    const QString name = dn_get_name(dn);
+
+    if (success) {
+        d->success_message(account_option_success_context(option, set, name));
+
+        return true;
+    } else {
+        const QString context = account_option_error_context(option, set, name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+bool AdInterface::user_unlock(const QString &dn) {
+    const AdOperationGuard operation_guard(d);
+
+    const bool result = attribute_replace_string(dn, ATTRIBUTE_LOCKOUT_TIME, LOCKOUT_UNLOCKED_VALUE);
+
+    const QString name = dn_get_name(dn);
+
+    if (result) {
+        d->success_message(QString(tr("User \"%1\" was unlocked.")).arg(name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to unlock user %1.")).arg(name);
+
+        d->error_message(context, d->default_error());
+
+        return result;
+    }
+}
+
+bool AdInterface::computer_reset_account(const QString &dn) {
+    const AdOperationGuard operation_guard(d);
+
+    const QString name = dn_get_name(dn);
+    const QString reset_password = QString("%1$").arg(name);
+
+    const bool success = user_set_pass(dn, reset_password, DoStatusMsg_No);
+
+    if (success) {
+        d->success_message(QString(tr("Computer \"%1\" was reset.")).arg(name));
+
+        return true;
+    } else {
+        const QString context = QString(tr("Failed to reset computer %1.")).arg(name);
+
+        d->error_message(context, d->default_error());
+
+        return false;
+    }
+}
+
+QList<QString> AdInterface::object_delete_batch(const QList<QString> &dn_list, const DoStatusMsg do_msg) {
+    const AdOperationGuard operation_guard(d);
+
+    QList<QString> out;
+
+    // Use a tree delete control to enable recursive delete
+    LDAPControl *tree_delete_control = NULL;
+    const int create_result = ldap_control_create(LDAP_CONTROL_X_TREE_DELETE, 1, NULL, 0, &tree_delete_control);
+    if (create_result != LDAP_SUCCESS) {
+        for (const QString &dn : dn_list) {
+            const QString error_context = QString(tr("Failed to delete object %1.")).arg(dn_get_name(dn));
+            d->error_message(error_context, tr("LDAP Operation error - Failed to create tree delete control."), do_msg);
+        }
+
+        return out;
+    }
+
+    LDAPControl *server_controls[2] = {tree_delete_control, NULL};
+
+    const QList<int> result_list = d->run_pipelined(PipelineType_Write, dn_list.size(),
+        [&](const int i) {
+            int msgid;
+            AdReadRouter::instance()->note_write();
+            const int result = ldap_delete_ext(d->ld, dn_list[i].toUtf8().constData(), server_controls, NULL, &msgid);
+
+            return (result == LDAP_SUCCESS) ? msgid : -1;
+        });
+
+    ldap_control_free(tree_delete_control);
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
+        const QString name = dn_get_name(dn);
+        const int result = result_list[i];
+
+        if (result == LDAP_SUCCESS) {
+            d->success_message(QString(tr("Object %1 was deleted.")).arg(name), do_msg);
+
+            out.append(dn);
+        } else {
+            const QString error_context = QString(tr("Failed to delete object %1.")).arg(name);
+            d->error_message(error_context, d->error_string(result), do_msg);
+        }
+    }
+
+    return out;
+}
+
+QList<QString> AdInterface::object_move_batch(const QList<QString> &dn_list, const QString &new_container, const QList<QString> &post_read_attributes, QHash<QString, AdObject> *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    const QList<int> result_list = d->run_pipelined(PipelineType_Write, dn_list.size(),
+        [&](const int i) {
+            const QString &dn = dn_list[i];
+            const QString rdn = dn.split(',')[0];
+
+            return d->send_rename(dn, rdn, new_container, post_read_attributes);
+        },
+        [&](const int i, LDAPMessage *res) {
+            if (post_read_out == nullptr) {
+                return;
+            }
+
+            AdObject object;
+            d->parse_result_read_entries(res, nullptr, &object);
+
+            // NOTE: use dn_move() for key instead of dn
+            // returned by server, so that keys match dn's
+            // generated by callers
+            if (!object.get_dn().isEmpty()) {
+                const QString new_dn = dn_move(dn_list[i], new_container);
+                post_read_out->insert(new_dn, object);
+            }
+        });
+
+    QList<QString> out;
+
+    const QString container_name = dn_get_name(new_container);
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
+        const QString object_name = dn_get_name(dn);
+        const int result = result_list[i];
+
+        if (result == LDAP_SUCCESS) {
+            d->success_message(QString(tr("Object %1 was moved to %2.")).arg(object_name, container_name));
+
+            out.append(dn);
+        } else {
+            const QString context = QString(tr("Failed to move object %1 to %2.")).arg(object_name, container_name);
+
+            d->error_message(context, d->error_string(result));
+        }
+    }
+
+    return out;
+}
+
+QList<QString> AdInterface::user_set_account_option_batch(const QList<QString> &dn_list, AccountOption option, bool set) {
+    const AdOperationGuard operation_guard(d);
+
+    QList<QString> out;
+
+    // NOTE: only options that are stored in UAC are
+    // pipelined, others require more complex processing
+    // and are done one by one
+    const bool is_uac_option = (option != AccountOption_CantChangePassword && option != AccountOption_PasswordExpired);
+    if (!is_uac_option) {
+        for (const QString &dn : dn_list) {
+            const bool success = user_set_account_option(dn, option, set);
+
+            if (success) {
+                out.append(dn);
+            }
+        }
+
+        return out;
+    }
+
+    // First, read current UAC values of all objects
+    QList<int> uac_list;
+    for (int i = 0; i < dn_list.size(); i++) {
+        uac_list.append(0);
+    }
+
+    char *read_attributes[] = {(char *) ATTRIBUTE_USER_ACCOUNT_CONTROL, NULL};
+
+    const QList<int> read_result_list = d->run_pipelined(PipelineType_Read, dn_list.size(),
+        [&](const int i) {
+            return d->send_search_object(dn_list[i], read_attributes);
+        },
+        [&](const int i, LDAPMessage *res) {
+            LDAPMessage *entry = ldap_first_entry(d->ld, res);
+
+            if (entry != NULL) {
+                const AdObject object = d->load_entry(entry);
+                uac_list[i] = object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+            }
+        });
+
+    // Then, write updated UAC values for objects that
+    // were read successfully
+    const QList<int> modify_index_list = [&]() {
+        QList<int> index_out;
+
+        for (int i = 0; i < dn_list.size(); i++) {
+            if (read_result_list[i] == LDAP_SUCCESS) {
+                index_out.append(i);
+            }
+        }
+
+        return index_out;
+    }();
+
+    const int bit = account_option_bit(option);
+
+    const QList<int> modify_result_list = d->run_pipelined(PipelineType_Write, modify_index_list.size(),
+        [&](const int j) {
+            const int i = modify_index_list[j];
+            const int updated_uac = bit_set(uac_list[i], bit, set);
+            const QByteArray updated_uac_bytes = QString::number(updated_uac).toUtf8();
+
+            return d->send_modify(dn_list[i], ATTRIBUTE_USER_ACCOUNT_CONTROL, LDAP_MOD_REPLACE, {updated_uac_bytes});
+        });
+
+    QList<int> result_list = read_result_list;
+    for (int j = 0; j < modify_index_list.size(); j++) {
+        const int i = modify_index_list[j];
+        result_list[i] = modify_result_list[j];
+    }
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
+        const QString name = dn_get_name(dn);
+        const int result = result_list[i];
+
+        if (result == LDAP_SUCCESS) {
+            d->success_message(account_option_success_context(option, set, name));
+
+            out.append(dn);
+        } else {
+            const QString context = account_option_error_context(option, set, name);
+
+            d->error_message(context, d->error_string(result));
+        }
+    }
+
+    return out;
+}
+
+QList<QString> AdInterface::user_set_account_option_batch(const QList<AdObject> &object_list, AccountOption option, bool set) {
+    const AdOperationGuard operation_guard(d);
+
+    QList<QString> out;
+
+    const bool is_uac_option = (option != AccountOption_CantChangePassword && option != AccountOption_PasswordExpired);
+    if (!is_uac_option) {
+        for (const AdObject &object : object_list) {
+            const bool success = user_set_account_option(object, option, set);
+
+            if (success) {
+                out.append(object.get_dn());
+            }
+        }
+
+        return out;
+    }
+
+    // NOTE: UAC values are already known, so only the
+    // writes are sent. Writes are swaps, so that objects
+    // with stale values are not modified. Those objects
+    // are retried using the dn version which reads
+    // current values first.
+    const int bit = account_option_bit(option);
+
+    const QList<int> result_list = d->run_pipelined(PipelineType_Write, object_list.size(),
+        [&](const int i) {
+            const AdObject &object = object_list[i];
+
+            if (!object.contains(ATTRIBUTE_USER_ACCOUNT_CONTROL)) {
+                return -1;
+            }
+
+            const QByteArray old_uac = object.get_value(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+            const int updated_uac = bit_set(object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL), bit, set);
+            const QByteArray updated_uac_bytes = QString::number(updated_uac).toUtf8();
+
+            return d->send_swap(object.get_dn(), ATTRIBUTE_USER_ACCOUNT_CONTROL, old_uac, updated_uac_bytes);
+        });
+
+    QList<QString> retry_list;
+
+    for (int i = 0; i < object_list.size(); i++) {
+        const AdObject &object = object_list[i];
+        const QString dn = object.get_dn();
+        const int result = result_list[i];
+
+        if (result == LDAP_SUCCESS) {
+            d->success_message(account_option_success_context(option, set, dn_get_name(dn)));
+
+            out.append(dn);
+        } else if (result == LDAP_NO_SUCH_ATTRIBUTE || !object.contains(ATTRIBUTE_USER_ACCOUNT_CONTROL)) {
+            retry_list.append(dn);
+        } else {
+            const QString context = account_option_error_context(option, set, dn_get_name(dn));
+
+            d->error_message(context, d->error_string(result));
+        }
+    }
+
+    if (!retry_list.isEmpty()) {
+        out += user_set_account_option_batch(retry_list, option, set);
+    }
+
+    return out;
+}
+
+QHash<QString, QList<QString>> AdInterface::group_add_member_batch(const QList<QString> &group_list, const QList<QString> &member_list) {
+    const AdOperationGuard operation_guard(d);
+
+    return d->group_member_batch(group_list, member_list, true);
+}
+
+QHash<QString, QList<QString>> AdInterface::group_remove_member_batch(const QList<QString> &group_list, const QList<QString> &member_list) {
+    const AdOperationGuard operation_guard(d);
+
+    return d->group_member_batch(group_list, member_list, false);
+}
+
+bool AdInterface::gpo_add(const QString &display_name, QString &dn_out, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const AdOperationGuard operation_guard(d);
+
+    auto error_message = [&](const QString &error) {
+        d->error_message(tr("Failed to create GPO."), error);
+    };
+
+    if (!d->logged_in_as_admin()) {
+        error_message(tr("Insufficient rights."));
+
+        return false;
+    }
+
+    //
+    // Generate UUID used for directory and object names
+    //
+    // TODO: make sure endianess works fine on processors
+    // with weird endianess.
+    const QString uuid = []() {
+        uuid_t uuid_struct;
+        uuid_generate_random(uuid_struct);
+
+        char uuid_cstr[UUID_STR_LEN];
+        uuid_unparse_upper(uuid_struct, uuid_cstr);
+
+        const QString out = "{" + QString(uuid_cstr) + "}";
+
+        return out;
+    }();
+
+    // Ex: "\\domain.alt\sysvol\domain.alt\Policies\{FF7E0880-F3AD-4540-8F1D-4472CB4A7044}"
+    const QString filesys_path = QString("\\\\%1\\sysvol\\%2\\Policies\\%3").arg(d->domain.toLower(), d->domain.toLower(), uuid);
+    const QString gpt_path = filesys_path_to_smb_path(filesys_path);
+    const QString gpc_dn = QString("CN=%1,CN=Policies,CN=System,%2").arg(uuid, d->domain_head);
+
+    // After each error case we need to clean up whatever we
+    // have created successfully so far. Don't just use
+    // gpo_delete() because we want to delete partially in
+    // some error cases and that shouldn't print any error
+    // messages.
+    auto cleanup = [&]() {
+        const AdObject gpc_object = search_object(gpc_dn);
+        const bool gpc_exists = !gpc_object.is_empty();
+        if (gpc_exists) {
+            object_delete(gpc_dn);
+        }
+
+        struct stat filestat;
+        const int stat_result = smbc_stat(gpt_path.toUtf8().constData(), &filestat);
+        const bool gpt_exists = (stat_result == 0);
+        if (gpt_exists) {
+            d->delete_gpt(gpt_path);
+        }
+    };
+
+    //
+    // Create GPT
+    //
+
+    // Create root dir
+    // "smb://domain.alt/sysvol/domain.alt/Policies/{FF7E0880-F3AD-4540-8F1D-4472CB4A7044}"
+    const int result_mkdir_gpt = smbc_mkdir(gpt_path.toUtf8().constData(), 0755);
+    if (result_mkdir_gpt != 0) {
+        error_message(tr("Failed to create GPT root dir."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const QString gpt_machine_path = gpt_path + "/Machine";
+    const int result_mkdir_machine = smbc_mkdir(gpt_machine_path.toUtf8().constData(), 0755);
+    if (result_mkdir_machine != 0) {
+        error_message(tr("Failed to create GPT machine dir."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const QString gpt_user_path = gpt_path + "/User";
+    const int result_mkdir_user = smbc_mkdir(gpt_user_path.toUtf8().constData(), 0755);
+    if (result_mkdir_user != 0) {
+        error_message(tr("Failed to create GPT user dir."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const QString gpt_ini_path = gpt_path + "/GPT.INI";
+    const int ini_file = smbc_open(gpt_ini_path.toUtf8().constData(), O_WRONLY | O_CREAT, 0644);
+    if (ini_file < 0) {
+        error_message(tr("Failed to open GPT ini file."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const char *ini_contents = "[General]\r\nVersion=0\r\n";
+    const int bytes_written = smbc_write(ini_file, ini_contents, strlen(ini_contents));
+    smbc_close(ini_file);
+    if (bytes_written < 0) {
+        error_message(tr("Failed to write GPT ini file."));
+
+        cleanup();
+
+        return false;
+    }
+
+    //
+    // Create AD object for gpo
+    //
+    const bool result_add = object_add(gpc_dn, CLASS_GP_CONTAINER);
+    if (!result_add) {
+        error_message(tr("Failed to create GPC object."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const QHash<QString, QString> attribute_value_map = {
+        {ATTRIBUTE_DISPLAY_NAME, display_name},
+        {ATTRIBUTE_GPC_FILE_SYS_PATH, filesys_path},
+        // TODO: samba defaults to 1, ADUC defaults to 0. Figure out what's this supposed to be.
+        {ATTRIBUTE_FLAGS, "1"},
+        {ATTRIBUTE_VERSION_NUMBER, "0"},
+        {ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE"},
+        {ATTRIBUTE_GPC_FUNCTIONALITY_VERSION, "2"},
+    };
+
+    // NOTE: set all attributes in one request, which also
+    // returns the resulting GPC object if requested
+    AdChangeSet gpc_changes;
+    for (const QString &attribute : attribute_value_map.keys()) {
+        const QString value = attribute_value_map[attribute];
+
+        gpc_changes.replace_string(attribute, value);
+    }
+
+    const bool replace_success = object_modify(gpc_dn, gpc_changes, DoStatusMsg_Yes, post_read_attributes, post_read_out);
+
+    if (!replace_success) {
+        error_message(tr("Failed to set GPC attributes."));
+
+        cleanup();
+
+        return false;
+    }
+
+    // User object
+    const QString user_dn = "CN=User," + gpc_dn;
+    const bool result_add_user = object_add(user_dn, CLASS_CONTAINER);
+    attribute_replace_string(gpc_dn, ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE");
+    if (!result_add_user) {
+        error_message(tr("Failed to create user folder object for GPO."));
+
+        cleanup();
+
+        return false;
+    }
+
+    // Machine object
+    const QString machine_dn = "CN=Machine," + gpc_dn;
+    const bool result_add_machine = object_add(machine_dn, CLASS_CONTAINER);
+    attribute_replace_string(gpc_dn, ATTRIBUTE_SHOW_IN_ADVANCED_VIEW_ONLY, "TRUE");
+    if (!result_add_machine) {
+        error_message(tr("Failed to create machine folder object for GPO."));
+
+        cleanup();
+
+        return false;
+    }
+
+    const bool sync_perms_success = gpo_sync_perms(gpc_dn);
+
+    if (!sync_perms_success) {
+        // NOTE: don't fail if failed to sync perms, user
+        // can retry it later
+    }
+
+    dn_out = gpc_dn;
+
+    return true;
+}
+
+QList<QString> AdInterfacePrivate::gpo_get_gpt_contents(const QString &gpt_root_path, bool *ok) {
+    // Collect all contents of the path into a list
+    QList<QString> explore_stack;
+    QList<QString> seen_stack;
+
+    explore_stack.append(gpt_root_path);
+    seen_stack.append(gpt_root_path);
+
+    const QString error_context = QString(tr("Failed to get contents of GPT \"%1\".")).arg(gpt_root_path);
+
+    while (!explore_stack.isEmpty()) {
+        const QString path = explore_stack.takeLast();
+
+        const int dirp = smbc_opendir(path.toUtf8().constData());
+
+        if (dirp < 0) {
+            *ok = false;
+
+            error_message(error_context, tr("Failed to open dir."));
+
+            return QList<QString>();
+        }
+
+        // NOTE: set errno to 0, so that we know
+        // when readdir() fails because it will
+        // change errno.
+        errno = 0;
+
+        smbc_dirent *child_dirent;
+        while ((child_dirent = smbc_readdir(dirp)) != NULL) {
+            const QString child_name = QString(child_dirent->name);
+
+            const bool is_dot_path = (child_name == "." || child_name == "..");
+            if (is_dot_path) {
+                continue;
+            } else {
+                const QString child_path = path + "/" + child_name;
+
+                seen_stack.append(child_path);
+
+                const bool child_is_dir = smb_path_is_dir(child_path, ok);
+                if (!*ok) {
+                    return QList<QString>();
+                }
+
+                if (child_is_dir) {
+                    explore_stack.append(child_path);
+                }
+            }
+        }
+
+        if (errno != 0) {
+            *ok = false;
+
+            error_message(error_context, tr("Failed to read dir."));
+
+            return QList<QString>();
+        }
+
+        smbc_closedir(dirp);
+    }
+
+    return seen_stack;
+}
+
+bool AdInterface::gpo_delete(const QString &dn, bool *deleted_object) {
+    const AdOperationGuard operation_guard(d);
+
+    // NOTE: try to execute both steps, even if first one
+    // (deleting gpc) fails
+
+    // NOTE: get filesys path before deleting object,
+    // otherwise it won't be available!
+    const AdObject object = search_object(dn, {ATTRIBUTE_GPC_FILE_SYS_PATH, ATTRIBUTE_DISPLAY_NAME});
+    const QString filesys_path = object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
+
+    const QString name = object.get_string(ATTRIBUTE_DISPLAY_NAME);
+    const QString smb_path = filesys_path_to_smb_path(filesys_path);
+
+    const bool delete_gpc_success = object_delete(dn);
+    if (!delete_gpc_success) {
+        d->error_message(tr("Failed to delete GPC."), d->default_error());
+    }
+
+    const bool delete_gpt_success = d->delete_gpt(smb_path);
+    if (!delete_gpt_success) {
+        d->error_message_plain(tr("Failed to delete GPT."));
+    }
+
+    // Unlink policy
+    const QString base = d->domain_head;
+    const SearchScope scope = SearchScope_All;
+    const QList<QString> attributes = {ATTRIBUTE_GPLINK};
+    const QString filter = filter_CONDITION(Condition_Contains, ATTRIBUTE_GPLINK, dn);
+    const QHash<QString, AdObject> results = search(base, scope, filter, attributes);
+    for (const AdObject &linked_object : results.values()) {
+        const QString gplink_old_string = linked_object.get_string(ATTRIBUTE_GPLINK);
+
+        Gplink gplink = Gplink(gplink_old_string);
+        gplink.remove(dn);
+
+        attribute_replace_string(linked_object.get_dn(), ATTRIBUTE_GPLINK, gplink.to_string());
+    }
+    
+    const bool total_success = (delete_gpc_success && delete_gpt_success);
+
+    if (total_success) {
+        d->success_message(QString(tr("Group policy %1 was deleted.")).arg(name));
+    } else {
+        const bool partial_success = (delete_gpc_success || delete_gpt_success);
+        if (partial_success) {
+            d->success_message(QString(tr("Errors happened while trying to delete policy %1.")).arg(name));
+        } else {
+            d->success_message(QString(tr("Failed to delete policy %1.")).arg(name));
+        }
+    }
+
+    return total_success;
+}
+
+QString AdInterface::filesys_path_to_smb_path(const QString &filesys_path) const {
+    QString out = filesys_path;
+
+    // NOTE: sysvol paths created by windows have this weird
+    // capitalization and smbclient does NOT like it
+    out.replace("\\SysVol\\", "\\sysvol\\");
+    
+    out.replace("\\", "/");
+
+    const int sysvol_i = out.indexOf("/sysvol/");
+
+    out.remove(0, sysvol_i);
+
+    // TODO: currently using dc that was used for ldap
+    // connection, but maybe there's some specific dc that's
+    // supposed to be used for smb connection?
+    out = QString("smb://%1%2").arg(d->dc, out);
+
+    return out;
+}
+
+bool AdInterface::gpo_check_perms(const QString &gpo, bool *ok) {
+    const AdOperationGuard operation_guard(d);
+
+    // NOTE: skip perms check for non-admins, because don't
+    // have enough rights to get full sd
+    if (!d->logged_in_as_admin()) {
+        return true;
+    }
+
+    const AdObject gpc_object = search_object(gpo);
+    const QString name = gpc_object.get_string(ATTRIBUTE_DISPLAY_NAME);
+
+    const QString error_context = QString(tr("Failed to check permissions for GPO \"%1\".")).arg(name);
+
+    const QString gpc_sd = [&]() {
+        const QString out = get_gpt_sd_string(gpc_object, AceMaskFormat_Hexadecimal);
+
+        if (out.isEmpty()) {
+            d->error_message(error_context, tr("Failed to get GPT security descriptor."));
+            
+            return QString();
+        }
+
+        return out;
+    }();
+
+    const QString gpt_sd = [&]() {
+        const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
+        const QString smb_path = filesys_path_to_smb_path(filesys_path);
+        const QByteArray smb_path_bytes = smb_path.toUtf8();
+        const char *smb_path_cstr = smb_path_bytes.constData();
+
+        // NOTE: the length of gpt sd string doesn't have a
+        // well defined bound, so we have to use an
+        // expanding buffer
+        size_t buffer_size = 1024 * sizeof(char);
+        char *buffer = (char *) malloc(buffer_size);
+
+        while (true) {
+            const int getxattr_result = smbc_getxattr(smb_path_cstr, "system.nt_sec_desc.*", buffer, buffer_size);
+
+            // NOTE: for some reason getxattr() returns positive
+            // non-zero return code on success, even though f-n
+            // description says it "returns 0 on success"
+            const bool success = (getxattr_result >= 0);
+
+            if (success) {
+                break;
+            } else {
+                const bool buffer_is_too_small = (errno == ERANGE);
+                
+                if (buffer_is_too_small) {
+                    // Error occured, but it is due to
+                    // insufficient buffer size, so try
+                    // again with bigger buffer
+                    buffer_size = 2 * buffer_size;
+                    buffer = (char *) realloc(buffer, buffer_size);
+                } else {
+                    const QString text = QString(tr("Failed to get GPT security descriptor, %1.")).arg(strerror(errno));
+                    d->error_message(error_context, text);
+
+                    free(buffer);
+
+                    return QString();
+                }
+            }
+        }
+
+        const QString out = QString(buffer);
+
+        free(buffer);
+
+        return out;
+    }();
+
+    qDebug() << "--------";
+    qDebug() << "gpc_sd:";
+    for (auto e : QString(gpc_sd).split(",")) {
+        qDebug() << e;
+    }
+
+    qDebug() << "--------";
+    qDebug() << "gpt_sd:";
+    for (auto e : QString(gpt_sd).split(",")) {
+        qDebug() << e;
+    }
+
+    if (gpc_sd.isEmpty() || gpt_sd.isEmpty()) {
+        *ok = false;
+
+        return false;
+    }
+
+    const bool sd_match = (gpc_sd == gpt_sd);
+
+    return sd_match;
+}
+
+bool AdInterface::gpo_sync_perms(const QString &dn) {
+    const AdOperationGuard operation_guard(d);
+
+    // First get GPC descriptor
+    const AdObject gpc_object = search_object(dn);
+    const QString name = gpc_object.get_string(ATTRIBUTE_DISPLAY_NAME);
+    const QString gpt_sd_string = get_gpt_sd_string(gpc_object, AceMaskFormat_Decimal);
+
+    const QString error_context = QString(tr("Failed to sync permissions of GPO \"%1\".")).arg(name);
+
+    if (gpt_sd_string.isEmpty()) {
+        d->error_message(error_context, tr("Failed to generate GPT security descriptor."));
+
+        return false;
+    }
+
+    // Get list of GPT contents
+
+    // NOTE: order is important, have to set perms of parent
+    // folders before their contents, otherwise fails to
+    // set! Default gpo_get_gpt_contents() order is good.
+    const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
+    const QString smb_path = filesys_path_to_smb_path(filesys_path);
+    bool ok = true;
+    const QList<QString> path_list = d->gpo_get_gpt_contents(smb_path, &ok);
+    if (!ok || path_list.isEmpty()) {
+        d->error_message(error_context, QString(tr("Failed to read GPT contents of \"%1\".")).arg(smb_path));
+        return false;
+    }
+
+    const QByteArray gpt_sd_bytes = gpt_sd_string.toUtf8();
+
+    // Set descriptor on all GPT contents
+    for (const QString &path : path_list) {
+        const int set_sd_result = smbc_setxattr(path.toUtf8().constData(), "system.nt_sec_desc.*", gpt_sd_bytes.constData(), gpt_sd_bytes.size(), 0);
+        if (set_sd_result != 0) {
+            const QString error = QString(tr("Failed to set permissions, %1.")).arg(strerror(errno));
+            d->error_message(error_context, error);
+
+            return false;
+        }
+    }
+
+    d->success_message(QString(tr("Synced permissions of GPO \"%1\".")).arg(name));
+
+    return true;
+}
+
+void AdInterfacePrivate::success_message(const QString &msg, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    const AdMessage message(msg, AdMessageType_Success);
+    messages.append(message);
+}
+
+void AdInterfacePrivate::error_message(const QString &context, const QString &error, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    QString msg = context;
+    if (!error.isEmpty()) {
+        msg += QString(tr(" Error: \"%1\"")).arg(error);
+
+        // Add period if needed, because some error strings,
+        // like the ones from LDAP, might not have one
+        if (!msg.endsWith(".")) {
+            msg += ".";
+        }
+    }
+
+    const AdMessage message(msg, AdMessageType_Error);
+    messages.append(message);
+}
+
+void AdInterfacePrivate::error_message_plain(const QString &text, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    const AdMessage message(text, AdMessageType_Error);
+    messages.append(message);
+}
+
+QString AdInterfacePrivate::default_error() const {
+    const int ldap_result = get_ldap_result();
+
+    return error_string(ldap_result);
+}
+
+QString AdInterfacePrivate::error_string(const int ldap_result) {
+    switch (ldap_result) {
+        case LDAP_NO_SUCH_OBJECT: return tr("No such object");
+        case LDAP_CONSTRAINT_VIOLATION: return tr("Constraint violation");
+        case LDAP_UNWILLING_TO_PERFORM: return tr("Server is unwilling to perform");
+        case LDAP_ALREADY_EXISTS: return tr("Already exists");
+        default: {
+            char *ldap_err = ldap_err2string(ldap_result);
+            const QString ldap_err_qstr(ldap_err);
+            return QString(tr("Server error: %1")).arg(ldap_err_qstr);
+        }
+    }
+}
+
+int AdInterfacePrivate::get_ldap_result() const {
+    int result;
+    ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &result);
+
+    return result;
+}
+
+QList<int> AdInterfacePrivate::run_pipelined(const PipelineType type, const int count, std::function<int(const int)> send_op, std::function<void(const int, LDAPMessage *)> on_reply) {
+    QList<int> result_list;
+    for (int i = 0; i < count; i++) {
+        result_list.append(LDAP_OTHER);
+    }
+
+    // msgid => op index, for ops that are in flight
+    // NOTE: map is ordered by msgid, so first key is the
+    // oldest op
+    QMap<int, int> in_flight;
+    int next_op = 0;
+    bool did_failover = false;
+
+    // NOTE: when connection is lost, none of the ops in
+    // flight will complete. Fail over once and resend
+    // them, but only if they are reads. Writes in flight
+    // may have been applied by the server even though
+    // their replies were lost, so resending them could
+    // apply them twice. Those fail with the connection
+    // error. Returns true if failover succeeded.
+    auto handle_connection_lost = [&](const int error) {
+        if (did_failover) {
+            return false;
+        }
+
+        did_failover = true;
+
+        if (!failover()) {
+            return false;
+        }
+
+        const QList<int> lost_list = in_flight.values();
+        in_flight.clear();
+
+        for (const int index : lost_list) {
+            if (type == PipelineType_Read) {
+                const int msgid = send_op(index);
+
+                if (msgid != -1) {
+                    in_flight[msgid] = index;
+                } else {
+                    result_list[index] = get_ldap_result();
+                }
+            } else {
+                result_list[index] = error;
+            }
+        }
+
+        return true;
+    };
+
+    while (next_op < count || !in_flight.isEmpty()) {
+        // Fill the window
+        while (next_op < count && in_flight.size() < PIPELINE_WINDOW_SIZE) {
+            const int msgid = send_op(next_op);
+
+            if (msgid != -1) {
+                in_flight[msgid] = next_op;
+                next_op++;
+
+                continue;
+            }
+
+            // NOTE: op that failed to send never reached
+            // the server, so it's safe to send it again
+            // after failover, even if it's a write
+            const int error = get_ldap_result();
+            const bool connection_lost = (error == LDAP_SERVER_DOWN || error == LDAP_CONNECT_ERROR);
+            if (connection_lost && handle_connection_lost(error)) {
+                continue;
+            }
+
+            result_list[next_op] = error;
+            next_op++;
+        }
+
+        if (in_flight.isEmpty()) {
+            break;
+        }
+
+        // Wait for oldest op to complete
+        // NOTE: wait for a specific msgid instead of
+        // LDAP_RES_ANY, so that replies of operations which
+        // are not part of this pipeline stay queued for
+        // their owners. Server processes ops in order, so
+        // replies of newer ops usually arrive after the
+        // oldest one and are picked up from the queue
+        // right away.
+        // NOTE: LDAP_MSG_ALL makes search replies arrive
+        // as one chain of entries + final result
+        const int oldest_msgid = in_flight.firstKey();
+        LDAPMessage *res = NULL;
+        const int res_type = receive_result(oldest_msgid, LDAP_MSG_ALL, &res);
+
+        if (res_type == -1 || res_type == 0) {
+            ldap_msgfree(res);
+
+            // NOTE: receive_result() only abandons the op
+            // it was waiting for, so abandon the rest here
+            if (res_type == 0) {
+                for (const int msgid : in_flight.keys()) {
+                    if (msgid != oldest_msgid) {
+                        ldap_abandon_ext(ld, msgid, NULL, NULL);
+                    }
+                }
+            }
+
+            // NOTE: if failover fails, ops in flight fail
+            // and ops that are sent after this fail right
+            // away
+            const int error = get_ldap_result();
+            const bool connection_lost = (error == LDAP_SERVER_DOWN || error == LDAP_CONNECT_ERROR);
+            if (connection_lost && handle_connection_lost(error)) {
+                continue;
+            }
+
+            for (const int index : in_flight.values()) {
+                result_list[index] = error;
+            }
+            in_flight.clear();
+
+            // NOTE: after cancel or timeout, fail the rest
+            // of the ops without sending them
+            if (res_type == 0) {
+                for (int index = next_op; index < count; index++) {
+                    result_list[index] = error;
+                }
+
+                break;
+            }
+
+            continue;
+        }
+
+        const int index = in_flight.take(oldest_msgid);
+
+        int errcode = LDAP_OTHER;
+        const int parse_result = ldap_parse_result(ld, res, &errcode, NULL, NULL, NULL, NULL, 0);
+        if (parse_result == LDAP_SUCCESS) {
+            result_list[index] = errcode;
+        } else {
+            result_list[index] = parse_result;
+        }
+
+        if (on_reply) {
+            on_reply(index, res);
+        }
+
+        ldap_msgfree(res);
+    }
+
+    return result_list;
+}
+
+int AdInterfacePrivate::send_search_object(const QString &dn, char **attributes, LDAPControl **server_controls) {
+    int msgid;
+    const int attrsonly = 0;
+    const int result = ldap_search_ext(ld, dn.toUtf8().constData(), LDAP_SCOPE_BASE, NULL, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &msgid);
+
+    if (result == LDAP_SUCCESS) {
+        return msgid;
+    } else {
+        return -1;
+    }
+}
+
+int AdInterfacePrivate::send_modify(const QString &dn, const QString &attribute, const int mod_op, const QList<QByteArray> &values) {
+    // NOTE: request is encoded when it's sent, so values
+    // only need to live until the end of this f-n
+    QVector<struct berval> bvalues_storage(values.size());
+    QVector<struct berval *> bvalues(values.size() + 1);
+    for (int i = 0; i < values.size(); i++) {
+        const QByteArray &value = values[i];
+        struct berval *bvalue = &(bvalues_storage[i]);
+
+        bvalue->bv_val = (char *) value.constData();
+        bvalue->bv_len = (size_t) value.size();
+
+        bvalues[i] = bvalue;
+    }
+    bvalues[values.size()] = NULL;
+
+    const QByteArray attribute_bytes = attribute.toUtf8();
+
+    LDAPMod attr;
+    attr.mod_op = (mod_op | LDAP_MOD_BVALUES);
+    attr.mod_type = (char *) attribute_bytes.constData();
+    attr.mod_bvalues = bvalues.data();
+
+    LDAPMod *attrs[] = {&attr, NULL};
+
+    int msgid;
+    AdReadRouter::instance()->note_write();
+    const int result = ldap_modify_ext(ld, dn.toUtf8().constData(), attrs, NULL, NULL, &msgid);
+
+    if (result == LDAP_SUCCESS) {
+        return msgid;
+    } else {
+        return -1;
+    }
+}
+
+int AdInterfacePrivate::send_swap(const QString &dn, const QString &attribute, const QByteArray &old_value, const QByteArray &new_value) {
+    struct berval old_bvalue;
+    old_bvalue.bv_val = (char *) old_value.constData();
+    old_bvalue.bv_len = (size_t) old_value.size();
+    struct berval *old_bvalues[] = {&old_bvalue, NULL};
+
+    struct berval new_bvalue;
+    new_bvalue.bv_val = (char *) new_value.constData();
+    new_bvalue.bv_len = (size_t) new_value.size();
+    struct berval *new_bvalues[] = {&new_bvalue, NULL};
+
+    const QByteArray attribute_bytes = attribute.toUtf8();
+
+    LDAPMod delete_mod;
+    delete_mod.mod_op = (LDAP_MOD_DELETE | LDAP_MOD_BVALUES);
+    delete_mod.mod_type = (char *) attribute_bytes.constData();
+    delete_mod.mod_bvalues = old_bvalues;
+
+    LDAPMod add_mod;
+    add_mod.mod_op = (LDAP_MOD_ADD | LDAP_MOD_BVALUES);
+    add_mod.mod_type = (char *) attribute_bytes.constData();
+    add_mod.mod_bvalues = new_bvalues;
+
+    LDAPMod *mods[] = {&delete_mod, &add_mod, NULL};
+
+    const QByteArray dn_bytes = dn.toUtf8();
+
+    int msgid;
+    AdReadRouter::instance()->note_write();
+    const int result = ldap_modify_ext(ld, dn_bytes.constData(), mods, NULL, NULL, &msgid);
+
+    if (result == LDAP_SUCCESS) {
+        return msgid;
+    } else {
+        return -1;
+    }
+}
+
+int AdInterfacePrivate::swap_value(const QString &dn, const QString &attribute, const QByteArray &old_value, const QByteArray &new_value) {
+    const int msgid = send_write([&]() {
+        return send_swap(dn, attribute, old_value, new_value);
+    });
+
+    if (msgid == -1) {
+        return get_ldap_result();
+    }
 
-    return true;
+    return wait_result(msgid, nullptr, nullptr);
 }
 
-QList<QString> AdInterfacePrivate::gpo_get_gpt_contents(const QString &gpt_root_path, bool *ok) {
-    // Collect all contents of the path into a list
-    QList<QString> explore_stack;
-    QList<QString> seen_stack;
+int AdInterfacePrivate::modify(const QString &dn, LDAPMod **mods, const QList<QString> &pre_read_attributes, AdObject *pre_read_out, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    LDAPControl **server_controls = read_entry_controls_create(pre_read_attributes, post_read_attributes);
 
-    explore_stack.append(gpt_root_path);
-    seen_stack.append(gpt_root_path);
+    const QByteArray dn_bytes = dn.toUtf8();
 
-    const QString error_context = QString(tr("Failed to get contents of GPT \"%1\".")).arg(gpt_root_path);
+    const int msgid = send_write([&]() {
+        int out;
+        AdReadRouter::instance()->note_write();
+        const int send_result = ldap_modify_ext(ld, dn_bytes.constData(), mods, server_controls, NULL, &out);
 
-    while (!explore_stack.isEmpty()) {
-        const QString path = explore_stack.takeLast();
+        if (send_result == LDAP_SUCCESS) {
+            return out;
+        } else {
+            return -1;
+        }
+    });
 
-        const int dirp = smbc_opendir(cstr(path));
+    ldap_controls_free(server_controls);
 
-        if (dirp < 0) {
-            *ok = false;
+    if (msgid == -1) {
+        return get_ldap_result();
+    }
 
-            error_message(error_context, tr("Failed to open dir."));
+    return wait_result(msgid, pre_read_out, post_read_out);
+}
 
-            return QList<QString>();
+int AdInterfacePrivate::add(const QString &dn, LDAPMod **mods, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    LDAPControl **server_controls = read_entry_controls_create(QList<QString>(), post_read_attributes);
+
+    const QByteArray dn_bytes = dn.toUtf8();
+
+    const int msgid = send_write([&]() {
+        int out;
+        AdReadRouter::instance()->note_write();
+        const int send_result = ldap_add_ext(ld, dn_bytes.constData(), mods, server_controls, NULL, &out);
+
+        if (send_result == LDAP_SUCCESS) {
+            return out;
+        } else {
+            return -1;
         }
+    });
 
-        // NOTE: set errno to 0, so that we know
-        // when readdir() fails because it will
-        // change errno.
-        errno = 0;
+    ldap_controls_free(server_controls);
 
-        smbc_dirent *child_dirent;
-        while ((child_dirent = smbc_readdir(dirp)) != NULL) {
-            const QString child_name = QString(child_dirent->name);
+    if (msgid == -1) {
+        return get_ldap_result();
+    }
 
-            const bool is_dot_path = (child_name == "." || child_name == "..");
-            if (is_dot_path) {
-                continue;
-            } else {
-                const QString child_path = path + "/" + child_name;
+    return wait_result(msgid, nullptr, post_read_out);
+}
 
-                seen_stack.append(child_path);
+int AdInterfacePrivate::rename(const QString &dn, const QString &new_rdn, const QString &new_superior, const QList<QString> &post_read_attributes, AdObject *post_read_out) {
+    const int msgid = send_write([&]() {
+        return send_rename(dn, new_rdn, new_superior, post_read_attributes);
+    });
 
-                const bool child_is_dir = smb_path_is_dir(child_path, ok);
-                if (!*ok) {
-                    return QList<QString>();
-                }
+    if (msgid == -1) {
+        return get_ldap_result();
+    }
 
-                if (child_is_dir) {
-                    explore_stack.append(child_path);
-                }
-            }
-        }
+    return wait_result(msgid, nullptr, post_read_out);
+}
 
-        if (errno != 0) {
-            *ok = false;
+int AdInterfacePrivate::delete_entry(const QString &dn, LDAPControl **server_controls) {
+    const QByteArray dn_bytes = dn.toUtf8();
 
-            error_message(error_context, tr("Failed to read dir."));
+    const int msgid = send_write([&]() {
+        int out;
+        AdReadRouter::instance()->note_write();
+        const int send_result = ldap_delete_ext(ld, dn_bytes.constData(), server_controls, NULL, &out);
 
-            return QList<QString>();
+        if (send_result == LDAP_SUCCESS) {
+            return out;
+        } else {
+            return -1;
         }
+    });
 
-        smbc_closedir(dirp);
+    if (msgid == -1) {
+        return get_ldap_result();
     }
 
-    return seen_stack;
+    return wait_result(msgid, nullptr, nullptr);
 }
 
-bool AdInterface::gpo_delete(const QString &dn, bool *deleted_object) {
-    // NOTE: try to execute both steps, even if first one
-    // (deleting gpc) fails
+int AdInterfacePrivate::send_rename(const QString &dn, const QString &new_rdn, const QString &new_superior, const QList<QString> &post_read_attributes) {
+    LDAPControl **server_controls = read_entry_controls_create(QList<QString>(), post_read_attributes);
 
-    // NOTE: get filesys path before deleting object,
-    // otherwise it won't be available!
-    const AdObject object = search_object(dn, {ATTRIBUTE_GPC_FILE_SYS_PATH, ATTRIBUTE_DISPLAY_NAME});
-    const QString filesys_path = object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
+    const QByteArray dn_bytes = dn.toUtf8();
+    const QByteArray new_rdn_bytes = new_rdn.toUtf8();
+    const QByteArray new_superior_bytes = new_superior.toUtf8();
 
-    const QString name = object.get_string(ATTRIBUTE_DISPLAY_NAME);
-    const QString smb_path = filesys_path_to_smb_path(filesys_path);
+    // NOTE: NULL superior means that object stays in the
+    // same parent
+    const char *new_superior_cstr = [&]() -> const char * {
+        if (new_superior.isEmpty()) {
+            return NULL;
+        } else {
+            return new_superior_bytes.constData();
+        }
+    }();
 
-    const bool delete_gpc_success = object_delete(dn);
-    if (!delete_gpc_success) {
-        d->error_message(tr("Failed to delete GPC."), d->default_error());
-    }
+    int msgid;
+    AdReadRouter::instance()->note_write();
+    const int result = ldap_rename(ld, dn_bytes.constData(), new_rdn_bytes.constData(), new_superior_cstr, 1, server_controls, NULL, &msgid);
 
-    const bool delete_gpt_success = d->delete_gpt(smb_path);
-    if (!delete_gpt_success) {
-        d->error_message_plain(tr("Failed to delete GPT."));
+    ldap_controls_free(server_controls);
+
+    if (result == LDAP_SUCCESS) {
+        return msgid;
+    } else {
+        return -1;
     }
+}
 
-    // Unlink policy
-    const QString base = d->domain_head;
-    const SearchScope scope = SearchScope_All;
-    const QList<QString> attributes = {ATTRIBUTE_GPLINK};
-    const QString filter = filter_CONDITION(Condition_Contains, ATTRIBUTE_GPLINK, dn);
-    const QHash<QString, AdObject> results = search(base, scope, filter, attributes);
-    for (const AdObject &linked_object : results.values()) {
-        const QString gplink_old_string = linked_object.get_string(ATTRIBUTE_GPLINK);
+int AdInterfacePrivate::wait_result(const int msgid, AdObject *pre_read_out, AdObject *post_read_out) {
+    LDAPMessage *res = NULL;
+    const int res_type = receive_result(msgid, LDAP_MSG_ALL, &res);
 
-        Gplink gplink = Gplink(gplink_old_string);
-        gplink.remove(dn);
+    if (res_type == -1 || res_type == 0) {
+        ldap_msgfree(res);
 
-        attribute_replace_string(linked_object.get_dn(), ATTRIBUTE_GPLINK, gplink.to_string());
+        return get_ldap_result();
     }
-    
-    const bool total_success = (delete_gpc_success && delete_gpt_success);
 
-    if (total_success) {
-        d->success_message(QString(tr("Group policy %1 was deleted.")).arg(name));
-    } else {
-        const bool partial_success = (delete_gpc_success || delete_gpt_success);
-        if (partial_success) {
-            d->success_message(QString(tr("Errors happened while trying to delete policy %1.")).arg(name));
-        } else {
-            d->success_message(QString(tr("Failed to delete policy %1.")).arg(name));
-        }
-    }
+    const int result = parse_result_read_entries(res, pre_read_out, post_read_out);
 
-    return total_success;
+    ldap_msgfree(res);
+
+    // NOTE: save result so that default_error() reports
+    // it, same as after synchronous f-ns
+    int result_copy = result;
+    ldap_set_option(ld, LDAP_OPT_RESULT_CODE, &result_copy);
+
+    return result;
 }
 
-QString AdInterface::filesys_path_to_smb_path(const QString &filesys_path) const {
-    QString out = filesys_path;
+int AdInterfacePrivate::parse_result_read_entries(LDAPMessage *res, AdObject *pre_read_out, AdObject *post_read_out) {
+    int result = LDAP_OTHER;
+    LDAPControl **returned_controls = NULL;
+    const int parse_result = ldap_parse_result(ld, res, &result, NULL, NULL, NULL, &returned_controls, 0);
+    if (parse_result != LDAP_SUCCESS) {
+        result = parse_result;
+    }
 
-    // NOTE: sysvol paths created by windows have this weird
-    // capitalization and smbclient does NOT like it
-    out.replace("\\SysVol\\", "\\sysvol\\");
-    
-    out.replace("\\", "/");
+    // NOTE: entries are only returned if operation
+    // succeeded and the server supports the controls,
+    // otherwise outputs are set to empty objects
+    const bool success = (result == LDAP_SUCCESS);
 
-    const int sysvol_i = out.indexOf("/sysvol/");
+    if (pre_read_out != nullptr) {
+        *pre_read_out = success ? read_entry_control_get(returned_controls, LDAP_CONTROL_PRE_READ) : AdObject();
+    }
 
-    out.remove(0, sysvol_i);
+    if (post_read_out != nullptr) {
+        *post_read_out = success ? read_entry_control_get(returned_controls, LDAP_CONTROL_POST_READ) : AdObject();
+    }
 
-    // TODO: currently using dc that was used for ldap
-    // connection, but maybe there's some specific dc that's
-    // supposed to be used for smb connection?
-    out = QString("smb://%1%2").arg(d->dc, out);
+    ldap_controls_free(returned_controls);
 
-    return out;
+    return result;
 }
 
-bool AdInterface::gpo_check_perms(const QString &gpo, bool *ok) {
-    // NOTE: skip perms check for non-admins, because don't
-    // have enough rights to get full sd
-    if (!d->logged_in_as_admin()) {
-        return true;
+AdObject AdInterfacePrivate::load_entry(LDAPMessage *entry, int *size_out, AdObjectBuilder *builder) {
+    char *dn_cstr = ldap_get_dn(ld, entry);
+    const QString dn(dn_cstr);
+    ldap_memfree(dn_cstr);
+
+    // NOTE: if caller didn't pass a builder, then object
+    // gets it's own arena
+    AdObjectBuilder local_builder;
+    if (builder == nullptr) {
+        builder = &local_builder;
     }
 
-    const AdObject gpc_object = search_object(gpo);
-    const QString name = gpc_object.get_string(ATTRIBUTE_DISPLAY_NAME);
+    builder->begin(dn);
 
-    const QString error_context = QString(tr("Failed to check permissions for GPO \"%1\".")).arg(name);
+    int size = dn.size();
 
-    const QString gpc_sd = [&]() {
-        const QString out = get_gpt_sd_string(gpc_object, AceMaskFormat_Hexadecimal);
+    // Attributes which were returned partially, mapped to
+    // values returned so far. These are added to the object
+    // after the rest of the values are loaded.
+    QHash<QString, QList<QByteArray>> ranged_values_map;
+    QHash<QString, int> incomplete_range_map;
 
-        if (out.isEmpty()) {
-            d->error_message(error_context, tr("Failed to get GPT security descriptor."));
-            
-            return QString();
-        }
+    BerElement *berptr;
+    for (char *attr = ldap_first_attribute(ld, entry, &berptr); attr != NULL; attr = ldap_next_attribute(ld, entry, berptr)) {
+        struct berval **values_ldap = ldap_get_values_len(ld, entry, attr);
+        const int values_count = [&]() {
+            if (values_ldap != NULL) {
+                return ldap_count_values_len(values_ldap);
+            } else {
+                return 0;
+            }
+        }();
 
-        return out;
-    }();
+        // NOTE: server returns large multi-valued
+        // attributes in ranges, for example
+        // "member;range=0-1499". Save values under the
+        // plain attribute name and remember where the
+        // range ended to load the rest later.
+        const QString attribute_full(attr);
+        QString attribute;
+        int range_end;
+        const bool is_ranged = parse_range_attribute(attribute_full, &attribute, &range_end);
+
+        if (is_ranged && range_end != -1) {
+            QList<QByteArray> &values = ranged_values_map[attribute];
+
+            for (int i = 0; i < values_count; i++) {
+                const struct berval value_berval = *values_ldap[i];
+                values.append(QByteArray(value_berval.bv_val, value_berval.bv_len));
+            }
 
-    const QString gpt_sd = [&]() {
-        const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
-        const QString smb_path = filesys_path_to_smb_path(filesys_path);
-        const char *smb_path_cstr = cstr(smb_path);
+            incomplete_range_map[attribute] = range_end;
+        } else {
+            // NOTE: values are copied straight into the
+            // arena, without intermediate containers
+            builder->add_attribute(AdAtomTable::instance()->intern(attribute));
 
-        // NOTE: the length of gpt sd string doesn't have a
-        // well defined bound, so we have to use an
-        // expanding buffer
-        size_t buffer_size = 1024 * sizeof(char);
-        char *buffer = (char *) malloc(buffer_size);
+            for (int i = 0; i < values_count; i++) {
+                const struct berval value_berval = *values_ldap[i];
+                builder->add_value(value_berval.bv_val, value_berval.bv_len);
+            }
+        }
 
-        while (true) {
-            const int getxattr_result = smbc_getxattr(smb_path_cstr, "system.nt_sec_desc.*", buffer, buffer_size);
+        for (int i = 0; i < values_count; i++) {
+            size += values_ldap[i]->bv_len;
+        }
 
-            // NOTE: for some reason getxattr() returns positive
-            // non-zero return code on success, even though f-n
-            // description says it "returns 0 on success"
-            const bool success = (getxattr_result >= 0);
+        ldap_value_free_len(values_ldap);
+        ldap_memfree(attr);
+    }
+    ber_free(berptr, 0);
 
-            if (success) {
-                break;
+    for (const QString &attribute : incomplete_range_map.keys()) {
+        QList<QByteArray> &values = ranged_values_map[attribute];
+
+        const bool limit_reached = (range_limit > 0 && values.size() >= range_limit);
+        if (!limit_reached) {
+            const int start = incomplete_range_map[attribute] + 1;
+
+            if (defer_ranges) {
+                deferred_range_map[dn][attribute] = start;
             } else {
-                const bool buffer_is_too_small = (errno == ERANGE);
-                
-                if (buffer_is_too_small) {
-                    // Error occured, but it is due to
-                    // insufficient buffer size, so try
-                    // again with bigger buffer
-                    buffer_size = 2 * buffer_size;
-                    buffer = (char *) realloc(buffer, buffer_size);
-                } else {
-                    const QString text = QString(tr("Failed to get GPT security descriptor, %1.")).arg(strerror(errno));
-                    d->error_message(error_context, text);
+                const int size_before = values.size();
 
-                    free(buffer);
+                load_range(dn, attribute, start, &values);
 
-                    return QString();
+                for (int i = size_before; i < values.size(); i++) {
+                    size += values[i].size();
                 }
             }
         }
 
-        const QString out = QString(buffer);
+        // Apply range limit to values returned in the
+        // first range
+        if (range_limit > 0 && values.size() > range_limit) {
+            values = values.mid(0, range_limit);
+        }
 
-        free(buffer);
+        builder->add_attribute(AdAtomTable::instance()->intern(attribute));
 
-        return out;
-    }();
+        for (const QByteArray &value : values) {
+            builder->add_value(value.constData(), value.size());
+        }
+    }
 
-    qDebug() << "--------";
-    qDebug() << "gpc_sd:";
-    for (auto e : QString(gpc_sd).split(",")) {
-        qDebug() << e;
+    if (size_out != nullptr) {
+        *size_out = size;
     }
 
-    qDebug() << "--------";
-    qDebug() << "gpt_sd:";
-    for (auto e : QString(gpt_sd).split(",")) {
-        qDebug() << e;
+    return builder->end();
+}
+
+AdObject AdInterfacePrivate::complete_ranges(const AdObject &object) {
+    const QString dn = object.get_dn();
+
+    if (!deferred_range_map.contains(dn)) {
+        return object;
     }
 
-    if (gpc_sd.isEmpty() || gpt_sd.isEmpty()) {
-        *ok = false;
+    const QHash<QString, int> range_map = deferred_range_map.take(dn);
+    QHash<QString, QList<QByteArray>> attributes_data = object.get_attributes_data();
 
-        return false;
+    for (const QString &attribute : range_map.keys()) {
+        QList<QByteArray> &values = attributes_data[attribute];
+
+        load_range(dn, attribute, range_map[attribute], &values);
+
+        if (range_limit > 0 && values.size() > range_limit) {
+            values = values.mid(0, range_limit);
+        }
     }
 
-    const bool sd_match = (gpc_sd == gpt_sd);
+    AdObject out;
+    out.load(dn, attributes_data);
 
-    return sd_match;
+    return out;
 }
 
-bool AdInterface::gpo_sync_perms(const QString &dn) {
-    // First get GPC descriptor
-    const AdObject gpc_object = search_object(dn);
-    const QString name = gpc_object.get_string(ATTRIBUTE_DISPLAY_NAME);
-    const QString gpt_sd_string = get_gpt_sd_string(gpc_object, AceMaskFormat_Decimal);
-
-    const QString error_context = QString(tr("Failed to sync permissions of GPO \"%1\".")).arg(name);
+bool AdInterfacePrivate::load_range(const QString &dn, const QString &attribute, const int start, QList<QByteArray> *values) {
+    const QByteArray dn_bytes = dn.toUtf8();
+    int range_start = start;
 
-    if (gpt_sd_string.isEmpty()) {
-        d->error_message(error_context, tr("Failed to generate GPT security descriptor."));
+    while (true) {
+        // NOTE: when there's a limit, request only up to
+        // the limit so that server doesn't send more than
+        // needed
+        const QString range_end_string = [&]() {
+            if (range_limit > 0) {
+                return QString::number(range_limit - 1);
+            } else {
+                return QString("*");
+            }
+        }();
 
-        return false;
-    }
+        if (range_limit > 0 && range_start >= range_limit) {
+            return true;
+        }
 
-    // Get list of GPT contents
+        const QString ranged_attribute = QString("%1;range=%2-%3").arg(attribute, QString::number(range_start), range_end_string);
+        const QByteArray ranged_attribute_bytes = ranged_attribute.toUtf8();
+        char *attributes[] = {(char *) ranged_attribute_bytes.constData(), NULL};
 
-    // NOTE: order is important, have to set perms of parent
-    // folders before their contents, otherwise fails to
-    // set! Default gpo_get_gpt_contents() order is good.
-    const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
-    const QString smb_path = filesys_path_to_smb_path(filesys_path);
-    bool ok = true;
-    const QList<QString> path_list = d->gpo_get_gpt_contents(smb_path, &ok);
-    if (!ok || path_list.isEmpty()) {
-        d->error_message(error_context, QString(tr("Failed to read GPT contents of \"%1\".")).arg(smb_path));
-        return false;
-    }
+        LDAPMessage *res = NULL;
+        const int result = search_async(dn_bytes.constData(), LDAP_SCOPE_BASE, "(objectClass=*)", attributes, NULL, &res);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to load range" << ranged_attribute << "of" << dn << ":" << ldap_err2string(result);
 
-    // Set descriptor on all GPT contents
-    for (const QString &path : path_list) {
-        const int set_sd_result = smbc_setxattr(cstr(path), "system.nt_sec_desc.*", cstr(gpt_sd_string), strlen(cstr(gpt_sd_string)), 0);
-        if (set_sd_result != 0) {
-            const QString error = QString(tr("Failed to set permissions, %1.")).arg(strerror(errno));
-            d->error_message(error_context, error);
+            ldap_msgfree(res);
 
             return false;
         }
-    }
 
-    d->success_message(QString(tr("Synced permissions of GPO \"%1\".")).arg(name));
+        // Find ranged attribute in the reply. Server
+        // replaces "*" with actual end of range, or keeps
+        // it if this is the last range.
+        int range_end = -1;
+        bool found = false;
+
+        LDAPMessage *entry = ldap_first_entry(ld, res);
+        if (entry != NULL) {
+            BerElement *berptr;
+            for (char *attr = ldap_first_attribute(ld, entry, &berptr); attr != NULL; attr = ldap_next_attribute(ld, entry, berptr)) {
+                QString reply_attribute;
+                int reply_end;
+                const bool is_ranged = parse_range_attribute(QString(attr), &reply_attribute, &reply_end);
+
+                if (is_ranged && reply_attribute.compare(attribute, Qt::CaseInsensitive) == 0) {
+                    struct berval **values_ldap = ldap_get_values_len(ld, entry, attr);
+
+                    if (values_ldap != NULL) {
+                        const int values_count = ldap_count_values_len(values_ldap);
+                        values->reserve(values->size() + values_count);
+
+                        for (int i = 0; i < values_count; i++) {
+                            const struct berval value_berval = *values_ldap[i];
+                            values->append(QByteArray(value_berval.bv_val, value_berval.bv_len));
+                        }
+                    }
+
+                    ldap_value_free_len(values_ldap);
+
+                    range_end = reply_end;
+                    found = true;
+                }
+
+                ldap_memfree(attr);
+            }
+            ber_free(berptr, 0);
+        }
+
+        // NOTE: free each range as soon as it's copied so
+        // that only one range is held in memory in
+        // addition to the values
+        ldap_msgfree(res);
 
-    return true;
-}
+        if (!found || range_end == -1) {
+            return found;
+        }
 
-void AdInterfacePrivate::success_message(const QString &msg, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
+        range_start = range_end + 1;
     }
-
-    const AdMessage message(msg, AdMessageType_Success);
-    messages.append(message);
 }
 
-void AdInterfacePrivate::error_message(const QString &context, const QString &error, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
+QHash<QString, QList<QString>> AdInterfacePrivate::group_member_batch(const QList<QString> &group_list, const QList<QString> &member_list, const bool add) {
+    QList<QString> op_group_list;
+    QList<QString> op_member_list;
+    for (const QString &group : group_list) {
+        for (const QString &member : member_list) {
+            op_group_list.append(group);
+            op_member_list.append(member);
+        }
     }
 
-    QString msg = context;
-    if (!error.isEmpty()) {
-        msg += QString(tr(" Error: \"%1\"")).arg(error);
-
-        // Add period if needed, because some error strings,
-        // like the ones from LDAP, might not have one
-        if (!msg.endsWith(".")) {
-            msg += ".";
+    const int mod_op = [&]() {
+        if (add) {
+            return LDAP_MOD_ADD;
+        } else {
+            return LDAP_MOD_DELETE;
         }
-    }
+    }();
 
-    const AdMessage message(msg, AdMessageType_Error);
-    messages.append(message);
-}
+    const QList<int> result_list = run_pipelined(PipelineType_Write, op_group_list.size(),
+        [&](const int i) {
+            const QByteArray member_bytes = op_member_list[i].toUtf8();
 
-void AdInterfacePrivate::error_message_plain(const QString &text, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
-    }
+            return send_modify(op_group_list[i], ATTRIBUTE_MEMBER, mod_op, {member_bytes});
+        });
 
-    const AdMessage message(text, AdMessageType_Error);
-    messages.append(message);
-}
+    QHash<QString, QList<QString>> out;
 
-QString AdInterfacePrivate::default_error() const {
-    const int ldap_result = get_ldap_result();
-    switch (ldap_result) {
-        case LDAP_NO_SUCH_OBJECT: return tr("No such object");
-        case LDAP_CONSTRAINT_VIOLATION: return tr("Constraint violation");
-        case LDAP_UNWILLING_TO_PERFORM: return tr("Server is unwilling to perform");
-        case LDAP_ALREADY_EXISTS: return tr("Already exists");
-        default: {
-            char *ldap_err = ldap_err2string(ldap_result);
-            const QString ldap_err_qstr(ldap_err);
-            return QString(tr("Server error: %1")).arg(ldap_err_qstr);
+    // NOTE: use AdInterface context for messages so that
+    // they are the same as in group_add_member() and
+    // group_remove_member()
+    for (int i = 0; i < op_group_list.size(); i++) {
+        const QString &group = op_group_list[i];
+        const QString &member = op_member_list[i];
+        const QString member_name = dn_get_name(member);
+        const QString group_name = dn_get_name(group);
+        const int result = result_list[i];
+
+        if (result == LDAP_SUCCESS) {
+            if (add) {
+                success_message(QString(AdInterface::tr("Object %1 was added to group %2.")).arg(member_name, group_name));
+            } else {
+                success_message(QString(AdInterface::tr("Object %1 was removed from group %2.")).arg(member_name, group_name));
+            }
+
+            out[group].append(member);
+        } else {
+            const QString context = [&]() {
+                if (add) {
+                    return QString(AdInterface::tr("Failed to add object %1 to group %2.")).arg(member_name, group_name);
+                } else {
+                    return QString(AdInterface::tr("Failed to remove object %1 from group %2.")).arg(member_name, group_name);
+                }
+            }();
+
+            error_message(context, error_string(result));
         }
     }
-}
-
-int AdInterfacePrivate::get_ldap_result() const {
-    int result;
-    ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &result);
 
-    return result;
+    return out;
 }
 
 bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
@@ -1801,7 +4861,7 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
         }
 
         if (is_dir) {
-            const int result_rmdir = smbc_rmdir(cstr(path));
+            const int result_rmdir = smbc_rmdir(path.toUtf8().constData());
 
             if (result_rmdir != 0) {
                 error_message(QString(tr("Failed to delete GPT folder %1.")).arg(path), strerror(errno));
@@ -1809,7 +4869,7 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
                 return false;
             }
         } else {
-            const int result_unlink = smbc_unlink(cstr(path));
+            const int result_unlink = smbc_unlink(path.toUtf8().constData());
 
             if (result_unlink != 0) {
                 error_message(QString(tr("Failed to delete GPT file %1.")).arg(path), strerror(errno));
@@ -1824,7 +4884,7 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
 
 bool AdInterfacePrivate::smb_path_is_dir(const QString &path, bool *ok) {
     struct stat filestat;
-    const int stat_result = smbc_stat(cstr(path), &filestat);
+    const int stat_result = smbc_stat(path.toUtf8().constData(), &filestat);
     if (stat_result != 0) {
         error_message(QString(tr("Failed to get filestat for \"%1\".")).arg(path), strerror(errno));
 
@@ -1884,135 +4944,18 @@ bool AdInterfacePrivate::logged_in_as_admin() {
 }
 
 QList<QString> get_domain_hosts(const QString &domain, const QString &site) {
-    QList<QString> hosts;
-
-    // TODO: confirm site query is formatted properly, currently getting no answer back (might be working as intended, since tested on domain without sites?)
-
-    // Query site hosts
-    if (!site.isEmpty()) {
-        char dname[1000];
-        snprintf(dname, sizeof(dname), "_ldap._tcp.%s._sites.%s", cstr(site), cstr(domain));
+    const QList<AdSrvRecord> records = AdDiscoveryCache::instance()->get_records(domain, site);
 
-        const QList<QString> site_hosts = query_server_for_hosts(dname);
-        hosts.append(site_hosts);
+    QList<QString> hosts;
+    for (const AdSrvRecord &record : records) {
+        hosts.append(record.host);
     }
 
-    // Query default hosts
-    char dname_default[1000];
-    snprintf(dname_default, sizeof(dname_default), "_ldap._tcp.%s", cstr(domain));
-
-    const QList<QString> default_hosts = query_server_for_hosts(dname_default);
-    hosts.append(default_hosts);
-
     hosts.removeDuplicates();
 
     return hosts;
 }
 
-/**
- * Perform a query for dname and output hosts
- * dname is a combination of protocols (d->ldap, tcp), domain and site
- * NOTE: this is rewritten from
- * https://github.com/paleg/libadclient/blob/master/adclient.cpp
- * which itself is copied from
- * https://www.ccnx.org/releases/latest/doc/ccode/html/ccndc-srv_8c_source.html
- * Another example of similar procedure:
- * https://www.gnu.org/software/shishi/coverage/shishi/lib/resolv.c.gcov.html
- */
-QList<QString> query_server_for_hosts(const char *dname) {
-    union dns_msg {
-        HEADER header;
-        unsigned char buf[NS_MAXMSG];
-    } msg;
-
-    auto error = []() {
-        return QList<QString>();
-    };
-
-    const long unsigned msg_len = res_search(dname, ns_c_in, ns_t_srv, msg.buf, sizeof(msg.buf));
-
-    const bool message_error = (msg_len < 0 || msg_len < sizeof(HEADER));
-    if (message_error) {
-        error();
-    }
-
-    const int packet_count = ntohs(msg.header.qdcount);
-    const int answer_count = ntohs(msg.header.ancount);
-
-    unsigned char *curr = msg.buf + sizeof(msg.header);
-    const unsigned char *eom = msg.buf + msg_len;
-
-    // Skip over packet records
-    for (int i = packet_count; i > 0 && curr < eom; i--) {
-        const int packet_len = dn_skipname(curr, eom);
-
-        const bool packet_error = (packet_len < 0);
-        if (packet_error) {
-            error();
-        }
-
-        curr = curr + packet_len + QFIXEDSZ;
-    }
-
-    QList<QString> hosts;
-
-    // Process answers by collecting hosts into list
-    for (int i = 0; i < answer_count; i++) {
-        // Get server
-        char server[NS_MAXDNAME];
-        const int server_len = dn_expand(msg.buf, eom, curr, server, sizeof(server));
-
-        const bool server_error = (server_len < 0);
-        if (server_error) {
-            error();
-        }
-
-        curr = curr + server_len;
-
-        int record_type;
-        int UNUSED(record_class);
-        int UNUSED(ttl);
-        int record_len;
-        GETSHORT(record_type, curr);
-        GETSHORT(record_class, curr);
-        GETLONG(ttl, curr);
-        GETSHORT(record_len, curr);
-
-        unsigned char *record_end = curr + record_len;
-        if (record_end > eom) {
-            error();
-        }
-
-        // Skip non-server records
-        if (record_type != ns_t_srv) {
-            curr = record_end;
-
-            continue;
-        }
-
-        int UNUSED(priority);
-        int UNUSED(weight);
-        int UNUSED(port);
-        GETSHORT(priority, curr);
-        GETSHORT(weight, curr);
-        GETSHORT(port, curr);
-
-        // Get host
-        char host[NS_MAXDNAME];
-        const int host_len = dn_expand(msg.buf, eom, curr, host, sizeof(host));
-        const bool host_error = (host_len < 0);
-        if (host_error) {
-            error();
-        }
-
-        hosts.append(QString(host));
-
-        curr = record_end;
-    }
-
-    return hosts;
-}
-
 /**
  * Callback for ldap_sasl_interactive_bind_s
  */
@@ -2135,8 +5078,316 @@ QString get_gpt_sd_string(const AdObject &gpc_object, const AceMaskFormat format
     return out;
 }
 
+QString account_option_success_context(const AccountOption option, const bool set, const QString &name) {
+    switch (option) {
+        case AccountOption_Disabled: {
+            if (set) {
+                return QString(AdInterface::tr("Object %1 has been disabled.")).arg(name);
+            } else {
+                return QString(AdInterface::tr("Object %1 has been enabled.")).arg(name);
+            }
+        }
+        default: {
+            const QString description = account_option_string(option);
+
+            if (set) {
+                return QString(AdInterface::tr("Account option \"%1\" was turned ON for object %2.")).arg(description, name);
+            } else {
+                return QString(AdInterface::tr("Account option \"%1\" was turned OFF for object %2.")).arg(description, name);
+            }
+        }
+    }
+}
+
+QString account_option_error_context(const AccountOption option, const bool set, const QString &name) {
+    switch (option) {
+        case AccountOption_Disabled: {
+            if (set) {
+                return QString(AdInterface::tr("Failed to disable object %1.")).arg(name);
+            } else {
+                return QString(AdInterface::tr("Failed to enable object %1.")).arg(name);
+            }
+        }
+        default: {
+            const QString description = account_option_string(option);
+
+            if (set) {
+                return QString(AdInterface::tr("Failed to turn ON account option \"%1\" for object %2.")).arg(description, name);
+            } else {
+                return QString(AdInterface::tr("Failed to turn OFF account option \"%1\" for object %2.")).arg(description, name);
+            }
+        }
+    }
+}
+
+struct berval *sd_control_value(const bool get_sacl) {
+    // NOTE: sacl part of the sd can only be obtained by
+    // administrators, so for normal operations we omit it.
+    // For some operations sacl is required so there's an
+    // option to get it.
+    const int value_int = [&]() {
+        if (get_sacl) {
+            return (OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | SACL_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION);
+        } else {
+            return (OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION);
+        }
+    }();
+
+    BerElement *value_be = ber_alloc_t(LBER_USE_DER);
+    if (value_be == NULL) {
+        return NULL;
+    }
+
+    struct berval *out = NULL;
+    ber_printf(value_be, "{i}", value_int);
+    ber_flatten(value_be, &out);
+    ber_free(value_be, 1);
+
+    return out;
+}
+
+// NOTE: GC connections are to a different port and
+// see the whole forest, so they must never be handed out
+// as domain connections, even for the same host. Keep them
+// in a separate key space in the pool.
+QString connection_pool_key(const QString &dc, const AdRouting routing) {
+    if (routing == AdRouting_GlobalCatalog) {
+        return QString("gc/%1").arg(dc);
+    } else {
+        return dc;
+    }
+}
+
+int search_scope_to_ldap(const SearchScope scope) {
+    switch (scope) {
+        case SearchScope_Object: return LDAP_SCOPE_BASE;
+        case SearchScope_Children: return LDAP_SCOPE_ONELEVEL;
+        case SearchScope_All: return LDAP_SCOPE_SUBTREE;
+        case SearchScope_Descendants: return LDAP_SCOPE_CHILDREN;
+    }
+    return 0;
+}
+
+char **attributes_to_array(const QList<QString> &attributes) {
+    if (attributes.isEmpty()) {
+        // Pass NULL so LDAP gets all attributes
+        return NULL;
+    }
+
+    char **out = (char **) malloc((attributes.size() + 1) * sizeof(char *));
+
+    if (out != NULL) {
+        for (int i = 0; i < attributes.size(); i++) {
+            const QByteArray attribute_bytes = attributes[i].toUtf8();
+            out[i] = strdup(attribute_bytes.constData());
+        }
+        out[attributes.size()] = NULL;
+    }
+
+    return out;
+}
+
+void attributes_array_free(char **attributes_array) {
+    if (attributes_array == NULL) {
+        return;
+    }
+
+    for (int i = 0; attributes_array[i] != NULL; i++) {
+        free(attributes_array[i]);
+    }
+    free(attributes_array);
+}
+
+int stream_next_page_size(const int page_size, const int entry_count, const qint64 page_bytes, const qint64 first_entry_ms, const qint64 page_ms) {
+    // NOTE: server returned less than a full page, so
+    // there's nothing to learn from this page
+    if (entry_count < page_size || entry_count == 0) {
+        return page_size;
+    }
+
+    // Each page costs one round-trip plus time to transfer
+    // entries. Choose page size so that round-trip is a
+    // small part of page time.
+    const double latency_ms = std::max(first_entry_ms, (qint64) 1);
+    const double transfer_ms = std::max(page_ms - first_entry_ms, (qint64) 1);
+    const double entry_ms = transfer_ms / entry_count;
+    const int size_for_latency = (int) (latency_ms * STREAM_LATENCY_FACTOR / entry_ms);
+
+    // Limit page size in bytes so that big entries, like
+    // groups with lots of members, don't produce huge pages
+    const qint64 entry_bytes = std::max(page_bytes / entry_count, (qint64) 1);
+    const int size_for_bytes = (int) std::min((qint64) STREAM_MAX_PAGE_BYTES / entry_bytes, (qint64) STREAM_MAX_PAGE_SIZE);
+
+    // NOTE: grow gradually, measurements of small pages
+    // are noisy
+    const int max_growth = page_size * STREAM_MAX_GROWTH_FACTOR;
+
+    int out = size_for_latency;
+    out = std::min(out, max_growth);
+    out = std::min(out, size_for_bytes);
+    out = std::min(out, STREAM_MAX_PAGE_SIZE);
+    out = std::max(out, STREAM_FIRST_PAGE_SIZE);
+
+    return out;
+}
+
+// Parses attribute names of the form
+// "attribute;range=start-end". Returns true if attribute is
+// ranged. End is -1 if this is the last range, which is
+// denoted by "*".
+bool parse_range_attribute(const QString &attribute_full, QString *attribute_out, int *end_out) {
+    const QString range_option = ";range=";
+    const int range_index = attribute_full.indexOf(range_option, 0, Qt::CaseInsensitive);
+
+    if (range_index == -1) {
+        *attribute_out = attribute_full;
+        *end_out = -1;
+
+        return false;
+    }
+
+    *attribute_out = attribute_full.left(range_index);
+
+    const QString range_string = attribute_full.mid(range_index + range_option.size());
+    const QString end_string = range_string.section('-', 1, 1);
+
+    if (end_string == "*") {
+        *end_out = -1;
+    } else {
+        bool ok;
+        *end_out = end_string.toInt(&ok);
+
+        if (!ok) {
+            *end_out = -1;
+        }
+    }
+
+    return true;
+}
+
+// Creates a pre-read or post-read control (RFC 4527)
+// requesting given attributes. Control is not critical, so
+// that servers that don't support it still perform the
+// operation. Returns NULL if there are no attributes.
+LDAPControl *read_entry_control_create(const char *oid, const QList<QString> &attributes) {
+    if (attributes.isEmpty()) {
+        return NULL;
+    }
+
+    // Control value is a sequence of attribute names
+    char **attributes_array = attributes_to_array(attributes);
+    struct berval *value = NULL;
+
+    BerElement *ber = ber_alloc_t(LBER_USE_DER);
+    if (ber != NULL) {
+        const int print_result = ber_printf(ber, "{v}", attributes_array);
+
+        if (print_result != -1) {
+            ber_flatten(ber, &value);
+        }
+
+        ber_free(ber, 1);
+    }
+
+    attributes_array_free(attributes_array);
+
+    if (value == NULL) {
+        return NULL;
+    }
+
+    LDAPControl *control = NULL;
+    const int create_result = ldap_control_create(oid, 0, value, 1, &control);
+
+    ber_bvfree(value);
+
+    if (create_result != LDAP_SUCCESS) {
+        return NULL;
+    }
+
+    return control;
+}
+
+// Returns a NULL-terminated array of read entry controls
+// for a request. Controls are only created for non-empty
+// attribute lists. Free with ldap_controls_free().
+LDAPControl **read_entry_controls_create(const QList<QString> &pre_read_attributes, const QList<QString> &post_read_attributes) {
+    LDAPControl **out = (LDAPControl **) ldap_memcalloc(3, sizeof(LDAPControl *));
+    if (out == NULL) {
+        return NULL;
+    }
+
+    LDAPControl *pre_read_control = read_entry_control_create(LDAP_CONTROL_PRE_READ, pre_read_attributes);
+    LDAPControl *post_read_control = read_entry_control_create(LDAP_CONTROL_POST_READ, post_read_attributes);
+
+    int i = 0;
+    for (LDAPControl *control : {pre_read_control, post_read_control}) {
+        if (control != NULL) {
+            out[i] = control;
+            i++;
+        }
+    }
+
+    return out;
+}
+
+// Finds a pre-read or post-read control in the controls
+// returned by server and parses the entry it contains.
+// Entry is in the same format as search results. Returns
+// an empty object if control wasn't returned.
+AdObject read_entry_control_get(LDAPControl **controls, const char *oid) {
+    LDAPControl *control = ldap_control_find(oid, controls, NULL);
+    if (control == NULL) {
+        return AdObject();
+    }
+
+    BerElement *ber = ber_init(&control->ldctl_value);
+    if (ber == NULL) {
+        return AdObject();
+    }
+
+    QString dn;
+    QHash<QString, QList<QByteArray>> attributes;
+
+    // NOTE: "m" gets values without copying them, so
+    // they must be copied before ber is freed
+    struct berval dn_bvalue;
+    if (ber_scanf(ber, "{m{", &dn_bvalue) != LBER_ERROR) {
+        dn = QString::fromUtf8(dn_bvalue.bv_val, (int) dn_bvalue.bv_len);
+
+        struct berval attribute_bvalue;
+        while (ber_scanf(ber, "{m", &attribute_bvalue) != LBER_ERROR) {
+            BerVarray bvalues = NULL;
+            if (ber_scanf(ber, "[W]", &bvalues) == LBER_ERROR) {
+                break;
+            }
+
+            const QString attribute = QString::fromUtf8(attribute_bvalue.bv_val, (int) attribute_bvalue.bv_len);
+
+            QList<QByteArray> values;
+            for (int i = 0; bvalues != NULL && bvalues[i].bv_val != NULL; i++) {
+                values.append(QByteArray(bvalues[i].bv_val, (int) bvalues[i].bv_len));
+            }
+
+            attributes[attribute] = values;
+
+            ber_bvarray_free(bvalues);
+        }
+    }
+
+    ber_free(ber, 1);
+
+    AdObject out;
+    out.load(dn, attributes);
+
+    return out;
+}
+
 AdCookie::AdCookie() {
     cookie = NULL;
+
+    // NOTE: unlike streaming search, paged search starts
+    // with full pages and only shrinks them for big entries
+    page_size = STREAM_MAX_PAGE_SIZE;
 }
 
 bool AdCookie::more_pages() const {
@@ -2147,6 +5398,27 @@ AdCookie::~AdCookie() {
     ber_bvfree(cookie);
 }
 
+AdSyncState::AdSyncState() {
+    usn = -1;
+}
+
+bool AdSyncState::is_valid() const {
+    return (!dc.isEmpty() && usn >= 0);
+}
+
+AdVlvContext::AdVlvContext() {
+    context_id = NULL;
+    m_total_count = 0;
+}
+
+AdVlvContext::~AdVlvContext() {
+    ber_bvfree(context_id);
+}
+
+int AdVlvContext::total_count() const {
+    return m_total_count;
+}
+
 AdMessage::AdMessage(const QString &text, const AdMessageType &type) {
     m_text = text;
     m_type = type;
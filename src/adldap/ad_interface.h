@@ -30,6 +30,8 @@
 #include <QHash>
 #include <QSet>
 
+#include <functional>
+
 #include "ad_defines.h"
 
 class AdInterfacePrivate;
@@ -38,6 +40,7 @@ class QByteArray;
 class QDateTime;
 class AdObject;
 class AdConfig;
+class AdChangeSet;
 template <typename T>
 class QList;
 typedef void TALLOC_CTX;
@@ -55,6 +58,22 @@ enum DoStatusMsg {
     DoStatusMsg_No
 };
 
+// Determines which DC an AdInterface connects to.
+// Primary is the session's DC, all writes should go there.
+// ReadBalanced spreads connections over DC's of the
+// client's site, use it for heavy read-only work like
+// finds. Such AdInterface still connects to the primary DC
+// if there was a write recently, so that reads see that
+// write. Don't do writes through a ReadBalanced
+// AdInterface. GlobalCatalog connects to a GC server of
+// the forest on GC port. GC has all objects of the forest
+// but only some of their attributes and is read-only.
+enum AdRouting {
+    AdRouting_Primary,
+    AdRouting_ReadBalanced,
+    AdRouting_GlobalCatalog,
+};
+
 class AdCookie {
 public:
     AdCookie();
@@ -64,11 +83,53 @@ public:
 
 private:
     struct berval *cookie;
+    // Size of next page, adapted to size of entries
+    int page_size;
 
     friend class AdInterface;
     friend class AdInterfacePrivate;
 };
 
+// Keeps state between requests for windows of the same
+// virtual list view search. Use a new context when search
+// parameters or sort order change.
+class AdVlvContext {
+public:
+    AdVlvContext();
+    ~AdVlvContext();
+
+    // Number of objects in the whole sorted result set, as
+    // reported by the server in the last response. 0 if no
+    // windows were requested yet.
+    int total_count() const;
+
+private:
+    // NOTE: context owns the context id, copying would
+    // free it twice
+    Q_DISABLE_COPY(AdVlvContext)
+
+    struct berval *context_id;
+    int m_total_count;
+
+    friend class AdInterfacePrivate;
+};
+
+// Position in the change history of a DC, used for
+// incremental sync. USN's are local to each DC, so a
+// position is only valid for the DC where it was saved.
+class AdSyncState {
+public:
+    AdSyncState();
+
+    bool is_valid() const;
+
+private:
+    QString dc;
+    qint64 usn;
+
+    friend class AdInterface;
+};
+
 class AdMessage {
 
 public:
@@ -92,8 +153,14 @@ public:
      * AdConfig instance AdInterface defaults to outputting
      * raw attribute values. Note that AdInterface is not
      * responsible for deleting AdConfig instance.
+     *
+     * Different AdInterface's can be used by different
+     * threads at the same time, but one AdInterface should
+     * only be used by one thread. Static settings below
+     * only affect AdInterface's created after they are
+     * changed.
      */
-    AdInterface();
+    AdInterface(const AdRouting routing = AdRouting_Primary);
     ~AdInterface();
 
     /**
@@ -106,11 +173,36 @@ public:
 
     static void set_log_searches(const bool enabled);
 
+    // Pins connections to given DC. If dc is empty, each
+    // new connection goes to the nearest DC according to
+    // current DC ranking.
     static void set_dc(const QString &dc);
     static void set_sasl_nocanon(const bool is_on);
     static void set_port(const int port);
     static void set_cert_strategy(const CertStrategy strategy);
+    // Sets time limit for operations. Searches that hit the
+    // limit return results found so far. Other operations
+    // and searches on a DC that stopped responding fail
+    // with a timeout error.
+    static void set_timeout(const int seconds);
     static QString get_dc();
+    static int get_timeout();
+
+    // Limits number of values loaded for large
+    // multi-valued attributes, like "member" of big groups.
+    // Server returns such attributes in ranges and by
+    // default all ranges are retrieved. Use a limit when
+    // only a preview of values is needed. 0 means no limit.
+    void set_range_limit(const int max_values);
+
+    // Cancels operation that is currently running, or the
+    // next operation if none is running. This is the only
+    // f-n that is safe to call from another thread.
+    // Outstanding request is abandoned right away and
+    // operation fails, except search_stream() which stops.
+    // Operations that start after the cancelled one ends
+    // are not affected.
+    void cancel();
 
     bool is_connected() const;
     QList<AdMessage> messages() const;
@@ -118,6 +210,10 @@ public:
     void clear_messages();
     AdConfig *adconfig() const;
     QString client_user() const;
+    // DC that this AdInterface is connected to. May differ
+    // from get_dc() if connection was routed to another DC
+    // or failed over.
+    QString connected_dc() const;
 
     // NOTE: If request attributes list is empty, all attributes are returned
 
@@ -125,20 +221,116 @@ public:
     // in one go
     QHash<QString, AdObject> search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes);
 
+    // Searches whole forest in one query through Global
+    // Catalog. If filter or attributes use attributes that
+    // are not replicated to GC, or if GC is unavailable,
+    // searches subtree of domain head instead. Note that
+    // empty attributes list means all attributes, so such
+    // searches always go to domain. Requires AdConfig to
+    // determine which attributes are in GC.
+    QHash<QString, AdObject> search_forest(const QString &filter, const QList<QString> &attributes);
+
     // This is a more complicated version of search() which
     // separates the search process by pages as they arrive
     // from the server. In general you can use the simpler
     // search(). This version is specifically for cases
     // where you need to do something between pages, like
-    // processing UI events so it doesn't freeze.
+    // processing UI events so it doesn't freeze. If
+    // connection is lost between pages, search restarts
+    // from the first page on another DC and results
+    // are cleared, so results never mix pages from
+    // different DC's.
     bool search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie);
 
+    // Streaming version of search(). Callback is called for
+    // each object as soon as it arrives instead of waiting
+    // for the whole page. Callback returns false to stop
+    // the search, in which case the rest of the results
+    // are abandoned. First page is small so that first
+    // results arrive quickly, then page size is adjusted
+    // based on measured latency and entry size. Returns
+    // false on error, stopping is not an error.
+    bool search_stream(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, std::function<bool(const AdObject &object)> callback);
+
+    // Searches for one window of a sorted result set, using
+    // server-side sort and virtual list view controls.
+    // Results are sorted by "sort_attribute" and only
+    // "count" objects starting at "offset" position in
+    // sorted set are returned, in sorted order. Offset
+    // starts from 0. This makes it possible to view huge
+    // containers without loading all of their children.
+    // Total size of result set is returned through
+    // context.
+    bool search_vlv(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const bool sort_descending, const int offset, const int count, QList<AdObject> *results, AdVlvContext *context);
+
+    // Returns number of objects that match the search,
+    // without loading them. Count is taken from the virtual
+    // list view response to a one-object window that
+    // requests no attributes, so this is cheap even for
+    // huge containers. Returns false on error, for example
+    // if server doesn't support virtual list view.
+    bool search_count(const QString &base, const SearchScope scope, const QString &filter, int *count_out);
+
+    // Incremental sync. sync_begin() saves current position
+    // in the change history of connected DC. Call it
+    // before loading objects. sync_changes() then returns
+    // objects that were created, modified or moved into
+    // the search since that position and advances the
+    // position. Objects that were deleted, moved out of
+    // the search or stopped matching the filter are
+    // returned as a list of GUID's. That list may also
+    // contain GUID's of objects that were never in the
+    // search, ignore those. Cost depends on the number of
+    // changes, not on the number of objects. Returns false
+    // if changes can't be determined, for example if
+    // connection is to a different DC than the one where
+    // position was saved. In that case, reload all
+    // objects and begin a new sync.
+    bool sync_begin(AdSyncState *state);
+    bool sync_changes(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, AdSyncState *state, QList<AdObject> *changed, QList<QByteArray> *removed_guids);
+
+    // Change notifications. notification_start() starts a
+    // search with change notification control, after which
+    // server sends objects in the search whenever they
+    // change. Scope can only be object or children. Returns
+    // id of the notification or -1 on failure. Note that AD
+    // limits number of notifications per connection, 5 by
+    // default. notification_wait() waits for at most
+    // "timeout_ms" and returns changed objects that arrived
+    // by then. Deleted objects are returned too, with
+    // "isDeleted" attribute set. Notifications that were
+    // ended by the server are returned in "ended_ids".
+    // Returns false if connection failed. Don't use an
+    // AdInterface with notifications for other operations.
+    int notification_start(const QString &dn, const SearchScope scope, const QList<QString> &attributes);
+    void notification_stop(const int id);
+    bool notification_wait(const int timeout_ms, QList<AdObject> *changed, QList<int> *ended_ids);
+
     // Simplest search f-n that only searches for attributes
     // of one object
     AdObject search_object(const QString &dn, const QList<QString> &attributes = QList<QString>());
 
+    // Searches for attributes of multiple objects. Reads
+    // are sent all at once instead of one by one, so this
+    // is much faster than calling search_object() in a
+    // loop. Returns a map of dn => object, objects that
+    // couldn't be read are not included.
+    QHash<QString, AdObject> search_objects(const QList<QString> &dn_list, const QList<QString> &attributes = QList<QString>());
+
     bool attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg = DoStatusMsg_Yes);
 
+    // Versions of modifying f-ns that take an object
+    // which was already loaded instead of a dn. Old values
+    // are taken from the object instead of being
+    // requested from the server, so the modification costs
+    // one request. Object must contain modified
+    // attributes.
+    bool attribute_replace_values(const AdObject &object, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg = DoStatusMsg_Yes);
+    bool object_modify(const AdObject &object, const AdChangeSet &changes, const DoStatusMsg do_msg = DoStatusMsg_Yes);
+    bool group_set_scope(const AdObject &object, GroupScope scope, const DoStatusMsg do_msg = DoStatusMsg_Yes);
+    bool group_set_type(const AdObject &object, GroupType type);
+    bool user_set_account_option(const AdObject &object, AccountOption option, bool set);
+
     bool attribute_replace_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool attribute_add_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool attribute_delete_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg = DoStatusMsg_Yes);
@@ -147,10 +339,24 @@ public:
     bool attribute_replace_int(const QString &dn, const QString &attribute, const int value, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool attribute_replace_datetime(const QString &dn, const QString &attribute, const QDateTime &datetime);
 
-    bool object_add(const QString &dn, const QString &object_class);
+    // Applies all modifications in the change set in one
+    // request, instead of a request per attribute. The
+    // request is atomic, if it fails then none of the
+    // modifications are applied.
+    bool object_modify(const QString &dn, const AdChangeSet &changes, const DoStatusMsg do_msg = DoStatusMsg_Yes, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+
+    // F-ns that create, modify, move or rename objects can
+    // return the resulting object, loaded with
+    // "post_read_attributes". This uses the post-read
+    // control, so the object doesn't need to be read in a
+    // separate request. If the server doesn't support the
+    // control, "post_read_out" is set to an empty object
+    // and the caller needs to read the object itself.
+    // object_move_batch() returns objects by their new dn.
+    bool object_add(const QString &dn, const QString &object_class, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
     bool object_delete(const QString &dn, const DoStatusMsg do_msg = DoStatusMsg_Yes);
-    bool object_move(const QString &dn, const QString &new_container);
-    bool object_rename(const QString &dn, const QString &new_name);
+    bool object_move(const QString &dn, const QString &new_container, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+    bool object_rename(const QString &dn, const QString &new_name, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
 
     bool group_add_member(const QString &group_dn, const QString &user_dn);
     bool group_remove_member(const QString &group_dn, const QString &user_dn);
@@ -162,10 +368,28 @@ public:
     bool user_set_account_option(const QString &dn, AccountOption option, bool set);
     bool user_unlock(const QString &dn);
 
+    // Batch versions of operations. Requests for all
+    // objects are sent without waiting for replies, which
+    // makes operating on a large amount of objects much
+    // faster than calling single-object f-ns in a loop.
+    // Status messages are the same as for single-object
+    // f-ns. Return dn's of objects for which the operation
+    // succeeded.
+    QList<QString> object_delete_batch(const QList<QString> &dn_list, const DoStatusMsg do_msg = DoStatusMsg_Yes);
+    QList<QString> object_move_batch(const QList<QString> &dn_list, const QString &new_container, const QList<QString> &post_read_attributes = QList<QString>(), QHash<QString, AdObject> *post_read_out = nullptr);
+    QList<QString> user_set_account_option_batch(const QList<QString> &dn_list, AccountOption option, bool set);
+    QList<QString> user_set_account_option_batch(const QList<AdObject> &object_list, AccountOption option, bool set);
+
+    // Adds/removes every member in the list to/from every
+    // group in the list. Returns successfully changed
+    // memberships as a map of group => members.
+    QHash<QString, QList<QString>> group_add_member_batch(const QList<QString> &group_list, const QList<QString> &member_list);
+    QHash<QString, QList<QString>> group_remove_member_batch(const QList<QString> &group_list, const QList<QString> &member_list);
+
     bool computer_reset_account(const QString &dn);
 
     // "dn_out" is set to the dn of created gpo
-    bool gpo_add(const QString &name, QString &dn_out);
+    bool gpo_add(const QString &name, QString &dn_out, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
     bool gpo_delete(const QString &dn, bool *deleted_object);
     bool gpo_check_perms(const QString &gpo, bool *ok);
     bool gpo_sync_perms(const QString &gpo);
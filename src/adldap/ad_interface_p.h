@@ -21,15 +21,54 @@
 #ifndef AD_INTERFACE_P_H
 #define AD_INTERFACE_P_H
 
+#include <QAtomicInt>
 #include <QCoreApplication>
 #include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <functional>
 
 class AdInterface;
 class AdConfig;
+class AdChangeSet;
+class AdObjectBuilder;
 class QString;
 typedef struct ldap LDAP;
+typedef struct ldapmsg LDAPMessage;
+typedef struct ldapcontrol LDAPControl;
+typedef struct ldapmod LDAPMod;
 typedef struct _SMBCCTX SMBCCTX;
 
+enum PipelineType {
+    PipelineType_Read,
+    PipelineType_Write,
+};
+
+// Settings used by AdInterface's. Settings object is never
+// modified after it's created, setters replace current
+// settings with a modified copy. Each AdInterface takes
+// current settings when it's created and uses them until
+// it's destroyed, so settings can be changed while other
+// threads are using AdInterface's.
+class AdInterfaceSettings final {
+public:
+    AdInterfaceSettings();
+
+    AdConfig *adconfig;
+    bool log_searches;
+    QString dc;
+    // True if dc was set through set_dc(). Otherwise dc
+    // is the DC that was selected automatically for the
+    // last connection and the next connection selects
+    // again from current DC ranking.
+    bool dc_pinned;
+    void *sasl_nocanon;
+    int port;
+    CertStrategy cert_strategy;
+    int timeout;
+};
+
 class AdInterfacePrivate {
     Q_DECLARE_TR_FUNCTIONS(AdInterfacePrivate)
 
@@ -38,21 +77,209 @@ class AdInterfacePrivate {
 public:
     AdInterfacePrivate(AdInterface *q);
 
+    QSharedPointer<const AdInterfaceSettings> settings;
+    AdConfig *adconfig;
     LDAP *ld;
     bool is_connected;
     QString domain;
     QString domain_head;
+    AdRouting routing;
     QString dc;
+    // DC that this connection is counted against in
+    // AdReadRouter
+    QString routed_dc;
     QString client_user;
+    int pool_generation;
+    int range_limit;
+    QSet<int> notification_ids;
+    QAtomicInt cancel_requested;
+    // Number of public f-ns currently running, see
+    // AdOperationGuard
+    int operation_depth;
     QList<AdMessage> messages;
 
+    // If set, load_entry() doesn't load remaining values
+    // of ranged attributes, because that would send a
+    // search while another operation on this connection
+    // is still receiving results. Objects get the values
+    // returned so far and the rest are loaded by
+    // complete_ranges() after the operation is done.
+    bool defer_ranges;
+    // dn => attribute => index of first value that
+    // hasn't been loaded yet
+    QHash<QString, QHash<QString, int>> deferred_range_map;
+
     void success_message(const QString &msg, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     void error_message(const QString &context, const QString &error, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     void error_message_plain(const QString &text, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     QString default_error() const;
+    static QString error_string(const int ldap_result);
     int get_ldap_result() const;
-    bool search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl = false);
-    bool connect_via_ldap(const char *uri);
+    // NOTE: "show_deleted" includes deleted objects
+    // (tombstones) in results
+    bool search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl = false, const bool show_deleted = false);
+    bool search_all_pages(const QString &base, const int scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, const bool show_deleted);
+    // Reads highestCommittedUSN of connected DC from
+    // rootDSE
+    bool get_highest_usn(qint64 *usn_out);
+    bool search_vlv_internal(const char *base, const int scope, const char *filter, char **attributes, const char *sort_attribute, const bool sort_descending, const int offset, const int count, QList<AdObject> *results, AdVlvContext *context);
+    bool search_stream_internal(const char *base, const int scope, const char *filter, char **attributes, std::function<bool(const AdObject &object)> callback, const bool get_sacl = false);
+
+    static QSharedPointer<const AdInterfaceSettings> current_settings();
+    // Replaces current settings with a copy modified by
+    // "change". Change is applied while settings are
+    // locked, so it can safely depend on current values.
+    static void change_settings(std::function<void(AdInterfaceSettings *)> change);
+
+    // Creates a connection to dc and binds. This doesn't
+    // use any instance state, so it can be called from
+    // other threads. On failure, error_out is set.
+    static bool create_connection(const QString &dc, const AdInterfaceSettings &settings, LDAP **ld_out, QString *error_out);
+
+    // Connects to the first DC in the list to bind
+    // successfully. DC's are tried in order, each next DC
+    // is started if previous ones haven't connected after
+    // a short delay, or right away if they failed.
+    // Connections that bind after the winner are returned
+    // to the pool. DC's that failed are added to
+    // failed_list.
+    bool connect_race(const QList<QString> &dc_list, QList<QString> *failed_list);
+
+    // Connects to a Global Catalog server of the forest.
+    // Sets domain_head to forest root.
+    bool connect_gc();
+
+    // Returns true if GC has everything that a search with
+    // this filter and attributes needs
+    bool gc_can_answer(const QString &filter, const QList<QString> &attributes) const;
+
+    // Replaces a broken connection with a connection to
+    // another DC
+    bool failover();
+
+    // Replaces connection with a connection to given DC,
+    // for operations that only make sense on one DC.
+    // Current connection is returned to the pool. Doesn't
+    // change default DC. Returns false if DC can't be
+    // reached, in which case current connection is kept.
+    bool switch_dc(const QString &target_dc);
+
+    // Runs op and if it failed because connection was
+    // lost, fails over to another DC and runs it again. Op
+    // should return an LDAP result code. Only use this for
+    // reads, since a write could be applied twice. Use
+    // send_write() for writes.
+    int with_failover(std::function<int()> op);
+
+    // Calls send_op, which should start an async write and
+    // return it's msgid or -1 on failure. If write
+    // couldn't be sent because connection was lost, fails
+    // over to another DC and sends it again. Once a write
+    // has been sent, it's never resent, because the server
+    // may have applied it even if the reply is lost.
+    // Returns msgid or -1 on failure.
+    int send_write(std::function<int()> send_op);
+
+    // Waits for result of an async operation, arguments
+    // and return value are same as for ldap_result().
+    // Waiting is done in short intervals, so that it can be
+    // interrupted by cancel(). Operation is abandoned if
+    // it's cancelled or if no result arrives within
+    // operation timeout, in which case 0 is returned and
+    // result code is set to LDAP_USER_CANCELLED or
+    // LDAP_TIMEOUT.
+    int receive_result(const int msgid, const int all, LDAPMessage **res);
+
+    // Sends a search and waits for all of it's results
+    // using receive_result(), so that the search can be
+    // cancelled and times out like other operations.
+    // Returns LDAP result code. Results are returned in
+    // res even on failure and must be freed by caller.
+    int search_async(const char *base, const int scope, const char *filter, char **attributes, LDAPControl **server_controls, LDAPMessage **res);
+
+    // Runs "count" operations as a pipeline on this
+    // connection. "send_op" is called with op index and
+    // should start an async operation, returning it's
+    // msgid or -1 on failure. Up to a fixed window of
+    // operations are in flight at the same time, so a
+    // batch costs about one round-trip per window instead
+    // of one per operation. "on_reply" is optionally
+    // called with the complete reply of each operation,
+    // reply is freed afterwards. Only replies to ops of
+    // this pipeline are received, replies to other
+    // operations on the connection are left queued. If
+    // connection is lost, fails over to another DC and
+    // continues with ops that were not sent yet. Ops that
+    // were in flight are resent only for read pipelines.
+    // Returns LDAP result codes, in the same order as ops.
+    QList<int> run_pipelined(const PipelineType type, const int count, std::function<int(const int)> send_op, std::function<void(const int, LDAPMessage *)> on_reply = nullptr);
+
+    // Async senders for use inside run_pipelined(). Return
+    // msgid or -1 on failure.
+    int send_search_object(const QString &dn, char **attributes, LDAPControl **server_controls = NULL);
+    int send_modify(const QString &dn, const QString &attribute, const int mod_op, const QList<QByteArray> &values);
+
+    // Sends a modification that replaces old value of a
+    // single-valued attribute with a new value, but only
+    // if the attribute still has the old value. Old value
+    // is deleted and new value is added in the same
+    // request, so if old value is stale, the request fails
+    // with LDAP_NO_SUCH_ATTRIBUTE and nothing is modified.
+    int send_swap(const QString &dn, const QString &attribute, const QByteArray &old_value, const QByteArray &new_value);
+    int swap_value(const QString &dn, const QString &attribute, const QByteArray &old_value, const QByteArray &new_value);
+
+    // Synchronous versions of modify, add and rename
+    // operations that can request the entry as it was
+    // before the operation and as it is after the
+    // operation, using pre-read and post-read controls
+    // (RFC 4527). This way the entry doesn't need to be
+    // read in a separate request. Controls are only sent
+    // for non-empty attribute lists. Controls are not
+    // critical and servers that don't support them ignore
+    // them, in which case outputs are set to empty
+    // objects. These are sent through send_write().
+    int modify(const QString &dn, LDAPMod **mods, const QList<QString> &pre_read_attributes = QList<QString>(), AdObject *pre_read_out = nullptr, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+    int add(const QString &dn, LDAPMod **mods, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+    int rename(const QString &dn, const QString &new_rdn, const QString &new_superior, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+    int delete_entry(const QString &dn, LDAPControl **server_controls);
+
+    // Async rename for use inside run_pipelined(). Empty
+    // superior means that object stays in the same parent.
+    int send_rename(const QString &dn, const QString &new_rdn, const QString &new_superior, const QList<QString> &post_read_attributes = QList<QString>());
+
+    // Waits for result of an async operation. Returns
+    // LDAP result code, which is also saved so that
+    // default_error() can report it.
+    int wait_result(const int msgid, AdObject *pre_read_out, AdObject *post_read_out);
+
+    // Parses result code of a reply and entries returned
+    // by read entry controls, if outputs are not NULL
+    int parse_result_read_entries(LDAPMessage *res, AdObject *pre_read_out, AdObject *post_read_out);
+
+    // Implementations of public f-ns of the same name.
+    // Old values are only used for status messages. If
+    // they are not known, they are obtained through
+    // pre-read control.
+    bool attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const QList<QByteArray> *known_old_values, const DoStatusMsg do_msg);
+    bool object_modify(const QString &dn, const AdChangeSet &changes, const AdObject *known_object, const DoStatusMsg do_msg, const QList<QString> &post_read_attributes = QList<QString>(), AdObject *post_read_out = nullptr);
+
+    // Size of received values is returned through
+    // size_out, if it's not NULL
+    // Pass a builder to load objects into a shared arena
+    AdObject load_entry(LDAPMessage *entry, int *size_out = nullptr, AdObjectBuilder *builder = nullptr);
+
+    // Loads remaining values of a ranged attribute,
+    // starting from given index. Values are appended to
+    // the list as each range arrives.
+    bool load_range(const QString &dn, const QString &attribute, const int start, QList<QByteArray> *values);
+
+    // Loads values of ranged attributes that load_entry()
+    // deferred for this object. Returns object with
+    // complete values, or the same object if nothing was
+    // deferred for it.
+    AdObject complete_ranges(const AdObject &object);
+
+    QHash<QString, QList<QString>> group_member_batch(const QList<QString> &group_list, const QList<QString> &member_list, const bool add);
     bool delete_gpt(const QString &parent_path);
     bool smb_path_is_dir(const QString &path, bool *ok);
     bool logged_in_as_admin();
@@ -62,14 +289,25 @@ public:
     QList<QString> gpo_get_gpt_contents(const QString &gpt_root_path, bool *ok);
 
 private:
-    static AdConfig *adconfig;
-    static bool s_log_searches;
-    static QString s_dc;
-    static void *s_sasl_nocanon;
-    static int s_port;
-    static CertStrategy s_cert_strat;
+    static QMutex settings_mutex;
+    static QSharedPointer<const AdInterfaceSettings> s_settings;
+    static QMutex smbc_mutex;
     static SMBCCTX *smbc;
     AdInterface *q;
 };
 
+// Create this at the start of public f-ns that talk to the
+// server. cancel() applies to the operation that is
+// running or, if none is, to the next one. Cancel request
+// is cleared when the outermost operation ends, so that
+// AdInterface can be used again after that.
+class AdOperationGuard final {
+public:
+    AdOperationGuard(AdInterfacePrivate *d);
+    ~AdOperationGuard();
+
+private:
+    AdInterfacePrivate *d;
+};
+
 #endif /* AD_INTERFACE_P_H */
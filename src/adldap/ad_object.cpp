@@ -19,6 +19,7 @@
  */
 
 #include "ad_object.h"
+#include "ad_object_p.h"
 
 #include "ad_config.h"
 #include "ad_display.h"
@@ -34,13 +35,167 @@
 #include <QMap>
 #include <QString>
 #include <algorithm>
+#include <cstring>
+
+// NOTE: values are small in general, but there are
+// occasional large ones like security descriptors and
+// thumbnail photos. Those get their own blocks, so that
+// they don't waste the rest of a shared block.
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_LARGE_ALLOCATION (ARENA_BLOCK_SIZE / 4)
+
+AdObjectArena::AdObjectArena() {
+    block = nullptr;
+    block_used = 0;
+}
+
+AdObjectArena::~AdObjectArena() {
+    for (char *this_block : block_list) {
+        delete[] this_block;
+    }
+}
+
+char *AdObjectArena::allocate(const int size, const int alignment) {
+    if (size > ARENA_LARGE_ALLOCATION) {
+        // NOTE: new[] memory is aligned for any type
+        char *large_block = new char[size];
+        block_list.append(large_block);
+
+        return large_block;
+    }
+
+    const int padding = (alignment - block_used % alignment) % alignment;
+    const bool need_new_block = (block == nullptr || block_used + padding + size > ARENA_BLOCK_SIZE);
+
+    if (need_new_block) {
+        block = new char[ARENA_BLOCK_SIZE];
+        block_used = 0;
+        block_list.append(block);
+    } else {
+        block_used += padding;
+    }
+
+    char *out = block + block_used;
+    block_used += size;
+
+    return out;
+}
+
+AdObjectBuilder::AdObjectBuilder()
+: arena(new AdObjectArena()) {
+}
+
+void AdObjectBuilder::begin(const QString &dn_arg) {
+    dn = dn_arg;
+    attribute_list.clear();
+    value_list.clear();
+}
+
+void AdObjectBuilder::add_attribute(const AdAtom atom) {
+    AdObjectAttributeRef attribute;
+    attribute.atom = atom;
+    attribute.first_value = value_list.size();
+    attribute.value_count = 0;
+
+    attribute_list.append(attribute);
+}
+
+void AdObjectBuilder::add_value(const char *data, const int size) {
+    char *value_data = arena->allocate(size);
+    memcpy(value_data, data, size);
+
+    AdObjectValueRef value;
+    value.data = value_data;
+    value.size = size;
+
+    value_list.append(value);
+    attribute_list.last().value_count++;
+}
+
+AdObject AdObjectBuilder::end() {
+    // NOTE: sort is stable so that if an attribute was
+    // added twice, the last one is kept, same as when
+    // inserting into a hash
+    std::stable_sort(attribute_list.begin(), attribute_list.end(),
+        [](const AdObjectAttributeRef &a, const AdObjectAttributeRef &b) {
+            return (a.atom < b.atom);
+        });
+
+    const QVector<AdObjectAttributeRef> unique_list = [&]() {
+        QVector<AdObjectAttributeRef> out;
+
+        for (int i = 0; i < attribute_list.size(); i++) {
+            const bool is_last_duplicate = (i + 1 == attribute_list.size() || attribute_list[i + 1].atom != attribute_list[i].atom);
+
+            if (is_last_duplicate) {
+                out.append(attribute_list[i]);
+            }
+        }
+
+        return out;
+    }();
+
+    const int value_count = [&]() {
+        int out = 0;
+
+        for (const AdObjectAttributeRef &attribute : unique_list) {
+            out += attribute.value_count;
+        }
+
+        return out;
+    }();
+
+    // Copy attributes and values into arena, values of
+    // each attribute are placed next to each other in
+    // sorted order
+    auto table_attribute_list = reinterpret_cast<AdObjectAttributeRef *>(arena->allocate(unique_list.size() * sizeof(AdObjectAttributeRef), alignof(AdObjectAttributeRef)));
+    auto table_value_list = reinterpret_cast<AdObjectValueRef *>(arena->allocate(value_count * sizeof(AdObjectValueRef), alignof(AdObjectValueRef)));
+
+    int value_i = 0;
+    for (int i = 0; i < unique_list.size(); i++) {
+        const AdObjectAttributeRef &attribute = unique_list[i];
+
+        table_attribute_list[i].atom = attribute.atom;
+        table_attribute_list[i].first_value = value_i;
+        table_attribute_list[i].value_count = attribute.value_count;
+
+        for (int j = 0; j < attribute.value_count; j++) {
+            table_value_list[value_i] = value_list[attribute.first_value + j];
+            value_i++;
+        }
+    }
+
+    auto table = reinterpret_cast<AdObjectTable *>(arena->allocate(sizeof(AdObjectTable), alignof(AdObjectTable)));
+    table->attribute_count = unique_list.size();
+    table->attribute_list = table_attribute_list;
+    table->value_list = table_value_list;
+
+    AdObject object;
+    object.dn = dn;
+    object.arena = arena;
+    object.table = table;
+
+    return object;
+}
 
 AdObject::AdObject() {
+    table = nullptr;
 }
 
 void AdObject::load(const QString &dn_arg, const QHash<QString, QList<QByteArray>> &attributes_data_arg) {
-    dn = dn_arg;
-    attributes_data = attributes_data_arg;
+    AdObjectBuilder builder;
+    builder.begin(dn_arg);
+
+    for (auto it = attributes_data_arg.begin(); it != attributes_data_arg.end(); it++) {
+        const AdAtom atom = AdAtomTable::instance()->intern(it.key());
+        builder.add_attribute(atom);
+
+        for (const QByteArray &value : it.value()) {
+            builder.add_value(value.constData(), value.size());
+        }
+    }
+
+    *this = builder.end();
 }
 
 QString AdObject::get_dn() const {
@@ -48,45 +203,128 @@ QString AdObject::get_dn() const {
 }
 
 QHash<QString, QList<QByteArray>> AdObject::get_attributes_data() const {
-    return attributes_data;
+    QHash<QString, QList<QByteArray>> out;
+
+    if (table == nullptr) {
+        return out;
+    }
+
+    for (int i = 0; i < table->attribute_count; i++) {
+        const AdObjectAttributeRef &attribute = table->attribute_list[i];
+        const QString name = AdAtomTable::instance()->name(attribute.atom);
+
+        out[name] = get_values(name);
+    }
+
+    return out;
 }
 
 bool AdObject::is_empty() const {
-    return attributes_data.isEmpty();
+    return (table == nullptr || table->attribute_count == 0);
 }
 
 bool AdObject::contains(const QString &attribute) const {
-    return attributes_data.contains(attribute);
+    return contains(AdAtomTable::instance()->find(attribute));
+}
+
+bool AdObject::contains(const AdAtom attribute) const {
+    return (find(attribute) != nullptr);
 }
 
 QList<QString> AdObject::attributes() const {
-    return attributes_data.keys();
+    QList<QString> out;
+
+    if (table == nullptr) {
+        return out;
+    }
+
+    for (int i = 0; i < table->attribute_count; i++) {
+        const AdAtom atom = table->attribute_list[i].atom;
+        out.append(AdAtomTable::instance()->name(atom));
+    }
+
+    return out;
 }
 
 QList<QByteArray> AdObject::get_values(const QString &attribute) const {
-    if (contains(attribute)) {
-        return attributes_data[attribute];
-    } else {
+    return get_values(AdAtomTable::instance()->find(attribute));
+}
+
+QList<QByteArray> AdObject::get_values(const AdAtom attribute) const {
+    const AdObjectAttributeRef *ref = find(attribute);
+
+    if (ref == nullptr) {
         return QList<QByteArray>();
     }
+
+    QList<QByteArray> out;
+    out.reserve(ref->value_count);
+
+    for (int i = 0; i < ref->value_count; i++) {
+        const AdObjectValueRef &value = table->value_list[ref->first_value + i];
+        out.append(QByteArray(value.data, value.size));
+    }
+
+    return out;
 }
 
 QByteArray AdObject::get_value(const QString &attribute) const {
-    const QList<QByteArray> values = get_values(attribute);
+    return get_value(AdAtomTable::instance()->find(attribute));
+}
+
+QByteArray AdObject::get_value(const AdAtom attribute) const {
+    const QByteArray view = get_value_view(attribute);
+
+    // NOTE: deep copy
+    return QByteArray(view.constData(), view.size());
+}
+
+int AdObject::get_value_count(const QString &attribute) const {
+    return get_value_count(AdAtomTable::instance()->find(attribute));
+}
 
-    if (!values.isEmpty()) {
-        return values.first();
+int AdObject::get_value_count(const AdAtom attribute) const {
+    const AdObjectAttributeRef *ref = find(attribute);
+
+    if (ref != nullptr) {
+        return ref->value_count;
     } else {
+        return 0;
+    }
+}
+
+QByteArray AdObject::get_value_view(const QString &attribute, const int index) const {
+    return get_value_view(AdAtomTable::instance()->find(attribute), index);
+}
+
+QByteArray AdObject::get_value_view(const AdAtom attribute, const int index) const {
+    const AdObjectAttributeRef *ref = find(attribute);
+
+    if (ref == nullptr || index < 0 || index >= ref->value_count) {
         return QByteArray();
     }
+
+    const AdObjectValueRef &value = table->value_list[ref->first_value + index];
+
+    return QByteArray::fromRawData(value.data, value.size);
 }
 
 QList<QString> AdObject::get_strings(const QString &attribute) const {
-    const QList<QByteArray> values = get_values(attribute);
+    return get_strings(AdAtomTable::instance()->find(attribute));
+}
+
+QList<QString> AdObject::get_strings(const AdAtom attribute) const {
+    const AdObjectAttributeRef *ref = find(attribute);
+
+    if (ref == nullptr) {
+        return QList<QString>();
+    }
 
     QList<QString> strings;
-    for (const auto &value : values) {
-        const QString string = QString(value);
+    strings.reserve(ref->value_count);
+    for (int i = 0; i < ref->value_count; i++) {
+        const AdObjectValueRef &value = table->value_list[ref->first_value + i];
+        const QString string = QString(QByteArray::fromRawData(value.data, value.size));
         strings.append(string);
     }
 
@@ -94,14 +332,18 @@ QList<QString> AdObject::get_strings(const QString &attribute) const {
 }
 
 QString AdObject::get_string(const QString &attribute) const {
-    const QList<QString> strings = get_strings(attribute);
+    return get_string(AdAtomTable::instance()->find(attribute));
+}
+
+QString AdObject::get_string(const AdAtom attribute) const {
+    const int count = get_value_count(attribute);
 
     // NOTE: return last object class because that is the most derived one and is what's needed most of the time
-    if (!strings.isEmpty()) {
-        if (attribute == ATTRIBUTE_OBJECT_CLASS) {
-            return strings.last();
+    if (count > 0) {
+        if (attribute == ATOM_OBJECT_CLASS) {
+            return QString(get_value_view(attribute, count - 1));
         } else {
-            return strings.first();
+            return QString(get_value_view(attribute));
         }
     } else {
         return QString();
@@ -121,10 +363,14 @@ QList<int> AdObject::get_ints(const QString &attribute) const {
 }
 
 int AdObject::get_int(const QString &attribute) const {
-    const QList<int> ints = get_ints(attribute);
+    return get_int(AdAtomTable::instance()->find(attribute));
+}
 
-    if (!ints.isEmpty()) {
-        return ints.first();
+int AdObject::get_int(const AdAtom attribute) const {
+    if (get_value_count(attribute) > 0) {
+        const QString string = QString(get_value_view(attribute));
+
+        return string.toInt();
     } else {
         return 0;
     }
@@ -150,18 +396,22 @@ QList<bool> AdObject::get_bools(const QString &attribute) const {
 }
 
 bool AdObject::get_bool(const QString &attribute) const {
-    const QList<bool> bools = get_bools(attribute);
+    return get_bool(AdAtomTable::instance()->find(attribute));
+}
+
+bool AdObject::get_bool(const AdAtom attribute) const {
+    if (get_value_count(attribute) > 0) {
+        const QString string = QString(get_value_view(attribute));
 
-    if (!bools.isEmpty()) {
-        return bools.first();
+        return ad_string_to_bool(string);
     } else {
         return false;
     }
 }
 
 bool AdObject::get_system_flag(const SystemFlagsBit bit) const {
-    if (contains(ATTRIBUTE_SYSTEM_FLAGS)) {
-        const int system_flags_bits = get_int(ATTRIBUTE_SYSTEM_FLAGS);
+    if (contains(ATOM_SYSTEM_FLAGS)) {
+        const int system_flags_bits = get_int(ATOM_SYSTEM_FLAGS);
         const bool is_set = bit_is_set(system_flags_bits, bit);
 
         return is_set;
@@ -173,7 +423,7 @@ bool AdObject::get_system_flag(const SystemFlagsBit bit) const {
 bool AdObject::get_account_option(AccountOption option, AdConfig *adconfig) const {
     switch (option) {
         case AccountOption_CantChangePassword: {
-            if (contains(ATTRIBUTE_SECURITY_DESCRIPTOR)) {
+            if (contains(ATOM_SECURITY_DESCRIPTOR)) {
                 const auto security_state = get_security_state(adconfig);
                 const QByteArray self_trustee = sid_string_to_bytes(SID_NT_SELF);
                 const PermissionState permission_state = security_state[self_trustee][AcePermission_ChangePassword];
@@ -185,8 +435,8 @@ bool AdObject::get_account_option(AccountOption option, AdConfig *adconfig) cons
             }
         }
         case AccountOption_PasswordExpired: {
-            if (contains(ATTRIBUTE_PWD_LAST_SET)) {
-                const QString pwdLastSet_value = get_string(ATTRIBUTE_PWD_LAST_SET);
+            if (contains(ATOM_PWD_LAST_SET)) {
+                const QString pwdLastSet_value = get_string(ATOM_PWD_LAST_SET);
                 const bool expired = (pwdLastSet_value == AD_PWD_LAST_SET_EXPIRED);
 
                 return expired;
@@ -196,8 +446,8 @@ bool AdObject::get_account_option(AccountOption option, AdConfig *adconfig) cons
         }
         default: {
             // Account option is a UAC bit
-            if (contains(ATTRIBUTE_USER_ACCOUNT_CONTROL)) {
-                const int control = get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+            if (contains(ATOM_USER_ACCOUNT_CONTROL)) {
+                const int control = get_int(ATOM_USER_ACCOUNT_CONTROL);
                 const int bit = account_option_bit(option);
 
                 const bool set = ((control & bit) != 0);
@@ -212,7 +462,7 @@ bool AdObject::get_account_option(AccountOption option, AdConfig *adconfig) cons
 
 // NOTE: "group type" is really only the last bit of the groupType attribute, yeah it's confusing
 GroupType AdObject::get_group_type() const {
-    const int group_type = get_int(ATTRIBUTE_GROUP_TYPE);
+    const int group_type = get_int(ATOM_GROUP_TYPE);
 
     const bool security_bit_set = ((group_type & GROUP_TYPE_BIT_SECURITY) != 0);
 
@@ -224,7 +474,7 @@ GroupType AdObject::get_group_type() const {
 }
 
 GroupScope AdObject::get_group_scope() const {
-    const int group_type = get_int(ATTRIBUTE_GROUP_TYPE);
+    const int group_type = get_int(ATOM_GROUP_TYPE);
 
     for (int i = 0; i < GroupScope_COUNT; i++) {
         const GroupScope this_scope = (GroupScope) i;
@@ -239,14 +489,14 @@ GroupScope AdObject::get_group_scope() const {
 }
 
 bool AdObject::is_class(const QString &object_class) const {
-    const QString this_object_class = get_string(ATTRIBUTE_OBJECT_CLASS);
+    const QString this_object_class = get_string(ATOM_OBJECT_CLASS);
     const bool is_class = (this_object_class == object_class);
 
     return is_class;
 }
 
 QList<QString> AdObject::get_split_upn() const {
-    const QString upn = get_string(ATTRIBUTE_USER_PRINCIPAL_NAME);
+    const QString upn = get_string(ATOM_USER_PRINCIPAL_NAME);
     const int split_index = upn.lastIndexOf('@');
     const QString prefix = upn.left(split_index);
     const QString suffix = upn.mid(split_index + 1);
@@ -268,8 +518,8 @@ QString AdObject::get_upn_suffix() const {
 }
 
 security_descriptor *AdObject::get_sd(TALLOC_CTX *mem_ctx) const {
-    const QByteArray descriptor_bytes = get_value(ATTRIBUTE_SECURITY_DESCRIPTOR);
-    DATA_BLOB blob = data_blob_const(descriptor_bytes.data(), descriptor_bytes.size());
+    const QByteArray descriptor_bytes = get_value_view(ATOM_SECURITY_DESCRIPTOR);
+    DATA_BLOB blob = data_blob_const(descriptor_bytes.constData(), descriptor_bytes.size());
 
     security_descriptor *sd = talloc(mem_ctx, struct security_descriptor);
 
@@ -289,3 +539,24 @@ QHash<QByteArray, QHash<AcePermission, PermissionState>> AdObject::get_security_
 
     return out;
 }
+
+// NOTE: if name was never interned, then atom is
+// AD_ATOM_NONE and no object can contain it
+const AdObjectAttributeRef *AdObject::find(const AdAtom atom) const {
+    if (table == nullptr || atom == AD_ATOM_NONE) {
+        return nullptr;
+    }
+
+    const AdObjectAttributeRef *begin = table->attribute_list;
+    const AdObjectAttributeRef *end = table->attribute_list + table->attribute_count;
+    const AdObjectAttributeRef *it = std::lower_bound(begin, end, atom,
+        [](const AdObjectAttributeRef &ref, const AdAtom value) {
+            return (ref.atom < value);
+        });
+
+    if (it != end && it->atom == atom) {
+        return it;
+    } else {
+        return nullptr;
+    }
+}
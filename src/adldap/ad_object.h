@@ -29,19 +29,38 @@
  * with data once and not updated afterwards so it WILL
  * become out of date after any AD modification. Therefore,
  * do not keep it around for too long.
+ *
+ * Values are stored in a compact arena shared by all
+ * objects loaded from the same search page, see
+ * ad_object_p.h. Copying an object is cheap. Getters that
+ * return QByteArray's and lists return copies, which stay
+ * valid after the object is deleted. View getters return
+ * values without copying them, which is faster but views
+ * are only valid while this object or one of it's copies
+ * exists.
+ *
+ * Getters have overloads that take attribute atoms
+ * instead of names. Those are faster because they don't
+ * need to look up the name in atom table, use them in
+ * loops over many objects.
  */
 
+#include "ad_atom.h"
 #include "ad_defines.h"
 
 #include <QByteArray>
 #include <QHash>
 #include <QList>
+#include <QSharedPointer>
 #include <QString>
 
 class QDateTime;
 class AdConfig;
 struct security_descriptor;
 typedef void TALLOC_CTX;
+class AdObjectArena;
+class AdObjectAttributeRef;
+class AdObjectTable;
 
 class AdObject {
 
@@ -54,19 +73,33 @@ public:
     QHash<QString, QList<QByteArray>> get_attributes_data() const;
     bool is_empty() const;
     bool contains(const QString &attribute) const;
+    bool contains(const AdAtom attribute) const;
     QList<QString> attributes() const;
 
     QList<QByteArray> get_values(const QString &attribute) const;
+    QList<QByteArray> get_values(const AdAtom attribute) const;
     QByteArray get_value(const QString &attribute) const;
+    QByteArray get_value(const AdAtom attribute) const;
+
+    int get_value_count(const QString &attribute) const;
+    int get_value_count(const AdAtom attribute) const;
+    // NOTE: returned array points into this object's
+    // storage, see comment at the top
+    QByteArray get_value_view(const QString &attribute, const int index = 0) const;
+    QByteArray get_value_view(const AdAtom attribute, const int index = 0) const;
 
     QList<QString> get_strings(const QString &attribute) const;
+    QList<QString> get_strings(const AdAtom attribute) const;
     QString get_string(const QString &attribute) const;
+    QString get_string(const AdAtom attribute) const;
 
     int get_int(const QString &attribute) const;
+    int get_int(const AdAtom attribute) const;
     QList<int> get_ints(const QString &attribute) const;
 
     QList<bool> get_bools(const QString &attribute) const;
     bool get_bool(const QString &attribute) const;
+    bool get_bool(const AdAtom attribute) const;
 
     QDateTime get_datetime(const QString &attribute, const AdConfig *adconfig) const;
 
@@ -89,7 +122,12 @@ public:
 
 private:
     QString dn;
-    QHash<QString, QList<QByteArray>> attributes_data;
+    QSharedPointer<AdObjectArena> arena;
+    const AdObjectTable *table;
+
+    const AdObjectAttributeRef *find(const AdAtom attribute) const;
+
+    friend class AdObjectBuilder;
 };
 
 #endif /* AD_OBJECT_H */
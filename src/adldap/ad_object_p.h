@@ -0,0 +1,113 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_OBJECT_P_H
+#define AD_OBJECT_P_H
+
+/**
+ * Compact storage for AdObject's. Values of all objects
+ * loaded from one search page are copied into one arena,
+ * which is a list of large memory blocks. Each object also
+ * gets a table in the arena, which maps attribute atoms to
+ * values. Table is sorted by atom, so attributes are found
+ * by binary search. Objects share the arena and it is
+ * freed when the last object using it is deleted.
+ *
+ * Memory in the arena is never moved or modified after it
+ * was written to, so objects created by a builder can be
+ * passed to other threads while the builder keeps adding
+ * objects to the same arena.
+ */
+
+#include "ad_atom.h"
+
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class AdObject;
+
+class AdObjectValueRef {
+public:
+    const char *data;
+    int size;
+};
+
+class AdObjectAttributeRef {
+public:
+    AdAtom atom;
+    int first_value;
+    int value_count;
+};
+
+class AdObjectTable {
+public:
+    int attribute_count;
+    const AdObjectAttributeRef *attribute_list;
+    const AdObjectValueRef *value_list;
+};
+
+class AdObjectArena {
+
+public:
+    AdObjectArena();
+    ~AdObjectArena();
+
+    // Returns memory for given number of bytes. Pass
+    // alignment when allocating structs.
+    char *allocate(const int size, const int alignment = 1);
+
+private:
+    QList<char *> block_list;
+    char *block;
+    int block_used;
+
+    AdObjectArena(const AdObjectArena &) = delete;
+    AdObjectArena &operator=(const AdObjectArena &) = delete;
+};
+
+// Builds objects one at a time. Usage: begin(), then
+// add_attribute() followed by add_value() for each value of
+// that attribute, then end() returns the object. Use one
+// builder for all entries in a search page, so that they
+// share an arena. Builder is not thread-safe, but objects
+// that it returns are.
+class AdObjectBuilder {
+
+public:
+    AdObjectBuilder();
+
+    void begin(const QString &dn);
+    void add_attribute(const AdAtom atom);
+    void add_value(const char *data, const int size);
+    AdObject end();
+
+private:
+    QSharedPointer<AdObjectArena> arena;
+    QString dn;
+
+    // NOTE: these lists are kept between objects so that
+    // their memory is reused
+    QVector<AdObjectAttributeRef> attribute_list;
+    QVector<AdObjectValueRef> value_list;
+};
+
+#endif /* AD_OBJECT_P_H */
@@ -0,0 +1,112 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_read_router.h"
+
+#include <QMutexLocker>
+
+// NOTE: AD notifies DC's in the same site about changes
+// 15 seconds after a change, plus a few seconds of stagger
+// between DC's. Wait a bit longer to be safe.
+#define READ_YOUR_WRITES_SECONDS 30
+
+AdReadRouter *AdReadRouter::instance() {
+    static AdReadRouter router;
+
+    return &router;
+}
+
+AdReadRouter::AdReadRouter() {
+    // NOTE: timer is invalid until first write
+    last_write_timer.invalidate();
+    read_your_writes_seconds = READ_YOUR_WRITES_SECONDS;
+}
+
+QString AdReadRouter::select(const QList<QString> &dc_list) {
+    QMutexLocker locker(&mutex);
+
+    QString out;
+    int out_count = 0;
+
+    for (const QString &dc : dc_list) {
+        const int count = count_map.value(dc, 0);
+
+        if (out.isEmpty() || count < out_count) {
+            out = dc;
+            out_count = count;
+        }
+    }
+
+    if (!out.isEmpty()) {
+        count_map[out]++;
+    }
+
+    return out;
+}
+
+void AdReadRouter::add(const QString &dc) {
+    QMutexLocker locker(&mutex);
+
+    count_map[dc]++;
+}
+
+void AdReadRouter::remove(const QString &dc) {
+    QMutexLocker locker(&mutex);
+
+    count_map[dc]--;
+
+    if (count_map[dc] <= 0) {
+        count_map.remove(dc);
+    }
+}
+
+int AdReadRouter::connection_count(const QString &dc) {
+    QMutexLocker locker(&mutex);
+
+    return count_map.value(dc, 0);
+}
+
+void AdReadRouter::note_write() {
+    QMutexLocker locker(&mutex);
+
+    last_write_timer.start();
+}
+
+bool AdReadRouter::write_is_recent() {
+    QMutexLocker locker(&mutex);
+
+    if (!last_write_timer.isValid()) {
+        return false;
+    }
+
+    return (last_write_timer.elapsed() < read_your_writes_seconds * 1000);
+}
+
+void AdReadRouter::set_read_your_writes_seconds(const int seconds) {
+    QMutexLocker locker(&mutex);
+
+    read_your_writes_seconds = seconds;
+}
+
+int AdReadRouter::get_read_your_writes_seconds() {
+    QMutexLocker locker(&mutex);
+
+    return read_your_writes_seconds;
+}
@@ -0,0 +1,77 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_READ_ROUTER_H
+#define AD_READ_ROUTER_H
+
+/**
+ * Spreads read-only connections over DC's of the client's
+ * site. Every connected AdInterface is counted against
+ * it's DC and a read is routed to the DC with the least
+ * connections in use. Writes stay on the primary DC. Since
+ * other DC's receive writes only after replication, reads
+ * also stay on the primary DC for a while after a write,
+ * so that the app always sees it's own changes.
+ * Thread-safe.
+ */
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+class AdReadRouter {
+
+public:
+    static AdReadRouter *instance();
+
+    // Returns DC from the list with least connections in
+    // use. Ties go to the DC that comes first in the list.
+    // Returned DC is counted right away, so that
+    // concurrent callers don't all pick the same DC. Call
+    // remove() when connection is done.
+    QString select(const QList<QString> &dc_list);
+
+    void add(const QString &dc);
+    void remove(const QString &dc);
+    int connection_count(const QString &dc);
+
+    // Call this when sending a write
+    void note_write();
+
+    // Returns true if a write was sent recently enough that
+    // it might not have replicated to other DC's yet
+    bool write_is_recent();
+
+    // Sets how long reads stay on primary DC after a write
+    void set_read_your_writes_seconds(const int seconds);
+    int get_read_your_writes_seconds();
+
+private:
+    QMutex mutex;
+    QHash<QString, int> count_map;
+    QElapsedTimer last_write_timer;
+    int read_your_writes_seconds;
+
+    AdReadRouter();
+};
+
+#endif /* AD_READ_ROUTER_H */
@@ -277,7 +277,9 @@ QString ad_security_get_trustee_name(AdInterface &ad, const QByteArray &trustee)
             ATTRIBUTE_DISPLAY_NAME,
             ATTRIBUTE_SAMACCOUNT_NAME,
         };
-        const auto trustee_search = ad.search(ad.adconfig()->domain_head(), SearchScope_All, filter, QList<QString>());
+        // NOTE: trustee may be from another domain of the
+        // forest
+        const auto trustee_search = ad.search_forest(filter, attributes);
         if (!trustee_search.isEmpty()) {
             // NOTE: this is some weird name selection logic
             // but that's how microsoft does it. Maybe need
@@ -303,6 +305,14 @@ QString ad_security_get_trustee_name(AdInterface &ad, const QByteArray &trustee)
 }
 
 bool attribute_replace_security_descriptor(AdInterface *ad, const QString &dn, const QHash<QByteArray, QHash<AcePermission, PermissionState>> &descriptor_state_arg) {
+    const QByteArray new_descriptor_bytes = ad_security_make_descriptor(ad, dn, descriptor_state_arg);
+
+    const bool apply_success = ad->attribute_replace_value(dn, ATTRIBUTE_SECURITY_DESCRIPTOR, new_descriptor_bytes);
+
+    return apply_success;
+}
+
+QByteArray ad_security_make_descriptor(AdInterface *ad, const QString &dn, const QHash<QByteArray, QHash<AcePermission, PermissionState>> &descriptor_state_arg) {
     const QByteArray new_descriptor_bytes = [&]() {
         // Remove redundancy from permission state
         const QHash<QByteArray, QHash<AcePermission, PermissionState>> state = [&]() {
@@ -437,9 +447,7 @@ bool attribute_replace_security_descriptor(AdInterface *ad, const QString &dn, c
         return out;
     }();
 
-    const bool apply_success = ad->attribute_replace_value(dn, ATTRIBUTE_SECURITY_DESCRIPTOR, new_descriptor_bytes);
-
-    return apply_success;
+    return new_descriptor_bytes;
 }
 
 QList<QByteArray> ad_security_get_trustee_list_from_object(const AdObject &object) {
@@ -462,7 +470,8 @@ QByteArray dom_sid_to_bytes(const dom_sid &sid) {
 
 QByteArray dom_sid_string_to_bytes(const QString &string) {
     dom_sid sid;
-    dom_sid_parse(cstr(string), &sid);
+    const QByteArray string_bytes = string.toUtf8();
+    dom_sid_parse(string_bytes.constData(), &sid);
     const QByteArray bytes = dom_sid_to_bytes(sid);
 
     return bytes;
@@ -51,6 +51,10 @@ QHash<QByteArray, QHash<AcePermission, PermissionState>> ad_security_modify(cons
 QString ad_security_get_well_known_trustee_name(const QByteArray &trustee);
 QString ad_security_get_trustee_name(AdInterface &ad, const QByteArray &trustee);
 bool attribute_replace_security_descriptor(AdInterface *ad, const QString &dn, const QHash<QByteArray, QHash<AcePermission, PermissionState>> &descriptor_state_arg);
+// Returns object's current security descriptor with dacl
+// remade from given state. Use this to add the descriptor
+// to a change set instead of replacing it right away.
+QByteArray ad_security_make_descriptor(AdInterface *ad, const QString &dn, const QHash<QByteArray, QHash<AcePermission, PermissionState>> &descriptor_state_arg);
 QList<QByteArray> ad_security_get_trustee_list_from_object(const AdObject &object);
 QHash<QByteArray, QHash<AcePermission, PermissionState>> ad_security_get_state_from_sd(security_descriptor *sd, AdConfig *adconfig);
 bool ad_security_get_protected_against_deletion(const AdObject &object, AdConfig *config);
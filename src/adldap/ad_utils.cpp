@@ -283,7 +283,7 @@ QString dn_move(const QString &dn, const QString &new_parent_dn) {
 // =>
 // "domain.com/bar/foo"
 QString dn_canonical(const QString &dn) {
-    char *canonical_cstr = ldap_dn2ad_canonical(cstr(dn));
+    char *canonical_cstr = ldap_dn2ad_canonical(dn.toUtf8().constData());
     const QString canonical = QString(canonical_cstr);
     ldap_memfree(canonical_cstr);
 
@@ -368,21 +368,6 @@ bool bit_is_set(int bitmask, int bit) {
     return ((bitmask & bit) != 0);
 }
 
-const char *cstr(const QString &qstr) {
-    static QList<QByteArray> buffer;
-
-    const QByteArray bytes = qstr.toUtf8();
-    buffer.append(bytes);
-
-    // Limit buffer to 100 strings
-    if (buffer.size() > 100) {
-        buffer.removeAt(0);
-    }
-
-    // NOTE: return data of bytes in buffer NOT the temp local bytes
-    return buffer.last().constData();
-}
-
 bool load_adldap_translation(QTranslator &translator, const QLocale &locale) {
     return translator.load(locale, "adldap", "_", ":/adldap");
 }
@@ -420,7 +405,8 @@ QByteArray guid_string_to_bytes(const QString &guid_string) {
 
 QByteArray sid_string_to_bytes(const QString &sid_string) {
     dom_sid sid;
-    string_to_sid(&sid, cstr(sid_string));
+    const QByteArray sid_string_bytes = sid_string.toUtf8();
+    string_to_sid(&sid, sid_string_bytes.constData());
 
     const QByteArray sid_bytes = QByteArray((char *) &sid, sizeof(dom_sid));
 
@@ -21,6 +21,8 @@
 #ifndef ADLDAP_H
 #define ADLDAP_H
 
+#include "ad_atom.h"
+#include "ad_change_set.h"
 #include "ad_config.h"
 #include "ad_defines.h"
 #include "ad_display.h"
@@ -0,0 +1,321 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "change_listener.h"
+
+#include "adldap.h"
+#include "console_impls/object_impl.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// Default limit of AD on number of notifications per
+// connection
+#define NOTIFICATIONS_PER_CONNECTION_MAX 5
+#define WATCH_COUNT_MAX 25
+#define POLL_TIMEOUT_MS 200
+#define RECONNECT_DELAY_MS 10000
+
+// Notification that was started for a watch
+class ChangeListenerNotification final {
+public:
+    ChangeListenerWatch watch;
+    AdInterface *ad;
+    int id;
+};
+
+// NOTE: pinned flag is not compared, it doesn't change
+// what is watched
+bool ChangeListenerWatch::operator==(const ChangeListenerWatch &other) const {
+    return (dn == other.dn && scope == other.scope);
+}
+
+ChangeListener *ChangeListener::instance() {
+    static ChangeListener listener;
+
+    return &listener;
+}
+
+ChangeListener::ChangeListener()
+: QThread() {
+    stop_flag = false;
+}
+
+void ChangeListener::watch(const QString &dn, const SearchScope scope, const bool pinned) {
+    QMutexLocker locker(&mutex);
+
+    if (stop_flag) {
+        return;
+    }
+
+    ChangeListenerWatch watch;
+    watch.dn = dn;
+    watch.scope = scope;
+    watch.pinned = pinned;
+
+    // NOTE: watching again doesn't unpin a pinned watch
+    for (const ChangeListenerWatch &old_watch : watch_list) {
+        if (old_watch == watch && old_watch.pinned) {
+            watch.pinned = true;
+        }
+    }
+
+    watch_list.removeAll(watch);
+    watch_list.append(watch);
+
+    // Drop oldest watches that are not pinned if over
+    // limit
+    for (int i = 0; i < watch_list.size() && watch_list.size() > WATCH_COUNT_MAX;) {
+        if (watch_list[i].pinned) {
+            i++;
+        } else {
+            watch_list.removeAt(i);
+        }
+    }
+
+    watch_condition.wakeAll();
+
+    if (!isRunning()) {
+        start();
+    }
+}
+
+void ChangeListener::unwatch(const QString &dn, const SearchScope scope) {
+    ChangeListenerWatch watch;
+    watch.dn = dn;
+    watch.scope = scope;
+    watch.pinned = false;
+
+    remove_watch(watch);
+}
+
+void ChangeListener::stop() {
+    {
+        QMutexLocker locker(&mutex);
+
+        stop_flag = true;
+        watch_condition.wakeAll();
+    }
+
+    wait();
+}
+
+void ChangeListener::run() {
+    const QList<QString> attributes = console_object_search_attributes();
+
+    QList<AdInterface *> connection_list;
+    QList<ChangeListenerNotification> notification_list;
+    QElapsedTimer reconnect_timer;
+
+    auto get_notification_count = [&](AdInterface *ad) {
+        int out = 0;
+
+        for (const ChangeListenerNotification &notification : notification_list) {
+            if (notification.ad == ad) {
+                out++;
+            }
+        }
+
+        return out;
+    };
+
+    auto close_connection = [&](AdInterface *ad) {
+        for (int i = notification_list.size() - 1; i >= 0; i--) {
+            if (notification_list[i].ad == ad) {
+                notification_list.removeAt(i);
+            }
+        }
+
+        connection_list.removeAll(ad);
+
+        delete ad;
+    };
+
+    while (!stop_requested()) {
+        const QList<ChangeListenerWatch> current_watch_list = get_watch_list();
+
+        // Stop notifications for removed watches
+        for (int i = notification_list.size() - 1; i >= 0; i--) {
+            const ChangeListenerNotification notification = notification_list[i];
+
+            if (!current_watch_list.contains(notification.watch)) {
+                notification.ad->notification_stop(notification.id);
+                notification_list.removeAt(i);
+            }
+        }
+
+        const QList<AdInterface *> unused_connection_list = [&]() {
+            QList<AdInterface *> out;
+
+            for (AdInterface *ad : connection_list) {
+                if (get_notification_count(ad) == 0) {
+                    out.append(ad);
+                }
+            }
+
+            return out;
+        }();
+
+        for (AdInterface *ad : unused_connection_list) {
+            close_connection(ad);
+        }
+
+        // Start notifications for new watches
+        for (const ChangeListenerWatch &watch : current_watch_list) {
+            const bool already_started = [&]() {
+                for (const ChangeListenerNotification &notification : notification_list) {
+                    if (notification.watch == watch) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }();
+
+            if (already_started) {
+                continue;
+            }
+
+            AdInterface *ad = [&]() -> AdInterface * {
+                for (AdInterface *connection : connection_list) {
+                    if (get_notification_count(connection) < NOTIFICATIONS_PER_CONNECTION_MAX) {
+                        return connection;
+                    }
+                }
+
+                // NOTE: don't retry connecting right away
+                // if server is unreachable
+                const bool can_connect = (!reconnect_timer.isValid() || reconnect_timer.elapsed() > RECONNECT_DELAY_MS);
+                if (!can_connect) {
+                    return nullptr;
+                }
+
+                auto new_connection = new AdInterface();
+
+                if (!new_connection->is_connected()) {
+                    delete new_connection;
+                    reconnect_timer.start();
+
+                    return nullptr;
+                }
+
+                connection_list.append(new_connection);
+
+                return new_connection;
+            }();
+
+            if (ad == nullptr) {
+                break;
+            }
+
+            const int id = ad->notification_start(watch.dn, watch.scope, attributes);
+
+            if (id == -1) {
+                // NOTE: drop watch so that it's not retried
+                // forever
+                remove_watch(watch);
+
+                continue;
+            }
+
+            ChangeListenerNotification notification;
+            notification.watch = watch;
+            notification.ad = ad;
+            notification.id = id;
+            notification_list.append(notification);
+        }
+
+        if (connection_list.isEmpty()) {
+            // Nothing to listen to, wait until watches
+            // change
+            QMutexLocker locker(&mutex);
+
+            if (watch_list == current_watch_list && !stop_flag) {
+                watch_condition.wait(&mutex, RECONNECT_DELAY_MS);
+            }
+
+            continue;
+        }
+
+        const QList<AdInterface *> poll_list = connection_list;
+
+        for (AdInterface *ad : poll_list) {
+            QList<AdObject> changed_list;
+            QList<int> ended_list;
+            const bool success = ad->notification_wait(POLL_TIMEOUT_MS, &changed_list, &ended_list);
+
+            for (const AdObject &object : changed_list) {
+                const bool is_deleted = object.get_bool(ATTRIBUTE_IS_DELETED);
+
+                if (is_deleted) {
+                    const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+
+                    emit object_deleted(guid);
+                } else {
+                    emit object_changed(object);
+                }
+            }
+
+            // NOTE: server ends notifications when watched
+            // object is deleted or when it can't continue
+            // them, drop watches of such notifications
+            for (const int id : ended_list) {
+                for (int i = notification_list.size() - 1; i >= 0; i--) {
+                    const ChangeListenerNotification notification = notification_list[i];
+
+                    if (notification.ad == ad && notification.id == id) {
+                        remove_watch(notification.watch);
+                        notification_list.removeAt(i);
+                    }
+                }
+            }
+
+            // NOTE: notifications of a failed connection
+            // are started again on a new connection
+            if (!success) {
+                close_connection(ad);
+                reconnect_timer.start();
+            }
+        }
+    }
+
+    for (AdInterface *ad : connection_list) {
+        delete ad;
+    }
+}
+
+QList<ChangeListenerWatch> ChangeListener::get_watch_list() {
+    QMutexLocker locker(&mutex);
+
+    return watch_list;
+}
+
+void ChangeListener::remove_watch(const ChangeListenerWatch &watch) {
+    QMutexLocker locker(&mutex);
+
+    watch_list.removeAll(watch);
+    watch_condition.wakeAll();
+}
+
+bool ChangeListener::stop_requested() {
+    QMutexLocker locker(&mutex);
+
+    return stop_flag;
+}
@@ -0,0 +1,92 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGE_LISTENER_H
+#define CHANGE_LISTENER_H
+
+/**
+ * Background thread that listens for changes of objects
+ * using AD change notifications. Console watches
+ * containers it has fetched and properties dialogs watch
+ * their targets, so that changes made by other clients
+ * appear without a refresh. AD limits the number of
+ * notifications per connection, so watches are spread
+ * over multiple connections. Number of watches is limited
+ * too, the oldest watches are dropped when over the
+ * limit.
+ */
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "ad_defines.h"
+
+class AdObject;
+
+class ChangeListenerWatch final {
+public:
+    QString dn;
+    SearchScope scope;
+    bool pinned;
+
+    bool operator==(const ChangeListenerWatch &other) const;
+};
+
+class ChangeListener final : public QThread {
+    Q_OBJECT
+
+public:
+    static ChangeListener *instance();
+
+    // Starts listening for changes of object at "dn" or
+    // of it's children, depending on scope. Watching a
+    // dn that is already watched makes it the most
+    // recent watch. Pinned watches are never dropped
+    // because of the limit, use this for watches that
+    // must stay active until they are unwatched.
+    void watch(const QString &dn, const SearchScope scope, const bool pinned = false);
+    void unwatch(const QString &dn, const SearchScope scope);
+
+    // Stops listening and waits for thread to finish.
+    // Call this before quitting.
+    void stop();
+
+signals:
+    // NOTE: deleted objects are not emitted by
+    // object_changed()
+    void object_changed(const AdObject &object);
+    void object_deleted(const QByteArray &guid);
+
+private:
+    QMutex mutex;
+    QWaitCondition watch_condition;
+    QList<ChangeListenerWatch> watch_list;
+    bool stop_flag;
+
+    ChangeListener();
+
+    void run() override;
+    QList<ChangeListenerWatch> get_watch_list();
+    void remove_watch(const ChangeListenerWatch &watch);
+    bool stop_requested();
+};
+
+#endif /* CHANGE_LISTENER_H */
@@ -24,10 +24,7 @@
 #include "console_widget/console_widget.h"
 
 enum MyConsoleRole {
-    MyConsoleRole_SearchThreadId = ConsoleRole_LAST + 1,
-    MyConsoleRole_IconBeforeSearch,
-
-    MyConsoleRole_LAST,
+    MyConsoleRole_LAST = ConsoleRole_LAST + 1,
 };
 
 #endif /* MY_CONSOLE_ROLE_H */
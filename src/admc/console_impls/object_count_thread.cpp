@@ -0,0 +1,75 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "console_impls/object_count_thread.h"
+
+#include "adldap.h"
+
+ObjectCountThread::ObjectCountThread(const QString &base_arg, const QString &filter_arg, const bool count_children_arg) {
+    base = base_arg;
+    filter = filter_arg;
+    count_children = count_children_arg;
+
+    static int id_max = 0;
+    id = id_max;
+    id_max++;
+
+    connect(
+        this, &ObjectCountThread::finished,
+        this, &QObject::deleteLater);
+}
+
+int ObjectCountThread::get_id() const {
+    return id;
+}
+
+AdSyncState ObjectCountThread::get_sync_state() const {
+    return sync_state;
+}
+
+void ObjectCountThread::run() {
+    AdInterface ad;
+    if (!ad.is_connected()) {
+        emit count_ready(-1);
+
+        return;
+    }
+
+    // NOTE: start incremental sync before the search, so
+    // that changes made during the search are picked up by
+    // next refresh
+    ad.sync_begin(&sync_state);
+
+    if (!count_children) {
+        emit count_ready(-1);
+
+        return;
+    }
+
+    int count;
+    const bool success = ad.search_count(base, SearchScope_Children, filter, &count);
+
+    if (success) {
+        emit count_ready(count);
+    } else {
+        emit count_ready(-1);
+    }
+}
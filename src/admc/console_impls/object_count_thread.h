@@ -0,0 +1,68 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OBJECT_COUNT_THREAD_H
+#define OBJECT_COUNT_THREAD_H
+
+/**
+ * A thread that counts children of a container, without
+ * loading them. Used to decide whether a container should
+ * be displayed using virtual list view before fetching
+ * it, so that expanding containers doesn't block the UI
+ * while the server counts children. Counting can be
+ * skipped if container is known to be small. Thread also
+ * starts incremental sync for the container, so that
+ * fetching doesn't make any requests from the main
+ * thread. count_ready() is emitted exactly once, with -1
+ * if counting failed or was skipped. Sync state is
+ * available from get_sync_state() after that.
+ * ObjectCountThread deletes itself when it's finished.
+ */
+
+#include <QThread>
+
+#include "ad_interface.h"
+
+class ObjectCountThread final : public QThread {
+    Q_OBJECT
+
+public:
+    ObjectCountThread(const QString &base, const QString &filter, const bool count_children);
+
+    int get_id() const;
+
+    // Invalid if sync failed to start
+    AdSyncState get_sync_state() const;
+
+signals:
+    void count_ready(const int count);
+
+private:
+    QString base;
+    QString filter;
+    bool count_children;
+    int id;
+    AdSyncState sync_state;
+
+    void run() override;
+};
+
+#endif /* OBJECT_COUNT_THREAD_H */
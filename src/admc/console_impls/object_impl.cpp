@@ -21,12 +21,13 @@
 #include "console_impls/object_impl.h"
 
 #include "adldap.h"
+#include "change_listener.h"
 #include "console_impls/policy_impl.h"
 #include "console_impls/policy_impl.h"
 #include "console_impls/query_item_impl.h"
 #include "console_impls/query_folder_impl.h"
 #include "globals.h"
-#include "search_thread.h"
+#include "search_scheduler.h"
 #include "select_object_dialog.h"
 #include "settings.h"
 #include "status.h"
@@ -48,12 +49,28 @@
 #include "password_dialog.h"
 #include "editors/multi_editor.h"
 #include "console_impls/item_type.h"
+#include "console_impls/object_count_thread.h"
+#include "console_impls/object_prefetcher.h"
+#include "console_impls/object_vlv_model.h"
 #include "console_widget/results_view.h"
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QMenu>
 #include <QSet>
 #include <QStandardItemModel>
+#include <QTimer>
+
+// Containers with this many children are displayed using
+// server-side sort and virtual list view. Only containers
+// are loaded into console for them and the rest of
+// children are loaded by windows when displayed.
+#define VLV_CHILD_COUNT_MIN 2000
+
+// Changes received from other clients are applied in
+// batches, at most this often. This way, many objects
+// changed at once cost one search and one vlv reload.
+#define CHANGE_BATCH_DELAY_MS 200
 
 enum DropType {
     DropType_Move,
@@ -71,6 +88,12 @@ ObjectImpl::ObjectImpl(ConsoleWidget *console_arg)
 : ConsoleImpl(console_arg) {
     buddy_console = nullptr;
     policy_impl = nullptr;
+    vlv_model = nullptr;
+    prefetcher = new ObjectPrefetcher(console, this);
+
+    change_timer = new QTimer(this);
+    change_timer->setSingleShot(true);
+    change_timer->setInterval(CHANGE_BATCH_DELAY_MS);
 
     change_dc_dialog = new ChangeDCDialog(console);
     move_dialog = new SelectContainerDialog(console);
@@ -152,6 +175,16 @@ ObjectImpl::ObjectImpl(ConsoleWidget *console_arg)
     connect(
         change_dc_action, &QAction::triggered,
         change_dc_dialog, &QDialog::open);
+
+    connect(
+        ChangeListener::instance(), &ChangeListener::object_changed,
+        this, &ObjectImpl::on_object_changed);
+    connect(
+        change_timer, &QTimer::timeout,
+        this, &ObjectImpl::apply_pending_changes);
+    connect(
+        ChangeListener::instance(), &ChangeListener::object_deleted,
+        this, &ObjectImpl::on_object_deleted);
 }
 
 void ObjectImpl::set_policy_impl(PolicyImpl *policy_impl_arg) {
@@ -171,36 +204,118 @@ void ObjectImpl::disable_filtering() {
     filtering_is_ON = false;
 }
 
+void ObjectImpl::reset_sync_states() {
+    sync_map.clear();
+    prefetcher->clear();
+}
+
 
 // Load children of this item in scope tree
 // and load results linked to this scope item
 void ObjectImpl::fetch(const QModelIndex &index) {
     const QString base = index.data(ObjectRole_DN).toString();
+    const QString children_filter = get_children_filter();
+
+    // NOTE: count children before loading them. If there
+    // are too many, then only containers are loaded into
+    // console, so that scope tree still works. Results
+    // view then displays vlv model instead. Server counts
+    // children in a separate thread, so that expanding a
+    // container doesn't block the UI.
+    QStandardItem *item = console->get_item(index);
+    item->setData(true, ObjectRole_Fetching);
+
+    // NOTE: if container was small when it was last
+    // counted, it's very unlikely to have grown past vlv
+    // threshold since, so don't count it again. Half of
+    // the threshold leaves room for growth.
+    const QVariant prev_count_data = item->data(ObjectRole_ChildCount);
+    const int prev_count = prev_count_data.toInt();
+    const bool known_small = (prev_count_data.isValid() && prev_count >= 0 && prev_count < VLV_CHILD_COUNT_MIN / 2);
+
+    auto thread = new ObjectCountThread(base, children_filter, !known_small);
+    const int count_id = thread->get_id();
+    count_id_map[base] = count_id;
+
+    const QPersistentModelIndex persistent_index = index;
+
+    connect(
+        thread, &ObjectCountThread::count_ready,
+        this,
+        [this, thread, persistent_index, base, children_filter, count_id, known_small, prev_count](const int count) {
+            // NOTE: ignore count if container was fetched
+            // again while counting
+            const bool is_latest = (count_id_map.value(base, -1) == count_id);
+            if (!is_latest) {
+                return;
+            }
+
+            count_id_map.remove(base);
+
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            const int child_count = [&]() {
+                if (known_small) {
+                    return prev_count;
+                } else {
+                    return count;
+                }
+            }();
+
+            fetch_children(persistent_index, children_filter, child_count, thread->get_sync_state());
+        });
+
+    thread->start();
+}
+
+void ObjectImpl::fetch_children(const QModelIndex &index, const QString &children_filter, const int child_count, const AdSyncState &sync_state) {
+    const QString base = index.data(ObjectRole_DN).toString();
 
     const SearchScope scope = SearchScope_Children;
 
-    //
-    // Search object's children
-    //
-    const QString filter = [=]() {
-        QString out;
-
-        // NOTE: OR user filter with containers filter so
-        // that container objects are always shown, even if
-        // they are filtered out by user filter
-        if (filtering_is_ON) {
-            out = filter_OR({is_container_filter(), out});
-            out = filter_OR({current_filter, out});
-        }
+    // NOTE: if counting failed, for example because server
+    // doesn't support virtual list view, load all
+    // children
+    const bool use_vlv = (child_count >= VLV_CHILD_COUNT_MIN);
 
-        advanced_features_filter(out);
-        dev_mode_filter(out);
+    QStandardItem *item = console->get_item(index);
+    item->setData(use_vlv, ObjectRole_UsesVlv);
+    item->setData(child_count, ObjectRole_ChildCount);
 
-        return out;
+    const bool is_current_scope = (index == console->get_current_scope_item());
+    if (is_current_scope) {
+        if (use_vlv) {
+            auto new_vlv_model = new ObjectVlvModel(base, children_filter, this);
+            new_vlv_model->load_count(child_count);
+
+            set_vlv_model(new_vlv_model);
+        } else {
+            set_vlv_model(nullptr);
+        }
+    }
+
+    const QString filter = [=]() {
+        if (use_vlv) {
+            return filter_AND({children_filter, is_container_filter()});
+        } else {
+            return children_filter;
+        }
     }();
 
     const QList<QString> attributes = console_object_search_attributes();
 
+    // NOTE: sync was started by count thread, before the
+    // search
+    sync_map.remove(base);
+    if (sync_state.is_valid()) {
+        ObjectSyncRecord sync_record;
+        sync_record.state = sync_state;
+        sync_record.filter = children_filter;
+        sync_map[base] = sync_record;
+    }
+
     // NOTE: do an extra search before real search for
     // objects that should be visible in dev mode
     const bool dev_mode = settings_get_bool(SETTING_dev_mode);
@@ -214,7 +329,21 @@ void ObjectImpl::fetch(const QModelIndex &index) {
         }
     }
 
-    console_object_search(console, index, base, scope, filter, attributes);
+    SearchRequest *request = console_object_search(console, index, base, scope, filter, attributes);
+
+    // NOTE: prefetch child containers once this container
+    // is loaded
+    const QPersistentModelIndex persistent_index = index;
+    connect(
+        request, &SearchRequest::finished,
+        this,
+        [this, persistent_index, children_filter]() {
+            prefetcher->prefetch_children(persistent_index, children_filter);
+        });
+
+    // NOTE: listen for changes made by other clients, so
+    // that they appear without a refresh
+    ChangeListener::instance()->watch(base, SearchScope_Children);
 }
 
 bool ObjectImpl::can_drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) {
@@ -259,7 +388,18 @@ void ObjectImpl::drop(const QList<QPersistentModelIndex> &dropped_list, const QS
 QString ObjectImpl::get_description(const QModelIndex &index) const {
     QString out;
 
-    const QString object_count_text = console_object_count_string(console, index);
+    const QString object_count_text = [&]() {
+        const QString dn = index.data(ObjectRole_DN).toString();
+        const bool uses_vlv = (index.data(ObjectRole_UsesVlv).toBool() && vlv_model != nullptr && vlv_model->base() == dn);
+
+        if (uses_vlv) {
+            const int count = vlv_model->rowCount();
+
+            return QCoreApplication::translate("object_impl", "%n object(s)", "", count);
+        } else {
+            return console_object_count_string(console, index);
+        }
+    }();
 
     out += object_count_text;
 
@@ -271,9 +411,64 @@ QString ObjectImpl::get_description(const QModelIndex &index) const {
 }
 
 void ObjectImpl::activate(const QModelIndex &index) {
+    // NOTE: containers in vlv model are not scope items, so
+    // console can't navigate to them by itself. Find
+    // matching scope item and navigate to it instead.
+    const bool is_vlv_index = (vlv_model != nullptr && index.model() == vlv_model);
+    if (is_vlv_index) {
+        const QString dn = index.data(ObjectRole_DN).toString();
+        const QModelIndex current_scope = console->get_current_scope_item();
+        const QList<QModelIndex> scope_index_list = console->search_items(current_scope, ObjectRole_DN, dn, ItemType_Object);
+
+        if (!scope_index_list.isEmpty()) {
+            console->set_current_scope(scope_index_list[0]);
+
+            return;
+        }
+    }
+
     properties({index});
 }
 
+void ObjectImpl::selected_as_scope(const QModelIndex &index) {
+    // NOTE: if this container is still waiting to be
+    // fetched, fetch it before other containers
+    SearchScheduler::instance()->set_current_owner(console->get_item(index));
+
+    // NOTE: prefetched containers are loaded without
+    // fetch(), so start listening for their changes once
+    // they are visited. For containers that are about to
+    // be fetched, fetch() does this.
+    const bool was_fetched = console_item_get_was_fetched(index);
+    if (was_fetched) {
+        ChangeListener::instance()->watch(index.data(ObjectRole_DN).toString(), SearchScope_Children);
+    }
+
+    prefetcher->prefetch_children(index, get_children_filter());
+
+    const bool uses_vlv = index.data(ObjectRole_UsesVlv).toBool();
+
+    if (uses_vlv) {
+        const QString dn = index.data(ObjectRole_DN).toString();
+
+        const bool model_is_for_index = (vlv_model != nullptr && vlv_model->base() == dn);
+        if (model_is_for_index) {
+            view()->set_direct_model(vlv_model);
+        } else {
+            // NOTE: reuse child count from fetch, so that
+            // nothing is requested until rows are displayed
+            const int child_count = index.data(ObjectRole_ChildCount).toInt();
+
+            auto new_vlv_model = new ObjectVlvModel(dn, get_children_filter(), this);
+            new_vlv_model->load_count(child_count);
+
+            set_vlv_model(new_vlv_model);
+        }
+    } else {
+        view()->set_direct_model(nullptr);
+    }
+}
+
 QList<QAction *> ObjectImpl::get_all_custom_actions() const {
     QList<QAction *> out = {
         new_action,
@@ -444,7 +639,19 @@ void ObjectImpl::rename(const QList<QModelIndex> &index_list) {
             const QString old_dn = dn;
             const QString new_dn = dialog->get_new_dn();
             const QString parent_dn = dn_get_parent(old_dn);
-            move_and_rename(ad, {{old_dn, new_dn}}, parent_dn);
+
+            const QHash<QString, AdObject> new_object_map = [&]() {
+                QHash<QString, AdObject> out;
+
+                const AdObject new_object = dialog->get_new_object();
+                if (!new_object.get_dn().isEmpty()) {
+                    out[new_dn] = new_object;
+                }
+
+                return out;
+            }();
+
+            move_and_rename(ad, {{old_dn, new_dn}}, parent_dn, new_object_map);
         });
 
     dialog->open();
@@ -459,9 +666,18 @@ void ObjectImpl::properties(const QList<QModelIndex> &index_list) {
             return;
         }
 
-        auto apply_changes = [&ad, &dn_list](ConsoleWidget *target_console) {
+        // NOTE: console doesn't display large multi-valued
+        // attributes like group members, so there's no
+        // need to load all of their values
+        ad.set_range_limit(1);
+
+        // NOTE: search for objects once here to reuse them
+        // for both consoles
+        const QHash<QString, AdObject> object_map = ad.search_objects(dn_list);
+
+        auto apply_changes = [&dn_list, &object_map](ConsoleWidget *target_console) {
             for (const QString &dn : dn_list) {
-                const AdObject object = ad.search_object(dn);
+                const AdObject object = object_map.value(dn);
 
                 // NOTE: search for indexes instead of using the
                 // list given to f-n because we want to update
@@ -480,6 +696,8 @@ void ObjectImpl::properties(const QList<QModelIndex> &index_list) {
             apply_changes(buddy_console);
         }
 
+        reload_vlv_model();
+
         g_status()->display_ad_messages(ad, console);
     };
 
@@ -520,6 +738,11 @@ void ObjectImpl::refresh(const QList<QModelIndex> &index_list) {
 
     const QModelIndex index = index_list[0];
 
+    const bool refreshed_incrementally = refresh_incremental(index);
+    if (refreshed_incrementally) {
+        return;
+    }
+
     console->delete_children(index);
     fetch(index);
 }
@@ -537,21 +760,8 @@ void ObjectImpl::delete_action(const QList<QModelIndex> &index_list) {
 
     show_busy_indicator();
 
-    const QList<QString> deleted_list = [&]() {
-        QList<QString> out;
-
-        const QList<QString> target_list = index_list_to_dn_list(index_list);
-
-        for (const QString &target : target_list) {
-            const bool success = ad.object_delete(target);
-
-            if (success) {
-                out.append(target);
-            }
-        }
-
-        return out;
-    }();
+    const QList<QString> target_list = index_list_to_dn_list(index_list);
+    const QList<QString> deleted_list = ad.object_delete_batch(target_list);
 
     auto apply_changes = [&ad, &deleted_list](ConsoleWidget *target_console) {
         const QModelIndex object_root = get_object_tree_root(target_console);
@@ -572,6 +782,8 @@ void ObjectImpl::delete_action(const QList<QModelIndex> &index_list) {
         apply_changes(buddy_console);
     }
 
+    reload_vlv_model();
+
     hide_busy_indicator();
 
     g_status()->display_ad_messages(ad, console);
@@ -622,24 +834,13 @@ void ObjectImpl::on_move_dialog() {
     const QString new_parent_dn = move_dialog->get_selected();
 
     // First move in AD
-    const QList<QString> moved_objects = [&]() {
-        QList<QString> out;
-
-        for (const QString &dn : dn_list) {
-            const bool success = ad.object_move(dn, new_parent_dn);
-
-            if (success) {
-                out.append(dn);
-            }
-        }
-
-        return out;
-    }();
+    QHash<QString, AdObject> moved_object_map;
+    const QList<QString> moved_objects = ad.object_move_batch(dn_list, new_parent_dn, console_object_search_attributes(), &moved_object_map);
 
     g_status()->display_ad_messages(ad, nullptr);
 
     // Then move in console
-    move(ad, moved_objects, new_parent_dn);
+    move(ad, moved_objects, new_parent_dn, moved_object_map);
 
     hide_busy_indicator();
 }
@@ -670,11 +871,7 @@ void ObjectImpl::on_add_to_group() {
 
             const QList<QString> groups = dialog->get_selected();
 
-            for (const QString &target : target_list) {
-                for (auto group : groups) {
-                    ad.group_add_member(group, target);
-                }
-            }
+            ad.group_add_member_batch(groups, target_list);
 
             hide_busy_indicator();
 
@@ -781,8 +978,16 @@ void ObjectImpl::new_object(CreateDialog *dialog) {
                 }
 
                 const QModelIndex scope_parent_index = search_parent[0];
-                const QString created_dn = dialog->get_created_dn();
-                object_impl_add_objects_to_console_from_dns(target_console, ad, {created_dn}, scope_parent_index);
+
+                // NOTE: use object returned by create
+                // through post-read, if server supports it
+                const AdObject created_object = dialog->get_created_object();
+                if (!created_object.get_dn().isEmpty()) {
+                    object_impl_add_objects_to_console(target_console, {created_object}, scope_parent_index);
+                } else {
+                    const QString created_dn = dialog->get_created_dn();
+                    object_impl_add_objects_to_console_from_dns(target_console, ad, {created_dn}, scope_parent_index);
+                }
             };
 
             apply_changes(console);
@@ -791,6 +996,8 @@ void ObjectImpl::new_object(CreateDialog *dialog) {
                 apply_changes(buddy_console);
             }
 
+            reload_vlv_model();
+
             hide_busy_indicator();
         });
 }
@@ -803,28 +1010,47 @@ void ObjectImpl::set_disabled(const bool disabled) {
 
     show_busy_indicator();
 
-    const QList<QString> changed_objects = [&]() {
-        QList<QString> out;
-
-        const QList<QString> dn_list = get_selected_dn_list_object(console);
+    // NOTE: pass UAC values that were loaded into items,
+    // so that objects don't have to be read again before
+    // being modified
+    const QList<AdObject> object_list = [&]() {
+        QList<AdObject> out;
 
-        for (const QString &dn : dn_list) {
-            const bool success = ad.user_set_account_option(dn, AccountOption_Disabled, disabled);
+        const QList<QModelIndex> index_list = console->get_selected_items(ItemType_Object);
+        for (const QModelIndex &index : index_list) {
+            const QString dn = index.data(ObjectRole_DN).toString();
+            const QVariant uac = index.data(ObjectRole_UserAccountControl);
 
-            if (success) {
-                out.append(dn);
+            QHash<QString, QList<QByteArray>> attributes;
+            if (uac.isValid()) {
+                attributes[ATTRIBUTE_USER_ACCOUNT_CONTROL] = {QByteArray::number(uac.toInt())};
             }
+
+            AdObject object;
+            object.load(dn, attributes);
+
+            out.append(object);
         }
 
         return out;
     }();
 
+    const QList<QString> changed_objects = ad.user_set_account_option_batch(object_list, AccountOption_Disabled, disabled);
+
     auto apply_changes = [&changed_objects, &disabled](ConsoleWidget *target_console) {
+        const int disabled_bit = account_option_bit(AccountOption_Disabled);
+
         for (const QString &dn : changed_objects) {
             const QList<QModelIndex> index_list = target_console->search_items(QModelIndex(), ObjectRole_DN, dn, ItemType_Object);
             for (const QModelIndex &index : index_list) {
                 QStandardItem *item = target_console->get_item(index);
                 item->setData(disabled, ObjectRole_AccountDisabled);
+
+                const QVariant uac = item->data(ObjectRole_UserAccountControl);
+                if (uac.isValid()) {
+                    const int updated_uac = bit_set(uac.toInt(), disabled_bit, disabled);
+                    item->setData(updated_uac, ObjectRole_UserAccountControl);
+                }
             }
         }
     };
@@ -835,6 +1061,8 @@ void ObjectImpl::set_disabled(const bool disabled) {
         apply_changes(buddy_console);
     }
 
+    reload_vlv_model();
+
     hide_busy_indicator();
 
     g_status()->display_ad_messages(ad, console);
@@ -850,23 +1078,23 @@ void ObjectImpl::drop_objects(const QList<QPersistentModelIndex> &dropped_list,
 
     show_busy_indicator();
 
+    // NOTE: collect dropped objects by drop type first so
+    // that each type of operation is done as one batch
+    QList<QString> move_list;
+    QList<QString> add_to_group_list;
+
     for (const QPersistentModelIndex &dropped : dropped_list) {
         const QString dropped_dn = dropped.data(ObjectRole_DN).toString();
         const DropType drop_type = console_object_get_drop_type(dropped, target);
 
         switch (drop_type) {
             case DropType_Move: {
-                const bool move_success = ad.object_move(dropped_dn,
-                    target_dn);
-
-                if (move_success) {
-                    move(ad, QList<QString>({dropped_dn}), target_dn);
-                }
+                move_list.append(dropped_dn);
 
                 break;
             }
             case DropType_AddToGroup: {
-                ad.group_add_member(target_dn, dropped_dn);
+                add_to_group_list.append(dropped_dn);
 
                 break;
             }
@@ -876,6 +1104,17 @@ void ObjectImpl::drop_objects(const QList<QPersistentModelIndex> &dropped_list,
         }
     }
 
+    if (!move_list.isEmpty()) {
+        QHash<QString, AdObject> moved_object_map;
+        const QList<QString> moved_list = ad.object_move_batch(move_list, target_dn, console_object_search_attributes(), &moved_object_map);
+
+        move(ad, moved_list, target_dn, moved_object_map);
+    }
+
+    if (!add_to_group_list.isEmpty()) {
+        ad.group_add_member_batch({target_dn}, add_to_group_list);
+    }
+
     hide_busy_indicator();
 
     g_status()->display_ad_messages(ad, console);
@@ -901,18 +1140,29 @@ void ObjectImpl::drop_policies(const QList<QPersistentModelIndex> &dropped_list,
     }
 }
 
-void ObjectImpl::move_and_rename(AdInterface &ad, const QHash<QString, QString> &old_to_new_dn_map, const QString &new_parent_dn) {
+void ObjectImpl::move_and_rename(AdInterface &ad, const QHash<QString, QString> &old_to_new_dn_map, const QString &new_parent_dn, const QHash<QString, AdObject> &new_object_map) {
     const QList<QString> old_dn_list = old_to_new_dn_map.keys();
     const QList<QString> new_dn_list = old_to_new_dn_map.values();
 
     // NOTE: search for objects once here to reuse them
-    // multiple times later
+    // multiple times later. Only search for objects that
+    // weren't returned by the operation itself, through
+    // post-read.
     const QHash<QString, AdObject> object_map = [&]() {
         QHash<QString, AdObject> out;
+        QList<QString> search_list;
 
-        for (const QString &dn : new_dn_list) {
-            const AdObject object = ad.search_object(dn);
-            out[dn] = object;
+        for (const QString &new_dn : new_dn_list) {
+            if (new_object_map.contains(new_dn)) {
+                out[new_dn] = new_object_map[new_dn];
+            } else {
+                search_list.append(new_dn);
+            }
+        }
+
+        if (!search_list.isEmpty()) {
+            const QHash<QString, AdObject> search_results = ad.search_objects(search_list, console_object_search_attributes());
+            out.unite(search_results);
         }
 
         return out;
@@ -1007,12 +1257,14 @@ void ObjectImpl::move_and_rename(AdInterface &ad, const QHash<QString, QString>
     if (buddy_console != nullptr) {
         apply_changes(buddy_console);
     }
+
+    reload_vlv_model();
 }
 
 // NOTE: this is a helper f-n for move_and_rename() that
 // generates the new_dn_list for you, assuming that you just
 // want to move objects to new parent without renaming
-void ObjectImpl::move(AdInterface &ad, const QList<QString> &old_dn_list, const QString &new_parent_dn) {
+void ObjectImpl::move(AdInterface &ad, const QList<QString> &old_dn_list, const QString &new_parent_dn, const QHash<QString, AdObject> &new_object_map) {
     const QHash<QString, QString> old_to_new_dn_map = [&]() {
         QHash<QString, QString> out;
 
@@ -1024,7 +1276,374 @@ void ObjectImpl::move(AdInterface &ad, const QList<QString> &old_dn_list, const
         return out;
     }();
 
-    move_and_rename(ad, old_to_new_dn_map, new_parent_dn);
+    move_and_rename(ad, old_to_new_dn_map, new_parent_dn, new_object_map);
+}
+
+QString ObjectImpl::get_children_filter() const {
+    QString out;
+
+    // NOTE: OR user filter with containers filter so
+    // that container objects are always shown, even if
+    // they are filtered out by user filter
+    if (filtering_is_ON) {
+        out = filter_OR({is_container_filter(), out});
+        out = filter_OR({current_filter, out});
+    }
+
+    advanced_features_filter(out);
+    dev_mode_filter(out);
+
+    return out;
+}
+
+void ObjectImpl::set_vlv_model(ObjectVlvModel *model) {
+    // NOTE: switch view to new model before deleting old
+    // one
+    view()->set_direct_model(model);
+
+    if (vlv_model != model) {
+        delete vlv_model;
+        vlv_model = model;
+    }
+}
+
+void ObjectImpl::reload_vlv_model() {
+    if (vlv_model != nullptr) {
+        vlv_model->reload();
+    }
+}
+
+void ObjectImpl::reload_vlv_model_for_parent(const QString &parent_dn) {
+    if (vlv_model != nullptr && vlv_model->base() == parent_dn) {
+        vlv_model->reload();
+    }
+}
+
+void ObjectImpl::on_object_changed(const AdObject &object) {
+    const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+    if (guid.isEmpty()) {
+        return;
+    }
+
+    const QString dn = object.get_dn();
+    const QString parent_dn = dn_get_parent(dn);
+
+    // NOTE: objects are found by guid because dn of the
+    // object changes if it was moved or renamed by another
+    // client
+    const QModelIndex object_root = get_object_tree_root(console);
+    if (object_root.isValid()) {
+        const QList<QPersistentModelIndex> index_list = persistent_index_list(console->search_items(object_root, ObjectRole_GUID, guid, ItemType_Object));
+
+        bool object_is_in_tree = false;
+
+        for (const QPersistentModelIndex &index : index_list) {
+            // NOTE: if object was moved or renamed, dn's of
+            // it's children in scope tree are out of date,
+            // so delete the item and add it again under the
+            // new parent
+            const QString old_dn = index.data(ObjectRole_DN).toString();
+            const bool was_moved = (old_dn != dn);
+
+            if (was_moved) {
+                console->delete_item(index);
+                pending_reload_set.insert(dn_get_parent(old_dn));
+            } else {
+                const QList<QStandardItem *> row = console->get_row(index);
+                console_object_load(row, object);
+                object_is_in_tree = true;
+            }
+        }
+
+        const QModelIndex parent_index = [&]() {
+            const QList<QModelIndex> results = console->search_items(object_root, ObjectRole_DN, parent_dn, ItemType_Object);
+
+            if (results.size() == 1) {
+                return results[0];
+            } else {
+                return QModelIndex();
+            }
+        }();
+
+        const bool can_add = [&]() {
+            if (object_is_in_tree || !parent_index.isValid()) {
+                return false;
+            }
+
+            // NOTE: fetch will load the object by itself
+            const bool parent_was_fetched = console_item_get_was_fetched(parent_index);
+            const bool parent_is_fetching = parent_index.data(ObjectRole_Fetching).toBool();
+
+            return (parent_was_fetched && !parent_is_fetching);
+        }();
+
+        // NOTE: new object is added later, together with
+        // other objects that were added around the same
+        // time
+        if (can_add) {
+            pending_add_map[parent_dn].insert(guid);
+        }
+    }
+
+    // NOTE: query items are only updated, there's no way to
+    // know if a changed object now matches a query without
+    // searching it again
+    const QModelIndex query_root = get_query_tree_root(console);
+    if (query_root.isValid()) {
+        const QList<QModelIndex> index_list = console->search_items(query_root, ObjectRole_GUID, guid, ItemType_Object);
+
+        for (const QModelIndex &index : index_list) {
+            const QList<QStandardItem *> row = console->get_row(index);
+            console_object_load(row, object);
+        }
+    }
+
+    pending_reload_set.insert(parent_dn);
+
+    // NOTE: don't restart the timer if it's already
+    // running, so that a steady stream of changes doesn't
+    // delay applying them forever
+    if (!change_timer->isActive()) {
+        change_timer->start();
+    }
+}
+
+void ObjectImpl::apply_pending_changes() {
+    const QSet<QString> reload_set = pending_reload_set;
+    pending_reload_set.clear();
+
+    for (const QString &parent_dn : reload_set) {
+        reload_vlv_model_for_parent(parent_dn);
+    }
+
+    const QHash<QString, QSet<QByteArray>> add_map = pending_add_map;
+    pending_add_map.clear();
+
+    const QModelIndex object_root = get_object_tree_root(console);
+    if (!object_root.isValid()) {
+        return;
+    }
+
+    for (const QString &parent_dn : add_map.keys()) {
+        const QList<QModelIndex> parent_results = console->search_items(object_root, ObjectRole_DN, parent_dn, ItemType_Object);
+        if (parent_results.size() != 1) {
+            continue;
+        }
+
+        const QPersistentModelIndex parent_index = parent_results[0];
+
+        // NOTE: notifications are sent for all children,
+        // so check that new objects pass the filter that
+        // was used to fetch their parent. Objects are
+        // matched by guid, which has to be escaped byte by
+        // byte in filters.
+        const QList<QString> guid_filter_list = [&]() {
+            QList<QString> out;
+
+            for (const QByteArray &guid : add_map[parent_dn]) {
+                QString escaped_guid;
+                for (const char byte : guid) {
+                    escaped_guid += QString("\\%1").arg((uchar) byte, 2, 16, QChar('0'));
+                }
+
+                out.append(filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_GUID, escaped_guid));
+            }
+
+            return out;
+        }();
+
+        const bool uses_vlv = parent_index.data(ObjectRole_UsesVlv).toBool();
+        const QString children_filter = [&]() {
+            if (uses_vlv) {
+                return filter_AND({get_children_filter(), is_container_filter()});
+            } else {
+                return get_children_filter();
+            }
+        }();
+
+        const QString filter = filter_AND({children_filter, filter_OR(guid_filter_list)});
+
+        auto request = new SearchRequest(parent_dn, SearchScope_Children, filter, console_object_search_attributes(), nullptr);
+
+        connect(
+            request, &SearchRequest::results_ready,
+            this,
+            [this, parent_index](const QHash<QString, AdObject> &results) {
+                if (!parent_index.isValid()) {
+                    return;
+                }
+
+                // NOTE: if parent is being fetched again,
+                // fetch will load these objects by itself
+                const bool parent_is_fetching = parent_index.data(ObjectRole_Fetching).toBool();
+                if (parent_is_fetching) {
+                    return;
+                }
+
+                QList<AdObject> new_object_list;
+                for (const AdObject &object : results.values()) {
+                    const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+                    const bool already_added = !console->search_items(parent_index, ObjectRole_GUID, guid, ItemType_Object).isEmpty();
+
+                    if (!already_added) {
+                        new_object_list.append(object);
+                    }
+                }
+
+                object_impl_add_objects_to_console(console, new_object_list, parent_index);
+            });
+
+        SearchScheduler::instance()->submit(request);
+    }
+}
+
+void ObjectImpl::on_object_deleted(const QByteArray &guid) {
+    if (guid.isEmpty()) {
+        return;
+    }
+
+    const QList<QModelIndex> index_list = console->search_items(QModelIndex(), ObjectRole_GUID, guid, ItemType_Object);
+    const QList<QPersistentModelIndex> persistent_list = persistent_index_list(index_list);
+
+    for (const QPersistentModelIndex &index : persistent_list) {
+        console->delete_item(index);
+    }
+
+    // NOTE: deleted objects are moved out of their parent,
+    // so it's unknown whether vlv model contained this
+    // object
+    reload_vlv_model();
+}
+
+bool ObjectImpl::refresh_incremental(const QModelIndex &index) {
+    const QString base = index.data(ObjectRole_DN).toString();
+    const QString children_filter = get_children_filter();
+
+    const bool can_sync = [&]() {
+        if (!sync_map.contains(base)) {
+            return false;
+        }
+
+        // NOTE: objects that pass a changed filter are not
+        // changed objects, so they won't be returned by
+        // sync
+        const bool filter_changed = (sync_map[base].filter != children_filter);
+        if (filter_changed) {
+            return false;
+        }
+
+        // NOTE: children are incomplete until fetch is
+        // finished
+        const bool is_fetching = index.data(ObjectRole_Fetching).toBool();
+        if (is_fetching) {
+            return false;
+        }
+
+        return true;
+    }();
+
+    if (!can_sync) {
+        return false;
+    }
+
+    AdInterface ad;
+    if (ad_failed(ad)) {
+        return false;
+    }
+
+    // NOTE: console doesn't display large multi-valued
+    // attributes, so there's no need to load all of their
+    // values
+    ad.set_range_limit(1);
+
+    const bool uses_vlv = index.data(ObjectRole_UsesVlv).toBool();
+    const QString filter = [&]() {
+        if (uses_vlv) {
+            return filter_AND({children_filter, is_container_filter()});
+        } else {
+            return children_filter;
+        }
+    }();
+
+    AdSyncState sync_state = sync_map[base].state;
+    QList<AdObject> changed_list;
+    QList<QByteArray> removed_guid_list;
+    const bool sync_success = ad.sync_changes(base, SearchScope_Children, filter, console_object_search_attributes(), &sync_state, &changed_list, &removed_guid_list);
+
+    g_status()->display_ad_messages(ad, console);
+
+    if (!sync_success) {
+        sync_map.remove(base);
+
+        return false;
+    }
+
+    sync_map[base].state = sync_state;
+
+    show_busy_indicator();
+
+    const QHash<QByteArray, QPersistentModelIndex> child_map = [&]() {
+        QHash<QByteArray, QPersistentModelIndex> out;
+
+        QStandardItem *item = console->get_item(index);
+
+        for (int row = 0; row < item->rowCount(); row++) {
+            QStandardItem *child = item->child(row, 0);
+            const QByteArray guid = child->data(ObjectRole_GUID).toByteArray();
+
+            if (!guid.isEmpty()) {
+                out[guid] = QPersistentModelIndex(child->index());
+            }
+        }
+
+        return out;
+    }();
+
+    for (const QByteArray &guid : removed_guid_list) {
+        const QPersistentModelIndex child_index = child_map.value(guid);
+
+        if (child_index.isValid()) {
+            console->delete_item(child_index);
+        }
+    }
+
+    QList<AdObject> added_list;
+
+    for (const AdObject &object : changed_list) {
+        const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+        const QPersistentModelIndex child_index = child_map.value(guid);
+
+        if (!child_index.isValid()) {
+            added_list.append(object);
+
+            continue;
+        }
+
+        // NOTE: if object was renamed, dn's of it's
+        // children in scope tree are out of date, so
+        // replace the item and let it's children be
+        // fetched again
+        const QString old_dn = child_index.data(ObjectRole_DN).toString();
+        const bool was_renamed = (old_dn != object.get_dn());
+
+        if (was_renamed) {
+            console->delete_item(child_index);
+            added_list.append(object);
+        } else {
+            const QList<QStandardItem *> row = console->get_row(child_index);
+            console_object_load(row, object);
+        }
+    }
+
+    object_impl_add_objects_to_console(console, added_list, index);
+
+    if (uses_vlv) {
+        reload_vlv_model();
+    }
+
+    hide_busy_indicator();
+
+    return true;
 }
 
 void object_impl_add_objects_to_console(ConsoleWidget *console, const QList<AdObject> &object_list, const QModelIndex &parent) {
@@ -1076,8 +1695,10 @@ void object_impl_add_objects_to_console_from_dns(ConsoleWidget *console, AdInter
     const QList<AdObject> object_list = [&]() {
         QList<AdObject> out;
 
+        const QHash<QString, AdObject> object_map = ad.search_objects(dn_list);
+
         for (const QString &dn : dn_list) {
-            const AdObject object = ad.search_object(dn);
+            const AdObject object = object_map.value(dn);
             out.append(object);
         }
 
@@ -1089,15 +1710,17 @@ void object_impl_add_objects_to_console_from_dns(ConsoleWidget *console, AdInter
 
 void console_object_load(const QList<QStandardItem *> row, const AdObject &object) {
     // Load attribute columns
-    for (int i = 0; i < g_adconfig->get_columns().count(); i++) {
-        const QString attribute = g_adconfig->get_columns()[i];
+    // NOTE: use atoms because this runs for every cell
+    const QList<AdAtom> column_atoms = g_adconfig->get_column_atoms();
+    for (int i = 0; i < column_atoms.count(); i++) {
+        const AdAtom attribute = column_atoms[i];
 
         if (!object.contains(attribute)) {
             continue;
         }
 
-        const QString display_value = [attribute, object]() {
-            if (attribute == ATTRIBUTE_OBJECT_CLASS) {
+        const QString display_value = [attribute, &object]() {
+            if (attribute == ATOM_OBJECT_CLASS) {
                 const QString object_class = object.get_string(attribute);
 
                 if (object_class == CLASS_GROUP) {
@@ -1112,7 +1735,7 @@ void console_object_load(const QList<QStandardItem *> row, const AdObject &objec
                     return g_adconfig->get_class_display_name(object_class);
                 }
             } else {
-                const QByteArray value = object.get_value(attribute);
+                const QByteArray value = object.get_value_view(attribute);
                 return attribute_display_value(attribute, value, g_adconfig);
             }
         }();
@@ -1135,7 +1758,9 @@ void console_object_item_data_load(QStandardItem *item, const AdObject &object)
 
     item->setData(object.get_dn(), ObjectRole_DN);
 
-    const QList<QString> object_classes = object.get_strings(ATTRIBUTE_OBJECT_CLASS);
+    item->setData(object.get_value(ATOM_OBJECT_GUID), ObjectRole_GUID);
+
+    const QList<QString> object_classes = object.get_strings(ATOM_OBJECT_CLASS);
     item->setData(QVariant(object_classes), ObjectRole_ObjectClasses);
 
     const bool cannot_move = object.get_system_flag(SystemFlagsBit_CannotMove);
@@ -1149,6 +1774,11 @@ void console_object_item_data_load(QStandardItem *item, const AdObject &object)
 
     const bool account_disabled = object.get_account_option(AccountOption_Disabled, g_adconfig);
     item->setData(account_disabled, ObjectRole_AccountDisabled);
+
+    if (object.contains(ATOM_USER_ACCOUNT_CONTROL)) {
+        const int uac = object.get_int(ATOM_USER_ACCOUNT_CONTROL);
+        item->setData(uac, ObjectRole_UserAccountControl);
+    }
 }
 
 QList<QString> object_impl_column_labels() {
@@ -1185,36 +1815,25 @@ QList<QString> console_object_search_attributes() {
     
     attributes += ATTRIBUTE_USER_ACCOUNT_CONTROL;
 
+    // NOTE: needed to match objects returned by
+    // incremental sync
+    attributes += ATTRIBUTE_OBJECT_GUID;
+
     return attributes;
 }
 
-// NOTE: it is possible for a search to start while a
-// previous one hasn't finished. For that reason, this f-n
-// contains multiple workarounds for issues caused by that
-// case.
-void console_object_search(ConsoleWidget *console, const QModelIndex &index, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
-    auto search_id_matches = [](QStandardItem *item, SearchThread *thread) {
-        const int id_from_item = item->data(MyConsoleRole_SearchThreadId).toInt();
-        const int thread_id = thread->get_id();
-
-        const bool match = (id_from_item == thread_id);
-
-        return match;
-    };
-
+SearchRequest *console_object_search(ConsoleWidget *console, const QModelIndex &index, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
     QStandardItem *item = console->get_item(index);
 
-    // Save original icon
+    SearchScheduler *scheduler = SearchScheduler::instance();
 
-    // NOTE: only save original icon if there isn't one
-    // saved already. If this search overlaps a previous
-    // one, then previous search would've already saved it.
-    const QString icon_before_search_current = item->data(MyConsoleRole_IconBeforeSearch).toString();
-    if (icon_before_search_current.isEmpty()) {
-        const QIcon original_icon = item->icon();
-        const QString original_icon_name = original_icon.name();
-        item->setData(original_icon_name, MyConsoleRole_IconBeforeSearch);
-    }
+    // NOTE: cancel previous search for this item before
+    // saving the icon, so that previous search restores
+    // original icon first. Submitting would cancel it too,
+    // but too late for that.
+    scheduler->cancel(item);
+
+    const QString original_icon_name = item->icon().name();
 
     // Set icon to indicate that item is in "search" state
     item->setIcon(QIcon::fromTheme("system-search"));
@@ -1224,22 +1843,12 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
     item->setData(true, ObjectRole_Fetching);
     item->setDragEnabled(false);
 
-    auto search_thread = new SearchThread(base, scope, filter, attributes);
-
-    // NOTE: change item's search thread, this will be used
-    // later to handle situations where a thread is started
-    // while another is running
-    item->setData(search_thread->get_id(), MyConsoleRole_SearchThreadId);
+    auto request = new SearchRequest(base, scope, filter, attributes, item);
 
     const QPersistentModelIndex persistent_index = index;
 
-    // NOTE: need to pass console as receiver object to
-    // connect() even though we're using lambda as a slot.
-    // This is to be able to define queuedconnection type,
-    // because there's no connect() version with no receiver
-    // which has a connection type argument.
     QObject::connect(
-        search_thread, &SearchThread::results_ready,
+        request, &SearchRequest::results_ready,
         console,
         [=](const QHash<QString, AdObject> &results) {
             // NOTE: fetched index might become invalid for
@@ -1247,30 +1856,18 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
             // item at the index itself might get modified.
             // Since this slot runs in the main thread, it's
             // not possible for any catastrophic conflict to
-            // happen, so it's enough to just stop the
+            // happen, so it's enough to just cancel the
             // search.
             if (!persistent_index.isValid()) {
-                search_thread->stop();
-
-                return;
-            }
-
-            QStandardItem *item_now = console->get_item(persistent_index);
-
-            // NOTE: if another thread was started for this
-            // item, abort this thread
-            const bool thread_id_match = search_id_matches(item_now, search_thread);
-            if (!thread_id_match) {
-                search_thread->stop();
+                request->cancel();
 
                 return;
             }
 
             object_impl_add_objects_to_console(console, results.values(), persistent_index);
-        },
-        Qt::QueuedConnection);
+        });
     QObject::connect(
-        search_thread, &SearchThread::finished,
+        request, &SearchRequest::finished,
         console,
         [=]() {
             if (!persistent_index.isValid()) {
@@ -1279,27 +1876,26 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
 
             QStandardItem *item_now = console->get_item(persistent_index);
 
-            // NOTE: if another thread was started for this
-            // item, don't change item data. It will be
-            // changed by that other thread.
-            const bool thread_id_match = search_id_matches(item_now, search_thread);
-            if (!thread_id_match) {
-                return;
-            }
-
-            const QString original_icon_name = item_now->data(MyConsoleRole_IconBeforeSearch).toString();
             item_now->setIcon(QIcon::fromTheme(original_icon_name));
-
-            // NOTE: empty IconBeforeSearch so next search
-            // can use this as clean state
-            item_now->setData(QString(), MyConsoleRole_IconBeforeSearch);
-
             item_now->setData(false, ObjectRole_Fetching);
             item_now->setDragEnabled(true);
-        },
-        Qt::QueuedConnection);
+        });
+
+    // NOTE: cancel request when item is deleted, otherwise
+    // a queued request would still take a search slot once
+    // it's turn comes
+    QObject::connect(
+        item->model(), &QAbstractItemModel::rowsRemoved,
+        request,
+        [=]() {
+            if (!persistent_index.isValid()) {
+                request->cancel();
+            }
+        });
+
+    scheduler->submit(request);
 
-    search_thread->start();
+    return request;
 }
 
 void console_object_tree_init(ConsoleWidget *console, AdInterface &ad) {
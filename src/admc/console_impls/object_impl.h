@@ -39,6 +39,10 @@ class ConsoleWidget;
 class SelectContainerDialog;
 class RenameDialog;
 class CreateDialog;
+class ObjectVlvModel;
+class ObjectPrefetcher;
+class SearchRequest;
+class QTimer;
 
 /**
  * Some f-ns used for models that store objects.
@@ -53,10 +57,23 @@ enum ObjectRole {
     ObjectRole_AccountDisabled,
     ObjectRole_Fetching,
     ObjectRole_SearchId,
+    ObjectRole_UserAccountControl,
+    ObjectRole_UsesVlv,
+    // Number of children counted during last fetch
+    ObjectRole_ChildCount,
+    ObjectRole_GUID,
 
     ObjectRole_LAST,
 };
 
+// Position of incremental sync for a fetched container and
+// the filter that was used to fetch it
+class ObjectSyncRecord final {
+public:
+    AdSyncState state;
+    QString filter;
+};
+
 class ObjectImpl final : public ConsoleImpl {
     Q_OBJECT
 
@@ -74,12 +91,18 @@ public:
     
     void enable_filtering(const QString &filter);
     void disable_filtering();
+
+    // Makes next refresh reload all objects instead of
+    // applying changes since last refresh. Call this when
+    // settings that affect how objects are loaded change.
+    void reset_sync_states();
     
     void fetch(const QModelIndex &index);
     bool can_drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) override;
     void drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) override;
     QString get_description(const QModelIndex &index) const override;
     void activate(const QModelIndex &index) override;
+    void selected_as_scope(const QModelIndex &index) override;
 
     QList<QAction *> get_all_custom_actions() const override;
     QSet<QAction *> get_custom_actions(const QModelIndex &index, const bool single_selection) const override;
@@ -112,6 +135,9 @@ private slots:
     void on_reset_password();
     void on_edit_upn_suffixes();
     void on_reset_account();
+    void on_object_changed(const AdObject &object);
+    void on_object_deleted(const QByteArray &guid);
+    void apply_pending_changes();
 
 private:
     ConsoleWidget *buddy_console;
@@ -125,6 +151,19 @@ private:
     CreateDialog *create_group_dialog;
     CreateDialog *create_ou_dialog;
     CreateDialog *create_computer_dialog;
+    ObjectVlvModel *vlv_model;
+    ObjectPrefetcher *prefetcher;
+    QHash<QString, ObjectSyncRecord> sync_map;
+    // Container DN => id of the ObjectCountThread that is
+    // counting it's children for fetch
+    QHash<QString, int> count_id_map;
+    // Changes received from other clients that are waiting
+    // to be applied by apply_pending_changes(). Parent DN
+    // => GUID's of new children that need to be loaded and
+    // parents whose vlv model needs to be reloaded.
+    QHash<QString, QSet<QByteArray>> pending_add_map;
+    QSet<QString> pending_reload_set;
+    QTimer *change_timer;
 
     QString current_filter;
     bool filtering_is_ON;
@@ -147,8 +186,30 @@ private:
     void set_disabled(const bool disabled);
     void drop_objects(const QList<QPersistentModelIndex> &dropped_list, const QPersistentModelIndex &target);
     void drop_policies(const QList<QPersistentModelIndex> &dropped_list, const QPersistentModelIndex &target);
-    void move_and_rename(AdInterface &ad, const QHash<QString, QString> &old_dn_list, const QString &new_parent_dn);
-    void move(AdInterface &ad, const QList<QString> &old_dn_list, const QString &new_parent_dn);
+    // Objects in "new_object_map" are loaded into console
+    // as is, other objects are read first
+    void move_and_rename(AdInterface &ad, const QHash<QString, QString> &old_dn_list, const QString &new_parent_dn, const QHash<QString, AdObject> &new_object_map = QHash<QString, AdObject>());
+    void move(AdInterface &ad, const QList<QString> &old_dn_list, const QString &new_parent_dn, const QHash<QString, AdObject> &new_object_map = QHash<QString, AdObject>());
+    QString get_children_filter() const;
+    // Second part of fetch(), called once children have
+    // been counted and sync has started. Count is -1 if
+    // counting failed.
+    void fetch_children(const QModelIndex &index, const QString &children_filter, const int child_count, const AdSyncState &sync_state);
+    // Displays given model in results view and deletes
+    // previous one. Pass nullptr to display console items.
+    void set_vlv_model(ObjectVlvModel *model);
+    // Call after modifying objects, so that rows displayed
+    // by vlv model are reloaded
+    void reload_vlv_model();
+    // Applies changes made since last fetch or refresh to
+    // children of a container, without reloading
+    // unchanged children. Returns false if that's not
+    // possible, in which case all children should be
+    // reloaded.
+    bool refresh_incremental(const QModelIndex &index);
+    // Reloads vlv model if it displays children of given
+    // container
+    void reload_vlv_model_for_parent(const QString &parent_dn);
 };
 
 void object_impl_add_objects_to_console(ConsoleWidget *console, const QList<AdObject> &object_list, const QModelIndex &parent);
@@ -158,7 +219,9 @@ void console_object_item_data_load(QStandardItem *item, const AdObject &object);
 QList<QString> object_impl_column_labels();
 QList<int> object_impl_default_columns();
 QList<QString> console_object_search_attributes();
-void console_object_search(ConsoleWidget *console, const QModelIndex &index, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes);
+// Returned request can be used to find out when search
+// finishes. Request deletes itself after that.
+SearchRequest *console_object_search(ConsoleWidget *console, const QModelIndex &index, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes);
 void console_object_tree_init(ConsoleWidget *console, AdInterface &ad);
 bool console_object_is_ou(const QModelIndex &index);
 // NOTE: this may return an invalid index if there's no tree
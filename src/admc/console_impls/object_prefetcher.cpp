@@ -0,0 +1,267 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "console_impls/object_prefetcher.h"
+
+#include "adldap.h"
+#include "console_impls/item_type.h"
+#include "console_impls/object_impl.h"
+#include "console_widget/console_widget.h"
+#include "globals.h"
+#include "search_scheduler.h"
+#include "settings.h"
+
+#include <QStandardItem>
+#include <QStandardItemModel>
+#include <QTimer>
+
+#define PREFETCH_DEPTH_DEFAULT 1
+#define PREFETCH_PAGE_SIZE_DEFAULT 200
+#define PREFETCH_OBJECTS_PER_MINUTE_DEFAULT 5000
+
+// Oldest queued containers are dropped past this limit
+#define PENDING_MAX 100
+#define BUDGET_PERIOD_MS 60000
+
+ObjectPrefetcher::ObjectPrefetcher(ConsoleWidget *console_arg, QObject *parent)
+: QObject(parent) {
+    console = console_arg;
+    current_request = nullptr;
+    budget_used = 0;
+    budget_timer.start();
+
+    delay_timer = new QTimer(this);
+    delay_timer->setSingleShot(true);
+
+    connect(
+        delay_timer, &QTimer::timeout,
+        this, &ObjectPrefetcher::start_next);
+}
+
+void ObjectPrefetcher::prefetch_children(const QModelIndex &parent, const QString &filter, const int depth) {
+    const bool prefetch_ON = settings_get_bool(SETTING_prefetch);
+
+    // NOTE: in dev mode fetch() loads extra objects which
+    // prefetch doesn't know about, so leave everything to
+    // fetch()
+    const bool dev_mode = settings_get_bool(SETTING_dev_mode);
+
+    if (!prefetch_ON || dev_mode || !parent.isValid()) {
+        return;
+    }
+
+    const int depth_max = settings_get_variant(SETTING_prefetch_depth, PREFETCH_DEPTH_DEFAULT).toInt();
+    if (depth > depth_max) {
+        return;
+    }
+
+    QList<ObjectPrefetchEntry> new_list;
+
+    QStandardItem *parent_item = console->get_item(parent);
+    for (int row = 0; row < parent_item->rowCount(); row++) {
+        const QModelIndex index = parent_item->child(row, 0)->index();
+
+        if (!can_prefetch(index)) {
+            continue;
+        }
+
+        ObjectPrefetchEntry entry;
+        entry.index = index;
+        entry.filter = filter;
+        entry.depth = depth;
+        entry.discard = false;
+
+        new_list.append(entry);
+    }
+
+    // Remove containers that are already queued, they will
+    // be requeued in new position
+    for (const ObjectPrefetchEntry &new_entry : new_list) {
+        for (int i = pending_list.size() - 1; i >= 0; i--) {
+            if (pending_list[i].index == new_entry.index) {
+                pending_list.removeAt(i);
+            }
+        }
+    }
+
+    // NOTE: children of a container that user just visited
+    // are the most likely to be visited next, so they go
+    // first. Deeper levels go after everything else.
+    if (depth == 1) {
+        pending_list = new_list + pending_list;
+    } else {
+        pending_list += new_list;
+    }
+
+    while (pending_list.size() > PENDING_MAX) {
+        pending_list.removeLast();
+    }
+
+    start_next();
+}
+
+void ObjectPrefetcher::clear() {
+    pending_list.clear();
+    delay_timer->stop();
+
+    if (current_request != nullptr) {
+        current_entry.discard = true;
+        current_request->cancel();
+    }
+}
+
+void ObjectPrefetcher::start_next() {
+    if (current_request != nullptr) {
+        return;
+    }
+
+    if (budget_timer.elapsed() >= BUDGET_PERIOD_MS) {
+        budget_timer.restart();
+        budget_used = 0;
+    }
+
+    // Wait until next period if used up the budget
+    const int budget = settings_get_variant(SETTING_prefetch_objects_per_minute, PREFETCH_OBJECTS_PER_MINUTE_DEFAULT).toInt();
+    if (budget_used >= budget) {
+        if (!pending_list.isEmpty() && !delay_timer->isActive()) {
+            delay_timer->start(BUDGET_PERIOD_MS - budget_timer.elapsed());
+        }
+
+        return;
+    }
+
+    while (!pending_list.isEmpty()) {
+        const ObjectPrefetchEntry entry = pending_list.takeFirst();
+
+        // NOTE: container might have been fetched normally
+        // or removed since it was queued
+        if (!can_prefetch(entry.index)) {
+            continue;
+        }
+
+        current_entry = entry;
+
+        const QString base = entry.index.data(ObjectRole_DN).toString();
+        const QList<QString> attributes = console_object_search_attributes();
+
+        // NOTE: owner is the item, same as for normal
+        // fetch, so if user gets to this container before
+        // prefetch is done, normal fetch cancels prefetch
+        QStandardItem *item = console->get_item(entry.index);
+
+        current_request = new SearchRequest(base, SearchScope_Children, entry.filter, attributes, item, SearchPriority_Background);
+
+        connect(
+            current_request, &SearchRequest::results_ready,
+            this, &ObjectPrefetcher::on_results);
+        connect(
+            current_request, &SearchRequest::finished,
+            this, &ObjectPrefetcher::on_finished);
+
+        // NOTE: stop prefetching a container that was
+        // deleted. Request is deleted later after it
+        // finishes, so check that it's still current.
+        SearchRequest *request = current_request;
+        connect(
+            item->model(), &QAbstractItemModel::rowsRemoved,
+            request,
+            [this, request]() {
+                if (current_request == request && !current_entry.index.isValid()) {
+                    current_entry.discard = true;
+                    current_request->cancel();
+                }
+            });
+
+        SearchScheduler::instance()->submit(current_request);
+
+        return;
+    }
+}
+
+void ObjectPrefetcher::on_results(const QHash<QString, AdObject> &results) {
+    budget_used += results.size();
+
+    if (current_entry.discard) {
+        return;
+    }
+
+    for (const QString &dn : results.keys()) {
+        current_entry.results.insert(dn, results[dn]);
+    }
+
+    // NOTE: container doesn't fit into one page, so leave
+    // it to normal fetch, which may also decide to use vlv
+    // for it
+    const int page_size = settings_get_variant(SETTING_prefetch_page_size, PREFETCH_PAGE_SIZE_DEFAULT).toInt();
+    if (current_entry.results.size() > page_size) {
+        current_entry.discard = true;
+        current_entry.results.clear();
+        current_request->cancel();
+    }
+}
+
+void ObjectPrefetcher::on_finished() {
+    current_request = nullptr;
+
+    const ObjectPrefetchEntry entry = current_entry;
+    current_entry.results.clear();
+
+    // NOTE: if normal fetch cancelled this prefetch, then
+    // container is already fetched and can_prefetch()
+    // fails
+    const bool should_load = (!entry.discard && can_prefetch(entry.index));
+
+    if (should_load) {
+        QStandardItem *item = console->get_item(entry.index);
+
+        console_item_set_was_fetched(item, true);
+        item->setData(false, ObjectRole_UsesVlv);
+
+        object_impl_add_objects_to_console(console, entry.results.values(), entry.index);
+
+        prefetch_children(entry.index, entry.filter, entry.depth + 1);
+    }
+
+    start_next();
+}
+
+bool ObjectPrefetcher::can_prefetch(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return false;
+    }
+
+    const bool is_object = (console_item_get_type(index) == ItemType_Object);
+    const bool was_fetched = console_item_get_was_fetched(index);
+    const bool is_fetching = index.data(ObjectRole_Fetching).toBool();
+
+    if (!is_object || was_fetched || is_fetching) {
+        return false;
+    }
+
+    const QList<QString> object_classes = index.data(ObjectRole_ObjectClasses).toStringList();
+    if (object_classes.isEmpty()) {
+        return false;
+    }
+
+    const QList<QString> filter_containers = g_adconfig->get_filter_containers();
+    const bool is_container = filter_containers.contains(object_classes.last());
+
+    return is_container;
+}
@@ -0,0 +1,90 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_PREFETCHER_H
+#define OBJECT_PREFETCHER_H
+
+/**
+ * Loads children of containers before user gets to them.
+ * After a container is fetched or selected, it's child
+ * containers are queued for prefetching. Children of most
+ * recently visited containers go first. Prefetching runs
+ * one background search at a time and only loads
+ * containers that fit into one page, bigger containers are
+ * left for a normal fetch. Prefetched containers are
+ * marked as fetched, so selecting or expanding them is
+ * instant. Depth, page size and number of objects loaded
+ * per minute are limited by settings. Prefetching is off
+ * by default.
+ */
+
+#include "adldap.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPersistentModelIndex>
+
+class ConsoleWidget;
+class SearchRequest;
+class QTimer;
+
+class ObjectPrefetchEntry final {
+public:
+    QPersistentModelIndex index;
+    QString filter;
+    int depth;
+    QHash<QString, AdObject> results;
+    bool discard;
+};
+
+class ObjectPrefetcher final : public QObject {
+    Q_OBJECT
+
+public:
+    ObjectPrefetcher(ConsoleWidget *console, QObject *parent);
+
+    // Queues child containers of given container. "depth"
+    // is the depth of children relative to container that
+    // user visited.
+    void prefetch_children(const QModelIndex &parent, const QString &filter, const int depth = 1);
+
+    // Drops queued containers and stops current prefetch.
+    // Call this when filter or other settings that affect
+    // loaded objects change.
+    void clear();
+
+private:
+    ConsoleWidget *console;
+    QList<ObjectPrefetchEntry> pending_list;
+    SearchRequest *current_request;
+    ObjectPrefetchEntry current_entry;
+    QTimer *delay_timer;
+    QElapsedTimer budget_timer;
+    int budget_used;
+
+    void start_next();
+    void on_results(const QHash<QString, AdObject> &results);
+    void on_finished();
+    bool can_prefetch(const QModelIndex &index) const;
+};
+
+#endif /* OBJECT_PREFETCHER_H */
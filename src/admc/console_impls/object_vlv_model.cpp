@@ -0,0 +1,389 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "console_impls/object_vlv_model.h"
+
+#include "adldap.h"
+#include "console_impls/item_type.h"
+#include "console_impls/object_impl.h"
+#include "console_impls/object_vlv_window_thread.h"
+#include "globals.h"
+#include "status.h"
+#include "utils.h"
+
+#include <QStandardItem>
+
+// Number of rows requested at once. Should be bigger than
+// the number of rows that fit on screen, so that one or
+// two windows are enough to display the view.
+#define WINDOW_SIZE 100
+
+// Max number of windows kept loaded. Oldest windows are
+// dropped first and requested again if they are displayed.
+#define WINDOW_COUNT_MAX 20
+
+ObjectVlvModel::ObjectVlvModel(const QString &base, const QString &filter_arg, QObject *parent)
+: QAbstractTableModel(parent) {
+    m_base = base;
+    filter = filter_arg;
+    sort_column = 0;
+    sort_order = Qt::AscendingOrder;
+    window_size = WINDOW_SIZE;
+    total_count = 0;
+    header_labels = object_impl_column_labels();
+    context = new AdVlvContext();
+    window_thread_running = false;
+    generation = 0;
+    sort_revert_pending = false;
+    prev_sort_column = 0;
+    prev_sort_order = Qt::AscendingOrder;
+}
+
+ObjectVlvModel::~ObjectVlvModel() {
+    clear_windows();
+
+    // NOTE: if a window thread is running, it still owns
+    // the context and will delete it
+    delete context;
+}
+
+QString ObjectVlvModel::base() const {
+    return m_base;
+}
+
+void ObjectVlvModel::load() {
+    reset(0);
+
+    // NOTE: there are no rows yet, so views won't request
+    // any windows. Request first one explicitly to get the
+    // total count.
+    request_window(0);
+}
+
+void ObjectVlvModel::load_count(const int count) {
+    reset(count);
+}
+
+void ObjectVlvModel::reload() {
+    clear_windows();
+
+    // NOTE: signal views that all rows changed, views will
+    // then request windows for rows that are displayed
+    if (total_count > 0) {
+        emit dataChanged(index(0, 0), index(total_count - 1, columnCount() - 1));
+    }
+}
+
+void ObjectVlvModel::set_window_size(const int size) {
+    if (size <= 0 || size == window_size) {
+        return;
+    }
+
+    window_size = size;
+
+    reload();
+}
+
+int ObjectVlvModel::loaded_window_count() const {
+    return window_map.size();
+}
+
+int ObjectVlvModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return total_count;
+}
+
+int ObjectVlvModel::columnCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return header_labels.size();
+}
+
+QVariant ObjectVlvModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const int window = index.row() / window_size;
+    const int row_in_window = index.row() % window_size;
+
+    auto window_it = window_map.constFind(window);
+    if (window_it == window_map.constEnd()) {
+        request_window(window);
+
+        return QVariant();
+    }
+
+    const QList<QList<QStandardItem *>> &row_list = window_it.value();
+
+    // NOTE: window may contain less rows than expected if
+    // objects were deleted since total count was received
+    if (row_in_window >= row_list.size()) {
+        return QVariant();
+    }
+
+    const QList<QStandardItem *> &row = row_list[row_in_window];
+    if (index.column() >= row.size()) {
+        return QVariant();
+    }
+
+    QStandardItem *item = row[index.column()];
+
+    return item->data(role);
+}
+
+QVariant ObjectVlvModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    return header_labels.value(section);
+}
+
+void ObjectVlvModel::sort(int column, Qt::SortOrder order) {
+    const bool sort_changed = (column != sort_column || order != sort_order);
+    const bool column_is_valid = (column >= 0 && column < columnCount());
+    if (!sort_changed || !column_is_valid) {
+        return;
+    }
+
+    // NOTE: server may refuse to sort by some attributes,
+    // for example if attribute is not indexed and sorting
+    // it would take too much memory on the server. Whether
+    // sort succeeded is only known when the first window
+    // arrives, so remember previous sort to go back to it.
+    if (!sort_revert_pending) {
+        prev_sort_column = sort_column;
+        prev_sort_order = sort_order;
+    }
+    sort_revert_pending = true;
+
+    sort_column = column;
+    sort_order = order;
+
+    reset(total_count);
+    request_window(0);
+}
+
+void ObjectVlvModel::reset(const int count) {
+    beginResetModel();
+
+    clear_windows();
+
+    // NOTE: context is specific to sort order, so start
+    // from a new one. If a window thread is running, it
+    // owns the old context and deletes it.
+    delete context;
+    context = new AdVlvContext();
+
+    total_count = count;
+
+    endResetModel();
+}
+
+void ObjectVlvModel::request_window(const int window) const {
+    if (requested_window_set.contains(window)) {
+        return;
+    }
+
+    requested_window_set.insert(window);
+    pending_window_list.append(window);
+
+    // NOTE: this is called from data() while views are
+    // painting. Starting a thread doesn't change the model,
+    // rows are changed later when thread's results arrive.
+    auto this_model = const_cast<ObjectVlvModel *>(this);
+    this_model->start_next_window();
+}
+
+void ObjectVlvModel::start_next_window() {
+    // NOTE: windows are loaded one at a time, because all
+    // requests share the context and server keeps the
+    // sorted result set for that context
+    if (window_thread_running) {
+        return;
+    }
+
+    while (!pending_window_list.isEmpty()) {
+        const int window = pending_window_list.takeFirst();
+
+        // NOTE: window might have been dropped by reload or
+        // sort before it was loaded
+        const bool still_requested = (requested_window_set.contains(window) && !window_map.contains(window));
+        if (!still_requested) {
+            continue;
+        }
+
+        const QString sort_attribute = g_adconfig->get_columns().value(sort_column);
+        const bool sort_descending = (sort_order == Qt::DescendingOrder);
+
+        auto thread = new ObjectVlvWindowThread(m_base, filter, sort_attribute, sort_descending, window, window_size, context);
+        context = nullptr;
+        window_thread_running = true;
+
+        const int request_generation = generation;
+
+        connect(
+            thread, &ObjectVlvWindowThread::window_ready,
+            this,
+            [this, thread, request_generation](const bool success) {
+                on_window_ready(thread, request_generation, success);
+            });
+
+        thread->start();
+
+        return;
+    }
+}
+
+void ObjectVlvModel::on_window_ready(ObjectVlvWindowThread *thread, const int request_generation, const bool success) {
+    window_thread_running = false;
+
+    if (request_generation != generation) {
+        // NOTE: rows were dropped while thread was running,
+        // so results might be outdated. Context is still
+        // usable if model didn't start a new one.
+        if (context == nullptr) {
+            context = thread->take_context();
+        }
+
+        start_next_window();
+
+        return;
+    }
+
+    context = thread->take_context();
+
+    const QList<AdMessage> messages = thread->get_messages();
+    for (const AdMessage &message : messages) {
+        if (message.type() == AdMessageType_Error) {
+            g_status()->add_message(message.text(), StatusType_Error);
+        }
+    }
+
+    if (success) {
+        sort_revert_pending = false;
+
+        add_window(thread->get_window(), thread->get_results());
+    } else if (sort_revert_pending) {
+        const QString column_name = header_labels.value(sort_column);
+        const QString error_text = tr("Failed to sort objects by \"%1\".").arg(column_name);
+        g_status()->add_message(error_text, StatusType_Error);
+
+        sort_revert_pending = false;
+        sort_column = prev_sort_column;
+        sort_order = prev_sort_order;
+
+        reset(total_count);
+        request_window(0);
+    }
+
+    // NOTE: on failure, window stays in requested set so
+    // that views don't request it again in a loop
+
+    start_next_window();
+}
+
+void ObjectVlvModel::add_window(const int window, const QList<AdObject> &results) {
+    const bool still_requested = (requested_window_set.contains(window) && !window_map.contains(window));
+    if (!still_requested) {
+        return;
+    }
+
+    QList<QList<QStandardItem *>> row_list;
+
+    for (const AdObject &object : results) {
+        QList<QStandardItem *> row;
+
+        for (int i = 0; i < columnCount(); i++) {
+            auto item = new QStandardItem();
+            item->setData(ItemType_Object, ConsoleRole_Type);
+
+            row.append(item);
+        }
+
+        console_object_load(row, object);
+
+        row_list.append(row);
+    }
+
+    window_map[window] = row_list;
+    window_queue.append(window);
+
+    while (window_queue.size() > WINDOW_COUNT_MAX) {
+        const int oldest_window = window_queue.first();
+        drop_window(oldest_window);
+    }
+
+    const int new_total_count = context->total_count();
+
+    if (new_total_count != total_count) {
+        // NOTE: objects were added or removed since
+        // previous window was loaded. Positions of rows in
+        // other windows are now wrong, so keep only the
+        // window that was just loaded.
+        beginResetModel();
+
+        const QList<int> other_windows = window_queue.mid(0, window_queue.size() - 1);
+        for (const int other_window : other_windows) {
+            drop_window(other_window);
+        }
+
+        total_count = new_total_count;
+
+        endResetModel();
+    } else {
+        const int first_row = window * window_size;
+        const int last_row = qMin(first_row + window_size, total_count) - 1;
+
+        if (first_row <= last_row) {
+            emit dataChanged(index(first_row, 0), index(last_row, columnCount() - 1));
+        }
+    }
+}
+
+void ObjectVlvModel::drop_window(const int window) {
+    const QList<QList<QStandardItem *>> row_list = window_map.take(window);
+    for (const QList<QStandardItem *> &row : row_list) {
+        qDeleteAll(row);
+    }
+
+    window_queue.removeAll(window);
+    requested_window_set.remove(window);
+}
+
+void ObjectVlvModel::clear_windows() {
+    const QList<int> window_list = window_map.keys();
+    for (const int window : window_list) {
+        drop_window(window);
+    }
+
+    requested_window_set.clear();
+    pending_window_list.clear();
+
+    // NOTE: discard results of requests that are in
+    // progress, they might be outdated
+    generation++;
+}
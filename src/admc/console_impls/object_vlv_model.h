@@ -0,0 +1,127 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_VLV_MODEL_H
+#define OBJECT_VLV_MODEL_H
+
+/**
+ * Model for children of huge containers. Instead of loading
+ * all children at once, rows are loaded in small windows
+ * when they are displayed, using server-side sort and
+ * virtual list view. Sorting is also done by the server,
+ * changing sort column or order drops loaded rows and
+ * requests new windows. Windows are loaded one at a time
+ * by ObjectVlvWindowThread, rows are empty until their
+ * window arrives. Rows contain the same data as object
+ * items in console, so indexes of this model can be passed
+ * to ObjectImpl f-ns.
+ */
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSet>
+
+class AdObject;
+class AdVlvContext;
+class ObjectVlvWindowThread;
+class QStandardItem;
+
+class ObjectVlvModel final : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    ObjectVlvModel(const QString &base, const QString &filter, QObject *parent);
+    ~ObjectVlvModel();
+
+    QString base() const;
+
+    // Requests the first window, which also determines the
+    // total count of rows. Rows are added when the window
+    // arrives.
+    void load();
+
+    // Sets total count of rows to a count that is already
+    // known, for example from ObjectCountThread, without
+    // making any requests. Windows are requested when rows
+    // are displayed, which also corrects the count if it
+    // has changed since.
+    void load_count(const int count);
+
+    // Drops loaded rows, they will be requested again when
+    // displayed. Call this after objects were modified.
+    void reload();
+
+    // Changes number of rows requested at once and drops
+    // loaded rows. Default size is suitable for console,
+    // other sizes are mostly useful for testing.
+    void set_window_size(const int size);
+
+    int loaded_window_count() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    QString m_base;
+    QString filter;
+    int sort_column;
+    Qt::SortOrder sort_order;
+    int window_size;
+    int total_count;
+    QList<QString> header_labels;
+
+    // NOTE: context is null while a window thread is
+    // running, because thread owns it for the duration of
+    // the request
+    AdVlvContext *context;
+    bool window_thread_running;
+
+    // Incremented when loaded rows are dropped, results of
+    // requests made before that are discarded
+    int generation;
+
+    // Sort to go back to if server refuses to sort by
+    // current column
+    bool sort_revert_pending;
+    int prev_sort_column;
+    Qt::SortOrder prev_sort_order;
+
+    // Loaded windows, each window contains rows of items
+    QHash<int, QList<QList<QStandardItem *>>> window_map;
+    // Windows in order of loading, for dropping the oldest
+    QList<int> window_queue;
+    // NOTE: mutable because windows are requested from
+    // data(), which is const
+    mutable QSet<int> requested_window_set;
+    mutable QList<int> pending_window_list;
+
+    void reset(const int count);
+    void request_window(const int window) const;
+    void start_next_window();
+    void on_window_ready(ObjectVlvWindowThread *thread, const int request_generation, const bool success);
+    void add_window(const int window, const QList<AdObject> &results);
+    void drop_window(const int window);
+    void clear_windows();
+};
+
+#endif /* OBJECT_VLV_MODEL_H */
@@ -0,0 +1,88 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "console_impls/object_vlv_window_thread.h"
+
+#include "adldap.h"
+#include "console_impls/object_impl.h"
+
+ObjectVlvWindowThread::ObjectVlvWindowThread(const QString &base_arg, const QString &filter_arg, const QString &sort_attribute_arg, const bool sort_descending_arg, const int window_arg, const int window_size_arg, AdVlvContext *context_arg) {
+    base = base_arg;
+    filter = filter_arg;
+    sort_attribute = sort_attribute_arg;
+    sort_descending = sort_descending_arg;
+    window = window_arg;
+    window_size = window_size_arg;
+    context = context_arg;
+
+    // NOTE: get attributes in ctor, so that thread itself
+    // doesn't touch console's globals
+    attributes = console_object_search_attributes();
+
+    connect(
+        this, &ObjectVlvWindowThread::finished,
+        this, &QObject::deleteLater);
+}
+
+ObjectVlvWindowThread::~ObjectVlvWindowThread() {
+    delete context;
+}
+
+int ObjectVlvWindowThread::get_window() const {
+    return window;
+}
+
+QList<AdObject> ObjectVlvWindowThread::get_results() const {
+    return results;
+}
+
+QList<AdMessage> ObjectVlvWindowThread::get_messages() const {
+    return messages;
+}
+
+AdVlvContext *ObjectVlvWindowThread::take_context() {
+    AdVlvContext *out = context;
+    context = nullptr;
+
+    return out;
+}
+
+void ObjectVlvWindowThread::run() {
+    AdInterface ad;
+    if (!ad.is_connected()) {
+        messages = ad.messages();
+
+        emit window_ready(false);
+
+        return;
+    }
+
+    // NOTE: console doesn't display large multi-valued
+    // attributes, so there's no need to load all of their
+    // values
+    ad.set_range_limit(1);
+
+    const int offset = window * window_size;
+    const bool success = ad.search_vlv(base, SearchScope_Children, filter, attributes, sort_attribute, sort_descending, offset, window_size, &results, context);
+
+    messages = ad.messages();
+
+    emit window_ready(success);
+}
@@ -0,0 +1,75 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_VLV_WINDOW_THREAD_H
+#define OBJECT_VLV_WINDOW_THREAD_H
+
+/**
+ * A thread that loads one window of rows for
+ * ObjectVlvModel, so that scrolling through huge
+ * containers doesn't block the UI while the server sorts
+ * children. Thread takes ownership of the VLV context for
+ * the duration of the request, because context is updated
+ * by each request. window_ready() is emitted exactly once,
+ * after that the model should take back the context using
+ * take_context(), otherwise the context is deleted
+ * together with the thread. ObjectVlvWindowThread deletes
+ * itself when it's finished.
+ */
+
+#include <QList>
+#include <QThread>
+
+#include "ad_interface.h"
+
+class AdObject;
+class AdVlvContext;
+
+class ObjectVlvWindowThread final : public QThread {
+    Q_OBJECT
+
+public:
+    ObjectVlvWindowThread(const QString &base, const QString &filter, const QString &sort_attribute, const bool sort_descending, const int window, const int window_size, AdVlvContext *context);
+    ~ObjectVlvWindowThread();
+
+    int get_window() const;
+    QList<AdObject> get_results() const;
+    QList<AdMessage> get_messages() const;
+    AdVlvContext *take_context();
+
+signals:
+    void window_ready(const bool success);
+
+private:
+    QString base;
+    QString filter;
+    QString sort_attribute;
+    bool sort_descending;
+    int window;
+    int window_size;
+    QList<QString> attributes;
+    AdVlvContext *context;
+    QList<AdObject> results;
+    QList<AdMessage> messages;
+
+    void run() override;
+};
+
+#endif /* OBJECT_VLV_WINDOW_THREAD_H */
@@ -117,6 +117,15 @@ QList<int> PolicyRootImpl::default_columns() const {
 // NOTE: not adding policy object to the domain
 // tree, but i think it's ok?
 void PolicyRootImpl::on_dialog_created_policy(const QString &dn) {
+    // NOTE: use object returned by create through
+    // post-read, if server supports it
+    const AdObject created_object = create_policy_dialog->get_created_object();
+    if (!created_object.get_dn().isEmpty()) {
+        create_policy_in_console(created_object);
+
+        return;
+    }
+
     AdInterface ad;
     if (ad_failed(ad)) {
         return;
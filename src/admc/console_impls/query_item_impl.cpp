@@ -24,6 +24,7 @@
 #include "console_impls/object_impl.h"
 #include "console_impls/query_folder_impl.h"
 #include "globals.h"
+#include "search_scheduler.h"
 #include "settings.h"
 #include "utils.h"
 #include "create_query_item_dialog.h"
@@ -88,6 +89,10 @@ QString QueryItemImpl::get_description(const QModelIndex &index) const {
     return object_count_text;
 }
 
+void QueryItemImpl::selected_as_scope(const QModelIndex &index) {
+    SearchScheduler::instance()->set_current_owner(console->get_item(index));
+}
+
 QList<QAction *> QueryItemImpl::get_all_custom_actions() const {
     QList<QAction *> out;
 
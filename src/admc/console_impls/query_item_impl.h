@@ -50,6 +50,7 @@ public:
 
     void fetch(const QModelIndex &index) override;
     QString get_description(const QModelIndex &index) const override;
+    void selected_as_scope(const QModelIndex &index) override;
 
     QList<QAction *> get_all_custom_actions() const override;
     QSet<QAction *> get_custom_actions(const QModelIndex &index, const bool single_selection) const override;
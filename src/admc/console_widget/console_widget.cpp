@@ -1166,6 +1166,10 @@ bool console_item_get_was_fetched(const QModelIndex &index) {
     return was_fetched;
 }
 
+void console_item_set_was_fetched(QStandardItem *item, const bool was_fetched) {
+    item->setData(was_fetched, ConsoleRole_WasFetched);
+}
+
 QString results_state_name(const int type) {
     return QString("RESULTS_STATE_%1").arg(type);
 }
@@ -172,5 +172,8 @@ private:
 
 int console_item_get_type(const QModelIndex &index);
 bool console_item_get_was_fetched(const QModelIndex &index);
+// Use this to mark an item as fetched if it's children
+// were loaded without a fetch() call
+void console_item_set_was_fetched(QStandardItem *item, const bool was_fetched);
 
 #endif /* CONSOLE_WIDGET_H */
@@ -21,6 +21,7 @@
 #include "console_widget/results_view.h"
 
 #include <QHeaderView>
+#include <QItemSelectionModel>
 #include <QListView>
 #include <QSortFilterProxyModel>
 #include <QStackedWidget>
@@ -51,6 +52,8 @@ ResultsView::ResultsView(QWidget *parent)
     proxy_model = new QSortFilterProxyModel(this);
     proxy_model->setSortCaseSensitivity(Qt::CaseInsensitive);
 
+    m_direct_model = nullptr;
+
     // Perform common setup on child views
     for (auto view : views.values()) {
         view->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -84,6 +87,12 @@ ResultsView::ResultsView(QWidget *parent)
         connect(
             view, &QTreeView::activated,
             [=](const QModelIndex &proxy_index) {
+                if (m_direct_model != nullptr) {
+                    emit activated(proxy_index);
+
+                    return;
+                }
+
                 const QModelIndex &source_index = proxy_model->mapToSource(proxy_index);
 
                 emit activated(source_index);
@@ -101,12 +110,61 @@ void ResultsView::set_model(QAbstractItemModel *model) {
 }
 
 void ResultsView::set_parent(const QModelIndex &source_index) {
+    source_parent = source_index;
+
+    if (m_direct_model != nullptr) {
+        return;
+    }
+
     const QModelIndex proxy_index = proxy_model->mapFromSource(source_index);
     for (auto view : views.values()) {
         view->setRootIndex(proxy_index);
     }
 }
 
+void ResultsView::set_direct_model(QAbstractItemModel *model) {
+    if (model == m_direct_model) {
+        return;
+    }
+
+    m_direct_model = model;
+
+    QAbstractItemModel *view_model = [&]() -> QAbstractItemModel * {
+        if (model != nullptr) {
+            return model;
+        } else {
+            return proxy_model;
+        }
+    }();
+
+    // NOTE: changing model resets header sections, so save
+    // and restore header state to keep hidden columns and
+    // sorting
+    const QByteArray header_state = m_detail_view->header()->saveState();
+
+    for (auto view : views.values()) {
+        // NOTE: view doesn't delete it's previous
+        // selection model when model is replaced
+        QItemSelectionModel *old_selection_model = view->selectionModel();
+        view->setModel(view_model);
+        delete old_selection_model;
+    }
+
+    m_detail_view->header()->restoreState(header_state);
+
+    if (model == nullptr) {
+        set_parent(source_parent);
+    }
+
+    // NOTE: direct models are not console models, so
+    // console can't handle drag and drop for them
+    set_drag_drop_enabled(drag_drop_enabled);
+}
+
+QAbstractItemModel *ResultsView::direct_model() const {
+    return m_direct_model;
+}
+
 void ResultsView::set_view_type(const ResultsViewType type) {
     QAbstractItemView *view = views[type];
 
@@ -146,6 +204,10 @@ QList<QModelIndex> ResultsView::get_selected_indexes() const {
         }
     }();
 
+    if (m_direct_model != nullptr) {
+        return proxy_indexes;
+    }
+
     // NOTE: need to map from proxy to source indexes if
     // focused view is results
     QList<QModelIndex> source_indexes;
@@ -187,8 +249,10 @@ void ResultsView::restore_state(const QVariant &state_variant, const QList<int>
 }
 
 void ResultsView::set_drag_drop_enabled(const bool enabled) {
+    drag_drop_enabled = enabled;
+
     const QAbstractItemView::DragDropMode mode = [&]() {
-        if (enabled) {
+        if (enabled && m_direct_model == nullptr) {
             return QAbstractItemView::DragDrop;
         } else {
             return QAbstractItemView::NoDragDrop;
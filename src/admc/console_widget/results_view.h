@@ -28,6 +28,7 @@
  * switch between views.
  */
 
+#include <QPersistentModelIndex>
 #include <QWidget>
 
 class QTreeView;
@@ -51,6 +52,18 @@ public:
 
     void set_model(QAbstractItemModel *model);
     void set_parent(const QModelIndex &source_index);
+
+    // Displays a different model instead of the one set by
+    // set_model(). Pass nullptr to switch back. The model
+    // is connected to views directly, without the sorting
+    // proxy, so it must implement sort() itself. This is
+    // for models that load rows lazily and can't afford
+    // the proxy requesting data for all rows. Root index
+    // set by set_parent() is ignored while direct model is
+    // displayed.
+    void set_direct_model(QAbstractItemModel *model);
+    QAbstractItemModel *direct_model() const;
+
     void set_view_type(const ResultsViewType type);
     QAbstractItemView *current_view() const;
     ResultsViewType current_view_type() const;
@@ -77,6 +90,9 @@ private:
     QStackedWidget *stacked_widget;
     QHash<ResultsViewType, QAbstractItemView *> views;
     QSortFilterProxyModel *proxy_model;
+    QAbstractItemModel *m_direct_model;
+    QPersistentModelIndex source_parent;
+    bool drag_drop_enabled;
     ResultsViewType m_current_view_type;
     QTreeView *m_detail_view;
 };
@@ -21,6 +21,7 @@
 #include "create_dialog.h"
 
 #include "adldap.h"
+#include "console_impls/object_impl.h"
 #include "edits/attribute_edit.h"
 #include "globals.h"
 #include "status.h"
@@ -59,6 +60,10 @@ QString CreateDialog::get_created_dn() const {
     return dn;
 }
 
+AdObject CreateDialog::get_created_object() const {
+    return created_object;
+}
+
 void CreateDialog::set_parent_dn(const QString &dn) {
     parent_dn = dn;
 }
@@ -91,11 +96,26 @@ void CreateDialog::accept() {
         g_status()->add_message(message, StatusType_Error);
     };
 
-    const bool add_success = ad.object_add(dn, m_object_class);
+    // NOTE: request created object from add and following
+    // modification, so that console doesn't need to read
+    // it
+    const QList<QString> post_read_attributes = console_object_search_attributes();
+    created_object = AdObject();
+
+    const bool add_success = ad.object_add(dn, m_object_class, post_read_attributes, &created_object);
 
     bool final_success = false;
     if (add_success) {
-        const bool apply_success = edits_apply(ad, m_edit_list, dn, true);
+        AdChangeSet changes;
+        QList<AttributeEdit *> changed_edits;
+        bool apply_success = edits_apply_with_changes(ad, m_edit_list, dn, &changes, &changed_edits, true);
+
+        const bool changes_success = ad.object_modify(dn, changes, DoStatusMsg_Yes, post_read_attributes, &created_object);
+        if (changes_success) {
+            edits_reset_modified(changed_edits);
+        } else {
+            apply_success = false;
+        }
 
         if (apply_success) {
             final_success = true;
@@ -27,6 +27,7 @@
 
 #include <QDialog>
 
+#include "ad_object.h"
 #include "widget_state.h"
 
 class QLineEdit;
@@ -48,6 +49,11 @@ public:
     void init(QLineEdit *name_edit_arg, QDialogButtonBox *button_box, const QList<AttributeEdit *> &edits_list, const QList<QLineEdit *> &required_list, const QList<QWidget *> &widget_list, const QString &object_class);
 
     QString get_created_dn() const;
+
+    // Returns created object, if server returned it
+    // through post-read. Otherwise returns an empty
+    // object.
+    AdObject get_created_object() const;
     void set_parent_dn(const QString &dn);
     void open() override;
     void accept() override;
@@ -55,6 +61,7 @@ public:
 
 private:
     QString parent_dn;
+    AdObject created_object;
     QLineEdit *name_edit;
     QList<AttributeEdit *> m_edit_list;
     QList<QLineEdit *> m_required_list;
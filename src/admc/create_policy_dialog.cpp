@@ -34,6 +34,10 @@ CreatePolicyDialog::CreatePolicyDialog(QWidget *parent)
     ui->setupUi(this);
 }
 
+AdObject CreatePolicyDialog::get_created_object() const {
+    return created_object;
+}
+
 void CreatePolicyDialog::open() {
     AdInterface ad;
     if (ad_failed(ad)) {
@@ -111,8 +115,10 @@ void CreatePolicyDialog::accept() {
         return;
     }
 
+    created_object = AdObject();
+
     QString created_dn;
-    const bool success = ad.gpo_add(name, created_dn);
+    const bool success = ad.gpo_add(name, created_dn, console_policy_search_attributes(), &created_object);
 
     hide_busy_indicator();
 
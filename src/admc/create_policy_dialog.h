@@ -27,6 +27,8 @@
 
 #include <QDialog>
 
+#include "ad_object.h"
+
 class QLineEdit;
 
 namespace Ui {
@@ -39,6 +41,11 @@ class CreatePolicyDialog : public QDialog {
 public:
     CreatePolicyDialog(QWidget *parent);
 
+    // Returns created GPC object, if server returned it
+    // through post-read. Otherwise returns an empty
+    // object.
+    AdObject get_created_object() const;
+
 signals:
     void created_policy(const QString &dn);
 
@@ -48,6 +55,7 @@ public slots:
 
 private:
     Ui::CreatePolicyDialog *ui;
+    AdObject created_object;
 };
 
 #endif /* CREATE_POLICY_DIALOG_H */
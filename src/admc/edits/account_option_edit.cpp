@@ -42,6 +42,8 @@ AccountOptionEdit::AccountOptionEdit(QCheckBox *check_arg, const AccountOption o
 }
 
 void AccountOptionEdit::load_internal(AdInterface &ad, const AdObject &object) {
+    loaded_object = object;
+
     const bool option_is_set = object.get_account_option(option, g_adconfig);
     check->setChecked(option_is_set);
 }
@@ -52,7 +54,16 @@ void AccountOptionEdit::set_read_only(const bool read_only) {
 
 bool AccountOptionEdit::apply(AdInterface &ad, const QString &dn) const {
     const bool new_value = check->isChecked();
-    const bool success = ad.user_set_account_option(dn, option, new_value);
+
+    // NOTE: pass loaded object so that UAC doesn't need to
+    // be read again
+    const bool success = [&]() {
+        if (loaded_object.get_dn() == dn) {
+            return ad.user_set_account_option(loaded_object, option, new_value);
+        } else {
+            return ad.user_set_account_option(dn, option, new_value);
+        }
+    }();
 
     return success;
 }
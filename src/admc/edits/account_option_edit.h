@@ -24,6 +24,7 @@
 #include "edits/attribute_edit.h"
 
 #include "ad_defines.h"
+#include "ad_object.h"
 
 class QCheckBox;
 class QWidget;
@@ -37,6 +38,7 @@ public:
 private:
     AccountOption option;
     QCheckBox *check;
+    AdObject loaded_object;
 };
 
 void account_option_setup_conflicts(const QHash<AccountOption, QCheckBox *> &check_map);
@@ -22,6 +22,8 @@
 
 #include "tabs/properties_tab.h"
 
+#include "adldap.h"
+
 #include <QDebug>
 
 AttributeEdit::AttributeEdit(QList<AttributeEdit *> *edits_out, QObject *parent)
@@ -51,6 +53,23 @@ bool AttributeEdit::verify(AdInterface &ad, const QString &dn) const {
     return true;
 }
 
+bool AttributeEdit::apply(AdInterface &ad, const QString &dn) const {
+    AdChangeSet changes;
+
+    const bool added = add_changes(&changes);
+    if (!added) {
+        qDebug() << "ERROR: attribute edit implements neither apply() nor add_changes()";
+
+        return false;
+    }
+
+    return ad.object_modify(dn, changes);
+}
+
+bool AttributeEdit::add_changes(AdChangeSet *changes) const {
+    return false;
+}
+
 bool AttributeEdit::modified() const {
     return m_modified;
 }
@@ -73,10 +92,33 @@ bool edits_verify(AdInterface &ad, QList<AttributeEdit *> edits, const QString &
 }
 
 bool edits_apply(AdInterface &ad, QList<AttributeEdit *> edits, const QString &dn, const bool ignore_modified) {
+    AdChangeSet changes;
+    QList<AttributeEdit *> changed_edits;
+
+    bool success = edits_apply_with_changes(ad, edits, dn, &changes, &changed_edits, ignore_modified);
+
+    const bool changes_success = ad.object_modify(dn, changes);
+    if (changes_success) {
+        edits_reset_modified(changed_edits);
+    } else {
+        success = false;
+    }
+
+    return success;
+}
+
+bool edits_apply_with_changes(AdInterface &ad, QList<AttributeEdit *> edits, const QString &dn, AdChangeSet *changes, QList<AttributeEdit *> *changed_out, const bool ignore_modified) {
     bool success = true;
 
     for (auto edit : edits) {
         if (edit->modified() || ignore_modified) {
+            const bool added = edit->add_changes(changes);
+            if (added) {
+                changed_out->append(edit);
+
+                continue;
+            }
+
             const bool apply_success = edit->apply(ad, dn);
             if (apply_success) {
                 edit->reset_modified();
@@ -89,6 +131,12 @@ bool edits_apply(AdInterface &ad, QList<AttributeEdit *> edits, const QString &d
     return success;
 }
 
+void edits_reset_modified(QList<AttributeEdit *> edits) {
+    for (auto edit : edits) {
+        edit->reset_modified();
+    }
+}
+
 void edits_load(QList<AttributeEdit *> edits, AdInterface &ad, const AdObject &object) {
     for (auto edit : edits) {
         edit->load(ad, object);
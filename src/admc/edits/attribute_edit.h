@@ -33,6 +33,7 @@
 class PropertiesTab;
 class AdInterface;
 class AdObject;
+class AdChangeSet;
 
 class AttributeEdit : public QObject {
     Q_OBJECT
@@ -52,8 +53,17 @@ public:
     virtual bool verify(AdInterface &ad, const QString &dn) const;
 
     // Apply current input by making a modification to the
-    // AD server
-    virtual bool apply(AdInterface &ad, const QString &dn) const = 0;
+    // AD server. Default implementation applies changes
+    // from add_changes().
+    virtual bool apply(AdInterface &ad, const QString &dn) const;
+
+    // Add modifications for current input to the change
+    // set instead of applying them right away, so that
+    // edits of one object can be applied in one request.
+    // Edits that only modify attributes of the object
+    // should implement this instead of apply(). Returns
+    // false if edit doesn't support change sets.
+    virtual bool add_changes(AdChangeSet *changes) const;
 
     // Returns whether edit was edited by user. Rsets on
     // load(). Note that this will be true if user EVER
@@ -84,6 +94,15 @@ protected:                                                                \
                                                                           \
 public:
 
+#define DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS()                            \
+    void set_read_only(const bool read_only) override;                    \
+    bool add_changes(AdChangeSet *changes) const override;                \
+                                                                          \
+protected:                                                                \
+    void load_internal(AdInterface &ad, const AdObject &object) override; \
+                                                                          \
+public:
+
 // Helper f-ns that iterate over edit lists for you
 void edits_connect_to_tab(QList<AttributeEdit *> edits, PropertiesTab *tab);
 
@@ -104,8 +123,20 @@ bool edits_verify(AdInterface &ad, QList<AttributeEdit *> edits, const QString &
 // process stopped on first error, the user would have to
 // apply multiple times while fixing errors to see all of
 // them.
+//
+// Edits that support change sets are applied together in
+// one request.
 bool edits_apply(AdInterface &ad, QList<AttributeEdit *> edits, const QString &dn, const bool ignore_modified = false);
 
+// Same as edits_apply(), but instead of applying the change
+// set, changes are added to given change set. Edits that
+// were added to the change set are returned in
+// "changed_out". Call edits_reset_modified() for them
+// after change set was applied.
+bool edits_apply_with_changes(AdInterface &ad, QList<AttributeEdit *> edits, const QString &dn, AdChangeSet *changes, QList<AttributeEdit *> *changed_out, const bool ignore_modified = false);
+
+void edits_reset_modified(QList<AttributeEdit *> edits);
+
 void edits_load(QList<AttributeEdit *> edits, AdInterface &ad, const AdObject &object);
 
 // NOTE: not all edits might support read-only mode, see
@@ -45,6 +45,8 @@ void CountryEdit::set_read_only(const bool read_only) {
     combo->setEnabled(!read_only);
 }
 
-bool CountryEdit::apply(AdInterface &ad, const QString &dn) const {
-    return country_combo_apply(combo, ad, dn);
+bool CountryEdit::add_changes(AdChangeSet *changes) const {
+    country_combo_add_changes(combo, changes);
+
+    return true;
 }
@@ -29,7 +29,7 @@ class CountryEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     CountryEdit(QComboBox *combo, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QComboBox *combo;
@@ -123,7 +123,7 @@ void country_combo_load(QComboBox *combo, const AdObject &object) {
     }
 }
 
-bool country_combo_apply(const QComboBox *combo, AdInterface &ad, const QString &dn) {
+void country_combo_add_changes(const QComboBox *combo, AdChangeSet *changes) {
     const int code = combo->currentData().toInt();
 
     const bool country_code_is_known = (country_strings.contains(code) && country_abbreviations.contains(code));
@@ -131,17 +131,16 @@ bool country_combo_apply(const QComboBox *combo, AdInterface &ad, const QString
     if (!country_code_is_known) {
         qDebug() << "Unknown country code:" << code;
 
-        return false;
+        return;
     }
 
     const QString code_string = QString::number(code);
     const QString country_string = country_strings[code];
     const QString abbreviation = country_abbreviations[code];
 
-    bool success = true;
-    success = success && ad.attribute_replace_string(dn, ATTRIBUTE_COUNTRY_CODE, code_string);
-    success = success && ad.attribute_replace_string(dn, ATTRIBUTE_COUNTRY_ABBREVIATION, abbreviation);
-    success = success && ad.attribute_replace_string(dn, ATTRIBUTE_COUNTRY, country_string);
-
-    return success;
+    // NOTE: all three attributes are in one change set,
+    // so they are either all changed or none are
+    changes->replace_string(ATTRIBUTE_COUNTRY_CODE, code_string);
+    changes->replace_string(ATTRIBUTE_COUNTRY_ABBREVIATION, abbreviation);
+    changes->replace_string(ATTRIBUTE_COUNTRY, country_string);
 }
@@ -23,12 +23,11 @@
 
 class QComboBox;
 class AdObject;
-class AdInterface;
-class QString;
+class AdChangeSet;
 
 void country_combo_load_data();
 void country_combo_init(QComboBox *combo);
 void country_combo_load(QComboBox *combo, const AdObject &object);
-bool country_combo_apply(const QComboBox *combo, AdInterface &ad, const QString &dn);
+void country_combo_add_changes(const QComboBox *combo, AdChangeSet *changes);
 
 #endif /* COUNTRY_WIDGET_H */
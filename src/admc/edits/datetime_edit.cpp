@@ -51,11 +51,12 @@ void DateTimeEdit::set_read_only(const bool read_only) {
     edit->setDisabled(read_only);
 }
 
-bool DateTimeEdit::apply(AdInterface &ad, const QString &dn) const {
+bool DateTimeEdit::add_changes(AdChangeSet *changes) const {
     const QDateTime datetime_local = edit->dateTime();
     const QDateTime datetime = datetime_local.toUTC();
+    const QString datetime_string = datetime_qdatetime_to_string(attribute, datetime, g_adconfig);
 
-    const bool success = ad.attribute_replace_datetime(dn, attribute, datetime);
+    changes->replace_string(attribute, datetime_string);
 
-    return success;
+    return true;
 }
@@ -31,7 +31,7 @@ class DateTimeEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     DateTimeEdit(QDateTimeEdit *edit, const QString &attribute_arg, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QString attribute;
@@ -39,6 +39,8 @@ DelegationEdit::DelegationEdit(QRadioButton *off_button_arg, QRadioButton *on_bu
 }
 
 void DelegationEdit::load_internal(AdInterface &ad, const AdObject &object) {
+    loaded_object = object;
+
     const bool is_on = object.get_account_option(AccountOption_TrustedForDelegation, g_adconfig);
 
     if (is_on) {
@@ -64,7 +66,15 @@ bool DelegationEdit::apply(AdInterface &ad, const QString &dn) const {
         return false;
     }();
 
-    const bool success = ad.user_set_account_option(dn, AccountOption_TrustedForDelegation, is_on);
+    // NOTE: pass loaded object so that UAC doesn't need to
+    // be read again
+    const bool success = [&]() {
+        if (loaded_object.get_dn() == dn) {
+            return ad.user_set_account_option(loaded_object, AccountOption_TrustedForDelegation, is_on);
+        } else {
+            return ad.user_set_account_option(dn, AccountOption_TrustedForDelegation, is_on);
+        }
+    }();
 
     return success;
 }
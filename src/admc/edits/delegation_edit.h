@@ -23,6 +23,8 @@
 
 #include "edits/attribute_edit.h"
 
+#include "ad_object.h"
+
 class QRadioButton;
 
 class DelegationEdit final : public AttributeEdit {
@@ -34,6 +36,7 @@ public:
 private:
     QRadioButton *off_button;
     QRadioButton *on_button;
+    AdObject loaded_object;
 };
 
 #endif /* DELEGATION_EDIT_H */
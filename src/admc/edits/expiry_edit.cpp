@@ -43,6 +43,8 @@ void ExpiryEdit::set_read_only(const bool read_only) {
     edit_widget->set_read_only(read_only);
 }
 
-bool ExpiryEdit::apply(AdInterface &ad, const QString &dn) const {
-    return edit_widget->apply(ad, dn);
+bool ExpiryEdit::add_changes(AdChangeSet *changes) const {
+    edit_widget->add_changes(changes);
+
+    return true;
 }
@@ -29,7 +29,7 @@ class ExpiryEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     ExpiryEdit(ExpiryWidget *edit_widget, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     ExpiryWidget *edit_widget;
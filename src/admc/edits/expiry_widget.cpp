@@ -90,15 +90,16 @@ void ExpiryWidget::set_read_only(const bool read_only) {
     ui->date_edit->setReadOnly(read_only);
 }
 
-bool ExpiryWidget::apply(AdInterface &ad, const QString &dn) const {
+void ExpiryWidget::add_changes(AdChangeSet *changes) const {
     const bool never = ui->never_check->isChecked();
 
     if (never) {
-        return ad.attribute_replace_string(dn, ATTRIBUTE_ACCOUNT_EXPIRES, AD_LARGE_INTEGER_DATETIME_NEVER_2);
+        changes->replace_string(ATTRIBUTE_ACCOUNT_EXPIRES, AD_LARGE_INTEGER_DATETIME_NEVER_2);
     } else {
         const QDateTime datetime = QDateTime(ui->date_edit->date(), END_OF_DAY, Qt::UTC);
+        const QString datetime_string = datetime_qdatetime_to_string(ATTRIBUTE_ACCOUNT_EXPIRES, datetime, g_adconfig);
 
-        return ad.attribute_replace_datetime(dn, ATTRIBUTE_ACCOUNT_EXPIRES, datetime);
+        changes->replace_string(ATTRIBUTE_ACCOUNT_EXPIRES, datetime_string);
     }
 }
 
@@ -23,7 +23,7 @@
 
 #include <QWidget>
 
-class AdInterface;
+class AdChangeSet;
 class AdObject;
 
 namespace Ui {
@@ -37,7 +37,7 @@ public:
 
     void load(const AdObject &object);
     void set_read_only(const bool read_only);
-    bool apply(AdInterface &ad, const QString &dn) const;
+    void add_changes(AdChangeSet *changes) const;
 
 signals:
     void edited();
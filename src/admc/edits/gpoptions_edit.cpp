@@ -46,7 +46,7 @@ void GpoptionsEdit::set_read_only(const bool read_only) {
     check->setDisabled(read_only);
 }
 
-bool GpoptionsEdit::apply(AdInterface &ad, const QString &dn) const {
+bool GpoptionsEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = [this]() {
         const bool checked = check->isChecked();
         if (checked) {
@@ -55,7 +55,7 @@ bool GpoptionsEdit::apply(AdInterface &ad, const QString &dn) const {
             return GPOPTIONS_INHERIT;
         }
     }();
-    const bool success = ad.attribute_replace_string(dn, ATTRIBUTE_GPOPTIONS, new_value);
+    changes->replace_string(ATTRIBUTE_GPOPTIONS, new_value);
 
-    return success;
+    return true;
 }
@@ -29,7 +29,7 @@ class GpoptionsEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     GpoptionsEdit(QCheckBox *check, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QCheckBox *check;
@@ -45,6 +45,8 @@ GroupScopeEdit::GroupScopeEdit(QComboBox *combo_arg, QList<AttributeEdit *> *edi
 
 
 void GroupScopeEdit::load_internal(AdInterface &ad, const AdObject &object) {
+    loaded_object = object;
+
     const GroupScope scope = object.get_group_scope();
 
     combo->setCurrentIndex((int) scope);
@@ -56,7 +58,16 @@ void GroupScopeEdit::set_read_only(const bool read_only) {
 
 bool GroupScopeEdit::apply(AdInterface &ad, const QString &dn) const {
     const GroupScope new_value = (GroupScope) combo->currentData().toInt();
-    const bool success = ad.group_set_scope(dn, new_value);
+
+    // NOTE: pass loaded object so that group type doesn't
+    // need to be read again
+    const bool success = [&]() {
+        if (loaded_object.get_dn() == dn) {
+            return ad.group_set_scope(loaded_object, new_value);
+        } else {
+            return ad.group_set_scope(dn, new_value);
+        }
+    }();
 
     return success;
 }
@@ -23,6 +23,8 @@
 
 #include "edits/attribute_edit.h"
 
+#include "ad_object.h"
+
 class QComboBox;
 
 class GroupScopeEdit final : public AttributeEdit {
@@ -33,6 +35,7 @@ public:
 
 private:
     QComboBox *combo;
+    AdObject loaded_object;
 };
 
 #endif /* GROUP_SCOPE_EDIT_H */
@@ -43,6 +43,8 @@ GroupTypeEdit::GroupTypeEdit(QComboBox *combo_arg, QList<AttributeEdit *> *edits
 }
 
 void GroupTypeEdit::load_internal(AdInterface &ad, const AdObject &object) {
+    loaded_object = object;
+
     const GroupType type = object.get_group_type();
 
     combo->setCurrentIndex((int) type);
@@ -54,7 +56,16 @@ void GroupTypeEdit::set_read_only(const bool read_only) {
 
 bool GroupTypeEdit::apply(AdInterface &ad, const QString &dn) const {
     const GroupType new_value = (GroupType) combo->currentData().toInt();
-    const bool success = ad.group_set_type(dn, new_value);
+
+    // NOTE: pass loaded object so that group type doesn't
+    // need to be read again
+    const bool success = [&]() {
+        if (loaded_object.get_dn() == dn) {
+            return ad.group_set_type(loaded_object, new_value);
+        } else {
+            return ad.group_set_type(dn, new_value);
+        }
+    }();
 
     return success;
 }
@@ -51,11 +51,11 @@ void LogonComputersEdit::set_read_only(const bool read_only) {
     button->setEnabled(read_only);
 }
 
-bool LogonComputersEdit::apply(AdInterface &ad, const QString &dn) const {
+bool LogonComputersEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = dialog->get();
-    const bool success = ad.attribute_replace_string(dn, ATTRIBUTE_USER_WORKSTATIONS, new_value);
+    changes->replace_string(ATTRIBUTE_USER_WORKSTATIONS, new_value);
 
-    return success;
+    return true;
 }
 
 LogonComputersDialog::LogonComputersDialog(QWidget *parent)
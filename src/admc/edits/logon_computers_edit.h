@@ -30,7 +30,7 @@ class LogonComputersEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     LogonComputersEdit(QPushButton *button, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QPushButton *button;
@@ -60,11 +60,11 @@ void LogonHoursEdit::set_read_only(const bool read_only) {
     button->setEnabled(read_only);
 }
 
-bool LogonHoursEdit::apply(AdInterface &ad, const QString &dn) const {
+bool LogonHoursEdit::add_changes(AdChangeSet *changes) const {
     const QByteArray new_value = dialog->get();
-    const bool success = ad.attribute_replace_value(dn, ATTRIBUTE_LOGON_HOURS, new_value);
+    changes->replace_value(ATTRIBUTE_LOGON_HOURS, new_value);
 
-    return success;
+    return true;
 }
 
 QList<bool> shift_list(const QList<bool> &list, const int shift_amount);
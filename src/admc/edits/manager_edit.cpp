@@ -44,8 +44,10 @@ void ManagerEdit::set_read_only(const bool read_only) {
     widget->setEnabled(!read_only);
 }
 
-bool ManagerEdit::apply(AdInterface &ad, const QString &dn) const {
-    return widget->apply(ad, dn);
+bool ManagerEdit::add_changes(AdChangeSet *changes) const {
+    widget->add_changes(changes);
+
+    return true;
 }
 
 QString ManagerEdit::get_manager() const {
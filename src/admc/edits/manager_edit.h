@@ -37,7 +37,7 @@ class ManagerEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     ManagerEdit(ManagerWidget *widget_arg, const QString &manager_attribute_arg, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
     QString get_manager() const;
 
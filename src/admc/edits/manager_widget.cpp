@@ -52,10 +52,8 @@ void ManagerWidget::load(const AdObject &object) {
     load_value(manager);
 }
 
-bool ManagerWidget::apply(AdInterface &ad, const QString &dn) const {
-    const bool success = ad.attribute_replace_string(dn, manager_attribute, current_value);
-
-    return success;
+void ManagerWidget::add_changes(AdChangeSet *changes) const {
+    changes->replace_string(manager_attribute, current_value);
 }
 
 QString ManagerWidget::get_manager() const {
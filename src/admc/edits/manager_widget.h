@@ -24,7 +24,7 @@
 #include <QWidget>
 
 class AdObject;
-class AdInterface;
+class AdChangeSet;
 
 namespace Ui {
     class ManagerWidget;
@@ -38,7 +38,7 @@ public:
 
     void set_attribute(const QString &attribute);
     void load(const AdObject &object);
-    bool apply(AdInterface &ad, const QString &dn) const;
+    void add_changes(AdChangeSet *changes) const;
 
     QString get_manager() const;
     void reset();
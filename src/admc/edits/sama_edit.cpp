@@ -51,11 +51,11 @@ void SamaEdit::set_read_only(const bool read_only) {
     edit->setDisabled(read_only);
 }
 
-bool SamaEdit::apply(AdInterface &ad, const QString &dn) const {
+bool SamaEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = edit->text();
-    const bool success = ad.attribute_replace_string(dn, ATTRIBUTE_SAMACCOUNT_NAME, new_value);
+    changes->replace_string(ATTRIBUTE_SAMACCOUNT_NAME, new_value);
 
-    return success;
+    return true;
 }
 
 void SamaEdit::load_domain() {
@@ -29,7 +29,7 @@ class SamaEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     SamaEdit(QLineEdit *sama_edit, QLineEdit *domain_edit_arg, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
     void load_domain();
 
@@ -62,9 +62,9 @@ void StringEdit::set_read_only(const bool read_only) {
     edit->setDisabled(read_only);
 }
 
-bool StringEdit::apply(AdInterface &ad, const QString &dn) const {
+bool StringEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = edit->text();
-    const bool success = ad.attribute_replace_string(dn, attribute, new_value);
+    changes->replace_string(attribute, new_value);
 
-    return success;
+    return true;
 }
@@ -29,7 +29,7 @@ class StringEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     StringEdit(QLineEdit *edit_arg, const QString &attribute_arg, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QLineEdit *edit;
@@ -63,9 +63,9 @@ void StringLargeEdit::set_read_only(const bool read_only) {
     edit->setDisabled(read_only);
 }
 
-bool StringLargeEdit::apply(AdInterface &ad, const QString &dn) const {
+bool StringLargeEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = edit->toPlainText();
-    const bool success = ad.attribute_replace_string(dn, attribute, new_value);
+    changes->replace_string(attribute, new_value);
 
-    return success;
+    return true;
 }
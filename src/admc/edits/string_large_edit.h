@@ -34,7 +34,7 @@ class StringLargeEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     StringLargeEdit(QPlainTextEdit *edit, const QString &attribute_arg, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
 private:
     QPlainTextEdit *edit;
@@ -67,9 +67,9 @@ void StringOtherEdit::set_read_only(const bool read_only) {
     other_button->setDisabled(read_only);
 }
 
-bool StringOtherEdit::apply(AdInterface &ad, const QString &dn) const {
-    const bool main_succcess = main_edit->apply(ad, dn);
-    const bool other_success = ad.attribute_replace_values(dn, other_attribute, other_values);
+bool StringOtherEdit::add_changes(AdChangeSet *changes) const {
+    main_edit->add_changes(changes);
+    changes->replace_values(other_attribute, other_values);
 
-    return (main_succcess && other_success);
+    return true;
 }
@@ -70,19 +70,17 @@ bool UpnEdit::verify(AdInterface &ad, const QString &dn) const {
         return false;
     }
 
-    // Check that new upn is unique
+    // Check that new upn is unique in the forest
     // NOTE: filter has to also check that it's not the same object because of attribute edit weirdness. If user edits logon name, then retypes original, then applies, the edit will apply because it was modified by the user, even if the value didn't change. Without "not_object_itself", this check would determine that object's logon name conflicts with itself.
-    const QString base = g_adconfig->domain_head();
-    const SearchScope scope = SearchScope_All;
     const QString filter = [=]() {
         const QString not_object_itself = filter_CONDITION(Condition_NotEquals, ATTRIBUTE_DN, dn);
         const QString same_upn = filter_CONDITION(Condition_Equals, ATTRIBUTE_USER_PRINCIPAL_NAME, new_value);
 
         return filter_AND({same_upn, not_object_itself});
     }();
-    const QList<QString> attributes = QList<QString>();
+    const QList<QString> attributes = {ATTRIBUTE_DN};
 
-    const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+    const QHash<QString, AdObject> results = ad.search_forest(filter, attributes);
 
     const bool upn_not_unique = (results.size() > 0);
 
@@ -96,11 +94,11 @@ bool UpnEdit::verify(AdInterface &ad, const QString &dn) const {
     return true;
 }
 
-bool UpnEdit::apply(AdInterface &ad, const QString &dn) const {
+bool UpnEdit::add_changes(AdChangeSet *changes) const {
     const QString new_value = get_new_value();
-    const bool success = ad.attribute_replace_string(dn, ATTRIBUTE_USER_PRINCIPAL_NAME, new_value);
+    changes->replace_string(ATTRIBUTE_USER_PRINCIPAL_NAME, new_value);
 
-    return success;
+    return true;
 }
 
 QString UpnEdit::get_new_value() const {
@@ -31,7 +31,7 @@ class UpnEdit final : public AttributeEdit {
     Q_OBJECT
 public:
     UpnEdit(QLineEdit *prefix_edit, QComboBox *suffix_combo, QList<AttributeEdit *> *edits_out, QObject *parent);
-    DECL_ATTRIBUTE_EDIT_VIRTUALS();
+    DECL_ATTRIBUTE_EDIT_CHANGES_VIRTUALS();
 
     void init_suffixes(AdInterface &ad);
 
@@ -162,7 +162,8 @@ void FindWidget::find() {
     const QString base = ui->select_base_widget->get_base();
     const QList<QString> search_attributes = console_object_search_attributes();
 
-    auto find_thread = new SearchThread(base, SearchScope_All, filter, search_attributes);
+    // NOTE: finds can be heavy, so spread them over DC's
+    auto find_thread = new SearchThread(base, SearchScope_All, filter, search_attributes, AdRouting_ReadBalanced);
 
     connect(
         find_thread, &SearchThread::results_ready,
@@ -19,6 +19,7 @@
  */
 
 #include "adldap.h"
+#include "change_listener.h"
 #include "config.h"
 #include "globals.h"
 #include "main_window.h"
@@ -37,6 +38,7 @@ int main(int argc, char **argv) {
     // passing this type from thread results in a runtime
     // error.
     qRegisterMetaType<QHash<QString, AdObject>>("QHash<QString, AdObject>");
+    qRegisterMetaType<AdObject>("AdObject");
 
     QApplication app(argc, argv);
     app.setApplicationDisplayName(ADMC_APPLICATION_DISPLAY_NAME);
@@ -77,5 +79,9 @@ int main(int argc, char **argv) {
 
     const int retval = app.exec();
 
+    // NOTE: listener thread has to be stopped while ad
+    // config and connection pool still exist
+    ChangeListener::instance()->stop();
+
     return retval;
 }
@@ -193,6 +193,7 @@ MainWindow::MainWindow()
     settings_connect_action_to_bool_setting(ui->action_last_name_order, SETTING_last_name_before_first_name);
     settings_connect_action_to_bool_setting(ui->action_log_searches, SETTING_log_searches);
     settings_connect_action_to_bool_setting(ui->action_timestamps, SETTING_timestamp_log);
+    settings_connect_action_to_bool_setting(ui->action_prefetch, SETTING_prefetch);
     settings_connect_action_to_bool_setting(action_show_client_user, SETTING_show_client_user);
 
     // NOTE: not using
@@ -422,6 +423,10 @@ void MainWindow::refresh_object_tree() {
 
     show_busy_indicator();
 
+    // NOTE: tree is refreshed after settings change, which
+    // requires reloading all objects
+    object_impl->reset_sync_states();
+
     ui->console->refresh_scope(object_tree_root);
 
     hide_busy_indicator();
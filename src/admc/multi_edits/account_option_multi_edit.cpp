@@ -40,16 +40,19 @@ AccountOptionMultiEdit::AccountOptionMultiEdit(const QHash<AccountOption, QCheck
 // bitmask can be changed at the same time. BUT, do need to
 // do this if want to get separate status messages for each
 // bit.
-bool AccountOptionMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
+// NOTE: account options are applied right away instead of
+// through the change set because they are bits of one
+// attribute that has to be read first. Current value is
+// taken from target, after the first option is applied it
+// becomes stale, which AdInterface handles by rereading it.
+bool AccountOptionMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
     const QList<AccountOption> option_change_list = [&]() {
         QList<AccountOption> out;
 
-        const AdObject object = ad.search_object(target);
-
         for (const AccountOption &option : check_map.keys()) {
             QCheckBox *check = check_map[option];
 
-            const bool current_option_state = object.get_account_option(option, g_adconfig);
+            const bool current_option_state = target.get_account_option(option, g_adconfig);
             const bool new_option_state = check->isChecked();
             const bool option_changed = (new_option_state != current_option_state);
             if (option_changed) {
@@ -40,25 +40,13 @@ AttributeMultiEdit::AttributeMultiEdit(QCheckBox *apply_check_arg, QList<Attribu
         this, &AttributeMultiEdit::on_check_toggled);
 }
 
-bool AttributeMultiEdit::apply(AdInterface &ad, const QList<QString> &target_list) {
+bool AttributeMultiEdit::apply(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
     const bool need_to_apply = apply_check->isChecked();
     if (!need_to_apply) {
         return true;
     }
 
-    bool total_success = true;
-
-    for (const QString &target : target_list) {
-        const bool success = apply_internal(ad, target);
-
-        if (!success) {
-            total_success = false;
-        }
-    }
-
-    apply_check->setChecked(false);
-
-    return total_success;
+    return apply_internal(ad, target, changes);
 }
 
 void AttributeMultiEdit::reset() {
@@ -24,6 +24,8 @@
 #include <QObject>
 
 class AdInterface;
+class AdChangeSet;
+class AdObject;
 class PropertiesMultiTab;
 class QCheckBox;
 
@@ -36,7 +38,12 @@ class AttributeMultiEdit : public QObject {
 public:
     AttributeMultiEdit(QCheckBox *check, QList<AttributeMultiEdit *> &edits_out, QObject *parent);
 
-    bool apply(AdInterface &ad, const QList<QString> &target_list);
+    // Applies edit to target. Modifications of target's
+    // attributes are added to the change set, which is
+    // applied later together with changes of other edits.
+    // Target object is loaded before applying, so edits
+    // can use it's current values without reading it.
+    bool apply(AdInterface &ad, const AdObject &target, AdChangeSet *changes);
     void reset();
 
 private slots:
@@ -48,15 +55,15 @@ signals:
 protected:
     QCheckBox *apply_check;
     
-    virtual bool apply_internal(AdInterface &ad, const QString &target) = 0;
+    virtual bool apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) = 0;
     virtual void set_enabled(const bool enabled) = 0;
 };
 
-#define DECL_ATTRIBUTE_MULTI_EDIT_VIRTUALS()                              \
-protected:                                                                \
-    bool apply_internal(AdInterface &ad, const QString &target) override; \
-    void set_enabled(const bool enabled) override;                        \
-                                                                          \
+#define DECL_ATTRIBUTE_MULTI_EDIT_VIRTUALS()                                                      \
+protected:                                                                                        \
+    bool apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) override; \
+    void set_enabled(const bool enabled) override;                                                \
+                                                                                                  \
 public:
 
 void multi_edits_connect_to_tab(const QList<AttributeMultiEdit *> &edits, PropertiesMultiTab *tab);
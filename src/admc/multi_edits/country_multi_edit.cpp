@@ -38,8 +38,10 @@ CountryMultiEdit::CountryMultiEdit(QComboBox *country_combo_arg, QCheckBox *chec
     set_enabled(false);
 }
 
-bool CountryMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
-    return country_combo_apply(country_combo, ad, target);
+bool CountryMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
+    country_combo_add_changes(country_combo, changes);
+
+    return true;
 }
 
 void CountryMultiEdit::set_enabled(const bool enabled) {
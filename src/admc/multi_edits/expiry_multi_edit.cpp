@@ -41,8 +41,10 @@ ExpiryMultiEdit::ExpiryMultiEdit(ExpiryWidget *edit_widget_arg, QCheckBox *check
     set_enabled(false);
 }
 
-bool ExpiryMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
-    return edit_widget->apply(ad, target);
+bool ExpiryMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
+    edit_widget->add_changes(changes);
+
+    return true;
 }
 
 void ExpiryMultiEdit::set_enabled(const bool enabled) {
@@ -41,8 +41,10 @@ ManagerMultiEdit::ManagerMultiEdit(ManagerWidget *widget_arg, QCheckBox *check,
     set_enabled(false);
 }
 
-bool ManagerMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
-    return widget->apply(ad, target);
+bool ManagerMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
+    widget->add_changes(changes);
+
+    return true;
 }
 
 void ManagerMultiEdit::set_enabled(const bool enabled) {
@@ -38,9 +38,11 @@ StringMultiEdit::StringMultiEdit(QLineEdit *edit_arg, QCheckBox *check, const QS
     set_enabled(false);
 }
 
-bool StringMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
+bool StringMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
     const QString new_value = edit->text();
-    return ad.attribute_replace_string(target, attribute, new_value);
+    changes->replace_string(attribute, new_value);
+
+    return true;
 }
 
 void StringMultiEdit::set_enabled(const bool enabled) {
@@ -38,16 +38,17 @@ UpnMultiEdit::UpnMultiEdit(QComboBox *upn_suffix_combo_arg, QCheckBox *check, QL
     set_enabled(false);
 }
 
-bool UpnMultiEdit::apply_internal(AdInterface &ad, const QString &target) {
+bool UpnMultiEdit::apply_internal(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
     const QString new_value = [&]() {
-        const AdObject current_object = ad.search_object(target);
-        const QString current_prefix = current_object.get_upn_prefix();
+        const QString current_prefix = target.get_upn_prefix();
         const QString new_suffix = upn_suffix_combo->currentText();
 
         return QString("%1@%2").arg(current_prefix, new_suffix);
     }();
 
-    return ad.attribute_replace_string(target, ATTRIBUTE_USER_PRINCIPAL_NAME, new_value);
+    changes->replace_string(ATTRIBUTE_USER_PRINCIPAL_NAME, new_value);
+
+    return true;
 }
 
 void UpnMultiEdit::set_enabled(const bool enabled) {
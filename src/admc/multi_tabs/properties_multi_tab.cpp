@@ -22,10 +22,10 @@
 
 #include "multi_edits/attribute_multi_edit.h"
 
-bool PropertiesMultiTab::apply(AdInterface &ad, const QList<QString> &target_list) {
+bool PropertiesMultiTab::apply(AdInterface &ad, const AdObject &target, AdChangeSet *changes) {
     bool total_success = true;
     for (AttributeMultiEdit *edit : edit_list) {
-        const bool success = edit->apply(ad, target_list);
+        const bool success = edit->apply(ad, target, changes);
 
         if (!success) {
             total_success = false;
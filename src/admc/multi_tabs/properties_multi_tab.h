@@ -24,6 +24,8 @@
 #include <QWidget>
 
 class AdInterface;
+class AdChangeSet;
+class AdObject;
 class AttributeMultiEdit;
 
 /**
@@ -34,7 +36,7 @@ class PropertiesMultiTab : public QWidget {
     Q_OBJECT
 
 public:
-    virtual bool apply(AdInterface &ad, const QList<QString> &target_list);
+    virtual bool apply(AdInterface &ad, const AdObject &target, AdChangeSet *changes);
     virtual void reset();
 
     void on_edit_edited();
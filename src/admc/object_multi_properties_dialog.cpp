@@ -102,15 +102,57 @@ bool ObjectMultiPropertiesDialog::apply() {
     show_busy_indicator();
 
     bool total_apply_success = true;
-    for (PropertiesMultiTab *tab : tab_list) {
-        const bool success = tab->apply(ad, target_list);
 
-        if (!success) {
+    // NOTE: all targets are read at once before applying,
+    // so that edits and modifications don't need to read
+    // them one by one
+    const QHash<QString, AdObject> target_object_map = ad.search_objects(target_list);
+
+    // NOTE: targets that weren't found, for example
+    // because they were deleted since dialog was opened,
+    // are reported as failures
+    QList<QString> missing_error_list;
+
+    // NOTE: changes of all tabs for one target are
+    // gathered into one change set, so that each target
+    // is modified in one request
+    for (const QString &target : target_list) {
+        if (!target_object_map.contains(target)) {
+            const QString error = QString(tr("Failed to apply changes to %1, object wasn't found.")).arg(dn_get_name(target));
+            g_status()->add_message(error, StatusType_Error);
+            missing_error_list.append(error);
+
             total_apply_success = false;
+
+            continue;
+        }
+
+        const AdObject target_object = target_object_map[target];
+
+        AdChangeSet changes;
+
+        for (PropertiesMultiTab *tab : tab_list) {
+            const bool success = tab->apply(ad, target_object, &changes);
+
+            if (!success) {
+                total_apply_success = false;
+            }
         }
+
+        const bool changes_success = ad.object_modify(target_object, changes);
+        if (!changes_success) {
+            total_apply_success = false;
+        }
+    }
+
+    // NOTE: uncheck apply checks of edits that were
+    // applied
+    for (PropertiesMultiTab *tab : tab_list) {
+        tab->reset();
     }
 
     g_status()->display_ad_messages(ad, this);
+    error_log(missing_error_list, this);
 
     hide_busy_indicator();
 
@@ -22,6 +22,7 @@
 #include "ui_properties_dialog.h"
 
 #include "adldap.h"
+#include "change_listener.h"
 #include "console_impls/object_impl.h"
 #include "globals.h"
 #include "settings.h"
@@ -237,6 +238,19 @@ PropertiesDialog::PropertiesDialog(const QString &target_arg)
     connect(
         warning_dialog, &QDialog::accepted,
         this, &PropertiesDialog::on_warning_dialog_rejected);
+
+    // NOTE: reload target when it's changed by another
+    // client. Watch is pinned so that console watches
+    // can't push it out while dialog is open.
+    ChangeListener::instance()->watch(target, SearchScope_Object, true);
+    connect(
+        ChangeListener::instance(), &ChangeListener::object_changed,
+        this, &PropertiesDialog::on_object_changed);
+    connect(
+        this, &QDialog::finished,
+        [this]() {
+            ChangeListener::instance()->unwatch(target, SearchScope_Object);
+        });
 }
 
 void PropertiesDialog::on_current_tab_changed(QWidget *prev_tab, QWidget *new_tab) {
@@ -294,13 +308,36 @@ bool PropertiesDialog::apply_internal(AdInterface &ad) {
 
     bool total_apply_success = true;
 
+    // NOTE: modifications of other objects can't be
+    // batched, so they are applied first
+    for (auto tab : tabs) {
+        const bool apply_now_success = tab->apply_now(ad, target);
+        if (!apply_now_success) {
+            total_apply_success = false;
+        }
+    }
+
+    // NOTE: modifications of target's attributes made in
+    // all tabs are gathered into one change set and
+    // applied in one request, which is also atomic
+    AdChangeSet changes;
+
     for (auto tab : tabs) {
-        const bool apply_success = tab->apply(ad, target);
+        const bool apply_success = tab->add_changes(ad, target, &changes);
         if (!apply_success) {
             total_apply_success = false;
         }
     }
 
+    const bool changes_success = ad.object_modify(target, changes);
+    if (changes_success) {
+        for (auto tab : tabs) {
+            tab->on_changes_applied();
+        }
+    } else {
+        total_apply_success = false;
+    }
+
     g_status()->display_ad_messages(ad, this);
 
     if (total_apply_success) {
@@ -352,3 +389,16 @@ void PropertiesDialog::on_warning_dialog_accepted() {
 void PropertiesDialog::on_warning_dialog_rejected() {
     reset();
 }
+
+void PropertiesDialog::on_object_changed(const AdObject &object) {
+    // NOTE: don't overwrite edits that user hasn't applied
+    // yet
+    // NOTE: DN's are case-insensitive and server may
+    // return target's DN in a different case
+    const bool is_target = (object.get_dn().compare(target, Qt::CaseInsensitive) == 0);
+    if (!is_target || is_modified) {
+        return;
+    }
+
+    reset();
+}
@@ -36,6 +36,7 @@ class QPushButton;
 class AttributesTab;
 class AdInterface;
 class PropertiesWarningDialog;
+class AdObject;
 
 namespace Ui {
     class PropertiesDialog;
@@ -77,6 +78,7 @@ private:
     void on_current_tab_changed(QWidget *prev_tab, QWidget *new_tab);
     void on_warning_dialog_accepted();
     void on_warning_dialog_rejected();
+    void on_object_changed(const AdObject &object);
 };
 
 #endif /* PROPERTIES_DIALOG_H */
@@ -21,6 +21,7 @@
 #include "rename_dialog.h"
 
 #include "adldap.h"
+#include "console_impls/object_impl.h"
 #include "edits/attribute_edit.h"
 #include "globals.h"
 #include "status.h"
@@ -75,6 +76,10 @@ QString RenameDialog::get_new_dn() const {
     return new_dn;
 }
 
+AdObject RenameDialog::get_new_object() const {
+    return new_object;
+}
+
 void RenameDialog::open() {
     reset();
 
@@ -96,13 +101,29 @@ void RenameDialog::accept() {
 
     show_busy_indicator();
 
+    // NOTE: request renamed object from rename and
+    // following modification, so that console doesn't
+    // need to read it
+    const QList<QString> post_read_attributes = console_object_search_attributes();
+    new_object = AdObject();
+
     const QString new_name = name_edit->text();
-    const bool rename_success = ad.object_rename(target, new_name);
+    const bool rename_success = ad.object_rename(target, new_name, post_read_attributes, &new_object);
 
     bool final_success = false;
     if (rename_success) {
         const QString new_dn = dn_rename(target, new_name);
-        const bool apply_success = edits_apply(ad, edits, new_dn);
+
+        AdChangeSet changes;
+        QList<AttributeEdit *> changed_edits;
+        bool apply_success = edits_apply_with_changes(ad, edits, new_dn, &changes, &changed_edits);
+
+        const bool changes_success = ad.object_modify(new_dn, changes, DoStatusMsg_Yes, post_read_attributes, &new_object);
+        if (changes_success) {
+            edits_reset_modified(changed_edits);
+        } else {
+            apply_success = false;
+        }
 
         if (apply_success) {
             final_success = true;
@@ -23,6 +23,8 @@
 
 #include <QDialog>
 
+#include "ad_object.h"
+
 class QLineEdit;
 class QDialogButtonBox;
 class AttributeEdit;
@@ -42,11 +44,17 @@ public:
     void set_target(const QString &dn);
     void reset();
     QString get_new_dn() const;
+
+    // Returns renamed object, if server returned it
+    // through post-read. Otherwise returns an empty
+    // object.
+    AdObject get_new_object() const;
     void open() override;
     void accept() override;
 
 private:
     QString target;
+    AdObject new_object;
     QLineEdit *name_edit;
     QList<AttributeEdit *> edits;
 };
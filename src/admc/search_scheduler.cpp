@@ -0,0 +1,311 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "search_scheduler.h"
+
+#include "adldap.h"
+#include "search_thread.h"
+
+#include <algorithm>
+
+// Max number of searches running at the same time against
+// one DC
+#define RUNNING_PER_DC_MAX 3
+
+// Results of a running search are kept so that identical
+// requests submitted later can join it. Past this size the
+// results are dropped and the search stops accepting new
+// requests, which then start their own search.
+#define JOIN_RESULTS_MAX 5000
+
+class SearchJob final {
+public:
+    QString key;
+    QString base;
+    SearchScope scope;
+    QString filter;
+    QList<QString> attributes;
+    QList<SearchRequest *> request_list;
+    SearchThread *thread;
+    QString dc;
+    QHash<QString, AdObject> results;
+    bool can_join;
+};
+
+QString search_job_key(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes);
+bool search_job_is_normal(SearchJob *job);
+
+SearchRequest::SearchRequest(const QString &base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> &attributes_arg, const void *owner_arg, const SearchPriority priority_arg) {
+    base = base_arg;
+    scope = scope_arg;
+    filter = filter_arg;
+    attributes = attributes_arg;
+    owner = owner_arg;
+    priority = priority_arg;
+    job = nullptr;
+}
+
+void SearchRequest::cancel() {
+    SearchScheduler::instance()->remove_request(this);
+}
+
+SearchScheduler *SearchScheduler::instance() {
+    static SearchScheduler scheduler;
+
+    return &scheduler;
+}
+
+SearchScheduler::SearchScheduler() {
+    current_owner = nullptr;
+}
+
+void SearchScheduler::submit(SearchRequest *request) {
+    if (request->owner != nullptr) {
+        cancel(request->owner);
+    }
+
+    const QString key = search_job_key(request->base, request->scope, request->filter, request->attributes);
+
+    SearchJob *job = job_map.value(key, nullptr);
+
+    if (job == nullptr) {
+        job = new SearchJob();
+        job->key = key;
+        job->base = request->base;
+        job->scope = request->scope;
+        job->filter = request->filter;
+        job->attributes = request->attributes;
+        job->thread = nullptr;
+        job->can_join = true;
+
+        job_map[key] = job;
+        job_list.append(job);
+        queue.append(job);
+    }
+
+    job->request_list.append(request);
+    request->job = job;
+
+    if (job->thread != nullptr) {
+        emit request->started();
+    }
+
+    // NOTE: request joined a search that is already
+    // running, so give it the results that it missed
+    if (!job->results.isEmpty()) {
+        emit request->results_ready(job->results);
+    }
+
+    dispatch();
+}
+
+void SearchScheduler::cancel(const void *owner) {
+    QList<SearchRequest *> cancel_list;
+
+    for (SearchJob *job : job_list) {
+        for (SearchRequest *request : job->request_list) {
+            if (request->owner == owner) {
+                cancel_list.append(request);
+            }
+        }
+    }
+
+    for (SearchRequest *request : cancel_list) {
+        remove_request(request);
+    }
+}
+
+void SearchScheduler::set_current_owner(const void *owner) {
+    current_owner = owner;
+}
+
+void SearchScheduler::remove_request(SearchRequest *request) {
+    SearchJob *job = request->job;
+
+    if (job == nullptr) {
+        return;
+    }
+
+    job->request_list.removeAll(request);
+    finish_request(request);
+
+    if (!job->request_list.isEmpty()) {
+        return;
+    }
+
+    // Nobody needs results of this job anymore
+    if (job_map.value(job->key) == job) {
+        job_map.remove(job->key);
+    }
+
+    if (job->thread == nullptr) {
+        queue.removeAll(job);
+        job_list.removeAll(job);
+        delete job;
+    } else {
+        // NOTE: job is deleted once thread finishes, so
+        // that running count stays correct until then
+        job->results.clear();
+        job->thread->stop();
+    }
+}
+
+void SearchScheduler::dispatch() {
+    const QString dc = AdInterface::get_dc();
+
+    while (!queue.isEmpty() && running_count_map.value(dc, 0) < RUNNING_PER_DC_MAX) {
+        SearchJob *job = [&]() {
+            for (SearchJob *queued_job : queue) {
+                for (SearchRequest *request : queued_job->request_list) {
+                    if (request->owner == current_owner) {
+                        return queued_job;
+                    }
+                }
+            }
+
+            for (SearchJob *queued_job : queue) {
+                if (search_job_is_normal(queued_job)) {
+                    return queued_job;
+                }
+            }
+
+            return queue.first();
+        }();
+
+        queue.removeAll(job);
+        start_job(job, dc);
+    }
+}
+
+void SearchScheduler::start_job(SearchJob *job, const QString &dc) {
+    job->dc = dc;
+    running_count_map[dc]++;
+
+    job->thread = new SearchThread(job->base, job->scope, job->filter, job->attributes);
+
+    // NOTE: thread signals arrive as queued calls in the
+    // main thread. Thread finishes after emitting all
+    // results, so finished always comes after last
+    // results. Thread deletes itself after finished.
+    connect(
+        job->thread, &SearchThread::results_ready,
+        this,
+        [this, job](const QHash<QString, AdObject> &results) {
+            on_job_results(job, results);
+        });
+    connect(
+        job->thread, &SearchThread::finished,
+        this,
+        [this, job]() {
+            on_job_finished(job);
+        });
+
+    job->thread->start();
+
+    // NOTE: iterate over a copy because receivers may
+    // cancel their requests
+    const QList<SearchRequest *> request_list = job->request_list;
+    for (SearchRequest *request : request_list) {
+        if (job->request_list.contains(request)) {
+            emit request->started();
+        }
+    }
+}
+
+void SearchScheduler::on_job_results(SearchJob *job, const QHash<QString, AdObject> &results) {
+    if (job->request_list.isEmpty()) {
+        return;
+    }
+
+    if (job->can_join) {
+        // NOTE: not using unite() because it adds
+        // duplicate keys instead of replacing them
+        for (const QString &dn : results.keys()) {
+            job->results.insert(dn, results[dn]);
+        }
+
+        if (job->results.size() > JOIN_RESULTS_MAX) {
+            job->can_join = false;
+            job->results.clear();
+
+            if (job_map.value(job->key) == job) {
+                job_map.remove(job->key);
+            }
+        }
+    }
+
+    // NOTE: iterate over a copy because receivers may
+    // cancel their requests
+    const QList<SearchRequest *> request_list = job->request_list;
+    for (SearchRequest *request : request_list) {
+        if (job->request_list.contains(request)) {
+            emit request->results_ready(results);
+        }
+    }
+}
+
+void SearchScheduler::on_job_finished(SearchJob *job) {
+    running_count_map[job->dc]--;
+
+    if (job_map.value(job->key) == job) {
+        job_map.remove(job->key);
+    }
+
+    const QList<SearchRequest *> request_list = job->request_list;
+    job->request_list.clear();
+
+    for (SearchRequest *request : request_list) {
+        finish_request(request);
+    }
+
+    job_list.removeAll(job);
+    delete job;
+
+    dispatch();
+}
+
+void SearchScheduler::finish_request(SearchRequest *request) {
+    request->job = nullptr;
+
+    emit request->finished();
+
+    request->deleteLater();
+}
+
+QString search_job_key(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
+    // NOTE: order of attributes doesn't change results
+    QList<QString> sorted_attributes = attributes;
+    std::sort(sorted_attributes.begin(), sorted_attributes.end());
+
+    const QString out = QString("%1\n%2\n%3\n%4").arg(base, QString::number(scope), filter, sorted_attributes.join(","));
+
+    return out;
+}
+
+// NOTE: job has normal priority if any of it's requests do
+bool search_job_is_normal(SearchJob *job) {
+    for (SearchRequest *request : job->request_list) {
+        if (request->priority == SearchPriority_Normal) {
+            return true;
+        }
+    }
+
+    return false;
+}
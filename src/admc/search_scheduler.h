@@ -0,0 +1,126 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEARCH_SCHEDULER_H
+#define SEARCH_SCHEDULER_H
+
+/**
+ * Runs SearchThread's for console fetches. Starting a
+ * thread, and with it a connection, for every fetch floods
+ * the DC when user clicks quickly through the tree, so the
+ * number of searches that run at the same time is limited
+ * per DC and the rest wait in a queue. When a slot frees
+ * up, search for the currently selected item goes first
+ * and background searches go last.
+ * Identical requests share one search. Every request has
+ * an owner, usually the item that displays results, and a
+ * new request cancels previous requests of the same
+ * owner. Scheduler must only be used from the main thread.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include "ad_defines.h"
+
+class AdObject;
+class SearchThread;
+class SearchJob;
+
+enum SearchPriority {
+    SearchPriority_Normal,
+    // For speculative searches, like prefetching. These
+    // only start when no normal requests are waiting.
+    SearchPriority_Background,
+};
+
+class SearchRequest final : public QObject {
+    Q_OBJECT
+
+public:
+    SearchRequest(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const void *owner, const SearchPriority priority = SearchPriority_Normal);
+
+    // Stops delivering results and emits finished() right
+    // away. Search itself is stopped if no other request
+    // shares it.
+    void cancel();
+
+signals:
+    // Emitted when search for this request starts running,
+    // or right away if request joined a running search
+    void started();
+
+    void results_ready(const QHash<QString, AdObject> &results);
+
+    // NOTE: emitted exactly once, both when search
+    // completes and when request is cancelled. Request
+    // deletes itself after that.
+    void finished();
+
+private:
+    QString base;
+    SearchScope scope;
+    QString filter;
+    QList<QString> attributes;
+    const void *owner;
+    SearchPriority priority;
+    SearchJob *job;
+
+    friend class SearchScheduler;
+};
+
+class SearchScheduler final : public QObject {
+    Q_OBJECT
+
+public:
+    static SearchScheduler *instance();
+
+    // Cancels previous requests of the same owner and
+    // queues this one. Connect to request's signals before
+    // submitting it.
+    void submit(SearchRequest *request);
+
+    // Cancels all requests of given owner
+    void cancel(const void *owner);
+
+    // Requests of this owner are started before others
+    void set_current_owner(const void *owner);
+
+private:
+    QList<SearchJob *> job_list;
+    QList<SearchJob *> queue;
+    QHash<QString, SearchJob *> job_map;
+    QHash<QString, int> running_count_map;
+    const void *current_owner;
+
+    SearchScheduler();
+
+    void remove_request(SearchRequest *request);
+    void dispatch();
+    void start_job(SearchJob *job, const QString &dc);
+    void on_job_results(SearchJob *job, const QHash<QString, AdObject> &results);
+    void on_job_finished(SearchJob *job);
+    void finish_request(SearchRequest *request);
+
+    friend class SearchRequest;
+};
+
+#endif /* SEARCH_SCHEDULER_H */
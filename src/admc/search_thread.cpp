@@ -23,14 +23,24 @@
 #include "adldap.h"
 #include "utils.h"
 
+#include <QElapsedTimer>
 #include <QHash>
+#include <QMutexLocker>
 
-SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> attributes_arg) {
+// Results are emitted when batch reaches this size or when
+// this much time has passed since previous emit. This
+// keeps the UI responsive without flooding it with signals.
+#define EMIT_BATCH_SIZE 200
+#define EMIT_INTERVAL_MS 100
+
+SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> attributes_arg, const AdRouting routing_arg) {
     stop_flag = false;
+    ad = nullptr;
     base = base_arg;
     scope = scope_arg;
     filter = filter_arg;
     attributes = attributes_arg;
+    routing = routing_arg;
 
     static int id_max = 0;
     id = id_max;
@@ -42,34 +52,77 @@ SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg,
 }
 
 void SearchThread::stop() {
+    QMutexLocker locker(&mutex);
+
     stop_flag = true;
+
+    // NOTE: cancel abandons the request that search is
+    // waiting on, so search stops right away instead of
+    // after current page is received
+    if (ad != nullptr) {
+        ad->cancel();
+    }
 }
 
 void SearchThread::run() {
     // TODO: handle search/connect failure
-    AdInterface ad;
-    if (!ad.is_connected()) {
+    AdInterface thread_ad(routing);
+    if (!thread_ad.is_connected()) {
         return;
     }
 
-    AdCookie cookie;
+    {
+        QMutexLocker locker(&mutex);
 
-    while (true) {
-        QHash<QString, AdObject> results;
+        if (stop_flag) {
+            return;
+        }
 
-        const bool success = ad.search_paged(base, scope, filter, attributes, &results, &cookie);
+        ad = &thread_ad;
+    }
 
-        emit results_ready(results);
+    QHash<QString, AdObject> batch;
+    bool emitted_first = false;
+    QElapsedTimer emit_timer;
+    emit_timer.start();
 
-        const bool search_interrupted = (!success || stop_flag);
-        if (search_interrupted) {
-            break;
-        }
+    auto emit_batch = [&]() {
+        emit results_ready(batch);
 
-        if (!cookie.more_pages()) {
-            break;
-        }
+        batch.clear();
+        emitted_first = true;
+        emit_timer.restart();
+    };
+
+    thread_ad.search_stream(base, scope, filter, attributes,
+        [&](const AdObject &object) {
+            batch.insert(object.get_dn(), object);
+
+            // NOTE: emit first result right away so that
+            // user sees that search is producing results
+            const bool need_emit = (!emitted_first || batch.size() >= EMIT_BATCH_SIZE || emit_timer.elapsed() >= EMIT_INTERVAL_MS);
+            if (need_emit) {
+                emit_batch();
+            }
+
+            return !stop_requested();
+        });
+
+    {
+        QMutexLocker locker(&mutex);
+
+        ad = nullptr;
     }
+
+    if (!batch.isEmpty()) {
+        emit_batch();
+    }
+}
+
+bool SearchThread::stop_requested() {
+    QMutexLocker locker(&mutex);
+
+    return stop_flag;
 }
 
 int SearchThread::get_id() const {
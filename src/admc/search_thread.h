@@ -25,17 +25,23 @@
  * A thread that performs an AD search operation. Useful for
  * searches that are expected to take a long time. For
  * regular small searches this is overkill. results_ready()
- * signal returns search results as they arrive. If search
- * has multiple pages, then results_ready() will be emitted
- * multiple times. Use stop() to stop search. Note that search is
- * not stopped immediately but when current results page is
- * done processing. SearchThread deletes itself when it's
- * finished.
+ * signal returns search results as they arrive. Results
+ * are streamed and emitted in small batches, so first
+ * results are shown quickly even for big searches. Use
+ * stop() to stop search. Request that is in progress is
+ * abandoned right away, even if server hasn't replied yet,
+ * and connection is released. SearchThread deletes itself
+ * when it's finished. Pass AdRouting_ReadBalanced for
+ * heavy searches that don't need to see console's
+ * incremental sync position, so that they are spread over
+ * DC's.
  */
 
+#include <QMutex>
 #include <QThread>
 
 #include "ad_defines.h"
+#include "ad_interface.h"
 
 class AdObject;
 
@@ -43,7 +49,7 @@ class SearchThread final : public QThread {
     Q_OBJECT
 
 public:
-    SearchThread(const QString base, const SearchScope scope, const QString &filter, const QList<QString> attributes);
+    SearchThread(const QString base, const SearchScope scope, const QString &filter, const QList<QString> attributes, const AdRouting routing = AdRouting_Primary);
 
     void stop();
     int get_id() const;
@@ -52,14 +58,21 @@ signals:
     void results_ready(const QHash<QString, AdObject> &results);
 
 private:
+    // NOTE: mutex protects stop flag and the AdInterface
+    // pointer, because stop() is called from another
+    // thread
+    QMutex mutex;
     bool stop_flag;
+    AdInterface *ad;
     QString base;
     SearchScope scope;
     QString filter;
     QList<QString> attributes;
+    AdRouting routing;
     int id;
 
     void run() override;
+    bool stop_requested();
 };
 
 #endif /* SEARCH_THREAD_H */
@@ -153,7 +153,23 @@ void SelectObjectDialog::on_add_button() {
         return out;
     }();
 
-    const QHash<QString, AdObject> search_results = ad.search(base, SearchScope_All, filter, console_object_search_attributes());
+    // NOTE: only load attributes that are displayed in
+    // this dialog, so that searches from domain head can
+    // go through Global Catalog and find objects from the
+    // whole forest
+    const QList<QString> attributes = {
+        ATTRIBUTE_OBJECT_CLASS,
+        ATTRIBUTE_OBJECT_GUID,
+        ATTRIBUTE_USER_ACCOUNT_CONTROL,
+    };
+
+    const QHash<QString, AdObject> search_results = [&]() {
+        if (base == g_adconfig->domain_head()) {
+            return ad.search_forest(filter, attributes);
+        } else {
+            return ad.search(base, SearchScope_All, filter, attributes);
+        }
+    }();
 
     if (search_results.size() == 1) {
         // Add to list
@@ -46,6 +46,7 @@ const QHash<QString, bool> bool_setting_default_map = {
     {SETTING_log_searches, false},
     {SETTING_timestamp_log, true},
     {SETTING_sasl_nocanon, true},
+    {SETTING_prefetch, false},
 };
 
 bool settings_get_bool(const QString setting) {
@@ -86,6 +86,7 @@ DEFINE_SETTING(SETTING_log_searches);
 DEFINE_SETTING(SETTING_timestamp_log);
 DEFINE_SETTING(SETTING_sasl_nocanon);
 DEFINE_SETTING(SETTING_show_client_user);
+DEFINE_SETTING(SETTING_prefetch);
 
 // Other
 DEFINE_SETTING(SETTING_dc);
@@ -95,6 +96,9 @@ DEFINE_SETTING(SETTING_query_items);
 DEFINE_SETTING(SETTING_port);
 DEFINE_SETTING(SETTING_cert_strategy);
 DEFINE_SETTING(SETTING_last_opened_version);
+DEFINE_SETTING(SETTING_prefetch_depth);
+DEFINE_SETTING(SETTING_prefetch_page_size);
+DEFINE_SETTING(SETTING_prefetch_objects_per_minute);
 
 QVariant settings_get_variant(const QString setting, const QVariant &default_value = QVariant());
 void settings_set_variant(const QString setting, const QVariant &value);
@@ -162,24 +162,23 @@ void AttributesTab::load(AdInterface &ad, const AdObject &object) {
     ui->view->sortByColumn(AttributesColumn_Name, Qt::AscendingOrder);
 }
 
-bool AttributesTab::apply(AdInterface &ad, const QString &target) {
-    bool total_success = true;
-
+bool AttributesTab::add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) {
     for (const QString &attribute : current.keys()) {
         const QList<QByteArray> current_values = current[attribute];
         const QList<QByteArray> original_values = original[attribute];
 
         if (current_values != original_values) {
-            const bool success = ad.attribute_replace_values(target, attribute, current_values);
-            if (success) {
-                original[attribute] = current_values;
-            } else {
-                total_success = false;
-            }
+            changes->replace_values(attribute, current_values);
         }
     }
 
-    return total_success;
+    return true;
+}
+
+void AttributesTab::on_changes_applied() {
+    for (const QString &attribute : current.keys()) {
+        original[attribute] = current[attribute];
+    }
 }
 
 void AttributesTab::load_row(const QList<QStandardItem *> &row, const QString &attribute, const QList<QByteArray> &values) {
@@ -45,7 +45,8 @@ public:
     ~AttributesTab();
 
     void load(AdInterface &ad, const AdObject &object) override;
-    bool apply(AdInterface &ad, const QString &target) override;
+    bool add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) override;
+    void on_changes_applied() override;
 
 private slots:
     void edit_attribute();
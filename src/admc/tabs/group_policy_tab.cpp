@@ -110,30 +110,21 @@ void GroupPolicyTab::load(AdInterface &ad, const AdObject &object) {
     PropertiesTab::load(ad, object);
 }
 
-bool GroupPolicyTab::apply(AdInterface &ad, const QString &target) {
-    bool total_success = true;
-
+bool GroupPolicyTab::add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) {
     const bool gplink_changed = !gplink.equals(original_gplink_string);
     if (gplink_changed) {
         const QString gplink_string = gplink.to_string();
 
-        const bool replace_success = ad.attribute_replace_string(target, ATTRIBUTE_GPLINK, gplink_string);
-
-        if (!replace_success) {
-            total_success = false;
-        }
-
-        if (replace_success) {
-            original_gplink_string = gplink_string;
-        }
+        changes->replace_string(ATTRIBUTE_GPLINK, gplink_string);
     }
 
-    const bool apply_success = PropertiesTab::apply(ad, target);
-    if (!apply_success) {
-        total_success = false;
-    }
+    return PropertiesTab::add_changes(ad, target, changes);
+}
+
+void GroupPolicyTab::on_changes_applied() {
+    original_gplink_string = gplink.to_string();
 
-    return total_success;
+    PropertiesTab::on_changes_applied();
 }
 
 void GroupPolicyTab::on_context_menu(const QPoint pos) {
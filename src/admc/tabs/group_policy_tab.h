@@ -49,7 +49,8 @@ public:
     ~GroupPolicyTab();
 
     void load(AdInterface &ad, const AdObject &object) override;
-    bool apply(AdInterface &ad, const QString &target) override;
+    bool add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) override;
+    void on_changes_applied() override;
 
 private slots:
     void on_context_menu(const QPoint pos);
@@ -121,11 +121,12 @@ void MembershipTab::load(AdInterface &ad, const AdObject &object) {
             const QByteArray group_sid = object.get_value(ATTRIBUTE_OBJECT_SID);
             const QString group_rid = extract_rid_from_sid(group_sid, g_adconfig);
 
-            const QString base = g_adconfig->domain_head();
-            const SearchScope scope = SearchScope_All;
+            // NOTE: search only this domain, because RID is
+            // only unique within a domain and primary group
+            // must be in the same domain as it's members
             const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_PRIMARY_GROUP_ID, group_rid);
-            const QList<QString> attributes = QList<QString>();
-            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+            const QList<QString> attributes = {ATTRIBUTE_DN};
+            const QHash<QString, AdObject> results = ad.search(g_adconfig->domain_head(), SearchScope_All, filter, attributes);
 
             for (const QString &user : results.keys()) {
                 original_primary_values.insert(user);
@@ -148,11 +149,9 @@ void MembershipTab::load(AdInterface &ad, const AdObject &object) {
             const int cut_index = user_sid_string.lastIndexOf("-") + 1;
             const QString group_sid = user_sid_string.left(cut_index) + group_rid;
 
-            const QString base = g_adconfig->domain_head();
-            const SearchScope scope = SearchScope_All;
             const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_SID, group_sid);
-            const QList<QString> attributes = QList<QString>();
-            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+            const QList<QString> attributes = {ATTRIBUTE_DN};
+            const QHash<QString, AdObject> results = ad.search_forest(filter, attributes);
 
             if (!results.isEmpty()) {
                 const QString group_dn = results.values()[0].get_dn();
@@ -168,7 +167,41 @@ void MembershipTab::load(AdInterface &ad, const AdObject &object) {
     reload_model();
 }
 
-bool MembershipTab::apply(AdInterface &ad, const QString &target) {
+// NOTE: members are values of group's "member" attribute,
+// so they are added to the change set
+bool MembershipTab::add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) {
+    if (type != MembershipTabType_Members) {
+        return true;
+    }
+
+    const QSet<QString> removed_set = original_values - current_values;
+    const QSet<QString> added_set = current_values - original_values;
+
+    for (const QString &member : removed_set) {
+        changes->delete_value(ATTRIBUTE_MEMBER, member.toUtf8());
+    }
+
+    for (const QString &member : added_set) {
+        changes->add_value(ATTRIBUTE_MEMBER, member.toUtf8());
+    }
+
+    return true;
+}
+
+void MembershipTab::on_changes_applied() {
+    if (type == MembershipTabType_Members) {
+        original_values = current_values;
+    }
+}
+
+// NOTE: groups of a user are changed by modifying "member"
+// attribute of those groups, so these changes can't be a
+// part of user's change set and are applied right away
+bool MembershipTab::apply_now(AdInterface &ad, const QString &target) {
+    if (type != MembershipTabType_MemberOf) {
+        return true;
+    }
+
     bool total_success = true;
 
     // NOTE: need temp copy because can't edit the set
@@ -176,108 +209,78 @@ bool MembershipTab::apply(AdInterface &ad, const QString &target) {
     QSet<QString> new_original_values = original_values;
     QSet<QString> new_original_primary_values = original_primary_values;
 
-    // NOTE: logic is kinda duplicated but switching on behavior within iterations would be very confusing
-    switch (type) {
-        case MembershipTabType_Members: {
-            const QString group = target;
-
-            for (auto user : original_values) {
-                const bool removed = !current_values.contains(user);
-                if (removed) {
-                    const bool success = ad.group_remove_member(group, user);
-                    if (success) {
-                        new_original_values.remove(user);
-                    } else {
-                        total_success = false;
-                    }
-                }
-            }
+    const QString user = target;
 
-            for (auto user : current_values) {
-                const bool added = !original_values.contains(user);
-                if (added) {
-                    const bool success = ad.group_add_member(group, user);
-                    if (success) {
-                        new_original_values.insert(user);
-                    } else {
-                        total_success = false;
-                    }
-                }
-            }
+    // NOTE: must change primary group before
+    // remove/add operations otherwise there will be
+    // conflicts
 
-            break;
+    // Change primary group
+    if (current_primary_values != original_primary_values) {
+        const QString original_primary_group = original_primary_values.values()[0];
+        const QString group_dn = current_primary_values.values()[0];
+
+        const bool success = ad.user_set_primary_group(group_dn, target);
+        if (success) {
+            new_original_primary_values = {group_dn};
+
+            // Server adds old primary group to
+            // normal membership
+            new_original_values.insert(original_primary_group);
+
+            // Server removes new primary group from
+            // normal membership
+            new_original_values.remove(group_dn);
+        } else {
+            total_success = false;
         }
-        case MembershipTabType_MemberOf: {
-            const QString user = target;
-
-            // NOTE: must change primary group before
-            // remove/add operations otherwise there will be
-            // conflicts
-
-            // Change primary group
-            if (current_primary_values != original_primary_values) {
-                const QString original_primary_group = original_primary_values.values()[0];
-                const QString group_dn = current_primary_values.values()[0];
-
-                const bool success = ad.user_set_primary_group(group_dn, target);
-                if (success) {
-                    new_original_primary_values = {group_dn};
-
-                    // Server adds old primary group to
-                    // normal membership
-                    new_original_values.insert(original_primary_group);
-
-                    // Server removes new primary group from
-                    // normal membership
-                    new_original_values.remove(group_dn);
-                } else {
-                    total_success = false;
-                }
-            }
+    }
 
-            // When setting primary groups, the server
-            // performs some membership modifications on
-            // it's end. Therefore, don't need to do
-            // anything with groups that were or are primary.
-            auto group_is_or_was_primary = [this](const QString &group) {
-                return original_primary_values.contains(group) || current_primary_values.contains(group);
-            };
+    // When setting primary groups, the server
+    // performs some membership modifications on
+    // it's end. Therefore, don't need to do
+    // anything with groups that were or are primary.
+    auto group_is_or_was_primary = [this](const QString &group) {
+        return original_primary_values.contains(group) || current_primary_values.contains(group);
+    };
+
+    QList<QString> removed_list;
+    for (auto group : original_values) {
+        const bool removed = !current_values.contains(group);
+        if (removed && !group_is_or_was_primary(group)) {
+            removed_list.append(group);
+        }
+    }
 
-            // Remove user from groups that were removed
-            for (auto group : original_values) {
-                if (group_is_or_was_primary(group)) {
-                    continue;
-                }
-
-                const bool removed = !current_values.contains(group);
-                if (removed) {
-                    const bool success = ad.group_remove_member(group, user);
-                    if (success) {
-                        new_original_values.remove(group);
-                    } else {
-                        total_success = false;
-                    }
-                }
-            }
+    QList<QString> added_list;
+    for (auto group : current_values) {
+        const bool added = !original_values.contains(group);
+        if (added && !group_is_or_was_primary(group)) {
+            added_list.append(group);
+        }
+    }
 
-            // Add user to groups that were added
-            for (auto group : current_values) {
-                if (group_is_or_was_primary(group)) {
-                    continue;
-                }
-
-                const bool added = !original_values.contains(group);
-                if (added) {
-                    const bool success = ad.group_add_member(group, user);
-                    if (success) {
-                        new_original_values.insert(group);
-                    } else {
-                        total_success = false;
-                    }
-                }
-            }
+    // Remove user from groups that were removed
+    if (!removed_list.isEmpty()) {
+        const QList<QString> removed_success_list = ad.group_remove_member_batch(removed_list, {user}).keys();
+        for (const QString &group : removed_success_list) {
+            new_original_values.remove(group);
+        }
 
-            break;
+        if (removed_success_list.size() != removed_list.size()) {
+            total_success = false;
+        }
+    }
+
+    // Add user to groups that were added
+    if (!added_list.isEmpty()) {
+        const QList<QString> added_success_list = ad.group_add_member_batch(added_list, {user}).keys();
+        for (const QString &group : added_success_list) {
+            new_original_values.insert(group);
+        }
+
+        if (added_success_list.size() != added_list.size()) {
+            total_success = false;
         }
     }
 
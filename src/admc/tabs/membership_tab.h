@@ -41,7 +41,9 @@ class MembershipTab : public PropertiesTab {
 
 public:
     void load(AdInterface &ad, const AdObject &object) override;
-    bool apply(AdInterface &ad, const QString &target) override;
+    bool apply_now(AdInterface &ad, const QString &target) override;
+    bool add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) override;
+    void on_changes_applied() override;
 
 protected:
     enum MembershipTabType {
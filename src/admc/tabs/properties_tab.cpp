@@ -33,7 +33,38 @@ bool PropertiesTab::verify(AdInterface &ad, const QString &target) const {
 }
 
 bool PropertiesTab::apply(AdInterface &ad, const QString &target) {
-    return edits_apply(ad, edits, target);
+    bool success = apply_now(ad, target);
+
+    AdChangeSet changes;
+
+    const bool add_success = add_changes(ad, target, &changes);
+    if (!add_success) {
+        success = false;
+    }
+
+    const bool changes_success = ad.object_modify(target, changes);
+    if (changes_success) {
+        on_changes_applied();
+    } else {
+        success = false;
+    }
+
+    return success;
+}
+
+bool PropertiesTab::apply_now(AdInterface &ad, const QString &target) {
+    return true;
+}
+
+bool PropertiesTab::add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) {
+    changed_edits.clear();
+
+    return edits_apply_with_changes(ad, edits, target, changes, &changed_edits);
+}
+
+void PropertiesTab::on_changes_applied() {
+    edits_reset_modified(changed_edits);
+    changed_edits.clear();
 }
 
 void PropertiesTab::on_edit_edited() {
@@ -34,6 +34,7 @@
 class AttributeEdit;
 class AdInterface;
 class AdObject;
+class AdChangeSet;
 
 class PropertiesTab : public QWidget {
     Q_OBJECT
@@ -41,7 +42,25 @@ class PropertiesTab : public QWidget {
 public:
     virtual void load(AdInterface &ad, const AdObject &object);
     virtual bool verify(AdInterface &ad, const QString &target) const;
-    virtual bool apply(AdInterface &ad, const QString &target);
+
+    // Applies changes made in this tab right away
+    bool apply(AdInterface &ad, const QString &target);
+
+    // Applies modifications that can't be a part of
+    // target's change set, like changes to other objects.
+    // These are not batched and are applied before the
+    // change set.
+    virtual bool apply_now(AdInterface &ad, const QString &target);
+
+    // Adds modifications of target's attributes to the
+    // change set, so that modifications made in all tabs
+    // can be applied in one request. Doesn't modify
+    // anything on the server.
+    virtual bool add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes);
+
+    // Called after the change set passed to add_changes()
+    // was applied successfully
+    virtual void on_changes_applied();
 
     void on_edit_edited();
 
@@ -52,6 +71,9 @@ signals:
 protected:
     QList<AttributeEdit *> edits;
 
+private:
+    QList<AttributeEdit *> changed_edits;
+
 };
 
 #endif /* PROPERTIES_TAB_H */
@@ -259,17 +259,23 @@ bool SecurityTab::set_trustee(const QString &trustee_name) {
     return true;
 }
 
-bool SecurityTab::apply(AdInterface &ad, const QString &target) {
+// NOTE: security descriptor is built from it's current
+// state on the server and replaced as part of the change
+// set
+bool SecurityTab::add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) {
     const bool modified = (original_permission_state_map != permission_state_map);
     if (!modified) {
         return true;
     }
 
-    const bool apply_success = attribute_replace_security_descriptor(&ad, target, permission_state_map);
+    const QByteArray descriptor = ad_security_make_descriptor(&ad, target, permission_state_map);
+    changes->replace_value(ATTRIBUTE_SECURITY_DESCRIPTOR, descriptor);
 
-    original_permission_state_map = permission_state_map;
+    return true;
+}
 
-    return apply_success;
+void SecurityTab::on_changes_applied() {
+    original_permission_state_map = permission_state_map;
 }
 
 void SecurityTab::on_add_trustee_button() {
@@ -289,8 +295,10 @@ void SecurityTab::on_add_trustee_button() {
                 QList<QByteArray> out;
 
                 const QList<QString> selected_list = dialog->get_selected();
+                const QHash<QString, AdObject> object_map = ad.search_objects(selected_list, {ATTRIBUTE_OBJECT_SID});
+
                 for (const QString &dn : selected_list) {
-                    const AdObject object = ad.search_object(dn, {ATTRIBUTE_OBJECT_SID});
+                    const AdObject object = object_map.value(dn);
                     const QByteArray sid = object.get_value(ATTRIBUTE_OBJECT_SID);
 
                     out.append(sid);
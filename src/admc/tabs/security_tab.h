@@ -63,7 +63,8 @@ public:
     static QHash<AcePermission, QString> ace_permission_to_name_map();
 
     void load(AdInterface &ad, const AdObject &object) override;
-    bool apply(AdInterface &ad, const QString &target) override;
+    bool add_changes(AdInterface &ad, const QString &target, AdChangeSet *changes) override;
+    void on_changes_applied() override;
 
     // NOTE: f-ns for testings
     QStandardItem *get_item(const AcePermission permission, const AceColumn column);
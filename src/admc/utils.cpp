@@ -173,7 +173,7 @@ QIcon get_object_icon(const AdObject &object) {
     };
 
     // Iterate over object classes in reverse, starting from most inherited class
-    QList<QString> object_classes = object.get_strings(ATTRIBUTE_OBJECT_CLASS);
+    QList<QString> object_classes = object.get_strings(ATOM_OBJECT_CLASS);
     std::reverse(object_classes.begin(), object_classes.end());
 
     const QString icon_name = [object_classes]() -> QString {
@@ -20,11 +20,67 @@
 
 #include "admc_test_ad_interface.h"
 
+#include "ad_connection_pool.h"
+#include "ad_discovery.h"
+#include "ad_read_router.h"
+
 #include "samba/dom_sid.h"
 
+#include <QAtomicInt>
+#include <QFile>
+#include <QLocale>
+#include <QRunnable>
+#include <QStandardPaths>
 #include <QTest>
+#include <QThreadPool>
 
 #define TEST_GPO "ADMCTestAdInterface_TEST_GPO"
+#define CONCURRENT_SEARCH_COUNT 300
+#define CONCURRENT_THREAD_COUNT 16
+
+// Searches with it's own AdInterface and counts searches
+// that returned expected results
+class ConcurrentSearchTask final : public QRunnable {
+
+public:
+    ConcurrentSearchTask(const QString &base_arg, const QSet<QString> &expected_arg, QAtomicInt *success_count_arg) {
+        base = base_arg;
+        expected = expected_arg;
+        success_count = success_count_arg;
+    }
+
+    void run() override {
+        AdInterface task_ad;
+        if (!task_ad.is_connected()) {
+            return;
+        }
+
+        const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+        const QHash<QString, AdObject> results = task_ad.search(base, SearchScope_Children, filter, {ATTRIBUTE_NAME, ATTRIBUTE_DESCRIPTION});
+
+        QSet<QString> dn_set;
+        for (const QString &dn : results.keys()) {
+            dn_set.insert(dn.toLower());
+        }
+
+        if (dn_set == expected) {
+            success_count->fetchAndAddOrdered(1);
+        }
+    }
+
+private:
+    QString base;
+    QSet<QString> expected;
+    QAtomicInt *success_count;
+};
+
+// Path of config cache file, same as the one used by
+// AdConfig
+QString config_cache_path(const QLocale &locale) {
+    const QString cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    return QString("%1/adconfig/%2-%3.cache").arg(cache_dir, g_adconfig->domain().toLower(), locale.name());
+}
 
 void ADMCTestAdInterface::cleanup() {
     // Delete test gpo, if it was leftover from previous test
@@ -192,6 +248,39 @@ void ADMCTestAdInterface::group_add_member() {
     QCOMPARE(member_list, QList<QString>({user_dn}));
 }
 
+// Server returns big multi-valued attributes in ranges
+// of 1500 values, check that all ranges are loaded and
+// that range limit stops loading early
+void ADMCTestAdInterface::group_ranged_members() {
+    const int member_count = 1600;
+
+    QList<QString> user_list;
+    for (int i = 0; i < member_count; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER, QString::number(i));
+        const QString user_dn = test_object_dn(name, CLASS_USER);
+        const bool add_user_success = ad.object_add(user_dn, CLASS_USER);
+        QVERIFY(add_user_success);
+
+        user_list.append(user_dn);
+    }
+
+    const QString group_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+    const bool add_group_success = ad.object_add(group_dn, CLASS_GROUP);
+    QVERIFY(add_group_success);
+
+    const QHash<QString, QList<QString>> added_map = ad.group_add_member_batch({group_dn}, user_list);
+    QCOMPARE(added_map.value(group_dn).size(), member_count);
+
+    const AdObject full_object = ad.search_object(group_dn, {ATTRIBUTE_MEMBER});
+    QCOMPARE(full_object.get_strings(ATTRIBUTE_MEMBER).size(), member_count);
+
+    ad.set_range_limit(1);
+    const AdObject limited_object = ad.search_object(group_dn, {ATTRIBUTE_MEMBER});
+    ad.set_range_limit(0);
+
+    QCOMPARE(limited_object.get_strings(ATTRIBUTE_MEMBER).size(), 1);
+}
+
 void ADMCTestAdInterface::group_remove_member() {
     group_add_member();
 
@@ -236,6 +325,27 @@ void ADMCTestAdInterface::group_set_type() {
         const GroupType current_type = group_object.get_group_type();
         QCOMPARE(current_type, type);
     }
+
+    // Object becomes stale after scope is changed, changing
+    // type using it should still keep the scope change
+    const AdObject object = ad.search_object(group_dn);
+    const GroupScope new_scope = [&]() {
+        if (object.get_group_scope() == GroupScope_Universal) {
+            return GroupScope_Global;
+        } else {
+            return GroupScope_Universal;
+        }
+    }();
+
+    const bool scope_success = ad.group_set_scope(object, new_scope);
+    QVERIFY(scope_success);
+
+    const bool type_success = ad.group_set_type(object, GroupType_Security);
+    QVERIFY(type_success);
+
+    const AdObject updated_object = ad.search_object(group_dn);
+    QCOMPARE(updated_object.get_group_scope(), new_scope);
+    QCOMPARE(updated_object.get_group_type(), GroupType_Security);
 }
 
 void ADMCTestAdInterface::user_set_account_option() {
@@ -254,4 +364,790 @@ void ADMCTestAdInterface::user_set_account_option() {
     }
 }
 
+void ADMCTestAdInterface::connection_pool() {
+    const QString head_dn = ad.adconfig()->domain_head();
+
+    // Connection of this interface is returned to the pool
+    // when it's destroyed
+    {
+        AdInterface first_ad;
+        QVERIFY(first_ad.is_connected());
+    }
+
+    // This interface should lease the connection back and
+    // be able to use it
+    const int hit_count_before = AdConnectionPool::instance()->hit_count();
+    AdInterface second_ad;
+    QVERIFY(second_ad.is_connected());
+    QCOMPARE(AdConnectionPool::instance()->hit_count(), hit_count_before + 1);
+
+    const AdObject head_object = second_ad.search_object(head_dn, {ATTRIBUTE_DN});
+    QVERIFY(!head_object.is_empty());
+}
+
+void ADMCTestAdInterface::batch_move_and_delete() {
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    const bool add_ou_success = ad.object_add(ou_dn, CLASS_OU);
+    QVERIFY(add_ou_success);
+
+    QList<QString> user_list;
+    for (int i = 0; i < 3; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool add_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(add_success);
+
+        user_list.append(dn);
+    }
+
+    const QList<QString> moved_list = ad.object_move_batch(user_list, ou_dn);
+    QCOMPARE(moved_list, user_list);
+
+    QList<QString> moved_dn_list;
+    for (const QString &dn : user_list) {
+        const QString dn_after_move = dn_move(dn, ou_dn);
+        QVERIFY(object_exists(dn_after_move));
+
+        moved_dn_list.append(dn_after_move);
+    }
+
+    const QList<QString> deleted_list = ad.object_delete_batch(moved_dn_list);
+    QCOMPARE(deleted_list, moved_dn_list);
+
+    for (const QString &dn : moved_dn_list) {
+        QVERIFY(!object_exists(dn));
+    }
+}
+
+void ADMCTestAdInterface::discovery_cache() {
+    AdDiscoveryCache *cache = AdDiscoveryCache::instance();
+
+    const QString domain = cache->default_domain();
+    QVERIFY(!domain.isEmpty());
+
+    const QList<AdSrvRecord> record_list = cache->get_records(domain, QString());
+    QVERIFY(!record_list.isEmpty());
+
+    // Selected host should be one of the records
+    const QList<QString> host_list = get_domain_hosts(domain, QString());
+    const QString selected_host = cache->select_host(domain, QString());
+    QVERIFY(host_list.contains(selected_host));
+}
+
+void ADMCTestAdInterface::dc_ranking() {
+    AdDiscoveryCache *cache = AdDiscoveryCache::instance();
+
+    const QString domain = cache->default_domain();
+    const QList<QString> ranked_list = cache->ranked_hosts(domain);
+    QVERIFY(!ranked_list.isEmpty());
+
+    // All ranked DC's should be discoverable
+    const QString site = cache->client_site(domain);
+    const QList<QString> host_list = get_domain_hosts(domain, site);
+    for (const QString &host : ranked_list) {
+        QVERIFY(host_list.contains(host));
+    }
+
+    // If DC is not pinned, new connections should go to
+    // the top-ranked DC
+    const QString saved_dc = AdInterface::get_dc();
+    AdInterface::set_dc(QString());
+
+    {
+        AdInterface ranked_ad;
+        QVERIFY(ranked_ad.is_connected());
+        QCOMPARE(AdInterface::get_dc(), ranked_list[0]);
+    }
+
+    AdInterface::set_dc(saved_dc);
+}
+
+void ADMCTestAdInterface::search_stream() {
+    for (int i = 0; i < 3; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool add_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(add_success);
+    }
+
+    const QString base = test_arena_dn();
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+    const QList<QString> attributes = {ATTRIBUTE_NAME};
+
+    // Streamed results should match regular search
+    QSet<QString> stream_dn_set;
+    const bool stream_success = ad.search_stream(base, SearchScope_All, filter, attributes,
+        [&](const AdObject &object) {
+            stream_dn_set.insert(object.get_dn());
+
+            return true;
+        });
+    QVERIFY(stream_success);
+
+    const QHash<QString, AdObject> search_results = ad.search(base, SearchScope_All, filter, attributes);
+    const QSet<QString> search_dn_set = search_results.keys().toSet();
+    QCOMPARE(stream_dn_set, search_dn_set);
+
+    // Returning false from callback should stop search
+    int stopped_count = 0;
+    const bool stopped_success = ad.search_stream(base, SearchScope_All, filter, attributes,
+        [&](const AdObject &) {
+            stopped_count++;
+
+            return false;
+        });
+    QVERIFY(stopped_success);
+    QCOMPARE(stopped_count, 1);
+}
+
+// Results from all pages should be collected, page size
+// shouldn't cause objects to be skipped
+void ADMCTestAdInterface::search_paged() {
+    const int user_count = 1100;
+
+    for (int i = 0; i < user_count; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER, QString::number(i));
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool add_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(add_success);
+    }
+
+    const QString base = test_arena_dn();
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+    const QList<QString> attributes = {ATTRIBUTE_NAME};
+
+    QHash<QString, AdObject> results;
+    AdCookie cookie;
+    int page_count = 0;
+
+    while (true) {
+        const bool success = ad.search_paged(base, SearchScope_All, filter, attributes, &results, &cookie);
+        QVERIFY(success);
+
+        page_count++;
+
+        if (!cookie.more_pages()) {
+            break;
+        }
+    }
+
+    QVERIFY(page_count > 1);
+    QCOMPARE(results.size(), user_count);
+}
+
+void ADMCTestAdInterface::search_objects() {
+    QList<QString> dn_list;
+    for (int i = 0; i < 3; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool add_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(add_success);
+
+        dn_list.append(dn);
+    }
+
+    // Objects that don't exist should be skipped
+    const QString missing_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+    const QList<QString> search_list = dn_list + QList<QString>({missing_dn});
+
+    const QHash<QString, AdObject> results = ad.search_objects(search_list, {ATTRIBUTE_NAME});
+    QCOMPARE(results.size(), dn_list.size());
+
+    for (const QString &dn : dn_list) {
+        QVERIFY(results.contains(dn));
+        QCOMPARE(results[dn].get_string(ATTRIBUTE_NAME), dn_get_name(dn));
+    }
+}
+
+void ADMCTestAdInterface::object_modify() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool add_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY(add_success);
+
+    AdChangeSet changes;
+    changes.replace_string(ATTRIBUTE_DESCRIPTION, "test description");
+    changes.replace_string(ATTRIBUTE_TELEPHONE_NUMBER, "123");
+    changes.add_value(ATTRIBUTE_TELEPHONE_NUMBER_OTHER, "456");
+
+    const bool modify_success = ad.object_modify(dn, changes);
+    QVERIFY(modify_success);
+
+    const AdObject object = ad.search_object(dn);
+    QCOMPARE(object.get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+    QCOMPARE(object.get_string(ATTRIBUTE_TELEPHONE_NUMBER), QString("123"));
+    QCOMPARE(object.get_strings(ATTRIBUTE_TELEPHONE_NUMBER_OTHER), QList<QString>({"456"}));
+
+    // Change set is atomic, so if one of the changes
+    // fails, none of them are applied
+    AdChangeSet bad_changes;
+    bad_changes.replace_string(ATTRIBUTE_DESCRIPTION, "other description");
+    bad_changes.delete_value(ATTRIBUTE_TELEPHONE_NUMBER_OTHER, "789");
+
+    const bool bad_modify_success = ad.object_modify(dn, bad_changes);
+    QVERIFY(!bad_modify_success);
+
+    const AdObject object_after_fail = ad.search_object(dn);
+    QCOMPARE(object_after_fail.get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+}
+
+void ADMCTestAdInterface::user_set_account_option_known() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool add_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY(add_success);
+
+    const AdObject object = ad.search_object(dn);
+
+    const bool disable_success = ad.user_set_account_option(object, AccountOption_Disabled, true);
+    QVERIFY(disable_success);
+    QVERIFY(ad.search_object(dn).get_account_option(AccountOption_Disabled, ad.adconfig()));
+
+    // Object is now stale, changing another option using
+    // it should still keep the previous change
+    const bool dont_expire_success = ad.user_set_account_option(object, AccountOption_DontExpirePassword, true);
+    QVERIFY(dont_expire_success);
+
+    const AdObject updated_object = ad.search_object(dn);
+    QVERIFY(updated_object.get_account_option(AccountOption_Disabled, ad.adconfig()));
+    QVERIFY(updated_object.get_account_option(AccountOption_DontExpirePassword, ad.adconfig()));
+
+    // Batch version
+    const QList<QString> changed_list = ad.user_set_account_option_batch(QList<AdObject>({updated_object}), AccountOption_Disabled, false);
+    QCOMPARE(changed_list, QList<QString>({dn}));
+    QVERIFY(!ad.search_object(dn).get_account_option(AccountOption_Disabled, ad.adconfig()));
+}
+
+void ADMCTestAdInterface::object_post_read() {
+    const QList<QString> attributes = {ATTRIBUTE_DESCRIPTION};
+
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    AdObject added_object;
+    const bool add_success = ad.object_add(user_dn, CLASS_USER, attributes, &added_object);
+    QVERIFY(add_success);
+    QVERIFY(object_exists(user_dn));
+
+    // NOTE: server may not support post-read control, in
+    // which case returned objects are empty. Operations
+    // still succeed in that case, which is checked above,
+    // but there is nothing else to test.
+    if (added_object.get_dn().isEmpty()) {
+        QSKIP("Server didn't return post-read entry, post-read control (RFC 4527) is not supported");
+    }
+    QCOMPARE(added_object.get_dn().toLower(), user_dn.toLower());
+
+    AdChangeSet changes;
+    changes.replace_string(ATTRIBUTE_DESCRIPTION, "test description");
+
+    AdObject modified_object;
+    const bool modify_success = ad.object_modify(user_dn, changes, DoStatusMsg_Yes, attributes, &modified_object);
+    QVERIFY(modify_success);
+
+    QCOMPARE(modified_object.get_dn().toLower(), user_dn.toLower());
+    QCOMPARE(modified_object.get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+
+    const QString new_name = "new-name";
+    const QString new_dn = test_object_dn(new_name, CLASS_USER);
+    AdObject renamed_object;
+    const bool rename_success = ad.object_rename(user_dn, new_name, attributes, &renamed_object);
+    QVERIFY(rename_success);
+    QVERIFY(object_exists(new_dn));
+
+    QCOMPARE(renamed_object.get_dn().toLower(), new_dn.toLower());
+    QCOMPARE(renamed_object.get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+}
+
+void ADMCTestAdInterface::search_vlv() {
+    for (int i = 0; i < 5; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool add_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(add_success);
+    }
+
+    const QString base = test_arena_dn();
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+    const QList<QString> attributes = {ATTRIBUTE_NAME};
+
+    // Window in the middle of sorted results
+    AdVlvContext context;
+    QList<AdObject> results;
+    const bool success = ad.search_vlv(base, SearchScope_Children, filter, attributes, ATTRIBUTE_NAME, false, 1, 2, &results, &context);
+    QVERIFY(success);
+    QCOMPARE(context.total_count(), 5);
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(results[0].get_string(ATTRIBUTE_NAME), QString("%1-1").arg(TEST_USER));
+    QCOMPARE(results[1].get_string(ATTRIBUTE_NAME), QString("%1-2").arg(TEST_USER));
+
+    // Reversed sort order
+    AdVlvContext descending_context;
+    QList<AdObject> descending_results;
+    const bool descending_success = ad.search_vlv(base, SearchScope_Children, filter, attributes, ATTRIBUTE_NAME, true, 0, 1, &descending_results, &descending_context);
+    QVERIFY(descending_success);
+    QCOMPARE(descending_results.size(), 1);
+    QCOMPARE(descending_results[0].get_string(ATTRIBUTE_NAME), QString("%1-4").arg(TEST_USER));
+
+    // Window past the end returns nothing
+    QList<AdObject> past_end_results;
+    const bool past_end_success = ad.search_vlv(base, SearchScope_Children, filter, attributes, ATTRIBUTE_NAME, false, 10, 2, &past_end_results, &context);
+    QVERIFY(past_end_success);
+    QVERIFY(past_end_results.isEmpty());
+}
+
+void ADMCTestAdInterface::sync_changes() {
+    const QString modified_dn = test_object_dn(QString("%1-modified").arg(TEST_USER), CLASS_USER);
+    const QString deleted_dn = test_object_dn(QString("%1-deleted").arg(TEST_USER), CLASS_USER);
+    const QString created_dn = test_object_dn(QString("%1-created").arg(TEST_USER), CLASS_USER);
+
+    QVERIFY(ad.object_add(modified_dn, CLASS_USER));
+    QVERIFY(ad.object_add(deleted_dn, CLASS_USER));
+
+    const QByteArray deleted_guid = ad.search_object(deleted_dn, {ATTRIBUTE_OBJECT_GUID}).get_value(ATTRIBUTE_OBJECT_GUID);
+    QVERIFY(!deleted_guid.isEmpty());
+
+    AdSyncState state;
+    const bool begin_success = ad.sync_begin(&state);
+    QVERIFY(begin_success);
+    QVERIFY(state.is_valid());
+
+    QVERIFY(ad.object_add(created_dn, CLASS_USER));
+    QVERIFY(ad.attribute_replace_string(modified_dn, ATTRIBUTE_DESCRIPTION, "test description"));
+    QVERIFY(ad.object_delete(deleted_dn));
+
+    const QList<QString> attributes = {ATTRIBUTE_DESCRIPTION};
+    QList<AdObject> changed;
+    QList<QByteArray> removed_guids;
+    const bool sync_success = ad.sync_changes(test_arena_dn(), SearchScope_Children, QString(), attributes, &state, &changed, &removed_guids);
+    QVERIFY(sync_success);
+
+    QHash<QString, AdObject> changed_map;
+    for (const AdObject &object : changed) {
+        changed_map[object.get_dn().toLower()] = object;
+    }
+
+    QVERIFY(changed_map.contains(created_dn.toLower()));
+    QVERIFY(changed_map.contains(modified_dn.toLower()));
+    QCOMPARE(changed_map[modified_dn.toLower()].get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+    QVERIFY(!changed_map[modified_dn.toLower()].get_value(ATTRIBUTE_OBJECT_GUID).isEmpty());
+    QVERIFY(removed_guids.contains(deleted_guid));
+
+    // Nothing changed since last sync
+    changed.clear();
+    removed_guids.clear();
+    const bool second_sync_success = ad.sync_changes(test_arena_dn(), SearchScope_Children, QString(), attributes, &state, &changed, &removed_guids);
+    QVERIFY(second_sync_success);
+    QVERIFY(changed.isEmpty());
+
+    // Sync from a connection that may be to another DC
+    // should go to the DC where sync began
+    AdInterface other_ad(AdRouting_ReadBalanced);
+    QVERIFY(other_ad.is_connected());
+
+    QVERIFY(ad.attribute_replace_string(modified_dn, ATTRIBUTE_DESCRIPTION, "other description"));
+
+    changed.clear();
+    removed_guids.clear();
+    const bool other_sync_success = other_ad.sync_changes(test_arena_dn(), SearchScope_Children, QString(), attributes, &state, &changed, &removed_guids);
+    QVERIFY(other_sync_success);
+    QCOMPARE(other_ad.connected_dc(), ad.connected_dc());
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed[0].get_string(ATTRIBUTE_DESCRIPTION), QString("other description"));
+}
+
+void ADMCTestAdInterface::change_notifications() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+
+    // NOTE: notifications need their own connection
+    AdInterface listener;
+    QVERIFY(listener.is_connected());
+
+    const int id = listener.notification_start(test_arena_dn(), SearchScope_Children, {ATTRIBUTE_DESCRIPTION});
+    QVERIFY(id != -1);
+
+    QVERIFY(ad.attribute_replace_string(dn, ATTRIBUTE_DESCRIPTION, "test description"));
+
+    // Notifications arrive with a delay, so wait for a bit
+    AdObject changed_object;
+    for (int i = 0; i < 20 && changed_object.is_empty(); i++) {
+        QList<AdObject> changed;
+        QList<int> ended_ids;
+        const bool wait_success = listener.notification_wait(500, &changed, &ended_ids);
+        QVERIFY(wait_success);
+        QVERIFY(!ended_ids.contains(id));
+
+        for (const AdObject &object : changed) {
+            if (object.get_dn().toLower() == dn.toLower()) {
+                changed_object = object;
+            }
+        }
+    }
+
+    QVERIFY(!changed_object.is_empty());
+    QCOMPARE(changed_object.get_string(ATTRIBUTE_DESCRIPTION), QString("test description"));
+    QVERIFY(!changed_object.get_value(ATTRIBUTE_OBJECT_GUID).isEmpty());
+
+    listener.notification_stop(id);
+}
+
+void ADMCTestAdInterface::search_cancel() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+
+    AdInterface cancelled_ad;
+    QVERIFY(cancelled_ad.is_connected());
+
+    cancelled_ad.cancel();
+
+    // Cancelled stream should stop without results and
+    // without failing
+    int result_count = 0;
+    const bool stream_success = cancelled_ad.search_stream(test_arena_dn(), SearchScope_All, QString(), {ATTRIBUTE_NAME},
+        [&](const AdObject &) {
+            result_count++;
+
+            return true;
+        });
+    QVERIFY(stream_success);
+    QCOMPARE(result_count, 0);
+
+    // Cancel only applies to one operation, operations
+    // after it work normally
+    const QHash<QString, AdObject> results = cancelled_ad.search(test_arena_dn(), SearchScope_All, QString(), {ATTRIBUTE_NAME});
+    QVERIFY(results.contains(dn));
+
+    // Cancel made between operations applies to the next
+    // one
+    cancelled_ad.cancel();
+    const AdObject cancelled_object = cancelled_ad.search_object(dn, {ATTRIBUTE_NAME});
+    QVERIFY(cancelled_object.is_empty());
+
+    const AdObject object = cancelled_ad.search_object(dn, {ATTRIBUTE_NAME});
+    QVERIFY(!object.is_empty());
+}
+
+void ADMCTestAdInterface::concurrent_searches() {
+    QSet<QString> expected;
+    for (int i = 0; i < 5; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        QVERIFY(ad.object_add(dn, CLASS_USER));
+
+        expected.insert(dn.toLower());
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(CONCURRENT_THREAD_COUNT);
+
+    QAtomicInt success_count(0);
+
+    // NOTE: alternate between pinned and unpinned DC and
+    // between two timeouts that are long enough for
+    // searches to finish, so that every setting value is
+    // valid
+    const QString original_dc = AdInterface::get_dc();
+    const int original_timeout = AdInterface::get_timeout();
+    const QString connected_dc = ad.connected_dc();
+
+    for (int i = 0; i < CONCURRENT_SEARCH_COUNT; i++) {
+        pool.start(new ConcurrentSearchTask(test_arena_dn(), expected, &success_count));
+
+        // NOTE: change settings while searches are running,
+        // this shouldn't affect AdInterface's that were
+        // already created. Changing DC and timeout also
+        // clears connection pool while tasks are using
+        // connections from it.
+        AdInterface::set_log_searches(i % 2 == 0);
+
+        if (i % 2 == 0) {
+            AdInterface::set_dc(connected_dc);
+            AdInterface::set_timeout(original_timeout * 2);
+        } else {
+            AdInterface::set_dc(original_dc);
+            AdInterface::set_timeout(original_timeout);
+        }
+    }
+
+    pool.waitForDone();
+
+    AdInterface::set_log_searches(false);
+    AdInterface::set_dc(original_dc);
+    AdInterface::set_timeout(original_timeout);
+
+    QCOMPARE(success_count.loadAcquire(), CONCURRENT_SEARCH_COUNT);
+}
+
+void ADMCTestAdInterface::read_routing() {
+    AdReadRouter *router = AdReadRouter::instance();
+
+    // Reads go to the DC with least connections, ties go
+    // to the first DC
+    const QString dc_a = "routing-test-a";
+    const QString dc_b = "routing-test-b";
+    QCOMPARE(router->select({dc_a, dc_b}), dc_a);
+    QCOMPARE(router->select({dc_a, dc_b}), dc_b);
+    QCOMPARE(router->select({dc_a, dc_b}), dc_a);
+    QCOMPARE(router->connection_count(dc_a), 2);
+    router->remove(dc_a);
+    router->remove(dc_a);
+    router->remove(dc_b);
+    QCOMPARE(router->connection_count(dc_a), 0);
+
+    // Balanced read right after a write should see that
+    // write
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+    QVERIFY(router->write_is_recent());
+
+    AdInterface read_ad(AdRouting_ReadBalanced);
+    QVERIFY(read_ad.is_connected());
+
+    const AdObject object = read_ad.search_object(dn);
+    QVERIFY(!object.is_empty());
+
+    // Without a recent write, balanced read goes to the
+    // least loaded DC. Load all DC's except the last one,
+    // so that read has to go there.
+    const int read_your_writes_seconds = router->get_read_your_writes_seconds();
+    router->set_read_your_writes_seconds(0);
+    QVERIFY(!router->write_is_recent());
+
+    AdDiscoveryCache *discovery = AdDiscoveryCache::instance();
+    const QString domain = g_adconfig->domain();
+    QList<QString> dc_list = discovery->ranked_hosts(domain);
+    if (dc_list.isEmpty()) {
+        dc_list = get_domain_hosts(domain, discovery->client_site(domain));
+    }
+    QVERIFY(!dc_list.isEmpty());
+
+    const QString least_loaded_dc = dc_list.last();
+    const QList<QString> loaded_dc_list = dc_list.mid(0, dc_list.size() - 1);
+    const int extra_load = 100;
+    for (const QString &dc : loaded_dc_list) {
+        for (int i = 0; i < extra_load; i++) {
+            router->add(dc);
+        }
+    }
+
+    {
+        AdInterface balanced_ad(AdRouting_ReadBalanced);
+        QVERIFY(balanced_ad.is_connected());
+        QCOMPARE(balanced_ad.connected_dc(), least_loaded_dc);
+    }
+
+    for (const QString &dc : loaded_dc_list) {
+        for (int i = 0; i < extra_load; i++) {
+            router->remove(dc);
+        }
+    }
+
+    // GC connections are not counted
+    const int count_before_gc = router->connection_count(least_loaded_dc);
+    {
+        AdInterface gc(AdRouting_GlobalCatalog);
+        QCOMPARE(router->connection_count(least_loaded_dc), count_before_gc);
+        if (gc.is_connected()) {
+            QCOMPARE(router->connection_count(gc.connected_dc()), 0);
+        }
+    }
+
+    router->set_read_your_writes_seconds(read_your_writes_seconds);
+}
+
+void ADMCTestAdInterface::search_forest() {
+    const QList<QString> filter_attributes = filter_get_attributes("(&(name=a*)(!(userAccountControl:1.2.840.113556.1.4.803:=2)))");
+    QCOMPARE(filter_attributes, QList<QString>({ATTRIBUTE_NAME, ATTRIBUTE_USER_ACCOUNT_CONTROL}));
+
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+
+    // NOTE: search_forest() falls back to domain search if
+    // GC is unavailable, so check GC directly, otherwise
+    // this test could pass without GC being used
+    AdInterface gc(AdRouting_GlobalCatalog);
+    if (!gc.is_connected()) {
+        QSKIP("No Global Catalog server is reachable, can't test forest search");
+    }
+
+    // NOTE: GC is updated through replication, so wait for
+    // the new user to get there
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_NAME, TEST_USER);
+    QTRY_VERIFY_WITH_TIMEOUT(gc.search(QString(), SearchScope_All, filter, {ATTRIBUTE_DN}).contains(dn), 30000);
+
+    const QHash<QString, AdObject> forest_results = ad.search_forest(filter, {ATTRIBUTE_DN});
+    QVERIFY(forest_results.contains(dn));
+
+    // Attributes that are not in GC fall back to domain
+    // search
+    const QHash<QString, AdObject> domain_results = ad.search_forest(filter, QList<QString>());
+    QVERIFY(domain_results.contains(dn));
+
+    // GC connections are pooled separately from domain
+    // connections, so a GC connection returned to the pool
+    // can't be acquired by the host name alone
+    const QString gc_dc = gc.connected_dc();
+    {
+        AdInterface other_gc(AdRouting_GlobalCatalog);
+        QVERIFY(other_gc.is_connected());
+    }
+    QVERIFY(AdConnectionPool::instance()->acquire(gc_dc) == NULL);
+}
+
+void ADMCTestAdInterface::object_storage() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+
+    // Objects from one search share an arena, make sure
+    // that a copy stays valid after the rest are deleted
+    AdObject object;
+    {
+        const QHash<QString, AdObject> results = ad.search(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_OBJECT_CLASS, ATTRIBUTE_NAME, ATTRIBUTE_USER_ACCOUNT_CONTROL});
+        QVERIFY(results.contains(dn));
+
+        object = results[dn];
+    }
+
+    QCOMPARE(object.get_dn(), dn);
+    QCOMPARE(object.get_string(ATTRIBUTE_NAME), QString(TEST_USER));
+    QCOMPARE(object.get_string(ATTRIBUTE_OBJECT_CLASS), QString(CLASS_USER));
+    QCOMPARE(object.get_value_count(ATTRIBUTE_OBJECT_CLASS), object.get_values(ATTRIBUTE_OBJECT_CLASS).size());
+    QCOMPARE(object.get_value_view(ATTRIBUTE_NAME), object.get_value(ATTRIBUTE_NAME));
+    QVERIFY(object.contains(ATTRIBUTE_USER_ACCOUNT_CONTROL));
+    QVERIFY(!object.contains(ATTRIBUTE_DESCRIPTION));
+    QVERIFY(object.get_value_view(ATTRIBUTE_DESCRIPTION).isEmpty());
+
+    // Loading from attributes data produces an equal
+    // object
+    AdObject loaded;
+    loaded.load(object.get_dn(), object.get_attributes_data());
+    QVERIFY(loaded.get_attributes_data() == object.get_attributes_data());
+    QCOMPARE(loaded.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL), object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL));
+}
+
+void ADMCTestAdInterface::attribute_atoms() {
+    AdAtomTable *atom_table = AdAtomTable::instance();
+
+    // Well-known atoms are assigned at compile time
+    QCOMPARE(atom_table->find(ATTRIBUTE_NAME), (AdAtom) ATOM_NAME);
+    QCOMPARE(atom_table->name(ATOM_OBJECT_CLASS), QString(ATTRIBUTE_OBJECT_CLASS));
+
+    // Schema attributes are interned when config is loaded
+    const AdAtom schema_atom = atom_table->find("carLicense");
+    QVERIFY(schema_atom != AD_ATOM_NONE);
+    QCOMPARE(atom_table->intern("carLicense"), schema_atom);
+    QCOMPARE(g_adconfig->get_attribute_type(schema_atom), g_adconfig->get_attribute_type(QString("carLicense")));
+    QCOMPARE(g_adconfig->get_attribute_type(ATOM_WHEN_CHANGED), AttributeType_GeneralizedTime);
+    QCOMPARE(g_adconfig->get_attribute_large_integer_subtype(ATOM_PWD_LAST_SET), LargeIntegerSubtype_Datetime);
+    QCOMPARE(g_adconfig->get_column_atoms().size(), g_adconfig->get_columns().size());
+
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    QVERIFY(ad.object_add(dn, CLASS_USER));
+
+    const AdObject object = ad.search_object(dn);
+    QCOMPARE(object.get_string(ATOM_NAME), object.get_string(ATTRIBUTE_NAME));
+    QCOMPARE(object.get_strings(ATOM_OBJECT_CLASS), object.get_strings(ATTRIBUTE_OBJECT_CLASS));
+    QCOMPARE(attribute_display_value(ATOM_WHEN_CREATED, object.get_value(ATOM_WHEN_CREATED), g_adconfig), attribute_display_value(ATTRIBUTE_WHEN_CREATED, object.get_value(ATTRIBUTE_WHEN_CREATED), g_adconfig));
+}
+
+void ADMCTestAdInterface::schema_tables() {
+    // Attributes of auxiliary classes are included, user
+    // gets objectSid from securityPrincipal
+    const QList<QString> mandatory = g_adconfig->get_mandatory_attributes({CLASS_USER});
+    QVERIFY(mandatory.contains(ATTRIBUTE_OBJECT_SID));
+    QCOMPARE(mandatory.toSet().size(), mandatory.size());
+
+    const QList<QString> optional = g_adconfig->get_optional_attributes({CLASS_TOP, CLASS_USER});
+    QVERIFY(optional.contains(ATTRIBUTE_DESCRIPTION));
+
+    QVERIFY(g_adconfig->get_possible_superiors({CLASS_USER}).contains(CLASS_OU));
+
+    QVERIFY(g_adconfig->get_attribute_is_single_valued(ATTRIBUTE_OBJECT_SID));
+    QVERIFY(!g_adconfig->get_attribute_is_single_valued(ATTRIBUTE_MEMBER));
+    QVERIFY(g_adconfig->get_attribute_is_backlink(ATTRIBUTE_MEMBER_OF));
+    QVERIFY(!g_adconfig->get_attribute_is_backlink(ATTRIBUTE_MEMBER));
+    QVERIFY(g_adconfig->get_attribute_is_constructed("canonicalName"));
+    QVERIFY(g_adconfig->get_attribute_range_upper(ATTRIBUTE_SAMACCOUNT_NAME) > 0);
+    QCOMPARE(g_adconfig->get_attribute_type("nonexistentAttribute"), AttributeType_StringCase);
+}
+
+void ADMCTestAdInterface::config_cache() {
+    const QString cache_path = config_cache_path(QLocale(QLocale::English));
+    QFile::remove(cache_path);
+
+    // First load saves cache, second load reads it
+    AdConfig loaded_config;
+    loaded_config.load(ad, QLocale(QLocale::English));
+    QVERIFY(!loaded_config.loaded_from_cache());
+    QVERIFY(QFile::exists(cache_path));
+
+    AdConfig cached_config;
+    cached_config.load(ad, QLocale(QLocale::English));
+    QVERIFY(cached_config.loaded_from_cache());
+
+    QCOMPARE(cached_config.get_columns(), loaded_config.get_columns());
+    QCOMPARE(cached_config.get_filter_containers(), loaded_config.get_filter_containers());
+    QCOMPARE(cached_config.get_class_display_name(CLASS_USER), loaded_config.get_class_display_name(CLASS_USER));
+    QCOMPARE(cached_config.get_attribute_type(ATTRIBUTE_WHEN_CHANGED), loaded_config.get_attribute_type(ATTRIBUTE_WHEN_CHANGED));
+    QCOMPARE(cached_config.get_attribute_is_backlink(ATTRIBUTE_MEMBER_OF), loaded_config.get_attribute_is_backlink(ATTRIBUTE_MEMBER_OF));
+    QCOMPARE(cached_config.get_mandatory_attributes({CLASS_USER}), loaded_config.get_mandatory_attributes({CLASS_USER}));
+    QCOMPARE(cached_config.get_possible_superiors({CLASS_USER}), loaded_config.get_possible_superiors({CLASS_USER}));
+    QCOMPARE(cached_config.get_right_guid("User-Force-Change-Password"), loaded_config.get_right_guid("User-Force-Change-Password"));
+
+    // Switching locale misses the cache, config for that
+    // locale is saved to a separate file
+    const QString other_cache_path = config_cache_path(QLocale(QLocale::Russian));
+    QFile::remove(other_cache_path);
+
+    AdConfig other_locale_config;
+    other_locale_config.load(ad, QLocale(QLocale::Russian));
+    QVERIFY(!other_locale_config.loaded_from_cache());
+    QVERIFY(QFile::exists(other_cache_path));
+
+    // Switching back hits the cache of first locale
+    AdConfig switched_back_config;
+    switched_back_config.load(ad, QLocale(QLocale::English));
+    QVERIFY(switched_back_config.loaded_from_cache());
+}
+
+void ADMCTestAdInterface::config_parallel_load() {
+    const QString cache_path = config_cache_path(QLocale(QLocale::English));
+    QFile::remove(cache_path);
+
+    AdConfig config;
+    config.load(ad, QLocale(QLocale::English));
+
+    const QHash<QString, qint64> timings = config.get_load_timings();
+    QVERIFY(timings.contains("attribute schemas"));
+    QVERIFY(timings.contains("extended rights"));
+    QVERIFY(timings.contains("total"));
+    QVERIFY(!config.loaded_from_cache());
+
+    // At least two phases must have been running at the
+    // same time
+    const QList<QPair<qint64, qint64>> interval_list = config.get_load_phase_intervals().values();
+
+    const bool phases_overlapped = [&]() {
+        for (int i = 0; i < interval_list.size(); i++) {
+            for (int j = i + 1; j < interval_list.size(); j++) {
+                const QPair<qint64, qint64> a = interval_list[i];
+                const QPair<qint64, qint64> b = interval_list[j];
+
+                if (a.first < b.second && b.first < a.second) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }();
+    QVERIFY(phases_overlapped);
+
+    // Categories found by the combined search map to
+    // classes
+    const QList<QString> filter_containers = config.get_filter_containers();
+    QVERIFY(filter_containers.contains(CLASS_OU));
+    QVERIFY(!filter_containers.contains(QString()));
+
+    QVERIFY(!config.get_right_guid("User-Force-Change-Password").isEmpty());
+    QCOMPARE(config.get_columns(), g_adconfig->get_columns());
+}
+
 QTEST_MAIN(ADMCTestAdInterface)
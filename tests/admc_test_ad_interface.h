@@ -39,11 +39,35 @@ private slots:
 
     void group_add_member();
     void group_remove_member();
+    void group_ranged_members();
     void group_set_scope();
     void group_set_type();
 
     void user_set_account_option();
 
+    void connection_pool();
+    void batch_move_and_delete();
+    void discovery_cache();
+    void dc_ranking();
+    void search_stream();
+    void search_paged();
+    void search_objects();
+    void object_modify();
+    void user_set_account_option_known();
+    void object_post_read();
+    void search_vlv();
+    void sync_changes();
+    void change_notifications();
+    void search_cancel();
+    void concurrent_searches();
+    void read_routing();
+    void search_forest();
+    void object_storage();
+    void attribute_atoms();
+    void schema_tables();
+    void config_cache();
+    void config_parallel_load();
+
 private:
 };
 
@@ -0,0 +1,107 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_object_prefetcher.h"
+
+#include "console_impls/item_type.h"
+#include "console_impls/object_impl.h"
+#include "console_widget/console_widget.h"
+#include "search_scheduler.h"
+#include "settings.h"
+
+#include <QSignalSpy>
+#include <QStandardItem>
+
+// NOTE: searches run in threads, so wait for them
+#define SEARCH_TIMEOUT_MS 10000
+
+// Sets up console with test arena which contains an OU
+// with one user. Arena is fetched, OU is not.
+void ADMCTestObjectPrefetcher::init() {
+    ADMCTest::init();
+
+    settings_set_bool(SETTING_prefetch, true);
+
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    QVERIFY(ad.object_add(ou_dn, CLASS_OU));
+
+    const QString user_dn = dn_from_name_and_parent(TEST_USER, ou_dn, CLASS_USER);
+    QVERIFY(ad.object_add(user_dn, CLASS_USER));
+
+    console = new ConsoleWidget(parent_widget);
+    object_impl = new ObjectImpl(console);
+    console->register_impl(ItemType_Object, object_impl);
+
+    const QList<QStandardItem *> arena_row = console->add_scope_item(ItemType_Object, QModelIndex());
+    const AdObject arena_object = ad.search_object(test_arena_dn(), console_object_search_attributes());
+    console_object_item_data_load(arena_row[0], arena_object);
+    console_item_set_was_fetched(arena_row[0], true);
+    arena_index = arena_row[0]->index();
+
+    const AdObject ou_object = ad.search_object(ou_dn, console_object_search_attributes());
+    object_impl_add_objects_to_console(console, {ou_object}, arena_index);
+
+    const QList<QModelIndex> ou_index_list = console->search_items(arena_index, ObjectRole_DN, ou_dn, ItemType_Object);
+    QCOMPARE(ou_index_list.size(), 1);
+    ou_index = ou_index_list[0];
+    QVERIFY(!console_item_get_was_fetched(ou_index));
+}
+
+void ADMCTestObjectPrefetcher::cleanup() {
+    settings_set_bool(SETTING_prefetch, false);
+
+    ADMCTest::cleanup();
+}
+
+// Child containers of selected container should be loaded
+// in background
+void ADMCTestObjectPrefetcher::prefetch_children() {
+    object_impl->selected_as_scope(arena_index);
+
+    QTRY_VERIFY_WITH_TIMEOUT(console_item_get_was_fetched(ou_index), SEARCH_TIMEOUT_MS);
+    QCOMPARE(console->get_item(ou_index)->rowCount(), 1);
+}
+
+// Prefetch started before reset should be dropped, because
+// it may use outdated settings
+void ADMCTestObjectPrefetcher::reset_drops_stale() {
+    object_impl->selected_as_scope(arena_index);
+    object_impl->reset_sync_states();
+
+    wait_for_searches();
+
+    QVERIFY(!console_item_get_was_fetched(ou_index));
+    QCOMPARE(console->get_item(ou_index)->rowCount(), 0);
+}
+
+// Waits for another search to go through scheduler, so
+// that late results of a dropped prefetch would have
+// arrived by then
+void ADMCTestObjectPrefetcher::wait_for_searches() {
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_NAME, TEST_OU);
+    auto request = new SearchRequest(test_arena_dn(), SearchScope_Children, filter, {ATTRIBUTE_NAME}, nullptr, SearchPriority_Background);
+    QSignalSpy finished_spy(request, &SearchRequest::finished);
+
+    SearchScheduler::instance()->submit(request);
+
+    QVERIFY(finished_spy.wait(SEARCH_TIMEOUT_MS));
+}
+
+QTEST_MAIN(ADMCTestObjectPrefetcher)
@@ -0,0 +1,50 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMC_TEST_OBJECT_PREFETCHER_H
+#define ADMC_TEST_OBJECT_PREFETCHER_H
+
+#include "admc_test.h"
+
+#include <QPersistentModelIndex>
+
+class ConsoleWidget;
+class ObjectImpl;
+
+class ADMCTestObjectPrefetcher : public ADMCTest {
+    Q_OBJECT
+
+private slots:
+    void init() override;
+    void cleanup() override;
+
+    void prefetch_children();
+    void reset_drops_stale();
+
+private:
+    ConsoleWidget *console;
+    ObjectImpl *object_impl;
+    QPersistentModelIndex arena_index;
+    QPersistentModelIndex ou_index;
+
+    void wait_for_searches();
+};
+
+#endif /* ADMC_TEST_OBJECT_PREFETCHER_H */
@@ -0,0 +1,136 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_object_vlv_model.h"
+
+#include "console_impls/object_vlv_model.h"
+
+// NOTE: rows are loaded in a thread, so wait for them
+#define ROW_TIMEOUT_MS 10000
+
+void ADMCTestObjectVlvModel::init() {
+    ADMCTest::init();
+
+    model = new ObjectVlvModel(test_arena_dn(), QString(), parent_widget);
+}
+
+// Model should load total count with first window and
+// then load other rows when they are requested
+void ADMCTestObjectVlvModel::load() {
+    const int user_count = 5;
+    create_users(user_count);
+
+    model->set_window_size(2);
+    model->load();
+
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), user_count, ROW_TIMEOUT_MS);
+
+    for (int row = 0; row < user_count; row++) {
+        QTRY_COMPARE_WITH_TIMEOUT(row_name(row), user_name(row), ROW_TIMEOUT_MS);
+    }
+}
+
+// Sorting should reload rows in new order
+void ADMCTestObjectVlvModel::sort() {
+    const int user_count = 3;
+    create_users(user_count);
+
+    model->load();
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), user_count, ROW_TIMEOUT_MS);
+    QTRY_COMPARE_WITH_TIMEOUT(row_name(0), user_name(0), ROW_TIMEOUT_MS);
+
+    model->sort(0, Qt::DescendingOrder);
+
+    for (int row = 0; row < user_count; row++) {
+        QTRY_COMPARE_WITH_TIMEOUT(row_name(row), user_name(user_count - 1 - row), ROW_TIMEOUT_MS);
+    }
+}
+
+// Model should keep a limited number of windows and load
+// dropped windows again when they are requested
+void ADMCTestObjectVlvModel::window_eviction() {
+    const int user_count = 25;
+    create_users(user_count);
+
+    model->set_window_size(1);
+    model->load();
+
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), user_count, ROW_TIMEOUT_MS);
+
+    for (int row = 0; row < user_count; row++) {
+        QTRY_COMPARE_WITH_TIMEOUT(row_name(row), user_name(row), ROW_TIMEOUT_MS);
+    }
+
+    QVERIFY(model->loaded_window_count() < user_count);
+
+    const QModelIndex first_index = model->index(0, 0);
+    QVERIFY2(!first_index.data().isValid(), "Oldest window wasn't dropped");
+
+    QTRY_COMPARE_WITH_TIMEOUT(row_name(0), user_name(0), ROW_TIMEOUT_MS);
+}
+
+// Context id is only valid on the connection that
+// received it. Using a context from another connection
+// should still succeed, by retrying without the context.
+void ADMCTestObjectVlvModel::context_from_other_connection() {
+    const int user_count = 3;
+    create_users(user_count);
+
+    const QList<QString> attributes = {ATTRIBUTE_NAME};
+
+    AdVlvContext context;
+
+    QList<AdObject> first_results;
+    const bool first_success = ad.search_vlv(test_arena_dn(), SearchScope_Children, QString(), attributes, ATTRIBUTE_NAME, false, 0, 1, &first_results, &context);
+    QVERIFY(first_success);
+    QCOMPARE(first_results.size(), 1);
+
+    AdInterface other_ad;
+    QVERIFY(other_ad.is_connected());
+
+    QList<AdObject> second_results;
+    const bool second_success = other_ad.search_vlv(test_arena_dn(), SearchScope_Children, QString(), attributes, ATTRIBUTE_NAME, false, 1, 1, &second_results, &context);
+    QVERIFY(second_success);
+    QCOMPARE(second_results.size(), 1);
+    QCOMPARE(second_results[0].get_string(ATTRIBUTE_NAME), user_name(1));
+    QCOMPARE(context.total_count(), user_count);
+}
+
+void ADMCTestObjectVlvModel::create_users(const int count) {
+    for (int i = 0; i < count; i++) {
+        const QString dn = test_object_dn(user_name(i), CLASS_USER);
+        const bool create_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY(create_success);
+    }
+}
+
+// NOTE: names are padded so that they sort in the same
+// order as numbers
+QString ADMCTestObjectVlvModel::user_name(const int i) const {
+    return QString("%1-%2").arg(TEST_USER).arg(i, 2, 10, QChar('0'));
+}
+
+QString ADMCTestObjectVlvModel::row_name(const int row) const {
+    const QModelIndex index = model->index(row, 0);
+
+    return index.data().toString();
+}
+
+QTEST_MAIN(ADMCTestObjectVlvModel)
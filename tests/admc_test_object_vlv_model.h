@@ -0,0 +1,47 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMC_TEST_OBJECT_VLV_MODEL_H
+#define ADMC_TEST_OBJECT_VLV_MODEL_H
+
+#include "admc_test.h"
+
+class ObjectVlvModel;
+
+class ADMCTestObjectVlvModel : public ADMCTest {
+    Q_OBJECT
+
+private slots:
+    void init() override;
+
+    void load();
+    void sort();
+    void window_eviction();
+    void context_from_other_connection();
+
+private:
+    ObjectVlvModel *model;
+
+    void create_users(const int count);
+    QString user_name(const int i) const;
+    QString row_name(const int row) const;
+};
+
+#endif /* ADMC_TEST_OBJECT_VLV_MODEL_H */
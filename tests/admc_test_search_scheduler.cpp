@@ -0,0 +1,133 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2021 BaseALT Ltd.
+ * Copyright (C) 2020-2021 Dmitry Degtyarev
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_search_scheduler.h"
+
+#include "console_impls/item_type.h"
+#include "console_impls/object_impl.h"
+#include "console_widget/console_widget.h"
+#include "search_scheduler.h"
+
+#include <QSignalSpy>
+#include <QStandardItem>
+
+// NOTE: searches run in threads, so wait for them
+#define SEARCH_TIMEOUT_MS 10000
+
+void ADMCTestSearchScheduler::init() {
+    ADMCTest::init();
+
+    started_list.clear();
+    finished_count = 0;
+}
+
+void ADMCTestSearchScheduler::cleanup() {
+    SearchScheduler::instance()->set_current_owner(nullptr);
+
+    ADMCTest::cleanup();
+}
+
+// When a slot frees up, request of current owner should
+// start before requests that were queued earlier
+void ADMCTestSearchScheduler::current_owner_goes_first() {
+    const int filler_count = fill_slots();
+
+    int owner_a;
+    int owner_b;
+    SearchRequest *request_a = make_request("a", &owner_a);
+    SearchRequest *request_b = make_request("b", &owner_b);
+    SearchScheduler::instance()->submit(request_a);
+    SearchScheduler::instance()->submit(request_b);
+
+    const int started_before = started_list.size();
+    QVERIFY(!started_list.contains(request_a));
+    QVERIFY(!started_list.contains(request_b));
+
+    SearchScheduler::instance()->set_current_owner(&owner_b);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished_count, filler_count + 2, SEARCH_TIMEOUT_MS);
+    QCOMPARE(started_list[started_before], request_b);
+}
+
+// Queued request of a console item should be cancelled
+// when item is deleted and never start
+void ADMCTestSearchScheduler::cancel_deleted_owner() {
+    auto console = new ConsoleWidget(parent_widget);
+    const QList<QStandardItem *> row = console->add_scope_item(ItemType_Object, QModelIndex());
+    const QModelIndex index = row[0]->index();
+
+    const int filler_count = fill_slots();
+
+    SearchRequest *request = console_object_search(console, index, test_arena_dn(), SearchScope_Children, QString(), console_object_search_attributes());
+    QSignalSpy started_spy(request, &SearchRequest::started);
+    QSignalSpy finished_spy(request, &SearchRequest::finished);
+
+    console->delete_item(index);
+    QCOMPARE(finished_spy.count(), 1);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished_count, filler_count, SEARCH_TIMEOUT_MS);
+    QCOMPARE(started_spy.count(), 0);
+}
+
+// NOTE: names make keys of requests different, so that
+// requests don't share searches
+SearchRequest *ADMCTestSearchScheduler::make_request(const QString &name, const void *owner) {
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_NAME, name);
+    auto request = new SearchRequest(test_arena_dn(), SearchScope_Children, filter, {ATTRIBUTE_NAME}, owner);
+
+    connect(
+        request, &SearchRequest::started,
+        this,
+        [this, request]() {
+            started_list.append(request);
+        });
+    connect(
+        request, &SearchRequest::finished,
+        this,
+        [this]() {
+            finished_count++;
+        });
+
+    return request;
+}
+
+// Submits requests until one of them has to wait in queue,
+// returns number of submitted requests. Running searches
+// finish only when events are processed, so slots stay
+// busy until test waits for something.
+int ADMCTestSearchScheduler::fill_slots() {
+    int out = 0;
+
+    while (true) {
+        const QString name = QString("filler-%1").arg(out);
+        SearchRequest *request = make_request(name, nullptr);
+        SearchScheduler::instance()->submit(request);
+
+        out++;
+
+        if (!started_list.contains(request)) {
+            break;
+        }
+    }
+
+    return out;
+}
+
+QTEST_MAIN(ADMCTestSearchScheduler)